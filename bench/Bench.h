@@ -0,0 +1,64 @@
+#ifndef _BENCH_BENCH_
+#define _BENCH_BENCH_
+#pragma once
+
+#include "../engine/Time.h"
+
+//\brief Times one section of a benchmark with the high resolution counter
+class BenchTimer
+{
+public:
+
+	BenchTimer() : m_startTime(Time::GetPreciseTimeSec()) { }
+
+	//\brief Start timing again from now
+	inline void Restart() { m_startTime = Time::GetPreciseTimeSec(); }
+
+	//\return how many milliseconds have passed since the timer was made or restarted
+	inline double GetElapsedMs() const { return (Time::GetPreciseTimeSec() - m_startTime) * 1000.0; }
+
+private:
+
+	double m_startTime;		///< Counter time in seconds when timing started
+};
+
+//\brief Small fast generator so runs are the same every time and can be compared
+//\param a_seed_OUT the state of the generator, any value but 0 to start with
+//\return the next number in the sequence
+inline unsigned int BenchRandom(unsigned int & a_seed_OUT)
+{
+	a_seed_OUT ^= a_seed_OUT << 13;
+	a_seed_OUT ^= a_seed_OUT >> 17;
+	a_seed_OUT ^= a_seed_OUT << 5;
+	return a_seed_OUT;
+}
+
+//\brief Keep the fastest time of several runs, it's the one least disturbed by whatever else the machine is doing
+//\param a_timeMs the time of the latest run
+//\param a_fastestMs_OUT the fastest time so far, 0 before the first run
+inline void BenchKeepFastest(double a_timeMs, double & a_fastestMs_OUT)
+{
+	if (a_fastestMs_OUT <= 0.0 || a_timeMs < a_fastestMs_OUT)
+	{
+		a_fastestMs_OUT = a_timeMs;
+	}
+}
+
+//\brief Print one line of results, the time for each item lets runs of different sizes be compared
+//\param a_name what was timed
+//\param a_numItems how many things were done in the time
+//\param a_timeMs how long it took
+void BenchReport(const char * a_name, unsigned int a_numItems, double a_timeMs);
+
+//\brief Keep a result alive so the optimiser can't remove the work that made it
+void BenchKeep(unsigned int a_result);
+
+//\brief Each benchmark runs a few times and reports the fastest time for each thing it measures
+void BenchObjectSpawn();
+void BenchHashMaps();
+void BenchStringHashes();
+void BenchSweepAndPrune();
+void BenchCollisionKernels();
+void BenchSnapshots();
+
+#endif // _BENCH_BENCH_
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/Vector.h"
+
+#include "../engine/CollisionUtils.h"
+
+#include "Bench.h"
+
+static const unsigned int s_numRuns = 5;			// Each timing is the fastest of this many runs
+static const unsigned int s_numShapes = 4096;		// How many spheres and boxes each line is tested against
+static const unsigned int s_numLines = 256;			// How many lines are tested in each run
+static const float s_worldSize = 100.0f;			// Shapes and lines are inside a cube this big
+
+//\brief Shapes and lines for the kernels, spheres and boxes share positions so the work is the same size
+struct CollisionData
+{
+	Vector m_positions[s_numShapes];
+	Vector m_boxDimensions[s_numShapes];
+	float m_sphereRadii[s_numShapes];
+	Vector m_lineStarts[s_numLines];
+	Vector m_lineEnds[s_numLines];
+	bool m_hits[s_numShapes];
+	float m_hitFractions[s_numShapes];
+};
+
+//\brief A random point inside the world
+static Vector RandomPoint(unsigned int & a_seed_OUT)
+{
+	const float randomScale = s_worldSize / 4294967295.0f;
+	return Vector(BenchRandom(a_seed_OUT) * randomScale, BenchRandom(a_seed_OUT) * randomScale, BenchRandom(a_seed_OUT) * randomScale);
+}
+
+//\brief Test every line against every sphere one at a time
+//\return how many line sphere pairs touch
+static unsigned int TestSpheresScalar(CollisionData & a_data)
+{
+	unsigned int numHits = 0;
+	for (unsigned int line = 0; line < s_numLines; ++line)
+	{
+		for (unsigned int i = 0; i < s_numShapes; ++i)
+		{
+			a_data.m_hits[i] = CollisionUtils::IntersectLineSphere(a_data.m_lineStarts[line], a_data.m_lineEnds[line], a_data.m_positions[i], a_data.m_sphereRadii[i], a_data.m_hitFractions[i]);
+			numHits += a_data.m_hits[i] ? 1 : 0;
+		}
+	}
+	return numHits;
+}
+
+//\brief Test every line against all the spheres with the batch kernel
+static unsigned int TestSpheresBatch(CollisionData & a_data)
+{
+	unsigned int numHits = 0;
+	for (unsigned int line = 0; line < s_numLines; ++line)
+	{
+		numHits += CollisionUtils::IntersectLineSpheres(a_data.m_lineStarts[line], a_data.m_lineEnds[line], a_data.m_positions, a_data.m_sphereRadii, s_numShapes,
+														a_data.m_hits, a_data.m_hitFractions);
+	}
+	return numHits;
+}
+
+//\brief Test every line against every axis aligned box one at a time
+static unsigned int TestBoxesScalar(CollisionData & a_data)
+{
+	unsigned int numHits = 0;
+	for (unsigned int line = 0; line < s_numLines; ++line)
+	{
+		for (unsigned int i = 0; i < s_numShapes; ++i)
+		{
+			a_data.m_hits[i] = CollisionUtils::IntersectLineAxisBox(a_data.m_lineStarts[line], a_data.m_lineEnds[line], a_data.m_positions[i], a_data.m_boxDimensions[i], a_data.m_hitFractions[i]);
+			numHits += a_data.m_hits[i] ? 1 : 0;
+		}
+	}
+	return numHits;
+}
+
+//\brief Test every line against all the axis aligned boxes with the batch kernel
+static unsigned int TestBoxesBatch(CollisionData & a_data)
+{
+	unsigned int numHits = 0;
+	for (unsigned int line = 0; line < s_numLines; ++line)
+	{
+		numHits += CollisionUtils::IntersectLineAxisBoxes(a_data.m_lineStarts[line], a_data.m_lineEnds[line], a_data.m_positions, a_data.m_boxDimensions, s_numShapes,
+														  a_data.m_hits, a_data.m_hitFractions);
+	}
+	return numHits;
+}
+
+//\brief Run one way of testing the lines a few times
+//\param a_numHits_OUT how many pairs touched, the same every run
+//\return the fastest time
+static double TimeTest(unsigned int (*a_test)(CollisionData &), CollisionData & a_data, unsigned int & a_numHits_OUT)
+{
+	double fastestMs = 0.0;
+	for (unsigned int run = 0; run < s_numRuns; ++run)
+	{
+		BenchTimer timer;
+		a_numHits_OUT = a_test(a_data);
+		BenchKeepFastest(timer.GetElapsedMs(), fastestMs);
+	}
+	BenchKeep(a_numHits_OUT);
+	return fastestMs;
+}
+
+void BenchCollisionKernels()
+{
+	CollisionData * data = (CollisionData *)malloc(sizeof(CollisionData));
+	if (data == NULL)
+	{
+		printf("  Not enough memory\n");
+		return;
+	}
+
+	// Shapes are small compared to the world and lines cross a good part of it, so some pairs touch and most don't
+	unsigned int seed = 0x6a09e667;
+	const float randomScale = 1.0f / 4294967295.0f;
+	for (unsigned int i = 0; i < s_numShapes; ++i)
+	{
+		data->m_positions[i] = RandomPoint(seed);
+		data->m_sphereRadii[i] = 0.5f + BenchRandom(seed) * randomScale * 1.5f;
+		data->m_boxDimensions[i] = Vector(data->m_sphereRadii[i] * 2.0f, data->m_sphereRadii[i] * 1.5f, data->m_sphereRadii[i]);
+	}
+	for (unsigned int i = 0; i < s_numLines; ++i)
+	{
+		data->m_lineStarts[i] = RandomPoint(seed);
+		data->m_lineEnds[i] = RandomPoint(seed);
+	}
+
+	unsigned int sphereScalarHits = 0, sphereBatchHits = 0, boxScalarHits = 0, boxBatchHits = 0;
+	const double sphereScalarMs = TimeTest(TestSpheresScalar, *data, sphereScalarHits);
+	const double sphereBatchMs = TimeTest(TestSpheresBatch, *data, sphereBatchHits);
+	const double boxScalarMs = TimeTest(TestBoxesScalar, *data, boxScalarHits);
+	const double boxBatchMs = TimeTest(TestBoxesBatch, *data, boxBatchHits);
+
+	const unsigned int numTests = s_numLines * s_numShapes;
+	printf(" %u lines against %u shapes, spheres hit %u and %u times, boxes hit %u and %u times\n", s_numLines, s_numShapes,
+		   sphereScalarHits, sphereBatchHits, boxScalarHits, boxBatchHits);
+	BenchReport("IntersectLineSphere in a loop", numTests, sphereScalarMs);
+	BenchReport("IntersectLineSpheres", numTests, sphereBatchMs);
+	BenchReport("IntersectLineAxisBox in a loop", numTests, boxScalarMs);
+	BenchReport("IntersectLineAxisBoxes", numTests, boxBatchMs);
+
+	free(data);
+}
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unordered_map>
+
+#include "../core/HashMap.h"
+
+#include "Bench.h"
+
+static const unsigned int s_numRuns = 3;								// Each timing is the fastest of this many runs
+static const unsigned int s_mapSizes[] = { 1000, 100000, 1000000 };		// How many keys are in the map for each set of timings
+static const unsigned int s_numMapSizes = sizeof(s_mapSizes) / sizeof(s_mapSizes[0]);
+
+//\brief Give both maps the same interface so one set of timing code covers both
+struct BenchHashMap
+{
+	inline void Insert(unsigned int a_key, unsigned int a_value) { m_map.Insert(a_key, a_value); }
+	inline unsigned int Find(unsigned int a_key) { unsigned int * value = m_map.Find(a_key); return value != NULL ? *value : 0; }
+
+	HashMap<unsigned int, unsigned int> m_map;
+};
+
+struct BenchStdMap
+{
+	inline void Insert(unsigned int a_key, unsigned int a_value) { m_map.insert(std::make_pair(a_key, a_value)); }
+	inline unsigned int Find(unsigned int a_key)
+	{
+		std::unordered_map<unsigned int, unsigned int>::const_iterator it = m_map.find(a_key);
+		return it != m_map.end() ? it->second : 0;
+	}
+
+	std::unordered_map<unsigned int, unsigned int> m_map;
+};
+
+//\brief Time filling a new map and then looking up every key, then as many keys that are not in the map
+//\param a_keys keys to insert and look up, the misses are read from after the first a_numKeys
+template <typename TMap>
+static void TimeMap(const unsigned int * a_keys, unsigned int a_numKeys, double & a_insertMs_OUT, double & a_hitMs_OUT, double & a_missMs_OUT)
+{
+	TMap map;
+	BenchTimer timer;
+	for (unsigned int i = 0; i < a_numKeys; ++i)
+	{
+		map.Insert(a_keys[i], i + 1);
+	}
+	BenchKeepFastest(timer.GetElapsedMs(), a_insertMs_OUT);
+
+	unsigned int found = 0;
+	timer.Restart();
+	for (unsigned int i = 0; i < a_numKeys; ++i)
+	{
+		found += map.Find(a_keys[i]);
+	}
+	BenchKeepFastest(timer.GetElapsedMs(), a_hitMs_OUT);
+
+	timer.Restart();
+	for (unsigned int i = 0; i < a_numKeys; ++i)
+	{
+		found += map.Find(a_keys[a_numKeys + i]);
+	}
+	BenchKeepFastest(timer.GetElapsedMs(), a_missMs_OUT);
+	BenchKeep(found);
+}
+
+void BenchHashMaps()
+{
+	// Twice as many keys as the largest map so the second half can be looked up and missed
+	const unsigned int maxKeys = s_mapSizes[s_numMapSizes - 1] * 2;
+	unsigned int * keys = (unsigned int *)malloc(sizeof(unsigned int) * maxKeys);
+	if (keys == NULL)
+	{
+		printf("  Not enough memory\n");
+		return;
+	}
+
+	// Keys are kept unique so every insert adds an entry and every miss really misses
+	HashMap<unsigned int, unsigned int> usedKeys;
+	usedKeys.Reserve(maxKeys);
+	unsigned int seed = 0x2545f491;
+	for (unsigned int i = 0; i < maxKeys; ++i)
+	{
+		do
+		{
+			keys[i] = BenchRandom(seed);
+		} while (!usedKeys.Insert(keys[i], i));
+	}
+
+	for (unsigned int size = 0; size < s_numMapSizes; ++size)
+	{
+		const unsigned int numKeys = s_mapSizes[size];
+		double insertMs = 0.0, hitMs = 0.0, missMs = 0.0;
+		double stdInsertMs = 0.0, stdHitMs = 0.0, stdMissMs = 0.0;
+		for (unsigned int run = 0; run < s_numRuns; ++run)
+		{
+			// Each size uses the last keys, the first half are inserted and the second half are the misses
+			TimeMap<BenchHashMap>(keys + maxKeys - numKeys * 2, numKeys, insertMs, hitMs, missMs);
+			TimeMap<BenchStdMap>(keys + maxKeys - numKeys * 2, numKeys, stdInsertMs, stdHitMs, stdMissMs);
+		}
+
+		printf(" %u keys\n", numKeys);
+		BenchReport("HashMap, insert", numKeys, insertMs);
+		BenchReport("std::unordered_map, insert", numKeys, stdInsertMs);
+		BenchReport("HashMap, find present", numKeys, hitMs);
+		BenchReport("std::unordered_map, find present", numKeys, stdHitMs);
+		BenchReport("HashMap, find missing", numKeys, missMs);
+		BenchReport("std::unordered_map, find missing", numKeys, stdMissMs);
+	}
+
+	free(keys);
+}
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/ObjectPool.h"
+
+#include "../engine/GameObject.h"
+
+#include "Bench.h"
+
+static const unsigned int s_numRuns = 5;			// Each timing is the fastest of this many runs
+static const unsigned int s_numLive = 16384;		// As many objects as a scene can hold
+static const unsigned int s_numSpawns = 100000;		// Objects spawned and destroyed in each run
+
+//\brief Spawn and destroy objects the way the world did before it had a pool
+struct HeapSpawner
+{
+	inline GameObject * Spawn(unsigned int & a_id_OUT) { a_id_OUT = 0; return new GameObject(); }
+	inline void Destroy(GameObject * a_object, unsigned int a_id) { delete a_object; }
+};
+
+//\brief Spawn and destroy objects the way the world does now, from a pool with handles for ids
+struct PoolSpawner
+{
+	PoolSpawner() : m_pool(s_numLive) { }
+	inline GameObject * Spawn(unsigned int & a_id_OUT) { return m_pool.Allocate(a_id_OUT); }
+	inline void Destroy(GameObject * a_object, unsigned int a_id) { m_pool.Free(a_id); }
+
+	ObjectPool<GameObject> m_pool;
+};
+
+//\brief Fill the live set, then over and over destroy a random object and spawn one in it's place, which
+//		 scatters free blocks the way a game does as objects die at different times
+//\return milliseconds to spawn and destroy s_numSpawns objects, not counting the first fill or the last empty
+template <typename TSpawner>
+static double TimeChurn(TSpawner & a_spawner, GameObject ** a_objects, unsigned int * a_ids)
+{
+	for (unsigned int i = 0; i < s_numLive; ++i)
+	{
+		a_objects[i] = a_spawner.Spawn(a_ids[i]);
+	}
+
+	unsigned int seed = 0x1234567;
+	BenchTimer timer;
+	for (unsigned int i = 0; i < s_numSpawns; ++i)
+	{
+		const unsigned int slot = BenchRandom(seed) % s_numLive;
+		a_spawner.Destroy(a_objects[slot], a_ids[slot]);
+		a_objects[slot] = a_spawner.Spawn(a_ids[slot]);
+	}
+	const double timeMs = timer.GetElapsedMs();
+
+	for (unsigned int i = 0; i < s_numLive; ++i)
+	{
+		BenchKeep(a_objects[i] != NULL ? 1 : 0);
+		a_spawner.Destroy(a_objects[i], a_ids[i]);
+	}
+	return timeMs;
+}
+
+//\brief Spawn a full scene of objects then destroy them all, again and again until s_numSpawns have been made
+//\return milliseconds for all the waves
+template <typename TSpawner>
+static double TimeWaves(TSpawner & a_spawner, GameObject ** a_objects, unsigned int * a_ids)
+{
+	BenchTimer timer;
+	for (unsigned int numSpawned = 0; numSpawned < s_numSpawns; numSpawned += s_numLive)
+	{
+		const unsigned int waveSize = s_numSpawns - numSpawned < s_numLive ? s_numSpawns - numSpawned : s_numLive;
+		for (unsigned int i = 0; i < waveSize; ++i)
+		{
+			a_objects[i] = a_spawner.Spawn(a_ids[i]);
+		}
+		for (unsigned int i = 0; i < waveSize; ++i)
+		{
+			a_spawner.Destroy(a_objects[i], a_ids[i]);
+		}
+	}
+	return timer.GetElapsedMs();
+}
+
+void BenchObjectSpawn()
+{
+	GameObject ** objects = (GameObject **)malloc(sizeof(GameObject *) * s_numLive);
+	unsigned int * ids = (unsigned int *)malloc(sizeof(unsigned int) * s_numLive);
+	if (objects == NULL || ids == NULL)
+	{
+		printf("  Not enough memory\n");
+		free(objects);
+		free(ids);
+		return;
+	}
+
+	HeapSpawner heap;
+	PoolSpawner pool;
+	double heapChurnMs = 0.0, poolChurnMs = 0.0, heapWavesMs = 0.0, poolWavesMs = 0.0;
+	for (unsigned int run = 0; run < s_numRuns; ++run)
+	{
+		BenchKeepFastest(TimeChurn(heap, objects, ids), heapChurnMs);
+		BenchKeepFastest(TimeChurn(pool, objects, ids), poolChurnMs);
+		BenchKeepFastest(TimeWaves(heap, objects, ids), heapWavesMs);
+		BenchKeepFastest(TimeWaves(pool, objects, ids), poolWavesMs);
+	}
+
+	BenchReport("new/delete, random churn", s_numSpawns, heapChurnMs);
+	BenchReport("ObjectPool, random churn", s_numSpawns, poolChurnMs);
+	BenchReport("new/delete, fill and empty", s_numSpawns, heapWavesMs);
+	BenchReport("ObjectPool, fill and empty", s_numSpawns, poolWavesMs);
+
+	free(objects);
+	free(ids);
+}
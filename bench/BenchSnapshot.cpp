@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../core/ObjectPool.h"
+
+#include "../engine/ComponentManager.h"
+#include "../engine/Components/ComponentRootMotion.h"
+#include "../engine/GameObject.h"
+#include "../engine/MemoryManager.h"
+#include "../engine/ModelManager.h"
+#include "../engine/SceneSnapshot.h"
+#include "../engine/WorldManager.h"
+
+#include "Bench.h"
+
+static const unsigned int s_numRuns = 10;			// Each timing is the fastest of this many runs
+static const unsigned int s_numObjects = 10000;		// How many objects are in the scene
+static const unsigned int s_moveEvery = 4;			// One object in this many is moving between the two snapshots
+static const float s_worldSize = 1000.0f;			// Objects are spread over a level this wide and deep
+static const float s_moveSpeed = 5.0f;				// How fast the moving objects travel, slow enough that no move finishes
+static const float s_stepDt = 1.0f / 60.0f;			// One simulation step passes between the two snapshots
+
+//\brief Fill a scene with objects from a pool, each with a root motion component and one in s_moveEvery with a move queued
+//\param a_objects_OUT storage for s_numObjects pointers to the objects so they can be taken out again
+//\return how many objects were added to the scene, all of them unless something ran out of memory
+static unsigned int FillScene(ObjectPool<GameObject> & a_pool, Scene & a_scene, GameObject ** a_objects_OUT)
+{
+	unsigned int seed = 0xbb67ae85;
+	const float randomScale = 1.0f / 4294967295.0f;
+	for (unsigned int i = 0; i < s_numObjects; ++i)
+	{
+		unsigned int newId = 0;
+		GameObject * newObject = a_pool.Allocate(newId);
+		if (newObject == NULL)
+		{
+			return i;
+		}
+		newObject->SetId(newId);
+		newObject->SetState(GameObject::eGameObjectState_Loading);
+		newObject->SetPos(Vector(BenchRandom(seed) * randomScale * s_worldSize, BenchRandom(seed) * randomScale * s_worldSize, 0.0f));
+		if (!a_scene.AddObject(newObject))
+		{
+			a_pool.Free(newId);
+			return i;
+		}
+		a_objects_OUT[i] = newObject;
+		if (!newObject->AddComponent<ComponentRootMotion>())
+		{
+			return i + 1;
+		}
+
+		if (i % s_moveEvery == 0)
+		{
+			ComponentRootMotion * rootMotion = newObject->GetComponent<ComponentRootMotion>(Component::eComponentTypeRootMotion);
+			rootMotion->QueueMove(newObject->GetPos() + Vector(s_worldSize, 0.0f, 0.0f), s_moveSpeed);
+		}
+	}
+	return s_numObjects;
+}
+
+//\brief Take the objects out of the scene and give them back to the pool, the scene would otherwise hand them to the world's pool
+static void EmptyScene(ObjectPool<GameObject> & a_pool, Scene & a_scene, GameObject ** a_objects, unsigned int a_numObjects)
+{
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		a_objects[i]->RemoveAllComponents();
+		a_scene.RemoveObject(a_objects[i]);
+		a_pool.Free(a_objects[i]);
+	}
+}
+
+void BenchSnapshots()
+{
+	// Objects come from a pool and components from the component manager the same as in the game
+	MemoryManager & memMan = MemoryManager::Get();
+	ComponentManager & compMan = ComponentManager::Get();
+	ObjectPool<GameObject> pool(s_numObjects);
+	GameObject ** objects = (GameObject **)malloc(sizeof(GameObject *) * s_numObjects);
+	Scene * scene = memMan.New<Scene>(MemoryManager::eArenaWorld);
+	const bool compManStarted = compMan.Startup();
+	const unsigned int numObjects = objects != NULL && scene != NULL && compManStarted ? FillScene(pool, *scene, objects) : 0;
+	if (numObjects < s_numObjects)
+	{
+		printf("  Not enough memory\n");
+		if (scene != NULL)
+		{
+			EmptyScene(pool, *scene, objects, numObjects);
+		}
+		memMan.Delete(MemoryManager::eArenaWorld, scene);
+		compMan.Shutdown();
+		free(objects);
+		return;
+	}
+
+	// Snapshots keep their buffers so every run after the first reuses them like a history would
+	SceneSnapshot base, current, delta, decoded, restored;
+	double saveMs = 0.0, encodeMs = 0.0, decodeMs = 0.0, restoreMs = 0.0;
+	bool succeeded = true;
+	for (unsigned int run = 0; run < s_numRuns && succeeded; ++run)
+	{
+		succeeded = scene->SaveSnapshot(base);
+		compMan.Update(s_stepDt, scene);
+
+		BenchTimer timer;
+		succeeded = succeeded && scene->SaveSnapshot(current);
+		BenchKeepFastest(timer.GetElapsedMs(), saveMs);
+
+		timer.Restart();
+		succeeded = succeeded && current.EncodeDelta(base, delta);
+		BenchKeepFastest(timer.GetElapsedMs(), encodeMs);
+
+		timer.Restart();
+		succeeded = succeeded && decoded.DecodeDelta(base, delta);
+		BenchKeepFastest(timer.GetElapsedMs(), decodeMs);
+
+		// Going back to the first snapshot puts the moving objects back where they were so every run does the same work
+		timer.Restart();
+		succeeded = succeeded && scene->RestoreSnapshot(base);
+		BenchKeepFastest(timer.GetElapsedMs(), restoreMs);
+
+		// The decoded snapshot has to be the one the delta was made from and the restored scene has to save the same as it was
+		succeeded = succeeded && decoded.GetDataSize() == current.GetDataSize() && memcmp(decoded.GetData(), current.GetData(), current.GetDataSize()) == 0;
+		succeeded = succeeded && scene->SaveSnapshot(restored) && restored.GetDataSize() == base.GetDataSize() && memcmp(restored.GetData(), base.GetData(), base.GetDataSize()) == 0;
+	}
+
+	if (succeeded)
+	{
+		printf(" %u objects with root motion of %u bytes, one in %u moving, snapshot %u bytes, delta %u bytes\n", s_numObjects, objects[0]->GetStateSize(), s_moveEvery,
+			   current.GetDataSize(), delta.GetDataSize());
+		BenchReport("SaveSnapshot", s_numObjects, saveMs);
+		BenchReport("EncodeDelta", s_numObjects, encodeMs);
+		BenchReport("DecodeDelta", s_numObjects, decodeMs);
+		BenchReport("RestoreSnapshot", s_numObjects, restoreMs);
+	}
+	else
+	{
+		printf("  Saving, encoding, decoding or restoring failed or a snapshot was different\n");
+	}
+
+	EmptyScene(pool, *scene, objects, numObjects);
+	memMan.Delete(MemoryManager::eArenaWorld, scene);
+	compMan.Shutdown();
+	free(objects);
+}
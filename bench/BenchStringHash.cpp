@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../engine/StringHash.h"
+
+#include "Bench.h"
+
+static const unsigned int s_numRuns = 5;				// Each timing is the fastest of this many runs
+static const unsigned int s_numStrings = 100000;		// How many names are in the corpus
+static const unsigned int s_maxStringLength = 160;		// Longest name that is made, including the terminator
+
+//\brief Pieces of the names in the corpus, they are put together into paths like the engine loads
+static const char * s_folders[] = { "models", "textures", "sounds", "scenes", "templates", "fonts", "gui" };
+static const char * s_areas[] = { "common", "level01", "level02", "level03", "frontend", "characters", "vehicles", "weapons" };
+static const char * s_words[] = { "crate", "barrel", "door", "Player", "enemy", "tree", "Rock", "wall", "floor", "light",
+								  "Explosion", "spark", "smoke", "health", "ammo", "trigger", "camera", "spawn", "button", "panel" };
+static const char * s_extensions[] = { ".obj", ".mtl", ".tga", ".wav", ".scn", ".tmp", ".fnt" };
+static const unsigned int s_numFolders = sizeof(s_folders) / sizeof(s_folders[0]);
+static const unsigned int s_numAreas = sizeof(s_areas) / sizeof(s_areas[0]);
+static const unsigned int s_numWords = sizeof(s_words) / sizeof(s_words[0]);
+static const unsigned int s_numExtensions = sizeof(s_extensions) / sizeof(s_extensions[0]);
+
+//\brief The hash as it was before GenerateCRC hashed eight bytes at a time, one table lookup per byte
+static unsigned int GenerateCRCByteAtATime(const char * a_string)
+{
+	unsigned int crc = 0xffffffff;
+	const unsigned char * buffer = (const unsigned char *)a_string;
+	while (*buffer)
+	{
+		crc = (crc >> 8) ^ StringHashCRC::s_table[(crc & 0xFF) ^ *buffer++];
+	}
+	return crc ^ 0xffffffff;
+}
+
+//\brief Make a name that looks like an asset path, a bare object name or a long nested path
+static void MakeName(unsigned int & a_seed_OUT, char * a_name_OUT)
+{
+	const unsigned int kind = BenchRandom(a_seed_OUT) % 4;
+	if (kind == 0)
+	{
+		// Object names like "crate_big_12"
+		sprintf(a_name_OUT, "%s_%s_%u", s_words[BenchRandom(a_seed_OUT) % s_numWords], s_words[BenchRandom(a_seed_OUT) % s_numWords], BenchRandom(a_seed_OUT) % 100);
+		return;
+	}
+
+	// Paths like "models\level01\crate_door.obj" with a few more levels of folders for the long ones
+	int length = sprintf(a_name_OUT, "%s\\%s\\", s_folders[BenchRandom(a_seed_OUT) % s_numFolders], s_areas[BenchRandom(a_seed_OUT) % s_numAreas]);
+	const unsigned int numExtraFolders = kind == 3 ? 2 + BenchRandom(a_seed_OUT) % 4 : 0;
+	for (unsigned int i = 0; i < numExtraFolders; ++i)
+	{
+		length += sprintf(a_name_OUT + length, "%s_%s\\", s_words[BenchRandom(a_seed_OUT) % s_numWords], s_areas[BenchRandom(a_seed_OUT) % s_numAreas]);
+	}
+	sprintf(a_name_OUT + length, "%s_%s%s", s_words[BenchRandom(a_seed_OUT) % s_numWords], s_words[BenchRandom(a_seed_OUT) % s_numWords], s_extensions[BenchRandom(a_seed_OUT) % s_numExtensions]);
+}
+
+void BenchStringHashes()
+{
+	// All the names are packed into one buffer one after the other like a string table
+	char * corpus = (char *)malloc(s_numStrings * s_maxStringLength);
+	const char ** names = (const char **)malloc(sizeof(const char *) * s_numStrings);
+	if (corpus == NULL || names == NULL)
+	{
+		printf("  Not enough memory\n");
+		free(corpus);
+		free(names);
+		return;
+	}
+
+	unsigned int seed = 0x9e3779b9;
+	unsigned int numBytes = 0;
+	for (unsigned int i = 0; i < s_numStrings; ++i)
+	{
+		char * name = corpus + numBytes;
+		MakeName(seed, name);
+		names[i] = name;
+		numBytes += (unsigned int)strlen(name) + 1;
+	}
+
+	// Both versions have to agree or the timings mean nothing
+	unsigned int numMismatches = 0;
+	for (unsigned int i = 0; i < s_numStrings; ++i)
+	{
+		numMismatches += StringHash::GenerateCRC(names[i], false) != GenerateCRCByteAtATime(names[i]) ? 1 : 0;
+	}
+	printf(" %u names, %u bytes, average length %.1f, %u hashes differ\n", s_numStrings, numBytes, (float)numBytes / s_numStrings - 1.0f, numMismatches);
+
+	double byteMs = 0.0, slicedMs = 0.0, slicedLowerMs = 0.0;
+	for (unsigned int run = 0; run < s_numRuns; ++run)
+	{
+		unsigned int hashes = 0;
+		BenchTimer timer;
+		for (unsigned int i = 0; i < s_numStrings; ++i)
+		{
+			hashes += GenerateCRCByteAtATime(names[i]);
+		}
+		BenchKeepFastest(timer.GetElapsedMs(), byteMs);
+
+		timer.Restart();
+		for (unsigned int i = 0; i < s_numStrings; ++i)
+		{
+			hashes += StringHash::GenerateCRC(names[i], false);
+		}
+		BenchKeepFastest(timer.GetElapsedMs(), slicedMs);
+
+		timer.Restart();
+		for (unsigned int i = 0; i < s_numStrings; ++i)
+		{
+			hashes += StringHash::GenerateCRC(names[i], true);
+		}
+		BenchKeepFastest(timer.GetElapsedMs(), slicedLowerMs);
+		BenchKeep(hashes);
+	}
+
+	BenchReport("One byte at a time", s_numStrings, byteMs);
+	BenchReport("GenerateCRC", s_numStrings, slicedMs);
+	BenchReport("GenerateCRC, converting to lower case", s_numStrings, slicedLowerMs);
+
+	free(corpus);
+	free(names);
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../core/SweepAndPrune.h"
+#include "../core/Vector.h"
+
+#include "../engine/CollisionUtils.h"
+
+#include "Bench.h"
+
+static const unsigned int s_numRuns = 3;			// Each timing is the fastest of this many runs
+static const unsigned int s_numSpheres = 50000;		// How many spheres are moving at once
+static const unsigned int s_numFrames = 60;			// How many updates are timed in each run
+static const float s_worldSize = 500.0f;			// Spheres stay inside a level this wide and deep
+static const float s_worldHeight = 20.0f;			// and this high, most games are spread out over the ground
+static const float s_minRadius = 0.25f;				// Smallest sphere
+static const float s_maxRadius = 0.75f;				// Largest sphere
+static const float s_maxSpeed = 0.5f;				// Furthest a sphere moves in one frame on each axis
+
+typedef SweepAndPrune<unsigned int> SphereBroadphase;
+
+//\brief The spheres being moved around, stored as arrays so the narrowphase can look them up by index
+struct Spheres
+{
+	Vector m_positions[s_numSpheres];
+	Vector m_velocities[s_numSpheres];
+	float m_radii[s_numSpheres];
+	SphereBroadphase::ProxyId m_proxies[s_numSpheres];
+};
+
+//\brief The narrowphase the scene uses for two spheres
+struct SphereOverlap
+{
+	SphereOverlap(const Spheres * a_spheres) : m_spheres(a_spheres) { }
+	inline bool operator()(unsigned int a_sphere1, unsigned int a_sphere2) const
+	{
+		return CollisionUtils::IntersectSphereSphere(m_spheres->m_positions[a_sphere1], m_spheres->m_radii[a_sphere1],
+													 m_spheres->m_positions[a_sphere2], m_spheres->m_radii[a_sphere2]);
+	}
+	const Spheres * m_spheres;
+};
+
+//\brief Accept every pair whose boxes overlap, to see what the narrowphase costs
+struct BoxOverlap
+{
+	inline bool operator()(unsigned int a_sphere1, unsigned int a_sphere2) const { return true; }
+};
+
+//\brief Count pairs the way a scene would report them
+struct CountOverlaps
+{
+	CountOverlaps(unsigned int * a_counts) : m_counts(a_counts) { }
+	inline void operator()(unsigned int a_sphere1, unsigned int a_sphere2, SphereBroadphase::eOverlap a_overlap) const { ++m_counts[a_overlap]; }
+	unsigned int * m_counts;
+};
+
+//\brief Start the spheres off in the same places every run
+static void PlaceSpheres(Spheres & a_spheres)
+{
+	unsigned int seed = 0x51ed27;
+	const float randomScale = 1.0f / 4294967295.0f;
+	for (unsigned int i = 0; i < s_numSpheres; ++i)
+	{
+		a_spheres.m_positions[i] = Vector(BenchRandom(seed) * randomScale * s_worldSize, BenchRandom(seed) * randomScale * s_worldSize, BenchRandom(seed) * randomScale * s_worldHeight);
+		a_spheres.m_velocities[i] = Vector((BenchRandom(seed) * randomScale * 2.0f - 1.0f) * s_maxSpeed, (BenchRandom(seed) * randomScale * 2.0f - 1.0f) * s_maxSpeed, (BenchRandom(seed) * randomScale * 2.0f - 1.0f) * s_maxSpeed);
+		a_spheres.m_radii[i] = s_minRadius + BenchRandom(seed) * randomScale * (s_maxRadius - s_minRadius);
+	}
+}
+
+//\brief Move every sphere, bouncing off the sides of the world, and tell the broadphase where it went
+static void MoveSpheres(Spheres & a_spheres, SphereBroadphase & a_broadphase)
+{
+	for (unsigned int i = 0; i < s_numSpheres; ++i)
+	{
+		Vector & pos = a_spheres.m_positions[i];
+		Vector & vel = a_spheres.m_velocities[i];
+		pos += vel;
+		if (pos.GetX() < 0.0f || pos.GetX() > s_worldSize) { vel.SetX(-vel.GetX()); }
+		if (pos.GetY() < 0.0f || pos.GetY() > s_worldSize) { vel.SetY(-vel.GetY()); }
+		if (pos.GetZ() < 0.0f || pos.GetZ() > s_worldHeight) { vel.SetZ(-vel.GetZ()); }
+
+		const Vector extent(a_spheres.m_radii[i]);
+		a_broadphase.Move(a_spheres.m_proxies[i], pos - extent, pos + extent);
+	}
+}
+
+//\brief Insert every sphere and run the frames
+//\param a_insertMs_OUT, a_moveMs_OUT, a_updateMs_OUT the fastest times for adding the spheres, moving them and updating the broadphase
+//\param a_counts_OUT how many pairs began, stayed and ended over all the frames of the last run
+template <typename TOverlapTest>
+static void TimeFrames(Spheres & a_spheres, const TOverlapTest & a_overlapTest, double & a_insertMs_OUT, double & a_moveMs_OUT, double & a_updateMs_OUT, unsigned int * a_counts_OUT)
+{
+	PlaceSpheres(a_spheres);
+	for (unsigned int i = 0; i < SphereBroadphase::eOverlapCount; ++i)
+	{
+		a_counts_OUT[i] = 0;
+	}
+
+	SphereBroadphase broadphase;
+	BenchTimer timer;
+	for (unsigned int i = 0; i < s_numSpheres; ++i)
+	{
+		const Vector extent(a_spheres.m_radii[i]);
+		a_spheres.m_proxies[i] = broadphase.Insert(i, a_spheres.m_positions[i] - extent, a_spheres.m_positions[i] + extent, true);
+	}
+	broadphase.Update(a_overlapTest, CountOverlaps(a_counts_OUT));
+	BenchKeepFastest(timer.GetElapsedMs(), a_insertMs_OUT);
+
+	double moveMs = 0.0, updateMs = 0.0;
+	for (unsigned int frame = 0; frame < s_numFrames; ++frame)
+	{
+		timer.Restart();
+		MoveSpheres(a_spheres, broadphase);
+		moveMs += timer.GetElapsedMs();
+
+		timer.Restart();
+		BenchKeep(broadphase.Update(a_overlapTest, CountOverlaps(a_counts_OUT)));
+		updateMs += timer.GetElapsedMs();
+	}
+	BenchKeepFastest(moveMs, a_moveMs_OUT);
+	BenchKeepFastest(updateMs, a_updateMs_OUT);
+}
+
+void BenchSweepAndPrune()
+{
+	Spheres * spheres = (Spheres *)malloc(sizeof(Spheres));
+	if (spheres == NULL)
+	{
+		printf("  Not enough memory\n");
+		return;
+	}
+
+	double sphereInsertMs = 0.0, sphereMoveMs = 0.0, sphereUpdateMs = 0.0;
+	double boxInsertMs = 0.0, boxMoveMs = 0.0, boxUpdateMs = 0.0;
+	unsigned int sphereCounts[SphereBroadphase::eOverlapCount];
+	unsigned int boxCounts[SphereBroadphase::eOverlapCount];
+	for (unsigned int run = 0; run < s_numRuns; ++run)
+	{
+		TimeFrames(*spheres, SphereOverlap(spheres), sphereInsertMs, sphereMoveMs, sphereUpdateMs, sphereCounts);
+		TimeFrames(*spheres, BoxOverlap(), boxInsertMs, boxMoveMs, boxUpdateMs, boxCounts);
+	}
+
+	printf(" %u spheres, %u frames\n", s_numSpheres, s_numFrames);
+	printf("  Boxes only:       %u began, %u stayed, %u ended\n", boxCounts[SphereBroadphase::eOverlapBegin], boxCounts[SphereBroadphase::eOverlapStay], boxCounts[SphereBroadphase::eOverlapEnd]);
+	printf("  Sphere overlaps:  %u began, %u stayed, %u ended\n", sphereCounts[SphereBroadphase::eOverlapBegin], sphereCounts[SphereBroadphase::eOverlapStay], sphereCounts[SphereBroadphase::eOverlapEnd]);
+	BenchReport("Insert and first update", s_numSpheres, sphereInsertMs);
+	BenchReport("Move spheres, per frame", s_numSpheres, sphereMoveMs / s_numFrames);
+	BenchReport("Update, boxes only, per frame", s_numSpheres, boxUpdateMs / s_numFrames);
+	BenchReport("Update, sphere narrowphase, per frame", s_numSpheres, sphereUpdateMs / s_numFrames);
+
+	free(spheres);
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "Bench.h"
+
+//\brief A benchmark that can be picked by name from the command line
+struct Benchmark
+{
+	const char * m_name;		///< Passed on the command line to run only this benchmark
+	void (*m_run)();			///< Runs the benchmark and prints the results
+};
+
+static const Benchmark s_benchmarks[] =
+{
+	{ "spawn",		BenchObjectSpawn },
+	{ "hashmap",	BenchHashMaps },
+	{ "crc",		BenchStringHashes },
+	{ "broadphase",	BenchSweepAndPrune },
+	{ "lines",		BenchCollisionKernels },
+	{ "snapshot",	BenchSnapshots },
+};
+static const unsigned int s_numBenchmarks = sizeof(s_benchmarks) / sizeof(s_benchmarks[0]);
+
+static volatile unsigned int s_keepResult = 0;
+
+void BenchReport(const char * a_name, unsigned int a_numItems, double a_timeMs)
+{
+	const double nsPerItem = a_numItems > 0 ? (a_timeMs * 1000000.0) / a_numItems : 0.0;
+	printf("  %-48s %9u items %10.3f ms %10.1f ns/item\n", a_name, a_numItems, a_timeMs, nsPerItem);
+}
+
+void BenchKeep(unsigned int a_result)
+{
+	s_keepResult += a_result;
+}
+
+int main(int argc, char * argv[])
+{
+	// This is a console program for timing the engine's containers and kernels, build it in release.
+	// With no parameters every benchmark is run, otherwise only the ones named.
+	unsigned int numRun = 0;
+	for (unsigned int i = 0; i < s_numBenchmarks; ++i)
+	{
+		bool runBenchmark = argc <= 1;
+		for (int arg = 1; arg < argc && !runBenchmark; ++arg)
+		{
+			runBenchmark = strcmp(argv[arg], s_benchmarks[i].m_name) == 0;
+		}
+
+		if (runBenchmark)
+		{
+			printf("%s\n", s_benchmarks[i].m_name);
+			s_benchmarks[i].m_run();
+			++numRun;
+		}
+	}
+
+	if (numRun == 0)
+	{
+		printf("Usage: bench [name...]\nBenchmarks:");
+		for (unsigned int i = 0; i < s_numBenchmarks; ++i)
+		{
+			printf(" %s", s_benchmarks[i].m_name);
+		}
+		printf("\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,842 @@
+#ifndef _CORE_BOUNDING_VOLUME_HIERARCHY_
+#define _CORE_BOUNDING_VOLUME_HIERARCHY_
+#pragma once
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Vector.h"
+
+//\brief A binary tree of axis aligned boxes for tracing line segments through a set of items without
+//		 testing every item. Leaves hold the items, each with a box that is a little larger than the
+//		 item so small movements don't change the tree at all. When an item does move out of it's box
+//		 only the boxes of it's ancestors are refit, the shape of the tree is kept until Rebuild is called.
+//		 Items are added to the tree next to the sibling that grows the total box area the least.
+//		 The data stored with each item is copied around so use pointers or handles.
+template <typename T>
+class BoundingVolumeHierarchy
+{
+public:
+
+	//\brief Items are referred to by the id of their leaf, which stays the same until the item is removed
+	typedef unsigned int LeafId;
+	static const LeafId s_invalidLeaf = 0xffffffff;
+
+	//\brief Most line segments traced together by TraceNearestPacket, one bit each in the returned mask
+	static const unsigned int s_maxPacketLines = 32;
+
+	//\brief Most items handed to a line test at once, leaves reached by a trace are gathered into batches this big
+	static const unsigned int s_maxLeafBatch = 8;
+
+	//\brief Result of a trace for functions that return more than one hit
+	struct Hit
+	{
+		T m_data;				///< What was stored with the item that was hit
+		float m_fraction;		///< How far along the line the hit is, 0 at the start and 1 at the end
+	};
+
+	BoundingVolumeHierarchy()
+		: m_nodes(NULL)
+		, m_stack(NULL)
+		, m_packetStack(NULL)
+		, m_root(s_invalidNode)
+		, m_firstFreeNode(s_invalidNode)
+		, m_nodeCapacity(0)
+		, m_numLeaves(0)
+		, m_margin(0.0f)
+	{ }
+
+	//\brief Make sure memory is freed if the tree is deleted
+	~BoundingVolumeHierarchy() { Done(); }
+
+	//\brief Set how much bigger than the item each leaf box is
+	//\param a_margin distance in world units an item can move before the tree is refit
+	inline void SetMargin(float a_margin) { m_margin = a_margin; }
+
+	//\brief Release all memory, the tree can be used again afterwards
+	inline void Done()
+	{
+		free(m_nodes);
+		free(m_stack);
+		free(m_packetStack);
+		m_nodes = NULL;
+		m_stack = NULL;
+		m_packetStack = NULL;
+		m_root = s_invalidNode;
+		m_firstFreeNode = s_invalidNode;
+		m_nodeCapacity = 0;
+		m_numLeaves = 0;
+	}
+
+	//\brief Add an item to the tree
+	//\param a_data what to return from traces that hit the item
+	//\param a_min, a_max the corners of the item's bounding box
+	//\return the id of the leaf for the item or s_invalidLeaf if memory could not be allocated
+	inline LeafId Insert(const T & a_data, const Vector & a_min, const Vector & a_max)
+	{
+		const unsigned int leaf = AllocateNode();
+		if (leaf == s_invalidNode)
+		{
+			return s_invalidLeaf;
+		}
+
+		Node & leafNode = m_nodes[leaf];
+		leafNode.m_data = a_data;
+		leafNode.m_min = a_min - m_margin;
+		leafNode.m_max = a_max + m_margin;
+		leafNode.m_child1 = s_invalidNode;
+		leafNode.m_child2 = s_invalidNode;
+		if (!InsertLeaf(leaf))
+		{
+			FreeNode(leaf);
+			return s_invalidLeaf;
+		}
+
+		++m_numLeaves;
+		return leaf;
+	}
+
+	//\brief Add many items to the tree at once. The new items are built into a subtree of their own which
+	//		 is then placed in the tree like a single item, much faster than inserting them one at a time.
+	//\param a_data, a_mins, a_maxs arrays of a_numItems items and the corners of their bounding boxes
+	//\param a_leaves_OUT array of a_numItems ids for the new leaves, in the same order as the items
+	//\return true if every item was added, nothing is added on failure
+	inline bool InsertBatch(const T * a_data, const Vector * a_mins, const Vector * a_maxs, unsigned int a_numItems, LeafId * a_leaves_OUT)
+	{
+		if (a_numItems == 0)
+		{
+			return true;
+		}
+
+		// Every item needs a leaf and a branch, growing once up front means the storage can't move part way through
+		const unsigned int numUsedNodes = m_numLeaves > 0 ? m_numLeaves * 2 - 1 : 0;
+		unsigned int newCapacity = m_nodeCapacity > 0 ? m_nodeCapacity : s_minCapacity;
+		while (newCapacity < numUsedNodes + a_numItems * 2)
+		{
+			newCapacity *= 2;
+		}
+		if (!Grow(newCapacity))
+		{
+			return false;
+		}
+
+		// The traversal stack is free scratch space for building the subtree
+		for (unsigned int i = 0; i < a_numItems; ++i)
+		{
+			const unsigned int leaf = AllocateNode();
+			Node & leafNode = m_nodes[leaf];
+			leafNode.m_data = a_data[i];
+			leafNode.m_min = a_mins[i] - m_margin;
+			leafNode.m_max = a_maxs[i] + m_margin;
+			a_leaves_OUT[i] = leaf;
+			m_stack[i] = leaf;
+		}
+		InsertLeaf(BuildTopDown(m_stack, a_numItems));
+
+		m_numLeaves += a_numItems;
+		return true;
+	}
+
+	//\brief Change the bounds of an item, nothing is done if it is still inside it's leaf box
+	//\param a_leaf the id returned when the item was inserted
+	//\return true if the leaf box changed and the ancestors were refit
+	inline bool Move(LeafId a_leaf, const Vector & a_min, const Vector & a_max)
+	{
+		if (!IsValid(a_leaf))
+		{
+			return false;
+		}
+
+		Node & leafNode = m_nodes[a_leaf];
+		if (Contains(leafNode.m_min, leafNode.m_max, a_min, a_max))
+		{
+			return false;
+		}
+
+		leafNode.m_min = a_min - m_margin;
+		leafNode.m_max = a_max + m_margin;
+		Refit(leafNode.m_parent);
+		return true;
+	}
+
+	//\brief Take an item out of the tree, the id may be handed out again by a later insert
+	//\return true if the id referred to an item in the tree
+	inline bool Remove(LeafId a_leaf)
+	{
+		if (!IsValid(a_leaf))
+		{
+			return false;
+		}
+
+		RemoveLeaf(a_leaf);
+		FreeNode(a_leaf);
+		--m_numLeaves;
+		return true;
+	}
+
+	//\brief Throw away the shape of the tree and build it again from the current leaf boxes, best done
+	//		 after a large number of items have been added or moved a long way from where they started.
+	//		 Leaf ids are kept so callers don't need to be told about it.
+	inline void Rebuild()
+	{
+		if (m_numLeaves < 2)
+		{
+			return;
+		}
+
+		// Gather all the leaves and return every internal node to the free list
+		unsigned int numLeaves = 0;
+		for (unsigned int i = 0; i < m_nodeCapacity; ++i)
+		{
+			if (m_nodes[i].m_height == 0)
+			{
+				m_stack[numLeaves++] = i;
+			}
+			else if (m_nodes[i].m_height > 0)
+			{
+				FreeNode(i);
+			}
+		}
+
+		// Enough nodes are free for all the internal nodes as the tree had them before
+		m_root = BuildTopDown(m_stack, numLeaves);
+		m_nodes[m_root].m_parent = s_invalidNode;
+	}
+
+	//\brief Find the closest item along a line segment
+	//\param a_lineStart, a_lineEnd the line to trace
+	//\param a_test is called as a_test(data, numItems, lineStart, lineEnd, hits_OUT, fractions_OUT) on batches of
+	//		 up to s_maxLeafBatch items the line reaches so the items can be tested together. For each item it sets
+	//		 the hit flag if the line touches the item and if so how far along the line it is.
+	//\param a_hit_OUT is set to the data and distance of the closest item hit
+	//\return true if anything was hit
+	template <typename LineTest>
+	inline bool TraceNearest(const Vector & a_lineStart, const Vector & a_lineEnd, const LineTest & a_test, Hit & a_hit_OUT)
+	{
+		if (m_root == s_invalidNode)
+		{
+			return false;
+		}
+
+		Vector invDir;
+		GetInverseDirection(a_lineStart, a_lineEnd, invDir);
+
+		// Leaves are tested in batches, the closest hit so far is only updated when a batch is full so a few
+		// more branches may be visited than if each leaf was tested as soon as it was reached
+		T leafBatch[s_maxLeafBatch];
+		unsigned int numLeaves = 0;
+		bool hitAnything = false;
+		float closestFraction = FLT_MAX;
+		unsigned int stackSize = 0;
+		m_stack[stackSize++] = m_root;
+		while (stackSize > 0)
+		{
+			const Node & node = m_nodes[m_stack[--stackSize]];
+			if (node.IsLeaf())
+			{
+				leafBatch[numLeaves++] = node.m_data;
+				if (numLeaves == s_maxLeafBatch)
+				{
+					hitAnything |= TestLeafBatch(leafBatch, numLeaves, a_lineStart, a_lineEnd, a_test, closestFraction, a_hit_OUT);
+					numLeaves = 0;
+				}
+				continue;
+			}
+
+			// Visit the nearer child first so far away branches get skipped once something is hit
+			float entry1 = 0.0f, entry2 = 0.0f;
+			const bool hit1 = IntersectLineBox(a_lineStart, invDir, m_nodes[node.m_child1], entry1) && entry1 < closestFraction;
+			const bool hit2 = IntersectLineBox(a_lineStart, invDir, m_nodes[node.m_child2], entry2) && entry2 < closestFraction;
+			if (hit1 && hit2)
+			{
+				const bool firstIsNearer = entry1 <= entry2;
+				m_stack[stackSize++] = firstIsNearer ? node.m_child2 : node.m_child1;
+				m_stack[stackSize++] = firstIsNearer ? node.m_child1 : node.m_child2;
+			}
+			else if (hit1)
+			{
+				m_stack[stackSize++] = node.m_child1;
+			}
+			else if (hit2)
+			{
+				m_stack[stackSize++] = node.m_child2;
+			}
+		}
+
+		if (numLeaves > 0)
+		{
+			hitAnything |= TestLeafBatch(leafBatch, numLeaves, a_lineStart, a_lineEnd, a_test, closestFraction, a_hit_OUT);
+		}
+		return hitAnything;
+	}
+
+	//\brief Find every item along a line segment, in no particular order
+	//\param a_hits_OUT pointer to caller supplied storage for the hits
+	//\param a_maxHits how many hits will fit in the storage, the trace stops when it is full
+	//\return the number of hits written
+	template <typename LineTest>
+	inline unsigned int TraceAll(const Vector & a_lineStart, const Vector & a_lineEnd, const LineTest & a_test, Hit * a_hits_OUT, unsigned int a_maxHits)
+	{
+		if (m_root == s_invalidNode || a_maxHits == 0)
+		{
+			return 0;
+		}
+
+		Vector invDir;
+		GetInverseDirection(a_lineStart, a_lineEnd, invDir);
+
+		T leafBatch[s_maxLeafBatch];
+		unsigned int numLeaves = 0;
+		unsigned int numHits = 0;
+		unsigned int stackSize = 0;
+		m_stack[stackSize++] = m_root;
+		while (stackSize > 0 && numHits < a_maxHits)
+		{
+			const Node & node = m_nodes[m_stack[--stackSize]];
+			float fraction = 1.0f;
+			if (!IntersectLineBox(a_lineStart, invDir, node, fraction))
+			{
+				continue;
+			}
+
+			if (node.IsLeaf())
+			{
+				leafBatch[numLeaves++] = node.m_data;
+				if (numLeaves == s_maxLeafBatch)
+				{
+					numHits += TestLeafBatch(leafBatch, numLeaves, a_lineStart, a_lineEnd, a_test, a_hits_OUT + numHits, a_maxHits - numHits);
+					numLeaves = 0;
+				}
+			}
+			else
+			{
+				m_stack[stackSize++] = node.m_child1;
+				m_stack[stackSize++] = node.m_child2;
+			}
+		}
+
+		if (numLeaves > 0 && numHits < a_maxHits)
+		{
+			numHits += TestLeafBatch(leafBatch, numLeaves, a_lineStart, a_lineEnd, a_test, a_hits_OUT + numHits, a_maxHits - numHits);
+		}
+		return numHits;
+	}
+
+	//\brief Find the closest item along each of a packet of line segments in one walk of the tree. Each
+	//		 node is fetched once for the whole packet and only the lines that reach it carry on below it,
+	//		 so lines that start near each other and head the same way share most of the traversal.
+	//\param a_lineStarts, a_lineEnds arrays of a_numLines lines, no more than s_maxPacketLines
+	//\param a_test is called on batches of items for each line like TraceNearest
+	//\param a_hits_OUT array of a_numLines hits, only set for the lines that hit something
+	//\return a mask with bit i set if line i hit anything
+	template <typename LineTest>
+	inline unsigned int TraceNearestPacket(const Vector * a_lineStarts, const Vector * a_lineEnds, unsigned int a_numLines, const LineTest & a_test, Hit * a_hits_OUT)
+	{
+		if (m_root == s_invalidNode || a_numLines == 0 || a_numLines > s_maxPacketLines)
+		{
+			return 0;
+		}
+
+		Vector invDirs[s_maxPacketLines];
+		float closestFractions[s_maxPacketLines];
+		for (unsigned int i = 0; i < a_numLines; ++i)
+		{
+			GetInverseDirection(a_lineStarts[i], a_lineEnds[i], invDirs[i]);
+			closestFractions[i] = FLT_MAX;
+		}
+
+		// Each line gathers it's own batch of leaves to test
+		T leafBatches[s_maxPacketLines][s_maxLeafBatch];
+		unsigned int numLeaves[s_maxPacketLines];
+		memset(numLeaves, 0, sizeof(numLeaves));
+
+		// Each entry on the stack is a node and the mask of lines that reached it
+		unsigned int hitLines = 0;
+		unsigned int stackSize = 0;
+		m_stack[stackSize] = m_root;
+		m_packetStack[stackSize++] = a_numLines < s_maxPacketLines ? (1u << a_numLines) - 1 : 0xffffffff;
+		while (stackSize > 0)
+		{
+			--stackSize;
+			const Node & node = m_nodes[m_stack[stackSize]];
+			const unsigned int lines = m_packetStack[stackSize];
+			if (node.IsLeaf())
+			{
+				for (unsigned int i = 0; i < a_numLines; ++i)
+				{
+					if ((lines & (1u << i)) == 0)
+					{
+						continue;
+					}
+					leafBatches[i][numLeaves[i]++] = node.m_data;
+					if (numLeaves[i] == s_maxLeafBatch)
+					{
+						if (TestLeafBatch(leafBatches[i], numLeaves[i], a_lineStarts[i], a_lineEnds[i], a_test, closestFractions[i], a_hits_OUT[i]))
+						{
+							hitLines |= 1u << i;
+						}
+						numLeaves[i] = 0;
+					}
+				}
+				continue;
+			}
+
+			// Split the lines between the children, skipping lines that have already hit something nearer
+			unsigned int lines1 = 0, lines2 = 0;
+			float nearest1 = FLT_MAX, nearest2 = FLT_MAX;
+			for (unsigned int i = 0; i < a_numLines; ++i)
+			{
+				if ((lines & (1u << i)) == 0)
+				{
+					continue;
+				}
+				float entry = 0.0f;
+				if (IntersectLineBox(a_lineStarts[i], invDirs[i], m_nodes[node.m_child1], entry) && entry < closestFractions[i])
+				{
+					lines1 |= 1u << i;
+					nearest1 = entry < nearest1 ? entry : nearest1;
+				}
+				if (IntersectLineBox(a_lineStarts[i], invDirs[i], m_nodes[node.m_child2], entry) && entry < closestFractions[i])
+				{
+					lines2 |= 1u << i;
+					nearest2 = entry < nearest2 ? entry : nearest2;
+				}
+			}
+
+			// Visit the child the packet reaches first next so far away branches are more likely to be skipped
+			const bool firstIsNearer = nearest1 <= nearest2;
+			const unsigned int nearChild = firstIsNearer ? node.m_child1 : node.m_child2;
+			const unsigned int farChild = firstIsNearer ? node.m_child2 : node.m_child1;
+			const unsigned int nearLines = firstIsNearer ? lines1 : lines2;
+			const unsigned int farLines = firstIsNearer ? lines2 : lines1;
+			if (farLines != 0)
+			{
+				m_stack[stackSize] = farChild;
+				m_packetStack[stackSize++] = farLines;
+			}
+			if (nearLines != 0)
+			{
+				m_stack[stackSize] = nearChild;
+				m_packetStack[stackSize++] = nearLines;
+			}
+		}
+
+		for (unsigned int i = 0; i < a_numLines; ++i)
+		{
+			if (numLeaves[i] > 0 && TestLeafBatch(leafBatches[i], numLeaves[i], a_lineStarts[i], a_lineEnds[i], a_test, closestFractions[i], a_hits_OUT[i]))
+			{
+				hitLines |= 1u << i;
+			}
+		}
+		return hitLines;
+	}
+
+	//\brief Accessors for items in the tree
+	inline bool IsValid(LeafId a_leaf) const { return a_leaf < m_nodeCapacity && m_nodes[a_leaf].m_height == 0; }
+	inline const T & GetData(LeafId a_leaf) const { return m_nodes[a_leaf].m_data; }
+	inline unsigned int GetNumLeaves() const { return m_numLeaves; }
+	inline unsigned int GetHeight() const { return m_root != s_invalidNode ? m_nodes[m_root].m_height : 0; }
+
+private:
+
+	//\brief The tree is not copyable as it owns it's memory
+	BoundingVolumeHierarchy(const BoundingVolumeHierarchy &);
+	BoundingVolumeHierarchy & operator=(const BoundingVolumeHierarchy &);
+
+	static const unsigned int s_invalidNode = 0xffffffff;	///< End of the free list or a missing child or parent
+	static const int s_freeNodeHeight = -1;					///< Height of a node that is not in use
+	static const unsigned int s_minCapacity = 64;			///< How many nodes to allocate on first use
+
+	//\brief Leaves have no children and store data, branches have two children
+	struct Node
+	{
+		inline bool IsLeaf() const { return m_child1 == s_invalidNode; }
+
+		Vector m_min;					///< Bounding box corners enclosing everything below this node
+		Vector m_max;
+		T m_data;						///< What the user stored, leaves only
+		unsigned int m_parent;			///< Parent node or the next free node when not in use
+		unsigned int m_child1;			///< Children of a branch
+		unsigned int m_child2;
+		int m_height;					///< 0 for leaves, one more than the tallest child for branches, -1 when free
+	};
+
+	//\brief Grow the node storage and link the new nodes onto the front of the free list
+	//\param a_newCapacity how many nodes there should be storage for, nothing is done if there already is
+	//\return false if memory could not be allocated
+	inline bool Grow(unsigned int a_newCapacity)
+	{
+		if (a_newCapacity <= m_nodeCapacity)
+		{
+			return true;
+		}
+
+		const unsigned int oldCapacity = m_nodeCapacity;
+		Node * newNodes = (Node *)realloc(m_nodes, sizeof(Node) * a_newCapacity);
+		if (newNodes == NULL)
+		{
+			return false;
+		}
+		m_nodes = newNodes;
+
+		// Traversal never holds more nodes than the tree has
+		unsigned int * newStack = (unsigned int *)realloc(m_stack, sizeof(unsigned int) * a_newCapacity);
+		if (newStack == NULL)
+		{
+			return false;
+		}
+		m_stack = newStack;
+
+		unsigned int * newPacketStack = (unsigned int *)realloc(m_packetStack, sizeof(unsigned int) * a_newCapacity);
+		if (newPacketStack == NULL)
+		{
+			return false;
+		}
+		m_packetStack = newPacketStack;
+
+		for (unsigned int i = oldCapacity; i < a_newCapacity; ++i)
+		{
+			m_nodes[i].m_parent = i + 1 < a_newCapacity ? i + 1 : m_firstFreeNode;
+			m_nodes[i].m_height = s_freeNodeHeight;
+		}
+		m_firstFreeNode = oldCapacity;
+		m_nodeCapacity = a_newCapacity;
+		return true;
+	}
+
+	//\brief Take a node from the free list, growing the storage if there are none
+	inline unsigned int AllocateNode()
+	{
+		if (m_firstFreeNode == s_invalidNode && !Grow(m_nodeCapacity > 0 ? m_nodeCapacity * 2 : s_minCapacity))
+		{
+			return s_invalidNode;
+		}
+
+		const unsigned int node = m_firstFreeNode;
+		m_firstFreeNode = m_nodes[node].m_parent;
+		m_nodes[node].m_parent = s_invalidNode;
+		m_nodes[node].m_child1 = s_invalidNode;
+		m_nodes[node].m_child2 = s_invalidNode;
+		m_nodes[node].m_height = 0;
+		return node;
+	}
+
+	//\brief Return a node to the free list
+	inline void FreeNode(unsigned int a_node)
+	{
+		m_nodes[a_node].m_parent = m_firstFreeNode;
+		m_nodes[a_node].m_height = s_freeNodeHeight;
+		m_firstFreeNode = a_node;
+	}
+
+	//\brief Run a line test on a batch of leaves and keep the closest hit
+	//\param a_closestFraction_OUT the closest hit so far, hits further along the line are ignored
+	//\return true if the closest hit is from this batch
+	template <typename LineTest>
+	static inline bool TestLeafBatch(const T * a_leafData, unsigned int a_numLeaves, const Vector & a_lineStart, const Vector & a_lineEnd, const LineTest & a_test, float & a_closestFraction_OUT, Hit & a_hit_OUT)
+	{
+		bool hits[s_maxLeafBatch];
+		float fractions[s_maxLeafBatch];
+		a_test(a_leafData, a_numLeaves, a_lineStart, a_lineEnd, hits, fractions);
+
+		bool hitAnything = false;
+		for (unsigned int i = 0; i < a_numLeaves; ++i)
+		{
+			if (hits[i] && fractions[i] < a_closestFraction_OUT)
+			{
+				a_closestFraction_OUT = fractions[i];
+				a_hit_OUT.m_data = a_leafData[i];
+				a_hit_OUT.m_fraction = fractions[i];
+				hitAnything = true;
+			}
+		}
+		return hitAnything;
+	}
+
+	//\brief Run a line test on a batch of leaves and write out every hit
+	//\param a_maxHits how many hits will fit in the storage, any more are dropped
+	//\return the number of hits written
+	template <typename LineTest>
+	static inline unsigned int TestLeafBatch(const T * a_leafData, unsigned int a_numLeaves, const Vector & a_lineStart, const Vector & a_lineEnd, const LineTest & a_test, Hit * a_hits_OUT, unsigned int a_maxHits)
+	{
+		bool hits[s_maxLeafBatch];
+		float fractions[s_maxLeafBatch];
+		a_test(a_leafData, a_numLeaves, a_lineStart, a_lineEnd, hits, fractions);
+
+		unsigned int numHits = 0;
+		for (unsigned int i = 0; i < a_numLeaves && numHits < a_maxHits; ++i)
+		{
+			if (hits[i])
+			{
+				a_hits_OUT[numHits].m_data = a_leafData[i];
+				a_hits_OUT[numHits].m_fraction = fractions[i];
+				++numHits;
+			}
+		}
+		return numHits;
+	}
+
+	//\brief Box helpers
+	static inline float GetArea(const Vector & a_min, const Vector & a_max)
+	{
+		const Vector size = a_max - a_min;
+		return 2.0f * (size.GetX() * size.GetY() + size.GetY() * size.GetZ() + size.GetZ() * size.GetX());
+	}
+	static inline Vector Min(const Vector & a_a, const Vector & a_b)
+	{
+		return Vector(a_a.GetX() < a_b.GetX() ? a_a.GetX() : a_b.GetX(), a_a.GetY() < a_b.GetY() ? a_a.GetY() : a_b.GetY(), a_a.GetZ() < a_b.GetZ() ? a_a.GetZ() : a_b.GetZ());
+	}
+	static inline Vector Max(const Vector & a_a, const Vector & a_b)
+	{
+		return Vector(a_a.GetX() > a_b.GetX() ? a_a.GetX() : a_b.GetX(), a_a.GetY() > a_b.GetY() ? a_a.GetY() : a_b.GetY(), a_a.GetZ() > a_b.GetZ() ? a_a.GetZ() : a_b.GetZ());
+	}
+	static inline bool Contains(const Vector & a_outerMin, const Vector & a_outerMax, const Vector & a_innerMin, const Vector & a_innerMax)
+	{
+		return	a_outerMin.GetX() <= a_innerMin.GetX() && a_outerMin.GetY() <= a_innerMin.GetY() && a_outerMin.GetZ() <= a_innerMin.GetZ() &&
+				a_outerMax.GetX() >= a_innerMax.GetX() && a_outerMax.GetY() >= a_innerMax.GetY() && a_outerMax.GetZ() >= a_innerMax.GetZ();
+	}
+
+	//\brief Read one component of a vector, 0 to 2 for x to z
+	static inline float GetAxis(const Vector & a_vec, unsigned int a_axis)
+	{
+		return a_axis == 0 ? a_vec.GetX() : (a_axis == 1 ? a_vec.GetY() : a_vec.GetZ());
+	}
+
+	//\brief One over each component of the line direction, infinite for components that are zero
+	static inline void GetInverseDirection(const Vector & a_lineStart, const Vector & a_lineEnd, Vector & a_invDir_OUT)
+	{
+		const Vector dir = a_lineEnd - a_lineStart;
+		a_invDir_OUT = Vector(	dir.GetX() != 0.0f ? 1.0f / dir.GetX() : FLT_MAX,
+								dir.GetY() != 0.0f ? 1.0f / dir.GetY() : FLT_MAX,
+								dir.GetZ() != 0.0f ? 1.0f / dir.GetZ() : FLT_MAX);
+	}
+
+	//\brief Slab test of a line segment against a node's box
+	//\param a_entry_OUT how far along the line it enters the box, 0 if it starts inside
+	static inline bool IntersectLineBox(const Vector & a_lineStart, const Vector & a_invDir, const Node & a_node, float & a_entry_OUT)
+	{
+		float entry = 0.0f;
+		float exit = 1.0f;
+		for (unsigned int axis = 0; axis < 3; ++axis)
+		{
+			const float start = GetAxis(a_lineStart, axis);
+			const float invDir = GetAxis(a_invDir, axis);
+			const float boxMin = GetAxis(a_node.m_min, axis);
+			const float boxMax = GetAxis(a_node.m_max, axis);
+			if (invDir == FLT_MAX)
+			{
+				// Parallel to the slab so it has to start between the planes
+				if (start < boxMin || start > boxMax)
+				{
+					return false;
+				}
+				continue;
+			}
+
+			float entryAxis = (boxMin - start) * invDir;
+			float exitAxis = (boxMax - start) * invDir;
+			if (entryAxis > exitAxis)
+			{
+				const float temp = entryAxis;
+				entryAxis = exitAxis;
+				exitAxis = temp;
+			}
+			entry = entryAxis > entry ? entryAxis : entry;
+			exit = exitAxis < exit ? exitAxis : exit;
+			if (entry > exit)
+			{
+				return false;
+			}
+		}
+
+		a_entry_OUT = entry;
+		return true;
+	}
+
+	//\brief Recalculate the boxes and heights of a node and all it's ancestors
+	inline void Refit(unsigned int a_node)
+	{
+		while (a_node != s_invalidNode)
+		{
+			Node & node = m_nodes[a_node];
+			const Node & child1 = m_nodes[node.m_child1];
+			const Node & child2 = m_nodes[node.m_child2];
+			node.m_min = Min(child1.m_min, child2.m_min);
+			node.m_max = Max(child1.m_max, child2.m_max);
+			node.m_height = 1 + (child1.m_height > child2.m_height ? child1.m_height : child2.m_height);
+			a_node = node.m_parent;
+		}
+	}
+
+	//\brief Place a leaf in the tree next to the node that makes the boxes grow the least
+	inline bool InsertLeaf(unsigned int a_leaf)
+	{
+		if (m_root == s_invalidNode)
+		{
+			m_root = a_leaf;
+			m_nodes[a_leaf].m_parent = s_invalidNode;
+			return true;
+		}
+
+		// Walk down the tree choosing the cheapest child each time
+		const Vector leafMin = m_nodes[a_leaf].m_min;
+		const Vector leafMax = m_nodes[a_leaf].m_max;
+		unsigned int sibling = m_root;
+		while (!m_nodes[sibling].IsLeaf())
+		{
+			const Node & node = m_nodes[sibling];
+			const float area = GetArea(node.m_min, node.m_max);
+			const float combinedArea = GetArea(Min(node.m_min, leafMin), Max(node.m_max, leafMax));
+
+			// Cost of making a new parent for this node and the leaf, and the cost pushed down to the children
+			const float cost = 2.0f * combinedArea;
+			const float inheritanceCost = 2.0f * (combinedArea - area);
+			const float cost1 = GetDescendCost(node.m_child1, leafMin, leafMax) + inheritanceCost;
+			const float cost2 = GetDescendCost(node.m_child2, leafMin, leafMax) + inheritanceCost;
+			if (cost < cost1 && cost < cost2)
+			{
+				break;
+			}
+			sibling = cost1 < cost2 ? node.m_child1 : node.m_child2;
+		}
+
+		// New branch takes the sibling's place
+		const unsigned int newParent = AllocateNode();
+		if (newParent == s_invalidNode)
+		{
+			return false;
+		}
+		const unsigned int oldParent = m_nodes[sibling].m_parent;
+		m_nodes[newParent].m_parent = oldParent;
+		m_nodes[newParent].m_child1 = sibling;
+		m_nodes[newParent].m_child2 = a_leaf;
+		m_nodes[sibling].m_parent = newParent;
+		m_nodes[a_leaf].m_parent = newParent;
+		if (oldParent != s_invalidNode)
+		{
+			if (m_nodes[oldParent].m_child1 == sibling)
+			{
+				m_nodes[oldParent].m_child1 = newParent;
+			}
+			else
+			{
+				m_nodes[oldParent].m_child2 = newParent;
+			}
+		}
+		else
+		{
+			m_root = newParent;
+		}
+
+		Refit(newParent);
+		return true;
+	}
+
+	//\brief How much it costs to put a leaf somewhere below a node
+	inline float GetDescendCost(unsigned int a_node, const Vector & a_leafMin, const Vector & a_leafMax) const
+	{
+		const Node & node = m_nodes[a_node];
+		const float combinedArea = GetArea(Min(node.m_min, a_leafMin), Max(node.m_max, a_leafMax));
+		return node.IsLeaf() ? combinedArea : combinedArea - GetArea(node.m_min, node.m_max);
+	}
+
+	//\brief Unlink a leaf from the tree, it's sibling takes the place of their parent
+	inline void RemoveLeaf(unsigned int a_leaf)
+	{
+		if (a_leaf == m_root)
+		{
+			m_root = s_invalidNode;
+			return;
+		}
+
+		const unsigned int parent = m_nodes[a_leaf].m_parent;
+		const unsigned int grandParent = m_nodes[parent].m_parent;
+		const unsigned int sibling = m_nodes[parent].m_child1 == a_leaf ? m_nodes[parent].m_child2 : m_nodes[parent].m_child1;
+		if (grandParent != s_invalidNode)
+		{
+			if (m_nodes[grandParent].m_child1 == parent)
+			{
+				m_nodes[grandParent].m_child1 = sibling;
+			}
+			else
+			{
+				m_nodes[grandParent].m_child2 = sibling;
+			}
+			m_nodes[sibling].m_parent = grandParent;
+			Refit(grandParent);
+		}
+		else
+		{
+			m_root = sibling;
+			m_nodes[sibling].m_parent = s_invalidNode;
+		}
+		FreeNode(parent);
+	}
+
+	//\brief Build a subtree from a set of leaves by splitting them at the middle of the longest axis of their centres
+	//\return the root of the new subtree
+	inline unsigned int BuildTopDown(unsigned int * a_leaves, unsigned int a_numLeaves)
+	{
+		if (a_numLeaves == 1)
+		{
+			return a_leaves[0];
+		}
+
+		// Bounds of the leaf centres decide where to split
+		Vector centreMin(FLT_MAX);
+		Vector centreMax(-FLT_MAX);
+		for (unsigned int i = 0; i < a_numLeaves; ++i)
+		{
+			const Node & leaf = m_nodes[a_leaves[i]];
+			const Vector centre = (leaf.m_min + leaf.m_max) * 0.5f;
+			centreMin = Min(centreMin, centre);
+			centreMax = Max(centreMax, centre);
+		}
+		const Vector extent = centreMax - centreMin;
+		unsigned int axis = extent.GetX() > extent.GetY() ? 0 : 1;
+		axis = GetAxis(extent, axis) > extent.GetZ() ? axis : 2;
+		const float split = (GetAxis(centreMin, axis) + GetAxis(centreMax, axis)) * 0.5f;
+
+		// Partition the leaves either side of the split, all on one side means they are stacked so split in half
+		unsigned int numLeft = 0;
+		for (unsigned int i = 0; i < a_numLeaves; ++i)
+		{
+			const Node & leaf = m_nodes[a_leaves[i]];
+			if ((GetAxis(leaf.m_min, axis) + GetAxis(leaf.m_max, axis)) * 0.5f < split)
+			{
+				const unsigned int temp = a_leaves[numLeft];
+				a_leaves[numLeft++] = a_leaves[i];
+				a_leaves[i] = temp;
+			}
+		}
+		if (numLeft == 0 || numLeft == a_numLeaves)
+		{
+			numLeft = a_numLeaves / 2;
+		}
+
+		const unsigned int branch = AllocateNode();
+		const unsigned int child1 = BuildTopDown(a_leaves, numLeft);
+		const unsigned int child2 = BuildTopDown(a_leaves + numLeft, a_numLeaves - numLeft);
+		m_nodes[branch].m_child1 = child1;
+		m_nodes[branch].m_child2 = child2;
+		m_nodes[child1].m_parent = branch;
+		m_nodes[child2].m_parent = branch;
+		m_nodes[branch].m_min = Min(m_nodes[child1].m_min, m_nodes[child2].m_min);
+		m_nodes[branch].m_max = Max(m_nodes[child1].m_max, m_nodes[child2].m_max);
+		m_nodes[branch].m_height = 1 + (m_nodes[child1].m_height > m_nodes[child2].m_height ? m_nodes[child1].m_height : m_nodes[child2].m_height);
+		return branch;
+	}
+
+	Node * m_nodes;						///< Storage for every node, leaves and branches
+	unsigned int * m_stack;				///< Scratch space for traversals and rebuilding, as big as the node storage
+	unsigned int * m_packetStack;		///< Which lines of a packet reached each node on the traversal stack
+	unsigned int m_root;				///< Top of the tree
+	unsigned int m_firstFreeNode;		///< Head of the list of unused nodes
+	unsigned int m_nodeCapacity;		///< How many nodes there is storage for
+	unsigned int m_numLeaves;			///< How many items are in the tree
+	float m_margin;						///< How much each leaf box is grown by so small movements don't refit
+};
+
+#endif // _CORE_BOUNDING_VOLUME_HIERARCHY_
@@ -0,0 +1,159 @@
+#ifndef _CORE_FLOAT4_
+#define _CORE_FLOAT4_
+#pragma once
+
+// SSE is used when the compiler targets it, define CORE_NO_SIMD to force the scalar version
+#if !defined(CORE_NO_SIMD) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__))
+	#define CORE_SIMD_SSE 1
+	#include <xmmintrin.h>
+#else
+	#include <math.h>
+#endif
+
+//\brief Four floats operated on together, the building block for the matrix and quaternion math.
+//		 Backed by an SSE register where available and plain floats otherwise, the results are the
+//		 same either way. Loads and stores are unaligned so any float array can be used as a source.
+class Float4
+{
+public:
+
+	// Constructors
+	inline Float4() { }
+	inline Float4(float a_x, float a_y, float a_z, float a_w)
+	{
+#ifdef CORE_SIMD_SSE
+		m_val = _mm_setr_ps(a_x, a_y, a_z, a_w);
+#else
+		m_val[0] = a_x; m_val[1] = a_y; m_val[2] = a_z; m_val[3] = a_w;
+#endif
+	}
+
+	//\brief Create with the same value in every component
+	static inline Float4 Splat(float a_val)
+	{
+#ifdef CORE_SIMD_SSE
+		return Float4(_mm_set1_ps(a_val));
+#else
+		return Float4(a_val, a_val, a_val, a_val);
+#endif
+	}
+
+	//\brief Read and write four floats from memory, no alignment required
+	static inline Float4 Load(const float * a_src)
+	{
+#ifdef CORE_SIMD_SSE
+		return Float4(_mm_loadu_ps(a_src));
+#else
+		return Float4(a_src[0], a_src[1], a_src[2], a_src[3]);
+#endif
+	}
+	inline void Store(float * a_dest_OUT) const
+	{
+#ifdef CORE_SIMD_SSE
+		_mm_storeu_ps(a_dest_OUT, m_val);
+#else
+		a_dest_OUT[0] = m_val[0]; a_dest_OUT[1] = m_val[1]; a_dest_OUT[2] = m_val[2]; a_dest_OUT[3] = m_val[3];
+#endif
+	}
+
+	//\brief Build a new Float4 from any combination of this one's components, indices are 0 to 3 for x to w
+	template <int X, int Y, int Z, int W>
+	inline Float4 Swizzle() const
+	{
+#ifdef CORE_SIMD_SSE
+		return Float4(_mm_shuffle_ps(m_val, m_val, _MM_SHUFFLE(W, Z, Y, X)));
+#else
+		return Float4(m_val[X], m_val[Y], m_val[Z], m_val[W]);
+#endif
+	}
+
+	//\brief Broadcast a single component into every component
+	template <int I>
+	inline Float4 Broadcast() const { return Swizzle<I, I, I, I>(); }
+
+	//\brief Component access, slow path for SIMD so keep it out of inner loops
+	inline float GetX() const { float vals[4]; Store(vals); return vals[0]; }
+	inline float GetY() const { float vals[4]; Store(vals); return vals[1]; }
+	inline float GetZ() const { float vals[4]; Store(vals); return vals[2]; }
+	inline float GetW() const { float vals[4]; Store(vals); return vals[3]; }
+
+	//\brief Sum of all four products
+	inline float Dot(const Float4 & a_val) const
+	{
+		float vals[4];
+		(*this * a_val).Store(vals);
+		return vals[0] + vals[1] + vals[2] + vals[3];
+	}
+
+	//\brief One bit per component, set when the component is less than zero, x in the lowest bit
+	inline int GetNegativeMask() const
+	{
+#ifdef CORE_SIMD_SSE
+		return _mm_movemask_ps(_mm_cmplt_ps(m_val, _mm_setzero_ps()));
+#else
+		return (m_val[0] < 0.0f ? 1 : 0) | (m_val[1] < 0.0f ? 2 : 0) | (m_val[2] < 0.0f ? 4 : 0) | (m_val[3] < 0.0f ? 8 : 0);
+#endif
+	}
+
+	//\brief Smaller or larger of each pair of components
+	static inline Float4 Min(const Float4 & a_val1, const Float4 & a_val2)
+	{
+#ifdef CORE_SIMD_SSE
+		return Float4(_mm_min_ps(a_val1.m_val, a_val2.m_val));
+#else
+		return Float4(	a_val1.m_val[0] < a_val2.m_val[0] ? a_val1.m_val[0] : a_val2.m_val[0], a_val1.m_val[1] < a_val2.m_val[1] ? a_val1.m_val[1] : a_val2.m_val[1],
+						a_val1.m_val[2] < a_val2.m_val[2] ? a_val1.m_val[2] : a_val2.m_val[2], a_val1.m_val[3] < a_val2.m_val[3] ? a_val1.m_val[3] : a_val2.m_val[3]);
+#endif
+	}
+	static inline Float4 Max(const Float4 & a_val1, const Float4 & a_val2)
+	{
+#ifdef CORE_SIMD_SSE
+		return Float4(_mm_max_ps(a_val1.m_val, a_val2.m_val));
+#else
+		return Float4(	a_val1.m_val[0] > a_val2.m_val[0] ? a_val1.m_val[0] : a_val2.m_val[0], a_val1.m_val[1] > a_val2.m_val[1] ? a_val1.m_val[1] : a_val2.m_val[1],
+						a_val1.m_val[2] > a_val2.m_val[2] ? a_val1.m_val[2] : a_val2.m_val[2], a_val1.m_val[3] > a_val2.m_val[3] ? a_val1.m_val[3] : a_val2.m_val[3]);
+#endif
+	}
+
+	//\brief Square root of each component
+	static inline Float4 Sqrt(const Float4 & a_val)
+	{
+#ifdef CORE_SIMD_SSE
+		return Float4(_mm_sqrt_ps(a_val.m_val));
+#else
+		return Float4(sqrtf(a_val.m_val[0]), sqrtf(a_val.m_val[1]), sqrtf(a_val.m_val[2]), sqrtf(a_val.m_val[3]));
+#endif
+	}
+
+	//\brief Multiply two values and add a third, the core of every transform
+	static inline Float4 MulAdd(const Float4 & a_mul1, const Float4 & a_mul2, const Float4 & a_add)
+	{
+		return (a_mul1 * a_mul2) + a_add;
+	}
+
+	// Operator overloads
+#ifdef CORE_SIMD_SSE
+	inline Float4 operator + (const Float4 & a_val) const { return Float4(_mm_add_ps(m_val, a_val.m_val)); }
+	inline Float4 operator - (const Float4 & a_val) const { return Float4(_mm_sub_ps(m_val, a_val.m_val)); }
+	inline Float4 operator * (const Float4 & a_val) const { return Float4(_mm_mul_ps(m_val, a_val.m_val)); }
+	inline Float4 operator * (float a_scale) const { return Float4(_mm_mul_ps(m_val, _mm_set1_ps(a_scale))); }
+#else
+	inline Float4 operator + (const Float4 & a_val) const { return Float4(m_val[0] + a_val.m_val[0], m_val[1] + a_val.m_val[1], m_val[2] + a_val.m_val[2], m_val[3] + a_val.m_val[3]); }
+	inline Float4 operator - (const Float4 & a_val) const { return Float4(m_val[0] - a_val.m_val[0], m_val[1] - a_val.m_val[1], m_val[2] - a_val.m_val[2], m_val[3] - a_val.m_val[3]); }
+	inline Float4 operator * (const Float4 & a_val) const { return Float4(m_val[0] * a_val.m_val[0], m_val[1] * a_val.m_val[1], m_val[2] * a_val.m_val[2], m_val[3] * a_val.m_val[3]); }
+	inline Float4 operator * (float a_scale) const { return Float4(m_val[0] * a_scale, m_val[1] * a_scale, m_val[2] * a_scale, m_val[3] * a_scale); }
+#endif
+	inline void operator += (const Float4 & a_val) { *this = *this + a_val; }
+	inline void operator -= (const Float4 & a_val) { *this = *this - a_val; }
+
+private:
+
+#ifdef CORE_SIMD_SSE
+	explicit inline Float4(__m128 a_val) : m_val(a_val) { }
+	__m128 m_val;			///< All four components in a register
+#else
+	float m_val[4];			///< Components in x, y, z, w order
+#endif
+};
+
+#endif // _CORE_FLOAT4_
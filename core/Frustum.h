@@ -0,0 +1,167 @@
+#ifndef _CORE_FRUSTUM_
+#define _CORE_FRUSTUM_
+#pragma once
+
+#include <math.h>
+
+#include "Float4.h"
+#include "Matrix.h"
+#include "Vector.h"
+
+//\brief The six planes bounding what a camera can see, for rejecting objects before they are
+//		 sent to be rendered. Plane normals point into the frustum. Volumes are tested four at a
+//		 time with Float4 and the test is conservative, a volume near a corner of the frustum may
+//		 be reported as visible when it is not but a visible volume is never rejected.
+class Frustum
+{
+public:
+
+	//\brief A volume to test, a box grown by a radius covers spheres, axis aligned boxes and points
+	struct Volume
+	{
+		Vector m_centre;		///< Middle of the volume in world space
+		Vector m_halfSize;		///< Half the size of the box part of the volume in x,y,z order, zero for spheres
+		float m_radius;			///< Radius of the sphere part of the volume, zero for boxes
+	};
+
+	//\brief Planes in the order they are stored
+	enum ePlane
+	{
+		ePlaneLeft = 0,
+		ePlaneRight,
+		ePlaneBottom,
+		ePlaneTop,
+		ePlaneNear,
+		ePlaneFar,
+
+		ePlaneCount,
+	};
+
+	Frustum() { }
+
+	//\brief Create from a combined world to clip space matrix
+	//\param a_viewProjection the view matrix multiplied by the projection matrix
+	Frustum(const Matrix & a_viewProjection) { Set(a_viewProjection); }
+
+	//\brief Extract the planes from the columns of a world to clip space matrix
+	//\param a_viewProjection the view matrix multiplied by the projection matrix
+	inline void Set(const Matrix & a_viewProjection)
+	{
+		// A point is inside when each clip coordinate is between -w and w
+		for (unsigned int axis = 0; axis < 3; ++axis)
+		{
+			for (unsigned int i = 0; i < 4; ++i)
+			{
+				const float clipW = a_viewProjection.GetValue(i, 3);
+				const float clipAxis = a_viewProjection.GetValue(i, axis);
+				m_planes[axis * 2][i] = clipW + clipAxis;
+				m_planes[(axis * 2) + 1][i] = clipW - clipAxis;
+			}
+		}
+
+		// Normalise so distances to the planes are in world units
+		for (unsigned int i = 0; i < ePlaneCount; ++i)
+		{
+			float * plane = m_planes[i];
+			const float length = sqrtf((plane[0] * plane[0]) + (plane[1] * plane[1]) + (plane[2] * plane[2]));
+			if (length > 0.0f)
+			{
+				const float invLength = 1.0f / length;
+				plane[0] *= invLength;
+				plane[1] *= invLength;
+				plane[2] *= invLength;
+				plane[3] *= invLength;
+			}
+		}
+	}
+
+	//\brief Test a single volume
+	//\return true if any part of the volume may be inside the frustum
+	inline bool Test(const Volume & a_volume) const
+	{
+		for (unsigned int i = 0; i < ePlaneCount; ++i)
+		{
+			const float * plane = m_planes[i];
+			const float distance = (plane[0] * a_volume.m_centre.GetX()) + (plane[1] * a_volume.m_centre.GetY()) + (plane[2] * a_volume.m_centre.GetZ()) + plane[3];
+			const float reach = (fabsf(plane[0]) * a_volume.m_halfSize.GetX()) + (fabsf(plane[1]) * a_volume.m_halfSize.GetY()) + (fabsf(plane[2]) * a_volume.m_halfSize.GetZ()) + a_volume.m_radius;
+			if (distance + reach < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//\brief Test many volumes, four at a time
+	//\param a_volumes pointer to the volumes to test
+	//\param a_numVolumes how many volumes are in the input and output arrays
+	//\param a_visible_OUT pointer to storage for a flag per volume, true if any part of the volume may be inside
+	//\return how many of the volumes may be inside the frustum
+	inline unsigned int TestBatch(const Volume * a_volumes, unsigned int a_numVolumes, bool * a_visible_OUT) const
+	{
+		// Plane components stay in registers for the whole batch
+		Float4 planeX[ePlaneCount], planeY[ePlaneCount], planeZ[ePlaneCount], planeW[ePlaneCount];
+		Float4 absPlaneX[ePlaneCount], absPlaneY[ePlaneCount], absPlaneZ[ePlaneCount];
+		for (unsigned int i = 0; i < ePlaneCount; ++i)
+		{
+			planeX[i] = Float4::Splat(m_planes[i][0]);
+			planeY[i] = Float4::Splat(m_planes[i][1]);
+			planeZ[i] = Float4::Splat(m_planes[i][2]);
+			planeW[i] = Float4::Splat(m_planes[i][3]);
+			absPlaneX[i] = Float4::Splat(fabsf(m_planes[i][0]));
+			absPlaneY[i] = Float4::Splat(fabsf(m_planes[i][1]));
+			absPlaneZ[i] = Float4::Splat(fabsf(m_planes[i][2]));
+		}
+
+		unsigned int numVisible = 0;
+		for (unsigned int first = 0; first < a_numVolumes; first += 4)
+		{
+			// Spare lanes at the end repeat the last volume and their results are ignored
+			const unsigned int numLanes = a_numVolumes - first < 4 ? a_numVolumes - first : 4;
+			const Volume & v0 = a_volumes[first];
+			const Volume & v1 = a_volumes[first + (numLanes > 1 ? 1 : 0)];
+			const Volume & v2 = a_volumes[first + (numLanes > 2 ? 2 : numLanes - 1)];
+			const Volume & v3 = a_volumes[first + numLanes - 1];
+
+			// Swap the volumes around so each Float4 holds the same component of four volumes
+			const Float4 centreX(v0.m_centre.GetX(), v1.m_centre.GetX(), v2.m_centre.GetX(), v3.m_centre.GetX());
+			const Float4 centreY(v0.m_centre.GetY(), v1.m_centre.GetY(), v2.m_centre.GetY(), v3.m_centre.GetY());
+			const Float4 centreZ(v0.m_centre.GetZ(), v1.m_centre.GetZ(), v2.m_centre.GetZ(), v3.m_centre.GetZ());
+			const Float4 halfSizeX(v0.m_halfSize.GetX(), v1.m_halfSize.GetX(), v2.m_halfSize.GetX(), v3.m_halfSize.GetX());
+			const Float4 halfSizeY(v0.m_halfSize.GetY(), v1.m_halfSize.GetY(), v2.m_halfSize.GetY(), v3.m_halfSize.GetY());
+			const Float4 halfSizeZ(v0.m_halfSize.GetZ(), v1.m_halfSize.GetZ(), v2.m_halfSize.GetZ(), v3.m_halfSize.GetZ());
+			const Float4 radius(v0.m_radius, v1.m_radius, v2.m_radius, v3.m_radius);
+
+			// A volume is outside if it is entirely behind any plane
+			int outsideMask = 0;
+			for (unsigned int i = 0; i < ePlaneCount; ++i)
+			{
+				Float4 distance = Float4::MulAdd(planeX[i], centreX, planeW[i] + radius);
+				distance = Float4::MulAdd(planeY[i], centreY, distance);
+				distance = Float4::MulAdd(planeZ[i], centreZ, distance);
+				distance = Float4::MulAdd(absPlaneX[i], halfSizeX, distance);
+				distance = Float4::MulAdd(absPlaneY[i], halfSizeY, distance);
+				distance = Float4::MulAdd(absPlaneZ[i], halfSizeZ, distance);
+				outsideMask |= distance.GetNegativeMask();
+			}
+
+			for (unsigned int lane = 0; lane < numLanes; ++lane)
+			{
+				const bool visible = (outsideMask & (1 << lane)) == 0;
+				a_visible_OUT[first + lane] = visible;
+				numVisible += visible ? 1 : 0;
+			}
+		}
+
+		return numVisible;
+	}
+
+	//\brief Access a plane as the normal in x,y,z and the distance in w
+	inline const float * GetPlane(ePlane a_plane) const { return m_planes[a_plane]; }
+
+private:
+
+	float m_planes[ePlaneCount][4];	///< Each plane as a normal and distance, a point p is inside when normal.p + distance >= 0
+};
+
+#endif // _CORE_FRUSTUM_
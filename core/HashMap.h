@@ -2,83 +2,350 @@
 #define _CORE_HASH_MAP_
 #pragma once
 
-#include <unordered_map>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
 
-//\brief This is a wrapper to an STL unordered map which is not in keeping with the ideals
-//		 of this project as being roll-your-own-everything but I need one NOW!
-template <class Key, class T>
+//\brief Default hash for integral keys, the map scrambles the bits so the key can be returned as is
+template <class Key>
+struct HashMapHash
+{
+	inline unsigned int operator()(const Key & a_key) const { return (unsigned int)a_key; }
+};
+
+//\brief Default storage for a hash map comes from the heap, supply a type with the same
+//		 two static functions as the last template parameter to allocate from elsewhere
+struct HashMapAllocator
+{
+	static inline void * Allocate(size_t a_sizeBytes) { return malloc(a_sizeBytes); }
+	static inline void Free(void * a_ptr) { free(a_ptr); }
+};
+
+//\brief An open addressing hash map using Robin Hood hashing. Keys, values and probe lengths are
+//		 each stored in their own flat array in a single allocation so a lookup only touches a couple
+//		 of cache lines and there is no allocation per entry. On insert, entries that are further from
+//		 their ideal slot steal the place of entries that are closer, which keeps probe lengths short
+//		 and lets a lookup stop as soon as it passes where the key would have been.
+//		 Iteration is done with Iterator objects so any number of loops can run at once, but inserting
+//		 or removing while iterating will invalidate them.
+template <class Key, class T, class Hasher = HashMapHash<Key>, class Allocator = HashMapAllocator>
 class HashMap
 {
 public:
 
-	HashMap() : m_iteratorValid(false) {}
+	//\brief Iterator to walk every entry in the map in storage order
+	class Iterator
+	{
+	public:
+
+		Iterator() : m_map(NULL), m_index(0) {}
+		Iterator(HashMap * a_map, unsigned int a_index) : m_map(a_map), m_index(a_index) { SkipEmpty(); }
+
+		inline void operator++() { ++m_index; SkipEmpty(); }
+		inline void operator++(int) { ++m_index; SkipEmpty(); }
+		inline bool operator==(const Iterator & a_other) const { return m_map == a_other.m_map && m_index == a_other.m_index; }
+		inline bool operator!=(const Iterator & a_other) const { return !(*this == a_other); }
+
+		//\brief Accessors for the entry the iterator is on, only valid when not at the end
+		inline const Key & GetKey() const { return m_map->m_keys[m_index]; }
+		inline T & GetValue() const { return m_map->m_values[m_index]; }
+
+	private:
+
+		//\brief Advance past any empty slots or stop at the end
+		inline void SkipEmpty()
+		{
+			while (m_index < m_map->m_capacity && m_map->m_probeLengths[m_index] == 0)
+			{
+				++m_index;
+			}
+		}
+
+		HashMap * m_map;			///< Map being iterated
+		unsigned int m_index;		///< Slot the iterator is on, capacity for the end
+	};
+
+	HashMap()
+		: m_memory(NULL)
+		, m_probeLengths(NULL)
+		, m_keys(NULL)
+		, m_values(NULL)
+		, m_capacity(0)
+		, m_count(0)
+		, m_shift(32)
+	{ }
+
+	//\brief Make sure all entries are destructed and memory freed if the map is deleted
+	~HashMap() { Clear(); Allocator::Free(m_memory); }
 
 	//\brief Search for an element in the map
 	//\param a_key the identifier for the item to look for
 	//\param a_value_OUT is a ref to and itme to populate if found
 	//\return true if the item was found and a_value_OUT will be modified
-	bool Get(Key a_key, T & a_value_OUT)  
+	inline bool Get(const Key & a_key, T & a_value_OUT) const
 	{
-		std::unordered_map<Key, T>::const_iterator got = m_map.find(a_key);
-		if (got != m_map.end())
+		const unsigned int index = FindIndex(a_key);
+		if (index != s_notFound)
 		{
-			a_value_OUT = got->second;
+			a_value_OUT = m_values[index];
 			return true;
 		}
-		else
+		return false;
+	}
+
+	//\brief Search for an element without copying it
+	//\return a pointer to the value stored in the map or NULL if not found, invalid after the next insert or remove
+	inline T * Find(const Key & a_key)
+	{
+		const unsigned int index = FindIndex(a_key);
+		return index != s_notFound ? &m_values[index] : NULL;
+	}
+	inline bool Contains(const Key & a_key) const { return FindIndex(a_key) != s_notFound; }
+
+	//\brief Add an element to the map, an existing element with the same key is left alone
+	//\param a_key the unique way to identify the object
+	//\param a_data the object to insert
+	//\return true if the element was added, false if the key was already present or memory could not be allocated
+	inline bool Insert(const Key & a_key, const T & a_data)
+	{
+		if (FindIndex(a_key) != s_notFound)
 		{
 			return false;
 		}
+
+		// Grow before the map gets too full for probe lengths to stay short
+		if ((m_count + 1) * s_maxLoadDenominator > m_capacity * s_maxLoadNumerator)
+		{
+			if (!Rehash(m_capacity == 0 ? s_minCapacity : m_capacity * 2))
+			{
+				return false;
+			}
+		}
+
+		return InsertNew(a_key, a_data);
 	}
 
-	//\brief Add an element to the map
-	//\param a_key the unique way to identify the object
-	//\param a_data the object to insert
-	void Insert(Key a_key, T a_data) 
+	//\brief Remove an element from the map
+	//\return true if the key was found and removed
+	inline bool Remove(const Key & a_key)
 	{
-		std::pair<Key, T> toInsert(a_key, a_data);
-		m_map.insert(toInsert); 
+		unsigned int index = FindIndex(a_key);
+		if (index == s_notFound)
+		{
+			return false;
+		}
+
+		// Shift following entries back a slot until one is found in it's ideal place, no tombstones needed
+		m_keys[index].~Key();
+		m_values[index].~T();
+		unsigned int next = (index + 1) & (m_capacity - 1);
+		while (m_probeLengths[next] > 1)
+		{
+			new (&m_keys[index]) Key(m_keys[next]);
+			new (&m_values[index]) T(m_values[next]);
+			m_probeLengths[index] = m_probeLengths[next] - 1;
+			m_keys[next].~Key();
+			m_values[next].~T();
+
+			index = next;
+			next = (next + 1) & (m_capacity - 1);
+		}
+		m_probeLengths[index] = 0;
+		--m_count;
+
+		return true;
 	}
 
-	//\brief Iterator like functionality
-	bool GetNext(T & a_value_OUT)
+	//\brief Remove all elements, memory is kept for reuse
+	inline void Clear()
 	{
-		// Early out for no objects
-		if (m_map.size() == 0)
+		for (unsigned int i = 0; i < m_capacity; ++i)
+		{
+			if (m_probeLengths[i] != 0)
+			{
+				m_keys[i].~Key();
+				m_values[i].~T();
+				m_probeLengths[i] = 0;
+			}
+		}
+		m_count = 0;
+	}
+
+	//\brief Make sure the map can hold a number of elements without growing
+	//\param a_numElements how many elements are expected in the map
+	//\return true if the map already had room or memory was allocated
+	inline bool Reserve(unsigned int a_numElements)
+	{
+		unsigned int newCapacity = s_minCapacity;
+		while (newCapacity * s_maxLoadNumerator < a_numElements * s_maxLoadDenominator)
+		{
+			newCapacity *= 2;
+		}
+		return newCapacity <= m_capacity || Rehash(newCapacity);
+	}
+
+	//\brief Reallocate the storage at a new size and reinsert every element
+	//\param a_capacity the number of slots which will be rounded up to a power of two and must fit all elements
+	//\return true if the memory was allocated
+	inline bool Rehash(unsigned int a_capacity)
+	{
+		// Round up to a power of two so the ideal slot is taken from the top bits of the hash
+		unsigned int newCapacity = s_minCapacity;
+		unsigned int newShift = 32 - s_minCapacityBits;
+		while (newCapacity < a_capacity || newCapacity * s_maxLoadNumerator < m_count * s_maxLoadDenominator)
+		{
+			newCapacity *= 2;
+			--newShift;
+		}
+
+		// One allocation for all three arrays, each starting on an aligned boundary
+		const size_t probeBytes = AlignSize(sizeof(unsigned char) * newCapacity);
+		const size_t keyBytes = AlignSize(sizeof(Key) * newCapacity);
+		const size_t valueBytes = AlignSize(sizeof(T) * newCapacity);
+		unsigned char * newMemory = (unsigned char *)Allocator::Allocate(probeBytes + keyBytes + valueBytes);
+		if (newMemory == NULL)
 		{
 			return false;
 		}
 
-		// Unititialised iterator
-		if (!m_iteratorValid)
+		// Swap the new storage in then reinsert everything from the old
+		unsigned char * oldMemory = m_memory;
+		unsigned char * oldProbeLengths = m_probeLengths;
+		Key * oldKeys = m_keys;
+		T * oldValues = m_values;
+		const unsigned int oldCapacity = m_capacity;
+
+		m_memory = newMemory;
+		m_probeLengths = newMemory;
+		m_keys = (Key *)(newMemory + probeBytes);
+		m_values = (T *)(newMemory + probeBytes + keyBytes);
+		m_capacity = newCapacity;
+		m_shift = newShift;
+		m_count = 0;
+		memset(m_probeLengths, 0, sizeof(unsigned char) * newCapacity);
+
+		for (unsigned int i = 0; i < oldCapacity; ++i)
 		{
-			m_mapIt = m_map.begin();
-			a_value_OUT = m_mapIt->second;
-			m_iteratorValid = true;
-			return true;
+			if (oldProbeLengths[i] != 0)
+			{
+				InsertNew(oldKeys[i], oldValues[i]);
+				oldKeys[i].~Key();
+				oldValues[i].~T();
+			}
 		}
-		else // Elements after the first
+
+		Allocator::Free(oldMemory);
+		return true;
+	}
+
+	//\brief Iteration over every element
+	inline Iterator Begin() { return Iterator(this, 0); }
+	inline Iterator End() { return Iterator(this, m_capacity); }
+
+	//\brief Informational functions
+	inline unsigned int GetCount() const { return m_count; }
+	inline unsigned int GetCapacity() const { return m_capacity; }
+	inline bool IsEmpty() const { return m_count == 0; }
+
+private:
+
+	//\brief The map is not copyable as it owns it's memory
+	HashMap(const HashMap &);
+	HashMap & operator=(const HashMap &);
+
+	static const unsigned int s_notFound = 0xffffffff;		///< Returned from FindIndex for a missing key
+	static const unsigned int s_minCapacityBits = 4;		///< Smallest table is 16 slots
+	static const unsigned int s_minCapacity = 1 << s_minCapacityBits;
+	static const unsigned int s_maxLoadNumerator = 7;		///< Grow when the map is more than 7/8ths full
+	static const unsigned int s_maxLoadDenominator = 8;
+	static const unsigned int s_maxProbeLength = 0xff;		///< Probe lengths are stored in a byte, grow if one would overflow
+	static const unsigned int s_fibonacciMultiplier = 2654435769u;	///< 2^32 / golden ratio, scrambles the hash so sequential keys spread out
+
+	//\brief Round a size up to keep each array aligned
+	static inline size_t AlignSize(size_t a_sizeBytes) { return (a_sizeBytes + 15) & ~((size_t)15); }
+
+	//\brief Where a key would be with no collisions
+	inline unsigned int GetIdealIndex(const Key & a_key) const
+	{
+		return (Hasher()(a_key) * s_fibonacciMultiplier) >> m_shift;
+	}
+
+	//\brief Walk from the ideal slot until the key is found or an entry closer to home is passed
+	//\return the slot index of the key or s_notFound
+	inline unsigned int FindIndex(const Key & a_key) const
+	{
+		if (m_count == 0)
 		{
-			++m_mapIt;
-			if (m_mapIt != m_map.end())
+			return s_notFound;
+		}
+
+		unsigned int index = GetIdealIndex(a_key);
+		unsigned int probeLength = 1;
+		while (m_probeLengths[index] >= probeLength)
+		{
+			if (m_probeLengths[index] == probeLength && m_keys[index] == a_key)
 			{
-				a_value_OUT = m_mapIt->second;
+				return index;
+			}
+			++probeLength;
+			index = (index + 1) & (m_capacity - 1);
+		}
+		return s_notFound;
+	}
+
+	//\brief Place a key that is known not to be in the map, there must be room for it
+	inline bool InsertNew(const Key & a_key, const T & a_data)
+	{
+		Key key(a_key);
+		T value(a_data);
+		unsigned int index = GetIdealIndex(key);
+		unsigned int probeLength = 1;
+		while (true)
+		{
+			// Empty slot ends the insert
+			if (m_probeLengths[index] == 0)
+			{
+				new (&m_keys[index]) Key(key);
+				new (&m_values[index]) T(value);
+				m_probeLengths[index] = (unsigned char)probeLength;
+				++m_count;
 				return true;
 			}
-			else // Reached the end
+
+			// Take from the rich, the entry closer to it's ideal slot moves along instead
+			if (m_probeLengths[index] < probeLength)
 			{
-				// Invalidate to be sure the next iteration fails
-				m_iteratorValid = false;
-				return false;
+				Key tempKey(m_keys[index]);
+				T tempValue(m_values[index]);
+				unsigned int tempProbeLength = m_probeLengths[index];
+				m_keys[index] = key;
+				m_values[index] = value;
+				m_probeLengths[index] = (unsigned char)probeLength;
+				key = tempKey;
+				value = tempValue;
+				probeLength = tempProbeLength;
+			}
+
+			++probeLength;
+			index = (index + 1) & (m_capacity - 1);
+
+			// Pathological clustering, make more room and place whatever entry is in hand
+			if (probeLength >= s_maxProbeLength)
+			{
+				return Rehash(m_capacity * 2) && InsertNew(key, value);
 			}
 		}
 	}
 
-private:
+	unsigned char * m_memory;			///< Single allocation holding all the arrays
+	unsigned char * m_probeLengths;		///< Distance from the ideal slot plus one for each slot, 0 means empty
+	Key * m_keys;						///< Keys for each slot
+	T * m_values;						///< Values for each slot
+	unsigned int m_capacity;			///< Number of slots, always a power of two
+	unsigned int m_count;				///< How many slots are in use
+	unsigned int m_shift;				///< How far to shift the scrambled hash to get a slot index
 
-	typename std::unordered_map<Key, T> m_map;						// The underlying evil STL map
-	typename std::unordered_map<Key, T>::const_iterator m_mapIt;		// Iterator to a map, prefix with typename because we are inside a template class
-	bool m_iteratorValid;
+	friend class Iterator;
 };
 
-#endif //_CORE_HASH_MAP
\ No newline at end of file
+#endif //_CORE_HASH_MAP
@@ -0,0 +1,508 @@
+#ifndef _CORE_JOB_SYSTEM_
+#define _CORE_JOB_SYSTEM_
+#pragma once
+
+#include <intrin.h>
+#include <windows.h>
+
+//\brief A pool of worker threads that run small jobs. Each thread has it's own queue that it adds to and
+//		 takes from at one end while idle threads steal from the other end, so threads only contend when
+//		 one runs out of work. The thread that calls Startup gets a queue too and runs jobs while it waits
+//		 for them to finish instead of sleeping. Jobs can only be added from that thread or from inside
+//		 other jobs, anywhere else they are run straight away.
+//		 A counter passed with a job counts it until it finishes, so a group of jobs can be waited on
+//		 together or used as the dependency for a later job which won't start until the counter is zero.
+class JobSystem
+{
+public:
+
+	//\brief Signatures of functions that can be run as jobs
+	typedef void (*JobFunction)(void * a_data);
+	typedef void (*RangeFunction)(void * a_data, unsigned int a_start, unsigned int a_end);
+
+	//\brief Tracks how many jobs in a group are yet to finish
+	class Counter
+	{
+	public:
+		Counter() : m_count(0) { }
+		inline bool IsDone() const { return m_count == 0; }
+		inline unsigned int GetCount() const { return (unsigned int)m_count; }
+
+	private:
+		friend class JobSystem;
+		volatile LONG m_count;	///< Jobs added with this counter that have not finished
+	};
+
+	static const unsigned int s_maxWorkers = 63;				///< Most worker threads that can be started, on top of the main thread
+	static const unsigned int s_numWorkersAuto = 0xffffffff;	///< Start one worker for each core other than the one the main thread uses
+	static const unsigned int s_invalidThread = 0xffffffff;		///< Thread index of a thread outside the system
+
+	JobSystem()
+		: m_queues(NULL)
+		, m_wakeSemaphore(NULL)
+		, m_tlsIndex(TLS_OUT_OF_INDEXES)
+		, m_numWorkers(0)
+		, m_numSleeping(0)
+		, m_numDeferred(0)
+		, m_running(false)
+	{ }
+
+	//\brief Make sure the threads are stopped if the system is deleted
+	~JobSystem() { Shutdown(); }
+
+	//\brief Start the worker threads, the calling thread becomes the main thread of the system
+	//\param a_numWorkers how many threads to start, s_numWorkersAuto for one per spare core
+	//\return true if the system is running, when there are no workers jobs are run as they are added
+	inline bool Startup(unsigned int a_numWorkers = s_numWorkersAuto)
+	{
+		if (m_running)
+		{
+			return false;
+		}
+
+		if (a_numWorkers == s_numWorkersAuto)
+		{
+			const unsigned int numCores = GetNumCores();
+			a_numWorkers = numCores > 1 ? numCores - 1 : 0;
+		}
+		m_numWorkers = a_numWorkers < s_maxWorkers ? a_numWorkers : s_maxWorkers;
+		m_numSleeping = 0;
+		m_numDeferred = 0;
+
+		m_tlsIndex = TlsAlloc();
+		m_queues = new WorkQueue[m_numWorkers + 1];
+		m_wakeSemaphore = CreateSemaphore(NULL, 0, s_maxSemaphoreCount, NULL);
+		if (m_tlsIndex == TLS_OUT_OF_INDEXES || m_wakeSemaphore == NULL)
+		{
+			Cleanup();
+			return false;
+		}
+		InitializeCriticalSection(&m_deferredLock);
+		TlsSetValue(m_tlsIndex, (LPVOID)1);
+		m_running = true;
+
+		// Queue 0 belongs to the main thread so workers start from 1
+		for (unsigned int i = 0; i < m_numWorkers; ++i)
+		{
+			m_workers[i].m_system = this;
+			m_workers[i].m_queueIndex = i + 1;
+			m_threads[i] = CreateThread(NULL, 0, WorkerThread, &m_workers[i], 0, NULL);
+			if (m_threads[i] == NULL)
+			{
+				m_numWorkers = i;
+				break;
+			}
+		}
+
+		return true;
+	}
+
+	//\brief Stop and wait for all the worker threads, any jobs still queued are not run
+	inline void Shutdown()
+	{
+		if (!m_running)
+		{
+			return;
+		}
+
+		m_running = false;
+		if (m_numWorkers > 0)
+		{
+			ReleaseSemaphore(m_wakeSemaphore, m_numWorkers, NULL);
+			WaitForMultipleObjects(m_numWorkers, m_threads, TRUE, INFINITE);
+			for (unsigned int i = 0; i < m_numWorkers; ++i)
+			{
+				CloseHandle(m_threads[i]);
+			}
+		}
+
+		DeleteCriticalSection(&m_deferredLock);
+		TlsSetValue(m_tlsIndex, NULL);
+		Cleanup();
+	}
+
+	//\brief Queue a function to be run on any thread
+	//\param a_function the function to call with a_data
+	//\param a_counter optional counter that includes the job until it finishes
+	//\param a_dependency optional counter that must reach zero before the job starts
+	inline void AddJob(JobFunction a_function, void * a_data, Counter * a_counter = NULL, const Counter * a_dependency = NULL)
+	{
+		Job job;
+		job.m_function = a_function;
+		job.m_rangeFunction = NULL;
+		job.m_data = a_data;
+		job.m_start = 0;
+		job.m_end = 0;
+		job.m_counter = a_counter;
+		AddJob(job, a_dependency);
+	}
+
+	//\brief Run a function over a range of indices split into jobs
+	//\param a_function is called with a_data and a start and end index, the end is not included
+	//\param a_count how many indices there are in total starting at 0
+	//\param a_batchSize how many indices each job covers, 0 to split the range evenly between threads
+	//\param a_counter optional counter that includes every job from the range until it finishes
+	//\param a_dependency optional counter that must reach zero before any job from the range starts
+	inline void ParallelFor(RangeFunction a_function, void * a_data, unsigned int a_count, unsigned int a_batchSize = 0, Counter * a_counter = NULL, const Counter * a_dependency = NULL)
+	{
+		if (a_batchSize == 0)
+		{
+			// A few jobs per thread so the ones that finish early can steal the rest
+			const unsigned int numJobs = (m_numWorkers + 1) * s_jobsPerThread;
+			a_batchSize = a_count > numJobs ? (a_count + numJobs - 1) / numJobs : 1;
+		}
+
+		Job job;
+		job.m_function = NULL;
+		job.m_rangeFunction = a_function;
+		job.m_data = a_data;
+		job.m_counter = a_counter;
+		for (unsigned int start = 0; start < a_count; start += a_batchSize)
+		{
+			job.m_start = start;
+			job.m_end = a_count - start > a_batchSize ? start + a_batchSize : a_count;
+			AddJob(job, a_dependency);
+		}
+	}
+
+	//\brief Run queued jobs on the calling thread until every job counted by a counter has finished
+	inline void Wait(const Counter & a_counter)
+	{
+		const unsigned int queueIndex = GetQueueIndex();
+		while (!a_counter.IsDone())
+		{
+			Job job;
+			if (queueIndex != s_invalidThread && FindJob(queueIndex, job))
+			{
+				Execute(job);
+			}
+			else
+			{
+				YieldProcessor();
+			}
+		}
+	}
+
+	//\brief Accessors for the state of the system
+	inline bool IsRunning() const { return m_running; }
+	inline unsigned int GetNumWorkers() const { return m_numWorkers; }
+	inline unsigned int GetNumThreads() const { return m_numWorkers + 1; }
+
+	//\brief Which of the system's threads is calling, for indexing per thread data
+	//\return 0 for the main thread, 1 upwards for workers or s_invalidThread for any other thread
+	inline unsigned int GetThreadIndex() const { return GetQueueIndex(); }
+
+	//\brief Ask the OS how many logical processors there are
+	static inline unsigned int GetNumCores()
+	{
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		return systemInfo.dwNumberOfProcessors > 0 ? systemInfo.dwNumberOfProcessors : 1;
+	}
+
+private:
+
+	//\brief The system is not copyable as it owns threads
+	JobSystem(const JobSystem &);
+	JobSystem & operator=(const JobSystem &);
+
+	static const unsigned int s_queueSize = 1024;				///< Jobs each thread can have queued, must be a power of two
+	static const unsigned int s_maxDeferredJobs = 256;			///< Jobs that can be waiting on a dependency at once
+	static const unsigned int s_jobsPerThread = 4;				///< How many jobs an evenly split range makes for each thread
+	static const unsigned int s_spinCount = 1024;				///< Attempts to find work before a worker sleeps
+	static const LONG s_maxSemaphoreCount = 0x7fffffff;
+
+	//\brief A function and the arguments to call it with
+	struct Job
+	{
+		JobFunction m_function;				///< Function for a single job, NULL for part of a range
+		RangeFunction m_rangeFunction;		///< Function for part of a range
+		void * m_data;						///< Passed to the function
+		unsigned int m_start;				///< Indices for part of a range
+		unsigned int m_end;
+		Counter * m_counter;				///< Counter to decrement when the job finishes
+	};
+
+	//\brief A job that can't be queued until a counter reaches zero
+	struct DeferredJob
+	{
+		Job m_job;
+		const Counter * m_dependency;
+	};
+
+	//\brief Fixed size work stealing queue. The owning thread pushes and pops at the bottom
+	//		 while other threads steal from the top, only taking the last job needs a compare exchange.
+	class WorkQueue
+	{
+	public:
+
+		WorkQueue() : m_top(0), m_bottom(0) { }
+
+		//\brief Add a job at the bottom, only called by the owning thread
+		//\return false if the queue is full
+		inline bool Push(const Job & a_job)
+		{
+			const LONG bottom = m_bottom;
+			if (bottom - m_top >= (LONG)s_queueSize)
+			{
+				return false;
+			}
+			m_jobs[bottom & (s_queueSize - 1)] = a_job;
+			_WriteBarrier();
+			m_bottom = bottom + 1;
+			return true;
+		}
+
+		//\brief Take the most recently added job, only called by the owning thread
+		inline bool Pop(Job & a_job_OUT)
+		{
+			const LONG bottom = m_bottom - 1;
+			m_bottom = bottom;
+			MemoryBarrier();
+			const LONG top = m_top;
+			if (top > bottom)
+			{
+				m_bottom = bottom + 1;
+				return false;
+			}
+
+			a_job_OUT = m_jobs[bottom & (s_queueSize - 1)];
+			if (top == bottom)
+			{
+				// Last job so race any thieves for it
+				const bool won = InterlockedCompareExchange(&m_top, top + 1, top) == top;
+				m_bottom = bottom + 1;
+				return won;
+			}
+			return true;
+		}
+
+		//\brief Take the oldest job, called by any other thread
+		inline bool Steal(Job & a_job_OUT)
+		{
+			const LONG top = m_top;
+			_ReadBarrier();
+			const LONG bottom = m_bottom;
+			if (top >= bottom)
+			{
+				return false;
+			}
+
+			a_job_OUT = m_jobs[top & (s_queueSize - 1)];
+			return InterlockedCompareExchange(&m_top, top + 1, top) == top;
+		}
+
+	private:
+
+		volatile LONG m_top;				///< Next job to steal
+		char m_padding[64];					///< Keep thieves and the owner off each other's cache line
+		volatile LONG m_bottom;				///< Where the next job is pushed
+		Job m_jobs[s_queueSize];
+	};
+
+	//\brief Passed to each worker thread on creation
+	struct WorkerContext
+	{
+		JobSystem * m_system;
+		unsigned int m_queueIndex;
+	};
+
+	//\brief Entry point for worker threads, runs jobs until the system shuts down
+	static DWORD WINAPI WorkerThread(LPVOID a_context)
+	{
+		WorkerContext * context = (WorkerContext *)a_context;
+		JobSystem * system = context->m_system;
+		const unsigned int queueIndex = context->m_queueIndex;
+		TlsSetValue(system->m_tlsIndex, (LPVOID)(size_t)(queueIndex + 1));
+
+		unsigned int spins = 0;
+		while (system->m_running)
+		{
+			Job job;
+			if (system->FindJob(queueIndex, job))
+			{
+				system->Execute(job);
+				spins = 0;
+				continue;
+			}
+
+			if (++spins < s_spinCount)
+			{
+				YieldProcessor();
+				continue;
+			}
+
+			// Announce the sleep before the last look so a job added in between will wake us
+			InterlockedIncrement(&system->m_numSleeping);
+			if (system->FindJob(queueIndex, job))
+			{
+				InterlockedDecrement(&system->m_numSleeping);
+				system->Execute(job);
+			}
+			else
+			{
+				WaitForSingleObject(system->m_wakeSemaphore, INFINITE);
+				InterlockedDecrement(&system->m_numSleeping);
+			}
+			spins = 0;
+		}
+
+		return 0;
+	}
+
+	//\brief Which queue belongs to the calling thread
+	inline unsigned int GetQueueIndex() const
+	{
+		const size_t tlsValue = m_running ? (size_t)TlsGetValue(m_tlsIndex) : 0;
+		return tlsValue > 0 ? (unsigned int)(tlsValue - 1) : s_invalidThread;
+	}
+
+	//\brief Look for work in a thread's own queue then try stealing from the others
+	inline bool FindJob(unsigned int a_queueIndex, Job & a_job_OUT)
+	{
+		if (m_queues[a_queueIndex].Pop(a_job_OUT))
+		{
+			return true;
+		}
+
+		const unsigned int numQueues = m_numWorkers + 1;
+		for (unsigned int i = 1; i < numQueues; ++i)
+		{
+			if (m_queues[(a_queueIndex + i) % numQueues].Steal(a_job_OUT))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//\brief Hold a job back until it's dependency is done or queue it straight away
+	inline void AddJob(const Job & a_job, const Counter * a_dependency)
+	{
+		if (a_job.m_counter != NULL)
+		{
+			InterlockedIncrement(&a_job.m_counter->m_count);
+		}
+
+		if (a_dependency != NULL && !a_dependency->IsDone())
+		{
+			// Checked again under the lock as the finishing job scans the list under the same lock
+			if (m_running && m_numWorkers > 0)
+			{
+				EnterCriticalSection(&m_deferredLock);
+				if (!a_dependency->IsDone() && m_numDeferred < s_maxDeferredJobs)
+				{
+					m_deferredJobs[m_numDeferred].m_job = a_job;
+					m_deferredJobs[m_numDeferred].m_dependency = a_dependency;
+					++m_numDeferred;
+					LeaveCriticalSection(&m_deferredLock);
+					return;
+				}
+				LeaveCriticalSection(&m_deferredLock);
+			}
+			Wait(*a_dependency);
+		}
+
+		Submit(a_job);
+	}
+
+	//\brief Put a job in the calling thread's queue and wake a worker, or run it if it can't be queued
+	inline void Submit(const Job & a_job)
+	{
+		const unsigned int queueIndex = GetQueueIndex();
+		if (m_numWorkers == 0 || queueIndex == s_invalidThread || !m_queues[queueIndex].Push(a_job))
+		{
+			Execute(a_job);
+			return;
+		}
+
+		// The job has to be visible before checking for sleepers or a worker could miss it
+		MemoryBarrier();
+		if (m_numSleeping > 0)
+		{
+			ReleaseSemaphore(m_wakeSemaphore, 1, NULL);
+		}
+	}
+
+	//\brief Run a job and count it as finished
+	inline void Execute(const Job & a_job)
+	{
+		if (a_job.m_function != NULL)
+		{
+			a_job.m_function(a_job.m_data);
+		}
+		else
+		{
+			a_job.m_rangeFunction(a_job.m_data, a_job.m_start, a_job.m_end);
+		}
+
+		if (a_job.m_counter != NULL && InterlockedDecrement(&a_job.m_counter->m_count) == 0)
+		{
+			ReleaseDeferredJobs();
+		}
+	}
+
+	//\brief Queue any jobs whose dependency is now done
+	inline void ReleaseDeferredJobs()
+	{
+		if (!m_running || m_numWorkers == 0)
+		{
+			return;
+		}
+
+		Job readyJobs[s_maxDeferredJobs];
+		unsigned int numReady = 0;
+		EnterCriticalSection(&m_deferredLock);
+		for (unsigned int i = 0; i < m_numDeferred; )
+		{
+			if (m_deferredJobs[i].m_dependency->IsDone())
+			{
+				readyJobs[numReady++] = m_deferredJobs[i].m_job;
+				m_deferredJobs[i] = m_deferredJobs[--m_numDeferred];
+			}
+			else
+			{
+				++i;
+			}
+		}
+		LeaveCriticalSection(&m_deferredLock);
+
+		// Queued outside the lock as a full queue runs the job here
+		for (unsigned int i = 0; i < numReady; ++i)
+		{
+			Submit(readyJobs[i]);
+		}
+	}
+
+	//\brief Free everything allocated by Startup
+	inline void Cleanup()
+	{
+		if (m_wakeSemaphore != NULL)
+		{
+			CloseHandle(m_wakeSemaphore);
+			m_wakeSemaphore = NULL;
+		}
+		if (m_tlsIndex != TLS_OUT_OF_INDEXES)
+		{
+			TlsFree(m_tlsIndex);
+			m_tlsIndex = TLS_OUT_OF_INDEXES;
+		}
+		delete [] m_queues;
+		m_queues = NULL;
+		m_numWorkers = 0;
+	}
+
+	WorkQueue * m_queues;								///< One queue per thread, the main thread's is first
+	HANDLE m_threads[s_maxWorkers];						///< Worker thread handles
+	WorkerContext m_workers[s_maxWorkers];				///< What each worker is passed when it starts
+	HANDLE m_wakeSemaphore;								///< Signalled when work is added while workers are asleep
+	CRITICAL_SECTION m_deferredLock;					///< Guards the deferred jobs
+	DeferredJob m_deferredJobs[s_maxDeferredJobs];		///< Jobs waiting for a dependency
+	DWORD m_tlsIndex;									///< Thread local slot holding each thread's queue index plus one
+	unsigned int m_numWorkers;							///< How many worker threads are running
+	volatile LONG m_numSleeping;						///< Workers waiting on the semaphore
+	unsigned int m_numDeferred;							///< Jobs waiting for a dependency
+	volatile bool m_running;							///< Cleared to stop the workers
+};
+
+#endif // _CORE_JOB_SYSTEM_
@@ -4,9 +4,10 @@
 
 #include <math.h>
 
+#include "Float4.h"
 #include "Vector.h"
 
-//\brief Basic 4x4 matrix
+//\brief Basic 4x4 matrix, rows are multiplied and transformed four floats at a time with Float4
 class Matrix
 {
 public:
@@ -35,6 +36,31 @@ public:
 	inline Vector GetPos() const	{ return pos; }
 	inline float GetDeterminant() const { return 0.0f; } //TODO
 	inline bool HasInverse() const { return GetDeterminant() > 0.0f; }
+
+	//\brief Inverse of a matrix made only of rotation, scale and translation, like an object's world matrix
+	//\return the matrix that undoes this one or identity if the rotation and scale part can't be inverted
+	inline Matrix GetInverseAffine() const
+	{
+		// Each column of the inverse of the 3x3 part is the cross product of the other two rows
+		const Vector col0 = look.Cross(up);
+		const Vector col1 = up.Cross(right);
+		const Vector col2 = right.Cross(look);
+		const float det = right.Dot(col0);
+		if (fabs(det) < 0.000001f)
+		{
+			return Identity();
+		}
+		const float invDet = 1.0f / det;
+		Matrix inv(	col0.GetX() * invDet, col1.GetX() * invDet, col2.GetX() * invDet, 0.0f,
+					col0.GetY() * invDet, col1.GetY() * invDet, col2.GetY() * invDet, 0.0f,
+					col0.GetZ() * invDet, col1.GetZ() * invDet, col2.GetZ() * invDet, 0.0f,
+					0.0f, 0.0f, 0.0f, 1.0f);
+
+		// Then the translation is undone in the inverted space
+		const Vector invPos = inv.GetRight() * -pos.GetX() + inv.GetLook() * -pos.GetY() + inv.GetUp() * -pos.GetZ();
+		inv.SetPos(invPos);
+		return inv;
+	}
 	static const Matrix Identity() 
 	{ 
 		float vals[16] = {	1.0f, 0.0f, 0.0f, 0.0f,
@@ -43,22 +69,45 @@ public:
 							0.0f, 0.0f, 0.0f, 1.0f };
 		return Matrix(vals);
 	}
-	inline Matrix Multiply(const Matrix & a_mat) 
+	inline Matrix Multiply(const Matrix & a_mat) const
 	{
 		Matrix mOut;
-		for (unsigned int r = 0; r < 4; ++r)
+		MultiplyRows(&f[0], &a_mat.f[0], &mOut.f[0]);
+		return mOut;
+	}
+
+	//\brief Multiply many matrices in one go, the output can be the same array as either input
+	//\param a_lhs pointer to the matrices on the left of each multiply
+	//\param a_rhs pointer to the matrices on the right of each multiply
+	//\param a_mats_OUT pointer to storage for the results
+	//\param a_numMats how many matrices are in each array
+	inline static void MultiplyBatch(const Matrix * a_lhs, const Matrix * a_rhs, Matrix * a_mats_OUT, unsigned int a_numMats)
+	{
+		for (unsigned int i = 0; i < a_numMats; ++i)
 		{
-			for (unsigned int c = 0; c < 4; ++c)
+			MultiplyRows(&a_lhs[i].f[0], &a_rhs[i].f[0], &a_mats_OUT[i].f[0]);
+		}
+	}
+
+	//\brief Multiply many matrices by the same matrix, like moving a set of local transforms into a parent's space
+	//\param a_lhs pointer to the matrices on the left of each multiply
+	//\param a_rhs the matrix on the right of every multiply
+	//\param a_mats_OUT pointer to storage for the results, can be the same as a_lhs
+	//\param a_numMats how many matrices are in the input and output arrays
+	inline static void MultiplyBatch(const Matrix * a_lhs, const Matrix & a_rhs, Matrix * a_mats_OUT, unsigned int a_numMats)
+	{
+		// Right hand side rows stay in registers for the whole batch
+		const Float4 rhs0 = Float4::Load(a_rhs.row[0]);
+		const Float4 rhs1 = Float4::Load(a_rhs.row[1]);
+		const Float4 rhs2 = Float4::Load(a_rhs.row[2]);
+		const Float4 rhs3 = Float4::Load(a_rhs.row[3]);
+		for (unsigned int i = 0; i < a_numMats; ++i)
+		{
+			for (unsigned int r = 0; r < 4; ++r)
 			{
-				mOut.row[r][c] = 0.0f;
-				for (unsigned int i = 0; i < 4; ++i) 
-				{
-					mOut.row[r][c] += row[r][i] * a_mat.row[i][c];
-				}
+				MultiplyRow(Float4::Load(a_lhs[i].row[r]), rhs0, rhs1, rhs2, rhs3).Store(a_mats_OUT[i].row[r]);
 			}
 		}
-
-		return mOut;
 	}
 	inline static Matrix GetRotateX(float a_angleRadians)
 	{
@@ -87,15 +136,100 @@ public:
 		rotMat.SetPos(	Vector::Zero());
 		return rotMat;
 	}
-	inline Vector Transform(const Vector & a_vec)
+	//\brief Projection from eye space to clip space matching gluPerspective, the eye looks down negative Z
+	//\param a_fovAngleY field of view in the y direction in radians
+	//\param a_aspect width of the view divided by height
+	//\param a_near, a_far distance from the eye to the clipping planes, always positive
+	inline static Matrix GetPerspective(float a_fovAngleY, float a_aspect, float a_near, float a_far)
+	{
+		const float focal = 1.0f / tanf(a_fovAngleY * 0.5f);
+		const float depthScale = 1.0f / (a_near - a_far);
+		return Matrix(	focal / a_aspect,	0.0f,	0.0f,										0.0f,
+						0.0f,				focal,	0.0f,										0.0f,
+						0.0f,				0.0f,	(a_far + a_near) * depthScale,				-1.0f,
+						0.0f,				0.0f,	2.0f * a_far * a_near * depthScale,			0.0f);
+	}
+	//\brief Blend between two transforms, each axis is rescaled to the blend of it's lengths at the start and end so
+	//		 it doesn't shrink part way through a rotation and any scale in the transforms is kept
+	//\param a_from, a_to the transforms at the start and end
+	//\param a_frac how far to blend, 0 gives a_from and 1 gives a_to
+	inline static Matrix Lerp(const Matrix & a_from, const Matrix & a_to, float a_frac)
+	{
+		Matrix result;
+		for (unsigned int i = 0; i < 16; ++i)
+		{
+			result.f[i] = a_from.f[i] + (a_to.f[i] - a_from.f[i]) * a_frac;
+		}
+		result.right = ScaleAxis(result.right, a_from.right.Length(), a_to.right.Length(), a_frac);
+		result.look = ScaleAxis(result.look, a_from.look.Length(), a_to.look.Length(), a_frac);
+		result.up = ScaleAxis(result.up, a_from.up.Length(), a_to.up.Length(), a_frac);
+		return result;
+	}
+	inline Vector Transform(const Vector & a_vec) const
 	{
-		return Vector(	a_vec.GetX() * row[0][0] + a_vec.GetY() * row[1][0] + a_vec.GetZ() * row[2][0] + row[3][0],
-						a_vec.GetX() * row[0][1] + a_vec.GetY() * row[1][1] + a_vec.GetZ() * row[2][1] + row[3][1],
-						a_vec.GetX() * row[0][2] + a_vec.GetY() * row[1][2] + a_vec.GetZ() * row[2][2] + row[3][2]);
+		float result[4];
+		TransformPoint(a_vec, Float4::Load(row[0]), Float4::Load(row[1]), Float4::Load(row[2]), Float4::Load(row[3])).Store(result);
+		return Vector(result[0], result[1], result[2]);
+	}
+
+	//\brief Transform many points by this matrix in one go
+	//\param a_points pointer to the points to transform
+	//\param a_points_OUT pointer to storage for the transformed points, can be the same as a_points
+	//\param a_numPoints how many points are in the input and output arrays
+	inline void TransformBatch(const Vector * a_points, Vector * a_points_OUT, unsigned int a_numPoints) const
+	{
+		// Matrix rows stay in registers for the whole batch
+		const Float4 row0 = Float4::Load(row[0]);
+		const Float4 row1 = Float4::Load(row[1]);
+		const Float4 row2 = Float4::Load(row[2]);
+		const Float4 row3 = Float4::Load(row[3]);
+		float result[4];
+		for (unsigned int i = 0; i < a_numPoints; ++i)
+		{
+			TransformPoint(a_points[i], row0, row1, row2, row3).Store(result);
+			a_points_OUT[i] = Vector(result[0], result[1], result[2]);
+		}
 	}
 	inline Matrix Scale(const float & a_scalar) { } //TODO!
 
 private:
+
+	//\brief Set the length of a blended axis to the blend of the lengths of the axes it was blended from
+	inline static Vector ScaleAxis(const Vector & a_axis, float a_fromLength, float a_toLength, float a_frac)
+	{
+		const float length = a_axis.Length();
+		return length > 0.0f ? a_axis * ((a_fromLength + (a_toLength - a_fromLength) * a_frac) / length) : a_axis;
+	}
+
+	//\brief One row of a matrix multiply, each component of the left row scales a row of the right matrix
+	inline static Float4 MultiplyRow(const Float4 & a_lhsRow, const Float4 & a_rhs0, const Float4 & a_rhs1, const Float4 & a_rhs2, const Float4 & a_rhs3)
+	{
+		Float4 result = a_lhsRow.Broadcast<0>() * a_rhs0;
+		result = Float4::MulAdd(a_lhsRow.Broadcast<1>(), a_rhs1, result);
+		result = Float4::MulAdd(a_lhsRow.Broadcast<2>(), a_rhs2, result);
+		return Float4::MulAdd(a_lhsRow.Broadcast<3>(), a_rhs3, result);
+	}
+
+	//\brief Full 4x4 multiply on raw rows, the right hand side is loaded first so the output can alias either input
+	inline static void MultiplyRows(const float * a_lhs, const float * a_rhs, float * a_out_OUT)
+	{
+		const Float4 rhs0 = Float4::Load(a_rhs);
+		const Float4 rhs1 = Float4::Load(a_rhs + 4);
+		const Float4 rhs2 = Float4::Load(a_rhs + 8);
+		const Float4 rhs3 = Float4::Load(a_rhs + 12);
+		for (unsigned int r = 0; r < 4; ++r)
+		{
+			MultiplyRow(Float4::Load(a_lhs + (r * 4)), rhs0, rhs1, rhs2, rhs3).Store(a_out_OUT + (r * 4));
+		}
+	}
+
+	//\brief Transform a point with a W of 1 by rows that are already loaded
+	inline static Float4 TransformPoint(const Vector & a_point, const Float4 & a_row0, const Float4 & a_row1, const Float4 & a_row2, const Float4 & a_row3)
+	{
+		Float4 result = Float4::MulAdd(Float4::Splat(a_point.GetX()), a_row0, a_row3);
+		result = Float4::MulAdd(Float4::Splat(a_point.GetY()), a_row1, result);
+		return Float4::MulAdd(Float4::Splat(a_point.GetZ()), a_row2, result);
+	}
 	
 	//\brief Union provided for different styles of access
 	union 
@@ -0,0 +1,227 @@
+#ifndef _CORE_OBJECT_POOL_
+#define _CORE_OBJECT_POOL_
+#pragma once
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+//\brief An ObjectPool is a fixed number of fixed size blocks allocated in one contiguous chunk.
+//		 Objects are referred to by handles which combine the index of the block with a generation
+//		 count that is bumped each time the block is freed. This means a handle to an object that has
+//		 since been freed (and possibly reused) can be detected instead of pointing at garbage.
+//		 Blocks are handed out lowest index first and freed blocks are reused most recent first
+//		 so live objects stay packed together at the front of the pool.
+template <class T>
+class ObjectPool
+{
+public:
+
+	//\brief A handle is the block index in the low bits and the generation in the high bits
+	typedef unsigned int Handle;
+
+	static const Handle s_invalidHandle = 0;						///< Generation 0 is never issued so a zeroed handle is always invalid
+	static const unsigned int s_maxCapacity = 0xffff + 1;			///< Maximum number of blocks addressable by a handle
+	static const unsigned int s_handleIndexBits = 16;				///< How many bits of the handle are used for the index
+	static const unsigned int s_handleIndexMask = 0xffff;			///< Mask to extract the index from a handle
+
+	//\brief Default constructor provided to allow declaration before Init
+	ObjectPool()
+		: m_memory(NULL)
+		, m_blocks(NULL)
+		, m_freeList(NULL)
+		, m_blockSizeBytes(0)
+		, m_capacity(0)
+		, m_numFree(0)
+	{ }
+
+	//\brief Setup the pool and allocate the memory in one go
+	ObjectPool(unsigned int a_capacity, size_t a_blockSizeBytes = sizeof(T))
+		: m_memory(NULL)
+		, m_blocks(NULL)
+		, m_freeList(NULL)
+		, m_blockSizeBytes(0)
+		, m_capacity(0)
+		, m_numFree(0)
+	{
+		Init(a_capacity, a_blockSizeBytes);
+	}
+
+	//\brief Make sure memory is freed if the pool is deleted
+	~ObjectPool() { Done(); }
+
+	//\brief For setting up the pool after declaration
+	//\param a_capacity is the maximum number of objects that can be alive at once
+	//\param a_blockSizeBytes is the size of each block, must be at least the size of T
+	//\return true if the allocation was succesful and the pool had not been initialised already
+	inline bool Init(unsigned int a_capacity, size_t a_blockSizeBytes = sizeof(T))
+	{
+		if (m_capacity > 0 || a_capacity == 0 || a_capacity > s_maxCapacity || a_blockSizeBytes < sizeof(T))
+		{
+			return false;
+		}
+
+		// Round the block size up to 16 bytes so each object starts on an aligned boundary
+		m_blockSizeBytes = (a_blockSizeBytes + 15) & ~((size_t)15);
+		m_memory = (unsigned char *)malloc(m_blockSizeBytes * a_capacity);
+		m_blocks = (BlockInfo *)malloc(sizeof(BlockInfo) * a_capacity);
+		m_freeList = (unsigned int *)malloc(sizeof(unsigned int) * a_capacity);
+		if (m_memory == NULL || m_blocks == NULL || m_freeList == NULL)
+		{
+			Done();
+			return false;
+		}
+
+		// The free list is a stack, fill it backwards so the lowest index is handed out first
+		m_capacity = a_capacity;
+		m_numFree = a_capacity;
+		for (unsigned int i = 0; i < a_capacity; ++i)
+		{
+			m_blocks[i].m_generation = 1;
+			m_blocks[i].m_inUse = false;
+			m_freeList[i] = a_capacity - 1 - i;
+		}
+
+		// This can be removed in all but DEBUG configuration, but its nice when viewing memory
+		memset(m_memory, 0, m_blockSizeBytes * a_capacity);
+
+		return true;
+	}
+
+	//\brief Destruct any live objects and release the memory
+	inline void Done()
+	{
+		if (m_blocks != NULL && m_memory != NULL)
+		{
+			for (unsigned int i = 0; i < m_capacity; ++i)
+			{
+				if (m_blocks[i].m_inUse)
+				{
+					GetBlock(i)->~T();
+				}
+			}
+		}
+
+		free(m_memory);
+		free(m_blocks);
+		free(m_freeList);
+		m_memory = NULL;
+		m_blocks = NULL;
+		m_freeList = NULL;
+		m_blockSizeBytes = 0;
+		m_capacity = 0;
+		m_numFree = 0;
+	}
+
+	//\brief Construct a new object in the next free block
+	//\param a_handle_OUT will be written with the handle of the new object, invalid on failure
+	//\return a pointer to the newly constructed object or NULL if the pool is full or the type does not fit
+	template <typename TDerived>
+	inline TDerived * Allocate(Handle & a_handle_OUT)
+	{
+		a_handle_OUT = s_invalidHandle;
+		if (m_numFree == 0 || sizeof(TDerived) > m_blockSizeBytes)
+		{
+			return NULL;
+		}
+
+		// Pop a block off the free list and construct in place
+		const unsigned int index = m_freeList[--m_numFree];
+		m_blocks[index].m_inUse = true;
+		a_handle_OUT = MakeHandle(index, m_blocks[index].m_generation);
+		return new (m_memory + (index * m_blockSizeBytes)) TDerived();
+	}
+	inline T * Allocate(Handle & a_handle_OUT) { return Allocate<T>(a_handle_OUT); }
+
+	//\brief Destruct an object and return it's block to the pool, any outstanding handles become stale
+	//\param a_handle the handle returned when the object was allocated
+	//\return true if the handle was valid and the object was freed
+	inline bool Free(Handle a_handle)
+	{
+		if (!IsValid(a_handle))
+		{
+			return false;
+		}
+
+		// Destruct, then bump the generation so old handles fail validation
+		const unsigned int index = a_handle & s_handleIndexMask;
+		GetBlock(index)->~T();
+		m_blocks[index].m_inUse = false;
+		if (++m_blocks[index].m_generation == 0)
+		{
+			m_blocks[index].m_generation = 1;
+		}
+		m_freeList[m_numFree++] = index;
+
+		return true;
+	}
+	inline bool Free(T * a_object) { return Free(GetHandle(a_object)); }
+
+	//\brief Resolve a handle to an object
+	//\return a pointer to the object or NULL if the handle is stale or invalid
+	inline T * Get(Handle a_handle)
+	{
+		return IsValid(a_handle) ? GetBlock(a_handle & s_handleIndexMask) : NULL;
+	}
+
+	//\brief Test a handle against the current generation of the block it refers to
+	inline bool IsValid(Handle a_handle) const
+	{
+		const unsigned int index = a_handle & s_handleIndexMask;
+		const unsigned short generation = (unsigned short)(a_handle >> s_handleIndexBits);
+		return	a_handle != s_invalidHandle &&
+				index < m_capacity &&
+				m_blocks[index].m_inUse &&
+				m_blocks[index].m_generation == generation;
+	}
+
+	//\brief Reverse lookup of a handle from a pointer that was allocated from this pool
+	//\return the current handle to the object or invalid if the pointer is not a live object in this pool
+	inline Handle GetHandle(const T * a_object) const
+	{
+		const unsigned char * ptr = (const unsigned char *)a_object;
+		if (m_memory == NULL || ptr < m_memory || ptr >= m_memory + (m_capacity * m_blockSizeBytes))
+		{
+			return s_invalidHandle;
+		}
+
+		const unsigned int index = (unsigned int)((ptr - m_memory) / m_blockSizeBytes);
+		return m_blocks[index].m_inUse ? MakeHandle(index, m_blocks[index].m_generation) : s_invalidHandle;
+	}
+
+	//\brief Raw block access for walking the pool linearly, check IsBlockInUse before touching the data
+	//\param a_index the index of the block in the pool from 0 to capacity
+	inline T * GetBlock(unsigned int a_index) { return (T *)(m_memory + (a_index * m_blockSizeBytes)); }
+	inline bool IsBlockInUse(unsigned int a_index) const { return a_index < m_capacity && m_blocks[a_index].m_inUse; }
+
+	//\brief Informational functions to track how much of the pool is in use
+	inline unsigned int GetCapacity() const { return m_capacity; }
+	inline unsigned int GetNumAllocated() const { return m_capacity - m_numFree; }
+	inline unsigned int GetNumFree() const { return m_numFree; }
+	inline size_t GetBlockSizeBytes() const { return m_blockSizeBytes; }
+	inline bool IsFull() const { return m_numFree == 0; }
+
+private:
+
+	//\brief Bookkeeping for each block is kept seperately so the objects themselves are tightly packed
+	struct BlockInfo
+	{
+		unsigned short m_generation;		///< Bumped on every free, skips 0
+		bool m_inUse;						///< If the block currently holds a constructed object
+	};
+
+	//\brief Combine an index and generation into a handle
+	static inline Handle MakeHandle(unsigned int a_index, unsigned short a_generation)
+	{
+		return ((Handle)a_generation << s_handleIndexBits) | (a_index & s_handleIndexMask);
+	}
+
+	unsigned char * m_memory;				///< Contiguous storage for all the blocks
+	BlockInfo * m_blocks;					///< Generation and usage info for each block
+	unsigned int * m_freeList;				///< Stack of free block indices
+	size_t m_blockSizeBytes;				///< Stride between each object, rounded up for alignment
+	unsigned int m_capacity;				///< Total number of blocks
+	unsigned int m_numFree;					///< How many blocks are left on the free list
+};
+
+#endif // _CORE_OBJECT_POOL_
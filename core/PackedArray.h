@@ -0,0 +1,248 @@
+#ifndef _CORE_PACKED_ARRAY_
+#define _CORE_PACKED_ARRAY_
+#pragma once
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+//\brief A PackedArray keeps objects of one type tightly packed at the front of a single allocation
+//		 so they can be walked in one loop with no gaps. Objects are referred to by handles in the
+//		 same style as ObjectPool, a slot index in the low bits and a generation in the high bits,
+//		 which resolve through a slot table to wherever the object currently is. Removing an object
+//		 copies the last object into the gap so objects move, keep handles and not pointers.
+//		 Storage grows by doubling up to the maximum set in Init.
+template <typename T>
+class PackedArray
+{
+public:
+
+	//\brief A handle is the slot index in the low bits and the generation in the high bits
+	typedef unsigned int Handle;
+
+	static const Handle s_invalidHandle = 0;					///< Generation 0 is never issued so a zeroed handle is always invalid
+	static const unsigned int s_maxCapacity = 0xffff + 1;		///< Maximum number of slots addressable by a handle
+	static const unsigned int s_handleIndexBits = 16;			///< How many bits of the handle are used for the slot index
+	static const unsigned int s_handleIndexMask = 0xffff;		///< Mask to extract the slot index from a handle
+	static const unsigned int s_minCapacity = 16;				///< Size of the first allocation
+
+	//\brief Default constructor provided to allow declaration before Init
+	PackedArray()
+		: m_data(NULL)
+		, m_slots(NULL)
+		, m_denseSlots(NULL)
+		, m_freeSlots(NULL)
+		, m_count(0)
+		, m_capacity(0)
+		, m_maxCapacity(0)
+		, m_numSlots(0)
+		, m_numFreeSlots(0)
+	{ }
+
+	//\brief Make sure objects are destructed and memory is freed if the array is deleted
+	~PackedArray() { Done(); }
+
+	//\brief Set the limit on how many objects can be in the array at once, no memory is allocated until the first add
+	//\param a_maxCapacity is the most objects the array will grow to hold
+	//\return true if the limit is usable and the array had not been initialised already
+	inline bool Init(unsigned int a_maxCapacity)
+	{
+		if (m_maxCapacity > 0 || a_maxCapacity == 0 || a_maxCapacity > s_maxCapacity)
+		{
+			return false;
+		}
+
+		m_maxCapacity = a_maxCapacity;
+		return true;
+	}
+
+	//\brief Destruct all objects and release the memory
+	inline void Done()
+	{
+		for (unsigned int i = 0; i < m_count; ++i)
+		{
+			m_data[i].~T();
+		}
+
+		free(m_data);
+		free(m_slots);
+		free(m_denseSlots);
+		free(m_freeSlots);
+		m_data = NULL;
+		m_slots = NULL;
+		m_denseSlots = NULL;
+		m_freeSlots = NULL;
+		m_count = 0;
+		m_capacity = 0;
+		m_maxCapacity = 0;
+		m_numSlots = 0;
+		m_numFreeSlots = 0;
+	}
+
+	//\brief Construct a new object on the end of the array
+	//\param a_handle_OUT will be written with the handle of the new object, invalid on failure
+	//\return a pointer to the new object, only valid until the next add or remove, or NULL if the array is full
+	inline T * Add(Handle & a_handle_OUT)
+	{
+		a_handle_OUT = s_invalidHandle;
+		if (m_count >= m_capacity && !Grow())
+		{
+			return NULL;
+		}
+
+		// Reuse the most recently freed slot before opening a new one
+		const unsigned int slotIndex = m_numFreeSlots > 0 ? m_freeSlots[--m_numFreeSlots] : m_numSlots++;
+		Slot & slot = m_slots[slotIndex];
+		slot.m_denseIndex = m_count;
+		slot.m_inUse = true;
+		m_denseSlots[m_count] = slotIndex;
+		a_handle_OUT = MakeHandle(slotIndex, slot.m_generation);
+		return new (&m_data[m_count++]) T();
+	}
+
+	//\brief Destruct an object and move the last object into it's place, any outstanding handles to it become stale
+	//\param a_handle the handle returned when the object was added
+	//\return true if the handle was valid and the object was removed
+	inline bool Remove(Handle a_handle)
+	{
+		if (!IsValid(a_handle))
+		{
+			return false;
+		}
+
+		// Fill the gap with the last object and point it's slot at the new position
+		const unsigned int slotIndex = a_handle & s_handleIndexMask;
+		const unsigned int denseIndex = m_slots[slotIndex].m_denseIndex;
+		const unsigned int lastIndex = m_count - 1;
+		m_data[denseIndex].~T();
+		if (denseIndex != lastIndex)
+		{
+			new (&m_data[denseIndex]) T(m_data[lastIndex]);
+			m_data[lastIndex].~T();
+			m_denseSlots[denseIndex] = m_denseSlots[lastIndex];
+			m_slots[m_denseSlots[denseIndex]].m_denseIndex = denseIndex;
+		}
+		--m_count;
+
+		// Bump the generation so old handles fail validation
+		Slot & slot = m_slots[slotIndex];
+		slot.m_inUse = false;
+		if (++slot.m_generation == 0)
+		{
+			slot.m_generation = 1;
+		}
+		m_freeSlots[m_numFreeSlots++] = slotIndex;
+
+		return true;
+	}
+
+	//\brief Resolve a handle to an object
+	//\return a pointer to the object or NULL if the handle is stale or invalid
+	inline T * Get(Handle a_handle)
+	{
+		return IsValid(a_handle) ? &m_data[m_slots[a_handle & s_handleIndexMask].m_denseIndex] : NULL;
+	}
+
+	//\brief Test a handle against the current generation of the slot it refers to
+	inline bool IsValid(Handle a_handle) const
+	{
+		const unsigned int slotIndex = a_handle & s_handleIndexMask;
+		const unsigned short generation = (unsigned short)(a_handle >> s_handleIndexBits);
+		return	a_handle != s_invalidHandle &&
+				slotIndex < m_numSlots &&
+				m_slots[slotIndex].m_inUse &&
+				m_slots[slotIndex].m_generation == generation;
+	}
+
+	//\brief Access to the packed objects for walking the whole array, from 0 to GetCount()
+	inline T * GetData() { return m_data; }
+	inline T & operator[](unsigned int a_index) { return m_data[a_index]; }
+
+	//\brief Informational functions to track how much of the array is in use
+	inline unsigned int GetCount() const { return m_count; }
+	inline unsigned int GetCapacity() const { return m_capacity; }
+	inline unsigned int GetMaxCapacity() const { return m_maxCapacity; }
+	inline bool IsFull() const { return m_count >= m_maxCapacity; }
+
+private:
+
+	//\brief Where the object for each handle is, kept seperate so the objects themselves are tightly packed
+	struct Slot
+	{
+		unsigned int m_denseIndex;			///< Position of the object in the packed array
+		unsigned short m_generation;		///< Bumped on every remove, skips 0
+		bool m_inUse;						///< If the slot currently refers to an object
+	};
+
+	//\brief Combine a slot index and generation into a handle
+	static inline Handle MakeHandle(unsigned int a_slotIndex, unsigned short a_generation)
+	{
+		return ((Handle)a_generation << s_handleIndexBits) | (a_slotIndex & s_handleIndexMask);
+	}
+
+	//\brief Double the storage, copying the objects across to the new allocation
+	//\return true if there is room for at least one more object
+	inline bool Grow()
+	{
+		if (m_capacity >= m_maxCapacity)
+		{
+			return false;
+		}
+
+		unsigned int newCapacity = m_capacity > 0 ? m_capacity * 2 : s_minCapacity;
+		newCapacity = newCapacity < m_maxCapacity ? newCapacity : m_maxCapacity;
+		T * newData = (T *)malloc(sizeof(T) * newCapacity);
+		Slot * newSlots = (Slot *)realloc(m_slots, sizeof(Slot) * newCapacity);
+		if (newSlots != NULL)
+		{
+			m_slots = newSlots;
+		}
+		unsigned int * newDenseSlots = (unsigned int *)realloc(m_denseSlots, sizeof(unsigned int) * newCapacity);
+		if (newDenseSlots != NULL)
+		{
+			m_denseSlots = newDenseSlots;
+		}
+		unsigned int * newFreeSlots = (unsigned int *)realloc(m_freeSlots, sizeof(unsigned int) * newCapacity);
+		if (newFreeSlots != NULL)
+		{
+			m_freeSlots = newFreeSlots;
+		}
+		if (newData == NULL || newSlots == NULL || newDenseSlots == NULL || newFreeSlots == NULL)
+		{
+			free(newData);
+			return false;
+		}
+
+		// Objects are copied rather than moved bytewise so types that own resources stay correct
+		for (unsigned int i = 0; i < m_count; ++i)
+		{
+			new (&newData[i]) T(m_data[i]);
+			m_data[i].~T();
+		}
+		free(m_data);
+		m_data = newData;
+
+		// New slots start at generation 1 so the first handle issued from them is never invalid
+		for (unsigned int i = m_capacity; i < newCapacity; ++i)
+		{
+			m_slots[i].m_denseIndex = 0;
+			m_slots[i].m_generation = 1;
+			m_slots[i].m_inUse = false;
+		}
+		m_capacity = newCapacity;
+
+		return true;
+	}
+
+	T * m_data;							///< Packed objects, the first m_count are constructed
+	Slot * m_slots;						///< Slot table that handles index into
+	unsigned int * m_denseSlots;		///< Which slot each packed object belongs to, for fixing up slots when objects move
+	unsigned int * m_freeSlots;			///< Stack of slot indices that have been removed and can be reused
+	unsigned int m_count;				///< How many objects are in the array
+	unsigned int m_capacity;			///< How many objects fit in the current allocation
+	unsigned int m_maxCapacity;			///< Limit the allocation can grow to
+	unsigned int m_numSlots;			///< How many slots have ever been used
+	unsigned int m_numFreeSlots;		///< How many slots are on the free stack
+};
+
+#endif // _CORE_PACKED_ARRAY_
@@ -0,0 +1,609 @@
+#ifndef _CORE_PAGE_ALLOCATOR_
+#define _CORE_PAGE_ALLOCATOR_
+#pragma once
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+//\brief A PageAllocator carves allocations out of fixed size pages that are kept and reused
+//		 rather than returned to the OS so a long running session does not fragment the heap.
+//		 Every allocation is referred to by a handle which is an index into a table of pointers
+//		 combined with a generation count, so stale handles are detected rather than dereferenced.
+//		 Allocations come in two flavours:
+//		 Fixed allocations never move, so it is safe to keep a raw pointer to them as long as they live.
+//		 Movable allocations live in their own pages and can be relocated by the compaction pass,
+//		 so they must always be resolved through their handle and the pointer never cached.
+//		 Allocations larger than a page get a page of their own which is freed as soon as the allocation is.
+class PageAllocator
+{
+public:
+
+	//\brief A handle is the table index in the low bits and the generation in the high bits
+	typedef unsigned int Handle;
+
+	static const Handle s_invalidHandle = 0;						///< Generation 0 is never issued so a zeroed handle is always invalid
+	static const unsigned int s_handleIndexBits = 20;				///< How many bits of the handle are used for the table index
+	static const unsigned int s_handleIndexMask = 0xfffff;			///< Mask to extract the index from a handle
+	static const unsigned int s_maxHandles = 0xfffff + 1;			///< Maximum number of live allocations addressable by a handle
+	static const unsigned int s_maxGeneration = 0xfff;				///< Generations wrap back to 1 after this
+	static const size_t s_alignment = 16;							///< All allocations start on this boundary
+
+	//\brief Default constructor provided to allow declaration before Init
+	PageAllocator()
+		: m_pages(NULL)
+		, m_handles(NULL)
+		, m_freeHandles(NULL)
+		, m_pageSizeBytes(0)
+		, m_maxPages(0)
+		, m_handleCapacity(0)
+		, m_numFreeHandles(0)
+		, m_numAllocations(0)
+		, m_compactCursor(0)
+	{
+		m_fillPage[eAllocationFixed] = s_noPage;
+		m_fillPage[eAllocationMovable] = s_noPage;
+	}
+
+	//\brief Make sure memory is freed if the allocator is deleted
+	~PageAllocator() { Done(); }
+
+	//\brief For setting up the allocator after declaration, no pages are allocated until they are needed
+	//\param a_pageSizeBytes is the size of each page, allocations larger than this get a dedicated page
+	//\param a_maxPages is the maximum number of pages that can be in use at once
+	//\return true if the page table was allocated and the allocator had not been initialised already
+	inline bool Init(size_t a_pageSizeBytes, unsigned int a_maxPages)
+	{
+		if (m_pages != NULL || a_pageSizeBytes < s_alignment * 2 || a_maxPages == 0)
+		{
+			return false;
+		}
+
+		m_pages = (Page *)malloc(sizeof(Page) * a_maxPages);
+		if (m_pages == NULL)
+		{
+			return false;
+		}
+
+		for (unsigned int i = 0; i < a_maxPages; ++i)
+		{
+			m_pages[i].m_memory = NULL;
+			m_pages[i].m_sizeBytes = 0;
+			m_pages[i].m_usedBytes = 0;
+			m_pages[i].m_liveBytes = 0;
+			m_pages[i].m_numLive = 0;
+			m_pages[i].m_type = ePageTypeFree;
+		}
+
+		m_pageSizeBytes = RoundUp(a_pageSizeBytes);
+		m_maxPages = a_maxPages;
+		m_compactCursor = 0;
+		return true;
+	}
+
+	//\brief Release every page and the handle table, any outstanding allocations are lost
+	inline void Done()
+	{
+		if (m_pages != NULL)
+		{
+			for (unsigned int i = 0; i < m_maxPages; ++i)
+			{
+				free(m_pages[i].m_memory);
+			}
+		}
+
+		free(m_pages);
+		free(m_handles);
+		free(m_freeHandles);
+		m_pages = NULL;
+		m_handles = NULL;
+		m_freeHandles = NULL;
+		m_pageSizeBytes = 0;
+		m_maxPages = 0;
+		m_handleCapacity = 0;
+		m_numFreeHandles = 0;
+		m_numAllocations = 0;
+		m_compactCursor = 0;
+		m_fillPage[eAllocationFixed] = s_noPage;
+		m_fillPage[eAllocationMovable] = s_noPage;
+	}
+
+	//\brief Allocate a block of memory that will never be moved
+	//\param a_sizeBytes how much memory is being allocated
+	//\return a pointer to zeroed memory or NULL if the allocator is out of pages
+	inline void * Allocate(size_t a_sizeBytes)
+	{
+		Handle handle = AllocateInternal(a_sizeBytes, eAllocationFixed);
+		return handle != s_invalidHandle ? m_handles[handle & s_handleIndexMask].m_ptr : NULL;
+	}
+
+	//\brief Allocate a block of memory that can be relocated by compaction
+	//\param a_sizeBytes how much memory is being allocated
+	//\return a handle to the memory, resolve it with Get each time it is used
+	inline Handle AllocateMovable(size_t a_sizeBytes)
+	{
+		return AllocateInternal(a_sizeBytes, eAllocationMovable);
+	}
+
+	//\brief Typed helpers to construct and destruct objects in fixed allocations
+	template <typename T>
+	inline T * New()
+	{
+		void * mem = Allocate(sizeof(T));
+		return mem != NULL ? new (mem) T() : NULL;
+	}
+	template <typename T>
+	inline void Delete(T * a_object)
+	{
+		if (a_object != NULL)
+		{
+			a_object->~T();
+			Free(a_object);
+		}
+	}
+
+	//\brief Return an allocation to it's page, any outstanding handles become stale
+	//\return true if the handle or pointer referred to a live allocation
+	inline bool Free(Handle a_handle)
+	{
+		if (!IsValid(a_handle))
+		{
+			return false;
+		}
+
+		// Mark the block as free in the page then release the handle
+		const unsigned int index = a_handle & s_handleIndexMask;
+		HandleEntry & entry = m_handles[index];
+		FreeBlock(entry.m_page, GetHeader(entry.m_ptr));
+		ReleaseHandle(index);
+		--m_numAllocations;
+
+		return true;
+	}
+	inline bool Free(void * a_ptr) { return a_ptr != NULL ? Free(GetHandle(a_ptr)) : false; }
+
+	//\brief Resolve a handle to the current location of it's memory
+	//\return a pointer to the memory or NULL if the handle is stale or invalid
+	inline void * Get(Handle a_handle) const
+	{
+		return IsValid(a_handle) ? m_handles[a_handle & s_handleIndexMask].m_ptr : NULL;
+	}
+
+	//\brief Test a handle against the current generation of the table entry it refers to
+	inline bool IsValid(Handle a_handle) const
+	{
+		const unsigned int index = a_handle & s_handleIndexMask;
+		const unsigned int generation = a_handle >> s_handleIndexBits;
+		return	a_handle != s_invalidHandle &&
+				index < m_handleCapacity &&
+				m_handles[index].m_inUse &&
+				m_handles[index].m_generation == generation;
+	}
+
+	//\brief Reverse lookup of a handle from the pointer to a live allocation
+	inline Handle GetHandle(const void * a_ptr) const
+	{
+		const unsigned int index = GetHeader(a_ptr)->m_handleIndex;
+		if (index < m_handleCapacity && m_handles[index].m_inUse && m_handles[index].m_ptr == a_ptr)
+		{
+			return MakeHandle(index, m_handles[index].m_generation);
+		}
+		return s_invalidHandle;
+	}
+
+	//\brief Incremental defragmentation, visits a number of pages and reclaims any that are
+	//		 mostly empty by moving their movable allocations into other pages
+	//\param a_maxPagesToVisit how many pages to look at before returning, keeps the cost per call bounded
+	//\return the number of pages that were emptied
+	inline unsigned int Compact(unsigned int a_maxPagesToVisit)
+	{
+		unsigned int pagesReclaimed = 0;
+		for (unsigned int i = 0; i < a_maxPagesToVisit && i < m_maxPages; ++i)
+		{
+			const unsigned int pageIndex = m_compactCursor;
+			m_compactCursor = (m_compactCursor + 1) % m_maxPages;
+
+			// Only evacuate movable pages that are less than half full, leave the page being filled alone
+			Page & page = m_pages[pageIndex];
+			if (page.m_type == ePageTypeMovable &&
+				pageIndex != m_fillPage[eAllocationMovable] &&
+				page.m_liveBytes * 2 < page.m_usedBytes)
+			{
+				if (EvacuatePage(pageIndex))
+				{
+					++pagesReclaimed;
+				}
+			}
+		}
+
+		return pagesReclaimed;
+	}
+
+	//\brief Informational functions to track how much memory is in use
+	inline unsigned int GetNumAllocations() const { return m_numAllocations; }
+	inline size_t GetPageSizeBytes() const { return m_pageSizeBytes; }
+	inline unsigned int GetMaxPages() const { return m_maxPages; }
+	inline unsigned int GetNumPagesInUse() const
+	{
+		unsigned int numPages = 0;
+		for (unsigned int i = 0; i < m_maxPages; ++i)
+		{
+			numPages += m_pages[i].m_type != ePageTypeFree ? 1 : 0;
+		}
+		return numPages;
+	}
+	inline size_t GetReservedBytes() const
+	{
+		size_t reservedBytes = 0;
+		for (unsigned int i = 0; i < m_maxPages; ++i)
+		{
+			reservedBytes += m_pages[i].m_sizeBytes;
+		}
+		return reservedBytes;
+	}
+	inline size_t GetLiveBytes() const
+	{
+		size_t liveBytes = 0;
+		for (unsigned int i = 0; i < m_maxPages; ++i)
+		{
+			liveBytes += m_pages[i].m_liveBytes;
+		}
+		return liveBytes;
+	}
+
+private:
+
+	//\brief Which kind of allocation is being requested, each kind fills it's own pages
+	enum eAllocation
+	{
+		eAllocationFixed = 0,
+		eAllocationMovable,
+
+		eAllocationCount,
+	};
+
+	//\brief What a page is currently being used for
+	enum ePageType
+	{
+		ePageTypeFree = 0,			///< Empty, memory may or may not be allocated
+		ePageTypeFixed,				///< Holding allocations that never move
+		ePageTypeMovable,			///< Holding allocations that compaction can relocate
+		ePageTypeLarge,				///< A single allocation bigger than the page size
+
+		ePageTypeCount,
+	};
+
+	//\brief Every allocation in a page is preceeded by a header so pages can be walked and pointers freed
+	struct BlockHeader
+	{
+		unsigned int m_handleIndex;			///< Index into the handle table or s_freeBlock
+		unsigned int m_sizeBytes;			///< Size of the block including this header
+		unsigned int m_pad[2];				///< Keep the allocation after the header aligned
+	};
+
+	//\brief Bookkeeping for each page
+	struct Page
+	{
+		unsigned char * m_memory;			///< Storage for the page, stays allocated when the page is freed unless it was large
+		size_t m_sizeBytes;					///< Size of the memory, the page size unless the page is large
+		size_t m_usedBytes;					///< Allocations are bumped from the start of the page
+		size_t m_liveBytes;					///< How much of the used memory has not been freed
+		unsigned int m_numLive;				///< How many allocations have not been freed
+		ePageType m_type;					///< What the page is being used for
+	};
+
+	//\brief Each handle refers to an entry in this table which knows where the allocation currently lives
+	struct HandleEntry
+	{
+		void * m_ptr;						///< Current location of the allocation
+		unsigned int m_page;				///< Index of the page the allocation is in
+		unsigned short m_generation;		///< Bumped on every free, skips 0
+		bool m_inUse;						///< If the entry refers to a live allocation
+	};
+
+	static const unsigned int s_noPage = 0xffffffff;		///< Marker for no fill page
+	static const unsigned int s_freeBlock = 0xffffffff;		///< Marker in a block header that is not live
+
+	//\brief Helper functions for alignment and moving between headers and allocations
+	static inline size_t RoundUp(size_t a_sizeBytes) { return (a_sizeBytes + s_alignment - 1) & ~(s_alignment - 1); }
+	static inline BlockHeader * GetHeader(const void * a_ptr) { return (BlockHeader *)((unsigned char *)a_ptr - sizeof(BlockHeader)); }
+	static inline Handle MakeHandle(unsigned int a_index, unsigned short a_generation)
+	{
+		return ((Handle)a_generation << s_handleIndexBits) | (a_index & s_handleIndexMask);
+	}
+
+	//\brief Find room for an allocation, create a page, write the header and assign a handle
+	inline Handle AllocateInternal(size_t a_sizeBytes, eAllocation a_allocation)
+	{
+		if (m_pages == NULL || a_sizeBytes == 0)
+		{
+			return s_invalidHandle;
+		}
+
+		// Make sure there is a handle to give out before touching any pages
+		unsigned int handleIndex = 0;
+		if (!AcquireHandle(handleIndex))
+		{
+			return s_invalidHandle;
+		}
+
+		// Allocations too big for a page get one to themselves
+		const size_t blockSizeBytes = RoundUp(a_sizeBytes + sizeof(BlockHeader));
+		unsigned int pageIndex = blockSizeBytes > m_pageSizeBytes ?
+								 AcquireLargePage(blockSizeBytes) :
+								 FindPageWithSpace(blockSizeBytes, a_allocation, s_noPage);
+		if (pageIndex == s_noPage)
+		{
+			ReleaseHandle(handleIndex);
+			return s_invalidHandle;
+		}
+
+		// Bump the allocation off the end of the page
+		void * ptr = PlaceBlock(pageIndex, blockSizeBytes, handleIndex);
+		memset(ptr, 0, blockSizeBytes - sizeof(BlockHeader));
+
+		HandleEntry & entry = m_handles[handleIndex];
+		entry.m_ptr = ptr;
+		entry.m_page = pageIndex;
+		++m_numAllocations;
+
+		return MakeHandle(handleIndex, entry.m_generation);
+	}
+
+	//\brief Write a block header at the end of a page's used memory
+	//\return a pointer to the memory after the header
+	inline void * PlaceBlock(unsigned int a_pageIndex, size_t a_blockSizeBytes, unsigned int a_handleIndex)
+	{
+		Page & page = m_pages[a_pageIndex];
+		BlockHeader * header = (BlockHeader *)(page.m_memory + page.m_usedBytes);
+		header->m_handleIndex = a_handleIndex;
+		header->m_sizeBytes = (unsigned int)a_blockSizeBytes;
+		page.m_usedBytes += a_blockSizeBytes;
+		page.m_liveBytes += a_blockSizeBytes;
+		++page.m_numLive;
+
+		return header + 1;
+	}
+
+	//\brief Mark a block as dead and reclaim the page if it is empty
+	inline void FreeBlock(unsigned int a_pageIndex, BlockHeader * a_header)
+	{
+		Page & page = m_pages[a_pageIndex];
+		const size_t blockSizeBytes = a_header->m_sizeBytes;
+		a_header->m_handleIndex = s_freeBlock;
+		page.m_liveBytes -= blockSizeBytes;
+		--page.m_numLive;
+
+		// Freeing the last block in the page can give the space straight back
+		if ((unsigned char *)a_header + blockSizeBytes == page.m_memory + page.m_usedBytes)
+		{
+			page.m_usedBytes -= blockSizeBytes;
+		}
+
+		if (page.m_numLive == 0)
+		{
+			ReleasePage(a_pageIndex);
+		}
+	}
+
+	//\brief Look for a page of the right type with enough room, the current fill page is tried first
+	//\param a_excludePage a page that must not be used, for when a page is being evacuated
+	//\return the index of a page or s_noPage if all pages are in use
+	inline unsigned int FindPageWithSpace(size_t a_blockSizeBytes, eAllocation a_allocation, unsigned int a_excludePage)
+	{
+		const ePageType pageType = a_allocation == eAllocationFixed ? ePageTypeFixed : ePageTypeMovable;
+		const unsigned int fillPage = m_fillPage[a_allocation];
+		if (fillPage != s_noPage && fillPage != a_excludePage && HasSpace(fillPage, a_blockSizeBytes))
+		{
+			return fillPage;
+		}
+
+		// Then any other partially used page of the same type, and finally an empty page
+		unsigned int freePage = s_noPage;
+		for (unsigned int i = 0; i < m_maxPages; ++i)
+		{
+			if (i == a_excludePage)
+			{
+				continue;
+			}
+
+			if (m_pages[i].m_type == pageType && HasSpace(i, a_blockSizeBytes))
+			{
+				m_fillPage[a_allocation] = i;
+				return i;
+			}
+
+			// Prefer empty pages that still have their memory
+			if (m_pages[i].m_type == ePageTypeFree &&
+				(freePage == s_noPage || (m_pages[freePage].m_memory == NULL && m_pages[i].m_memory != NULL)))
+			{
+				freePage = i;
+			}
+		}
+
+		if (freePage != s_noPage)
+		{
+			Page & page = m_pages[freePage];
+			if (page.m_memory == NULL)
+			{
+				page.m_memory = (unsigned char *)malloc(m_pageSizeBytes);
+				if (page.m_memory == NULL)
+				{
+					return s_noPage;
+				}
+				page.m_sizeBytes = m_pageSizeBytes;
+			}
+			page.m_type = pageType;
+			m_fillPage[a_allocation] = freePage;
+		}
+
+		return freePage;
+	}
+
+	//\brief Dedicate an empty page to a single allocation, resizing it's memory to fit
+	inline unsigned int AcquireLargePage(size_t a_blockSizeBytes)
+	{
+		// Use a page slot without memory if possible so existing pages are kept
+		unsigned int freePage = s_noPage;
+		for (unsigned int i = 0; i < m_maxPages; ++i)
+		{
+			if (m_pages[i].m_type == ePageTypeFree)
+			{
+				freePage = i;
+				if (m_pages[i].m_memory == NULL)
+				{
+					break;
+				}
+			}
+		}
+
+		if (freePage != s_noPage)
+		{
+			Page & page = m_pages[freePage];
+			free(page.m_memory);
+			page.m_memory = (unsigned char *)malloc(a_blockSizeBytes);
+			page.m_sizeBytes = page.m_memory != NULL ? a_blockSizeBytes : 0;
+			if (page.m_memory == NULL)
+			{
+				return s_noPage;
+			}
+			page.m_type = ePageTypeLarge;
+		}
+
+		return freePage;
+	}
+
+	//\brief Return an empty page for reuse, only large pages give their memory back
+	inline void ReleasePage(unsigned int a_pageIndex)
+	{
+		Page & page = m_pages[a_pageIndex];
+		if (page.m_type == ePageTypeLarge)
+		{
+			free(page.m_memory);
+			page.m_memory = NULL;
+			page.m_sizeBytes = 0;
+		}
+
+		page.m_usedBytes = 0;
+		page.m_liveBytes = 0;
+		page.m_numLive = 0;
+		page.m_type = ePageTypeFree;
+
+		for (unsigned int i = 0; i < eAllocationCount; ++i)
+		{
+			if (m_fillPage[i] == a_pageIndex)
+			{
+				m_fillPage[i] = s_noPage;
+			}
+		}
+	}
+
+	//\brief Move every live block out of a page so it can be reused
+	//\return true if the page was completely emptied
+	inline bool EvacuatePage(unsigned int a_pageIndex)
+	{
+		Page & page = m_pages[a_pageIndex];
+		size_t offset = 0;
+		while (offset < page.m_usedBytes && page.m_numLive > 0)
+		{
+			BlockHeader * header = (BlockHeader *)(page.m_memory + offset);
+			const size_t blockSizeBytes = header->m_sizeBytes;
+			offset += blockSizeBytes;
+			if (header->m_handleIndex == s_freeBlock)
+			{
+				continue;
+			}
+
+			// Out of room elsewhere, leave the rest of the page for a later pass
+			const unsigned int destPage = FindPageWithSpace(blockSizeBytes, eAllocationMovable, a_pageIndex);
+			if (destPage == s_noPage)
+			{
+				return false;
+			}
+
+			// Copy the allocation and point the handle at it's new home
+			const unsigned int handleIndex = header->m_handleIndex;
+			void * newPtr = PlaceBlock(destPage, blockSizeBytes, handleIndex);
+			memcpy(newPtr, header + 1, blockSizeBytes - sizeof(BlockHeader));
+			m_handles[handleIndex].m_ptr = newPtr;
+			m_handles[handleIndex].m_page = destPage;
+
+			// The last block freed will release the page
+			FreeBlock(a_pageIndex, header);
+		}
+
+		return page.m_type == ePageTypeFree;
+	}
+
+	//\brief Page fits another block on the end
+	inline bool HasSpace(unsigned int a_pageIndex, size_t a_blockSizeBytes) const
+	{
+		return m_pages[a_pageIndex].m_usedBytes + a_blockSizeBytes <= m_pages[a_pageIndex].m_sizeBytes;
+	}
+
+	//\brief Pop a handle table entry off the free stack, growing the table if needed
+	inline bool AcquireHandle(unsigned int & a_index_OUT)
+	{
+		if (m_numFreeHandles == 0)
+		{
+			// Grow the table by doubling, new entries are pushed so the lowest index is used first
+			const unsigned int newCapacity = m_handleCapacity == 0 ? 256 : m_handleCapacity * 2;
+			if (newCapacity > s_maxHandles)
+			{
+				return false;
+			}
+
+			HandleEntry * newHandles = (HandleEntry *)realloc(m_handles, sizeof(HandleEntry) * newCapacity);
+			if (newHandles == NULL)
+			{
+				return false;
+			}
+			m_handles = newHandles;
+
+			unsigned int * newFreeHandles = (unsigned int *)realloc(m_freeHandles, sizeof(unsigned int) * newCapacity);
+			if (newFreeHandles == NULL)
+			{
+				return false;
+			}
+			m_freeHandles = newFreeHandles;
+
+			for (unsigned int i = m_handleCapacity; i < newCapacity; ++i)
+			{
+				m_handles[i].m_ptr = NULL;
+				m_handles[i].m_page = s_noPage;
+				m_handles[i].m_generation = 1;
+				m_handles[i].m_inUse = false;
+				m_freeHandles[m_numFreeHandles++] = newCapacity - 1 - (i - m_handleCapacity);
+			}
+			m_handleCapacity = newCapacity;
+		}
+
+		a_index_OUT = m_freeHandles[--m_numFreeHandles];
+		m_handles[a_index_OUT].m_inUse = true;
+		return true;
+	}
+
+	//\brief Push a handle table entry back on the free stack and bump the generation so old handles fail
+	inline void ReleaseHandle(unsigned int a_index)
+	{
+		HandleEntry & entry = m_handles[a_index];
+		entry.m_ptr = NULL;
+		entry.m_page = s_noPage;
+		entry.m_inUse = false;
+		entry.m_generation = entry.m_generation >= s_maxGeneration ? 1 : entry.m_generation + 1;
+		m_freeHandles[m_numFreeHandles++] = a_index;
+	}
+
+	Page * m_pages;								///< Table of all pages, memory for each is allocated on first use
+	HandleEntry * m_handles;					///< Table of where every allocation lives
+	unsigned int * m_freeHandles;				///< Stack of unused handle table entries
+	size_t m_pageSizeBytes;						///< Size of every page that is not large
+	unsigned int m_maxPages;					///< Size of the page table
+	unsigned int m_handleCapacity;				///< Size of the handle table
+	unsigned int m_numFreeHandles;				///< How many entries are on the free stack
+	unsigned int m_numAllocations;				///< How many allocations are live
+	unsigned int m_compactCursor;				///< Which page compaction will visit next
+	unsigned int m_fillPage[eAllocationCount];	///< The page each kind of allocation was last placed in
+};
+
+#endif // _CORE_PAGE_ALLOCATOR_
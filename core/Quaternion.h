@@ -5,6 +5,7 @@
 #include <math.h>
 #include <stdio.h>
 
+#include "Float4.h"
 #include "MathUtils.h"
 #include "Matrix.h"
 #include "Vector.h"
@@ -24,24 +25,34 @@ public:
 
 	// Utility functions
 	float GetMagnitude() const { return sqrt((w*w) + (x*x) + (y*y) + (z*z)); }
-	bool IsUnit() const { return abs(1.0f - ((w*w) + (x*x) + (y*y) + (z*z))) > EPSILON; }
+	bool IsUnit() const { return fabs(1.0f - ((w*w) + (x*x) + (y*y) + (z*z))) < EPSILON; }
 	Matrix GetRotationMatrix() const { return Matrix(	(w*w)+(x*x)-(y*y)-(z*z),	(2.0f*x*y)-(2.0f*w*z),		(2.0f*x*z)+(2.0f*w*y),		0.0f,
 														(2.0f*x*y)+(2.0f*w*z),		(w*w)-(x*x)+(y*y)-(z*z),	(2.0f*y*z)+(2.0f*w*x),		0.0f,
-														(2.0f*x*z)-(2.0f*w*y),		(2.0f*y*z)-(2.0f*w*x),		(w*2)-(x*x)-(y*y)+(z*z),	0.0f,
-														0.0f,						0.0f						0.0f,						1.0f); }
+														(2.0f*x*z)-(2.0f*w*y),		(2.0f*y*z)-(2.0f*w*x),		(w*w)-(x*x)-(y*y)+(z*z),	0.0f,
+														0.0f,						0.0f,						0.0f,						1.0f); }
 
 	// Mutators
 	void Normalize() { float mag = GetMagnitude(); w /= mag; x /= mag; y /= mag; z /= mag; }
-	void Set(Vector a_axis, float a_angle) { Quaternion newQ(a_axis, f_angle); w = newQ.w; x = newQ.x; y = newQ.y; z = newQ.z; }
+	void Set(Vector a_axis, float a_angle) { Quaternion newQ(a_axis, a_angle); w = newQ.w; x = newQ.x; y = newQ.y; z = newQ.z; }
 
 	// Operator overloads
-	Quaternion operator * (const Quaternion & a_quat) const { return Quaternion(	(w*a_quat.w - x*a_quat.x - y*a_quat.y - z*a_quat.z), 
-																					(w*a_quat.x + x*a_quat.w + y*a_quat.z - z*a_quat.y),
-																					(w*a_quat.y - x*a_quat.z + y*a_quat.w + z*a_quat.x),
-																					(w*a_quat.z + x*a_quat.y - y*a_quat.x + z*a_quat.w)	); }
+	Quaternion operator * (const Quaternion & a_quat) const 
+	{ 
+		// Each component of the left scales a shuffled and signed copy of the right, components are stored w, x, y, z
+		const Float4 lhs = Float4::Load(&w);
+		const Float4 rhs = Float4::Load(&a_quat.w);
+		Float4 result = lhs.Broadcast<0>() * rhs;
+		result = Float4::MulAdd(lhs.Broadcast<1>(), rhs.Swizzle<1, 0, 3, 2>() * Float4(-1.0f,  1.0f, -1.0f,  1.0f), result);
+		result = Float4::MulAdd(lhs.Broadcast<2>(), rhs.Swizzle<2, 3, 0, 1>() * Float4(-1.0f,  1.0f,  1.0f, -1.0f), result);
+		result = Float4::MulAdd(lhs.Broadcast<3>(), rhs.Swizzle<3, 2, 1, 0>() * Float4(-1.0f, -1.0f,  1.0f,  1.0f), result);
+
+		Quaternion quatOut;
+		result.Store(&quatOut.w);
+		return quatOut;
+	}
 
 private:
-	float w, x, y, z;
+	float w, x, y, z;		// Must stay in this order and contiguous for Float4 loads
 };
 
 #endif //_CORE_QUATERNION_
\ No newline at end of file
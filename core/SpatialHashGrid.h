@@ -0,0 +1,504 @@
+#ifndef _CORE_SPATIAL_HASH_GRID_
+#define _CORE_SPATIAL_HASH_GRID_
+#pragma once
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Vector.h"
+
+//\brief A uniform grid over unbounded space for finding items near a point or inside a box without
+//		 testing every item. Cells are hashed into a fixed number of buckets so only occupied space
+//		 costs memory. Each item is an axis aligned box that is linked into every cell it touches,
+//		 items that would touch too many cells go on an oversized list that every query checks instead.
+//		 A query returns each item once no matter how many cells it is in.
+//		 The data stored with each item is copied around so use pointers or handles.
+template <typename T>
+class SpatialHashGrid
+{
+public:
+
+	//\brief Items are referred to by an id that stays the same for as long as the item is in the grid
+	typedef unsigned int ItemId;
+	static const ItemId s_invalidItem = 0xffffffff;
+
+	//\brief Default filter for queries accepts every item whose box overlaps the query box
+	struct AcceptAll
+	{
+		inline bool operator()(const T & a_data, const Vector & a_min, const Vector & a_max) const { return true; }
+	};
+
+	SpatialHashGrid()
+		: m_buckets(NULL)
+		, m_items(NULL)
+		, m_entries(NULL)
+		, m_cellSize(1.0f)
+		, m_invCellSize(1.0f)
+		, m_numBuckets(0)
+		, m_numItems(0)
+		, m_itemCapacity(0)
+		, m_entryCapacity(0)
+		, m_firstFreeItem(s_invalidIndex)
+		, m_firstFreeEntry(s_invalidIndex)
+		, m_queryStamp(0)
+	{ }
+
+	//\brief Make sure memory is freed if the grid is deleted
+	~SpatialHashGrid() { Done(); }
+
+	//\brief Setup the grid before use
+	//\param a_cellSize how big each cube of space is, around the size of a typical item works best
+	//\param a_numBuckets how many buckets the cells are hashed to, rounded up to a power of two
+	//\return true if the memory for the buckets was allocated
+	inline bool Init(float a_cellSize, unsigned int a_numBuckets)
+	{
+		if (m_buckets != NULL || a_cellSize <= 0.0f)
+		{
+			return false;
+		}
+
+		m_numBuckets = 1;
+		while (m_numBuckets < a_numBuckets)
+		{
+			m_numBuckets *= 2;
+		}
+
+		// One more bucket on the end for the oversized items
+		m_buckets = (unsigned int *)malloc(sizeof(unsigned int) * (m_numBuckets + 1));
+		if (m_buckets == NULL)
+		{
+			m_numBuckets = 0;
+			return false;
+		}
+		memset(m_buckets, 0xff, sizeof(unsigned int) * (m_numBuckets + 1));
+
+		m_cellSize = a_cellSize;
+		m_invCellSize = 1.0f / a_cellSize;
+		return true;
+	}
+
+	//\brief Release all memory, the grid can be initialised again afterwards
+	inline void Done()
+	{
+		free(m_buckets);
+		free(m_items);
+		free(m_entries);
+		m_buckets = NULL;
+		m_items = NULL;
+		m_entries = NULL;
+		m_numBuckets = 0;
+		m_numItems = 0;
+		m_itemCapacity = 0;
+		m_entryCapacity = 0;
+		m_firstFreeItem = s_invalidIndex;
+		m_firstFreeEntry = s_invalidIndex;
+	}
+
+	//\brief Add an item to the grid
+	//\param a_data what to return from queries that find the item
+	//\param a_min, a_max the corners of the item's bounding box
+	//\return the id of the item in the grid or s_invalidItem if memory could not be allocated
+	inline ItemId Insert(const T & a_data, const Vector & a_min, const Vector & a_max)
+	{
+		if (m_buckets == NULL)
+		{
+			return s_invalidItem;
+		}
+
+		// Link any new items into the free list after growing
+		if (m_firstFreeItem == s_invalidIndex)
+		{
+			unsigned int oldCapacity = 0;
+			if (!Grow(m_items, m_itemCapacity, oldCapacity))
+			{
+				return s_invalidItem;
+			}
+			for (unsigned int i = oldCapacity; i < m_itemCapacity; ++i)
+			{
+				m_items[i].m_firstEntry = s_removedItem;
+				m_items[i].m_nextFree = i + 1 < m_itemCapacity ? i + 1 : s_invalidIndex;
+			}
+			m_firstFreeItem = oldCapacity;
+		}
+
+		const ItemId itemId = m_firstFreeItem;
+		Item & item = m_items[itemId];
+		m_firstFreeItem = item.m_nextFree;
+		item.m_data = a_data;
+		item.m_firstEntry = s_invalidIndex;
+		item.m_queryStamp = m_queryStamp;
+		++m_numItems;
+
+		if (!LinkItem(itemId, a_min, a_max))
+		{
+			Remove(itemId);
+			return s_invalidItem;
+		}
+		return itemId;
+	}
+
+	//\brief Add many items to the grid at once, the item storage is grown once for all of them
+	//\param a_data, a_mins, a_maxs arrays of a_numItems items and the corners of their bounding boxes
+	//\param a_itemIds_OUT array of a_numItems ids for the new items, in the same order as the items
+	//\return true if every item was added, nothing is added on failure
+	inline bool InsertBatch(const T * a_data, const Vector * a_mins, const Vector * a_maxs, unsigned int a_numItems, ItemId * a_itemIds_OUT)
+	{
+		if (m_buckets == NULL)
+		{
+			return false;
+		}
+
+		// Grow until there are enough free items, the new ones go on the front of the free list
+		while (m_itemCapacity - m_numItems < a_numItems)
+		{
+			unsigned int oldCapacity = 0;
+			if (!Grow(m_items, m_itemCapacity, oldCapacity))
+			{
+				return false;
+			}
+			for (unsigned int i = oldCapacity; i < m_itemCapacity; ++i)
+			{
+				m_items[i].m_firstEntry = s_removedItem;
+				m_items[i].m_nextFree = i + 1 < m_itemCapacity ? i + 1 : m_firstFreeItem;
+			}
+			m_firstFreeItem = oldCapacity;
+		}
+
+		for (unsigned int i = 0; i < a_numItems; ++i)
+		{
+			if ((a_itemIds_OUT[i] = Insert(a_data[i], a_mins[i], a_maxs[i])) == s_invalidItem)
+			{
+				// Only linking can fail by now, take back everything added so far
+				for (unsigned int j = 0; j < i; ++j)
+				{
+					Remove(a_itemIds_OUT[j]);
+				}
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//\brief Change the bounds of an item, the cells are only touched if the item has crossed into a new one
+	//\return true if the item is still in the grid
+	inline bool Move(ItemId a_itemId, const Vector & a_min, const Vector & a_max)
+	{
+		if (!IsValid(a_itemId))
+		{
+			return false;
+		}
+
+		Item & item = m_items[a_itemId];
+		int cellMin[3], cellMax[3];
+		GetCell(a_min, cellMin);
+		GetCell(a_max, cellMax);
+		if (memcmp(cellMin, item.m_cellMin, sizeof(cellMin)) == 0 && memcmp(cellMax, item.m_cellMax, sizeof(cellMax)) == 0)
+		{
+			item.m_min = a_min;
+			item.m_max = a_max;
+			return true;
+		}
+
+		UnlinkItem(a_itemId);
+		if (!LinkItem(a_itemId, a_min, a_max))
+		{
+			Remove(a_itemId);
+			return false;
+		}
+		return true;
+	}
+
+	//\brief Take an item out of the grid, the id may be handed out again by a later insert
+	//\return true if the id referred to an item in the grid
+	inline bool Remove(ItemId a_itemId)
+	{
+		if (!IsValid(a_itemId))
+		{
+			return false;
+		}
+
+		UnlinkItem(a_itemId);
+		m_items[a_itemId].m_nextFree = m_firstFreeItem;
+		m_items[a_itemId].m_firstEntry = s_removedItem;
+		m_firstFreeItem = a_itemId;
+		--m_numItems;
+		return true;
+	}
+
+	//\brief Find every item whose bounding box overlaps a box
+	//\param a_min, a_max the corners of the box to search
+	//\param a_filter is called with each candidate's data and bounds and returns true to include it in the results
+	//\param a_results_OUT pointer to caller supplied storage for the results
+	//\param a_maxResults how many results will fit in the storage, the query stops when it is full
+	//\return the number of results written
+	template <typename Filter>
+	inline unsigned int Query(const Vector & a_min, const Vector & a_max, const Filter & a_filter, T * a_results_OUT, unsigned int a_maxResults)
+	{
+		if (m_numItems == 0 || a_maxResults == 0)
+		{
+			return 0;
+		}
+
+		// A new stamp marks items as seen so items in several cells are only tested once
+		if (++m_queryStamp == 0)
+		{
+			for (unsigned int i = 0; i < m_itemCapacity; ++i)
+			{
+				m_items[i].m_queryStamp = 0;
+			}
+			m_queryStamp = 1;
+		}
+
+		unsigned int numResults = 0;
+		QueryBucket(m_numBuckets, a_min, a_max, a_filter, a_results_OUT, a_maxResults, numResults);
+
+		int cellMin[3], cellMax[3];
+		GetCell(a_min, cellMin);
+		GetCell(a_max, cellMax);
+		if (GetNumCells(cellMin, cellMax) > m_numBuckets)
+		{
+			// Query covers more cells than there are buckets, cheaper to check every bucket once
+			for (unsigned int i = 0; i < m_numBuckets && numResults < a_maxResults; ++i)
+			{
+				QueryBucket(i, a_min, a_max, a_filter, a_results_OUT, a_maxResults, numResults);
+			}
+			return numResults;
+		}
+
+		for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+		{
+			for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+			{
+				for (int z = cellMin[2]; z <= cellMax[2] && numResults < a_maxResults; ++z)
+				{
+					QueryBucket(GetBucket(x, y, z), a_min, a_max, a_filter, a_results_OUT, a_maxResults, numResults);
+				}
+			}
+		}
+		return numResults;
+	}
+	inline unsigned int Query(const Vector & a_min, const Vector & a_max, T * a_results_OUT, unsigned int a_maxResults)
+	{
+		return Query(a_min, a_max, AcceptAll(), a_results_OUT, a_maxResults);
+	}
+
+	//\brief Accessors for items in the grid
+	inline bool IsValid(ItemId a_itemId) const { return a_itemId < m_itemCapacity && m_items[a_itemId].m_firstEntry != s_removedItem; }
+	inline const T & GetData(ItemId a_itemId) const { return m_items[a_itemId].m_data; }
+	inline unsigned int GetNumItems() const { return m_numItems; }
+	inline float GetCellSize() const { return m_cellSize; }
+
+private:
+
+	//\brief The grid is not copyable as it owns it's memory
+	SpatialHashGrid(const SpatialHashGrid &);
+	SpatialHashGrid & operator=(const SpatialHashGrid &);
+
+	static const unsigned int s_invalidIndex = 0xffffffff;		///< End of any list of items or entries
+	static const unsigned int s_removedItem = 0xfffffffe;		///< Marks an item slot as not in use
+	static const unsigned int s_maxCellsPerItem = 32;			///< Items that cover more cells than this are oversized
+	static const unsigned int s_minCapacity = 64;				///< How many items and entries to allocate on first use
+
+	//\brief Everything stored for each item
+	struct Item
+	{
+		T m_data;						///< What the user stored
+		Vector m_min;					///< Bounding box corners
+		Vector m_max;
+		int m_cellMin[3];				///< Range of cells the item is linked into
+		int m_cellMax[3];
+		unsigned int m_firstEntry;		///< Head of the list of cell entries for this item, s_removedItem when not in use
+		unsigned int m_nextFree;		///< Next item in the free list
+		unsigned int m_queryStamp;		///< Last query that tested this item
+	};
+
+	//\brief A link between an item and a bucket, an item has one for every cell it touches
+	struct Entry
+	{
+		unsigned int m_item;			///< Which item this entry belongs to
+		unsigned int m_bucket;			///< Which bucket the entry is linked into
+		unsigned int m_prev;			///< Entries in the same bucket
+		unsigned int m_next;
+		unsigned int m_nextForItem;		///< Next entry belonging to the same item, also used for the free list
+	};
+
+	//\brief Double the size of an array, indices stay valid as the array is only ever added to
+	//\param a_oldCapacity_OUT is set to the first new element
+	template <typename E>
+	static inline bool Grow(E *& a_array, unsigned int & a_capacity, unsigned int & a_oldCapacity_OUT)
+	{
+		const unsigned int newCapacity = a_capacity > 0 ? a_capacity * 2 : s_minCapacity;
+		E * newArray = (E *)realloc(a_array, sizeof(E) * newCapacity);
+		if (newArray == NULL)
+		{
+			return false;
+		}
+		a_array = newArray;
+		a_oldCapacity_OUT = a_capacity;
+		a_capacity = newCapacity;
+		return true;
+	}
+
+	//\brief Convert a position to the integer coordinates of the cell it is in
+	inline void GetCell(const Vector & a_pos, int * a_cell_OUT) const
+	{
+		a_cell_OUT[0] = (int)floorf(a_pos.GetX() * m_invCellSize);
+		a_cell_OUT[1] = (int)floorf(a_pos.GetY() * m_invCellSize);
+		a_cell_OUT[2] = (int)floorf(a_pos.GetZ() * m_invCellSize);
+	}
+
+	//\brief How many cells are in a range, saturates rather than overflowing for huge ranges
+	static inline unsigned int GetNumCells(const int * a_cellMin, const int * a_cellMax)
+	{
+		unsigned int numCells = 1;
+		for (unsigned int i = 0; i < 3; ++i)
+		{
+			const unsigned int extent = (unsigned int)(a_cellMax[i] - a_cellMin[i]) + 1;
+			if (extent > 0xffff || numCells * extent > 0xffff)
+			{
+				return 0xffffffff;
+			}
+			numCells *= extent;
+		}
+		return numCells;
+	}
+
+	//\brief Hash a cell to a bucket with the usual large primes
+	inline unsigned int GetBucket(int a_x, int a_y, int a_z) const
+	{
+		return (((unsigned int)a_x * 73856093u) ^ ((unsigned int)a_y * 19349663u) ^ ((unsigned int)a_z * 83492791u)) & (m_numBuckets - 1);
+	}
+
+	//\brief Link an item into every bucket for the cells it covers
+	inline bool LinkItem(ItemId a_itemId, const Vector & a_min, const Vector & a_max)
+	{
+		Item & item = m_items[a_itemId];
+		item.m_min = a_min;
+		item.m_max = a_max;
+		GetCell(a_min, item.m_cellMin);
+		GetCell(a_max, item.m_cellMax);
+
+		if (GetNumCells(item.m_cellMin, item.m_cellMax) > s_maxCellsPerItem)
+		{
+			return AddEntry(a_itemId, m_numBuckets);
+		}
+
+		for (int x = item.m_cellMin[0]; x <= item.m_cellMax[0]; ++x)
+		{
+			for (int y = item.m_cellMin[1]; y <= item.m_cellMax[1]; ++y)
+			{
+				for (int z = item.m_cellMin[2]; z <= item.m_cellMax[2]; ++z)
+				{
+					if (!AddEntry(a_itemId, GetBucket(x, y, z)))
+					{
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	//\brief Add a single entry to the front of a bucket
+	inline bool AddEntry(ItemId a_itemId, unsigned int a_bucket)
+	{
+		if (m_firstFreeEntry == s_invalidIndex)
+		{
+			unsigned int oldCapacity = 0;
+			if (!Grow(m_entries, m_entryCapacity, oldCapacity))
+			{
+				return false;
+			}
+			for (unsigned int i = oldCapacity; i < m_entryCapacity; ++i)
+			{
+				m_entries[i].m_nextForItem = i + 1 < m_entryCapacity ? i + 1 : s_invalidIndex;
+			}
+			m_firstFreeEntry = oldCapacity;
+		}
+
+		const unsigned int entryIndex = m_firstFreeEntry;
+		Entry & entry = m_entries[entryIndex];
+		m_firstFreeEntry = entry.m_nextForItem;
+
+		entry.m_item = a_itemId;
+		entry.m_bucket = a_bucket;
+		entry.m_prev = s_invalidIndex;
+		entry.m_next = m_buckets[a_bucket];
+		if (entry.m_next != s_invalidIndex)
+		{
+			m_entries[entry.m_next].m_prev = entryIndex;
+		}
+		m_buckets[a_bucket] = entryIndex;
+
+		entry.m_nextForItem = m_items[a_itemId].m_firstEntry;
+		m_items[a_itemId].m_firstEntry = entryIndex;
+		return true;
+	}
+
+	//\brief Remove all of an item's entries from their buckets and return them to the free list
+	inline void UnlinkItem(ItemId a_itemId)
+	{
+		unsigned int entryIndex = m_items[a_itemId].m_firstEntry;
+		while (entryIndex != s_invalidIndex)
+		{
+			Entry & entry = m_entries[entryIndex];
+			if (entry.m_prev != s_invalidIndex)
+			{
+				m_entries[entry.m_prev].m_next = entry.m_next;
+			}
+			else
+			{
+				m_buckets[entry.m_bucket] = entry.m_next;
+			}
+			if (entry.m_next != s_invalidIndex)
+			{
+				m_entries[entry.m_next].m_prev = entry.m_prev;
+			}
+
+			const unsigned int nextEntry = entry.m_nextForItem;
+			entry.m_nextForItem = m_firstFreeEntry;
+			m_firstFreeEntry = entryIndex;
+			entryIndex = nextEntry;
+		}
+		m_items[a_itemId].m_firstEntry = s_invalidIndex;
+	}
+
+	//\brief Test every unseen item in a bucket against the query
+	template <typename Filter>
+	inline void QueryBucket(unsigned int a_bucket, const Vector & a_min, const Vector & a_max, const Filter & a_filter, T * a_results_OUT, unsigned int a_maxResults, unsigned int & a_numResults_OUT)
+	{
+		unsigned int entryIndex = m_buckets[a_bucket];
+		while (entryIndex != s_invalidIndex && a_numResults_OUT < a_maxResults)
+		{
+			Item & item = m_items[m_entries[entryIndex].m_item];
+			if (item.m_queryStamp != m_queryStamp)
+			{
+				item.m_queryStamp = m_queryStamp;
+				if (item.m_min.GetX() <= a_max.GetX() && item.m_max.GetX() >= a_min.GetX() &&
+					item.m_min.GetY() <= a_max.GetY() && item.m_max.GetY() >= a_min.GetY() &&
+					item.m_min.GetZ() <= a_max.GetZ() && item.m_max.GetZ() >= a_min.GetZ() &&
+					a_filter(item.m_data, item.m_min, item.m_max))
+				{
+					a_results_OUT[a_numResults_OUT++] = item.m_data;
+				}
+			}
+			entryIndex = m_entries[entryIndex].m_next;
+		}
+	}
+
+	unsigned int * m_buckets;			///< Head entry of each bucket, the extra bucket at the end holds oversized items
+	Item * m_items;						///< Storage for every item
+	Entry * m_entries;					///< Storage for every link between an item and a bucket
+	float m_cellSize;					///< Size of each cell in world units
+	float m_invCellSize;				///< One over the cell size to convert positions to cells
+	unsigned int m_numBuckets;			///< Number of buckets not including the oversized one, always a power of two
+	unsigned int m_numItems;			///< How many items are in the grid
+	unsigned int m_itemCapacity;		///< How many items there is storage for
+	unsigned int m_entryCapacity;		///< How many entries there is storage for
+	unsigned int m_firstFreeItem;		///< Head of the list of unused items
+	unsigned int m_firstFreeEntry;		///< Head of the list of unused entries
+	unsigned int m_queryStamp;			///< Incremented each query so items are only tested once
+};
+
+#endif // _CORE_SPATIAL_HASH_GRID_
@@ -0,0 +1,426 @@
+#ifndef _CORE_SWEEP_AND_PRUNE_
+#define _CORE_SWEEP_AND_PRUNE_
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "HashMap.h"
+#include "Vector.h"
+
+//\brief Finds every pair of overlapping axis aligned boxes in a set by keeping the boxes sorted by their
+//		 smallest x and sweeping along that axis, only boxes whose x ranges overlap are tested on the others.
+//		 The order is kept from one update to the next and fixed up with an insertion sort, which is close
+//		 to linear as items only move a little between updates. Pairs are remembered so each update can
+//		 report which overlaps began, which carried on and which ended.
+//		 Only pairs where at least one item is listening are tracked, so items that never need to be told
+//		 about overlaps cost nothing when they touch each other.
+//		 The data stored with each item is copied around and can be reported after the item is removed, so use handles.
+template <typename T>
+class SweepAndPrune
+{
+public:
+
+	//\brief Items are referred to by the id of their proxy, which stays the same until the item is removed
+	typedef unsigned int ProxyId;
+	static const ProxyId s_invalidProxy = 0xffffffff;
+
+	//\brief How a pair's overlap changed in an update
+	enum eOverlap
+	{
+		eOverlapBegin = 0,		///< The pair started overlapping
+		eOverlapStay,			///< The pair was already overlapping last update
+		eOverlapEnd,			///< The pair stopped overlapping or one of them was removed
+
+		eOverlapCount,
+	};
+
+	SweepAndPrune()
+		: m_proxies(NULL)
+		, m_sortedProxies(NULL)
+		, m_sortedMins(NULL)
+		, m_endedPairs(NULL)
+		, m_numProxies(0)
+		, m_numListening(0)
+		, m_numSorted(0)
+		, m_proxyCapacity(0)
+		, m_endedCapacity(0)
+		, m_firstFreeProxy(s_invalidIndex)
+		, m_firstRemovedProxy(s_invalidIndex)
+		, m_updateStamp(0)
+	{ }
+
+	//\brief Make sure memory is freed if the broadphase is deleted
+	~SweepAndPrune() { Done(); }
+
+	//\brief Release all memory and forget all pairs without reporting them, the broadphase can be used again afterwards
+	inline void Done()
+	{
+		free(m_proxies);
+		free(m_sortedProxies);
+		free(m_sortedMins);
+		free(m_endedPairs);
+		m_pairs.Clear();
+		m_proxies = NULL;
+		m_sortedProxies = NULL;
+		m_sortedMins = NULL;
+		m_endedPairs = NULL;
+		m_numProxies = 0;
+		m_numListening = 0;
+		m_numSorted = 0;
+		m_proxyCapacity = 0;
+		m_endedCapacity = 0;
+		m_firstFreeProxy = s_invalidIndex;
+		m_firstRemovedProxy = s_invalidIndex;
+	}
+
+	//\brief Add an item, it is sorted into place and starts finding overlaps on the next update
+	//\param a_data what to report for pairs the item is in
+	//\param a_min, a_max the corners of the item's bounding box
+	//\param a_listening true if pairs with this item should be reported even if the other item is not listening
+	//\return the id of the item's proxy or s_invalidProxy if memory could not be allocated
+	inline ProxyId Insert(const T & a_data, const Vector & a_min, const Vector & a_max, bool a_listening)
+	{
+		if (m_firstFreeProxy == s_invalidIndex && !Grow())
+		{
+			return s_invalidProxy;
+		}
+
+		const ProxyId proxyId = m_firstFreeProxy;
+		Proxy & proxy = m_proxies[proxyId];
+		m_firstFreeProxy = proxy.m_nextFree;
+		proxy.m_data = a_data;
+		proxy.m_min = a_min;
+		proxy.m_max = a_max;
+		proxy.m_nextFree = s_invalidIndex;
+		proxy.m_state = eProxyInUse;
+		proxy.m_listening = a_listening;
+		m_numListening += a_listening ? 1 : 0;
+		++m_numProxies;
+
+		// New items go on the end of the order, the next sort moves them into place
+		m_sortedProxies[m_numSorted] = proxyId;
+		m_sortedMins[m_numSorted++] = a_min.GetX();
+		return proxyId;
+	}
+
+	//\brief Change the bounds of an item, the order is fixed up on the next update
+	//\return true if the id referred to an item
+	inline bool Move(ProxyId a_proxyId, const Vector & a_min, const Vector & a_max)
+	{
+		if (!IsValid(a_proxyId))
+		{
+			return false;
+		}
+		m_proxies[a_proxyId].m_min = a_min;
+		m_proxies[a_proxyId].m_max = a_max;
+		return true;
+	}
+
+	//\brief Take an item out, it's pairs are reported as ended on the next update and the id is not handed out again until then
+	//\return true if the id referred to an item
+	inline bool Remove(ProxyId a_proxyId)
+	{
+		if (!IsValid(a_proxyId))
+		{
+			return false;
+		}
+
+		Proxy & proxy = m_proxies[a_proxyId];
+		m_numListening -= proxy.m_listening ? 1 : 0;
+		proxy.m_state = eProxyRemoved;
+		proxy.m_nextFree = m_firstRemovedProxy;
+		m_firstRemovedProxy = a_proxyId;
+		--m_numProxies;
+		return true;
+	}
+
+	//\brief Change whether pairs with an item are reported, takes effect on the next update
+	inline void SetListening(ProxyId a_proxyId, bool a_listening)
+	{
+		if (IsValid(a_proxyId) && m_proxies[a_proxyId].m_listening != a_listening)
+		{
+			m_proxies[a_proxyId].m_listening = a_listening;
+			m_numListening += a_listening ? 1 : -1;
+		}
+	}
+
+	//\brief Sort the items, find every overlapping pair and report how each pair changed since the last update.
+	//		 Overlaps that began or carried on are reported first, then the ones that ended. The callback can
+	//		 insert, move and remove items, the changes are picked up by the next update.
+	//\param a_callback is called as a_callback(data1, data2, overlap) for each pair, the data of the item
+	//		 with the lower proxy id is always first so the same pair is always reported the same way round
+	//\return how many pairs are overlapping
+	template <typename TCallback>
+	inline unsigned int Update(const TCallback & a_callback)
+	{
+		return Update(BoxOverlap(), a_callback);
+	}
+
+	//\brief Update with a narrowphase that tests the shapes inside the boxes, pairs whose boxes overlap but whose
+	//		 shapes don't are treated as not overlapping so they don't begin, or end if they had begun
+	//\param a_overlapTest is called as a_overlapTest(data1, data2) for each pair of boxes that overlap, the same
+	//		 way round as the callback, and returns true if the items really overlap
+	template <typename TOverlapTest, typename TCallback>
+	inline unsigned int Update(const TOverlapTest & a_overlapTest, const TCallback & a_callback)
+	{
+		++m_updateStamp;
+
+		// Ids removed from here on have to wait for the next update as their pairs are still to be reported
+		unsigned int removedProxies = m_firstRemovedProxy;
+		m_firstRemovedProxy = s_invalidIndex;
+
+		// The order is always kept up to date, but nothing is found when nobody is listening. The end
+		// of pairs that were found before is still reported.
+		SortProxies();
+		const unsigned int numOverlaps = m_numListening > 0 ? FindPairs(a_overlapTest) : 0;
+		ReportPairs(a_callback);
+
+		// Removed items had their pairs ended so the ids are free to be used again
+		while (removedProxies != s_invalidIndex)
+		{
+			Proxy & proxy = m_proxies[removedProxies];
+			const unsigned int nextRemoved = proxy.m_nextFree;
+			proxy.m_state = eProxyFree;
+			proxy.m_nextFree = m_firstFreeProxy;
+			m_firstFreeProxy = removedProxies;
+			removedProxies = nextRemoved;
+		}
+
+		return numOverlaps;
+	}
+
+	//\brief Accessors for items in the broadphase
+	inline bool IsValid(ProxyId a_proxyId) const { return a_proxyId < m_proxyCapacity && m_proxies[a_proxyId].m_state == eProxyInUse; }
+	inline const T & GetData(ProxyId a_proxyId) const { return m_proxies[a_proxyId].m_data; }
+	inline unsigned int GetNumProxies() const { return m_numProxies; }
+	inline unsigned int GetNumPairs() const { return m_pairs.GetCount(); }
+
+private:
+
+	//\brief The broadphase is not copyable as it owns it's memory
+	SweepAndPrune(const SweepAndPrune &);
+	SweepAndPrune & operator=(const SweepAndPrune &);
+
+	static const unsigned int s_invalidIndex = 0xffffffff;		///< End of the free and removed lists
+	static const unsigned int s_minCapacity = 64;				///< How many proxies and ended pairs to allocate on first use
+
+	//\brief Proxies on the free list can be handed out, removed ones wait for an update to report their pairs ending
+	enum eProxyState
+	{
+		eProxyFree = 0,
+		eProxyInUse,
+		eProxyRemoved,
+	};
+
+	//\brief Everything stored for each item
+	struct Proxy
+	{
+		T m_data;						///< What the user stored
+		Vector m_min;					///< Bounding box corners
+		Vector m_max;
+		unsigned int m_nextFree;		///< Next proxy in the free or removed list
+		eProxyState m_state;			///< If the proxy is in use
+		bool m_listening;				///< If pairs with this item are reported
+	};
+
+	//\brief A pair of items that were overlapping as of the update stamp
+	struct Pair
+	{
+		T m_data1;						///< Data of the item with the lower proxy id
+		T m_data2;						///< Data of the item with the higher proxy id
+		unsigned int m_updateStamp;		///< Last update the pair was found overlapping
+		bool m_begun;					///< Set until the start of the overlap has been reported
+	};
+
+	//\brief Overlap test for updates without a narrowphase, the boxes overlapping is enough
+	struct BoxOverlap
+	{
+		inline bool operator()(const T & a_data1, const T & a_data2) const { return true; }
+	};
+
+	//\brief Pairs are keyed by both proxy ids, lowest in the top half
+	typedef unsigned long long PairKey;
+	struct PairHash
+	{
+		inline unsigned int operator()(const PairKey & a_key) const { return (unsigned int)(a_key ^ (a_key >> 32)); }
+	};
+	typedef HashMap<PairKey, Pair, PairHash> PairMap;
+
+	static inline PairKey GetPairKey(ProxyId a_proxyId1, ProxyId a_proxyId2)
+	{
+		return a_proxyId1 < a_proxyId2 ? ((PairKey)a_proxyId1 << 32) | a_proxyId2 : ((PairKey)a_proxyId2 << 32) | a_proxyId1;
+	}
+
+	//\brief Double the proxy storage and the sorted order with it, the order can never hold more than every proxy
+	inline bool Grow()
+	{
+		const unsigned int oldCapacity = m_proxyCapacity;
+		const unsigned int newCapacity = oldCapacity > 0 ? oldCapacity * 2 : s_minCapacity;
+		Proxy * newProxies = (Proxy *)realloc(m_proxies, sizeof(Proxy) * newCapacity);
+		if (newProxies == NULL)
+		{
+			return false;
+		}
+		m_proxies = newProxies;
+		ProxyId * newSortedProxies = (ProxyId *)realloc(m_sortedProxies, sizeof(ProxyId) * newCapacity);
+		if (newSortedProxies == NULL)
+		{
+			return false;
+		}
+		m_sortedProxies = newSortedProxies;
+		float * newSortedMins = (float *)realloc(m_sortedMins, sizeof(float) * newCapacity);
+		if (newSortedMins == NULL)
+		{
+			return false;
+		}
+		m_sortedMins = newSortedMins;
+
+		for (unsigned int i = oldCapacity; i < newCapacity; ++i)
+		{
+			m_proxies[i].m_state = eProxyFree;
+			m_proxies[i].m_nextFree = i + 1 < newCapacity ? i + 1 : s_invalidIndex;
+		}
+		m_firstFreeProxy = oldCapacity;
+		m_proxyCapacity = newCapacity;
+		return true;
+	}
+
+	//\brief Drop removed items from the order, pick up where the rest have moved to and sort them by their smallest x
+	inline void SortProxies()
+	{
+		unsigned int numSorted = 0;
+		for (unsigned int i = 0; i < m_numSorted; ++i)
+		{
+			const ProxyId proxyId = m_sortedProxies[i];
+			if (m_proxies[proxyId].m_state == eProxyInUse)
+			{
+				m_sortedProxies[numSorted] = proxyId;
+				m_sortedMins[numSorted++] = m_proxies[proxyId].m_min.GetX();
+			}
+		}
+		m_numSorted = numSorted;
+
+		// Insertion sort is cheap as the order from the last update is almost right
+		for (unsigned int i = 1; i < m_numSorted; ++i)
+		{
+			const float sortMin = m_sortedMins[i];
+			const ProxyId proxyId = m_sortedProxies[i];
+			unsigned int insertIndex = i;
+			for (; insertIndex > 0 && m_sortedMins[insertIndex - 1] > sortMin; --insertIndex)
+			{
+				m_sortedMins[insertIndex] = m_sortedMins[insertIndex - 1];
+				m_sortedProxies[insertIndex] = m_sortedProxies[insertIndex - 1];
+			}
+			m_sortedMins[insertIndex] = sortMin;
+			m_sortedProxies[insertIndex] = proxyId;
+		}
+	}
+
+	//\brief Sweep along x testing each item against those that start before it ends and stamp the pairs that overlap
+	//\param a_overlapTest has the final say on pairs whose boxes overlap
+	//\return how many pairs are overlapping
+	template <typename TOverlapTest>
+	inline unsigned int FindPairs(const TOverlapTest & a_overlapTest)
+	{
+		unsigned int numOverlaps = 0;
+		for (unsigned int i = 0; i < m_numSorted; ++i)
+		{
+			const ProxyId proxyId1 = m_sortedProxies[i];
+			const Proxy & proxy1 = m_proxies[proxyId1];
+			const float maxX = proxy1.m_max.GetX();
+			for (unsigned int j = i + 1; j < m_numSorted && m_sortedMins[j] <= maxX; ++j)
+			{
+				const ProxyId proxyId2 = m_sortedProxies[j];
+				const Proxy & proxy2 = m_proxies[proxyId2];
+				if ((proxy1.m_listening || proxy2.m_listening) &&
+					proxy1.m_min.GetY() <= proxy2.m_max.GetY() && proxy1.m_max.GetY() >= proxy2.m_min.GetY() &&
+					proxy1.m_min.GetZ() <= proxy2.m_max.GetZ() && proxy1.m_max.GetZ() >= proxy2.m_min.GetZ())
+				{
+					const T & data1 = proxyId1 < proxyId2 ? proxy1.m_data : proxy2.m_data;
+					const T & data2 = proxyId1 < proxyId2 ? proxy2.m_data : proxy1.m_data;
+					if (!a_overlapTest(data1, data2))
+					{
+						continue;
+					}
+
+					++numOverlaps;
+					const PairKey pairKey = GetPairKey(proxyId1, proxyId2);
+					if (Pair * pair = m_pairs.Find(pairKey))
+					{
+						pair->m_updateStamp = m_updateStamp;
+					}
+					else
+					{
+						Pair newPair;
+						newPair.m_data1 = data1;
+						newPair.m_data2 = data2;
+						newPair.m_updateStamp = m_updateStamp;
+						newPair.m_begun = true;
+						m_pairs.Insert(pairKey, newPair);
+					}
+				}
+			}
+		}
+		return numOverlaps;
+	}
+
+	//\brief Report every pair found this update and then those that were not, which are forgotten
+	template <typename TCallback>
+	inline void ReportPairs(const TCallback & a_callback)
+	{
+		// Pairs can't be removed while iterating so the ended ones are gathered first
+		unsigned int numEnded = 0;
+		for (typename PairMap::Iterator it = m_pairs.Begin(); it != m_pairs.End(); ++it)
+		{
+			Pair & pair = it.GetValue();
+			if (pair.m_updateStamp == m_updateStamp)
+			{
+				a_callback(pair.m_data1, pair.m_data2, pair.m_begun ? eOverlapBegin : eOverlapStay);
+				pair.m_begun = false;
+			}
+			else if (numEnded < m_endedCapacity || GrowEndedPairs())
+			{
+				m_endedPairs[numEnded++] = it.GetKey();
+			}
+		}
+
+		for (unsigned int i = 0; i < numEnded; ++i)
+		{
+			Pair endedPair;
+			m_pairs.Get(m_endedPairs[i], endedPair);
+			m_pairs.Remove(m_endedPairs[i]);
+			a_callback(endedPair.m_data1, endedPair.m_data2, eOverlapEnd);
+		}
+	}
+
+	//\brief Double the scratch list of ended pairs, pairs that don't fit are ended on a later update
+	inline bool GrowEndedPairs()
+	{
+		const unsigned int newCapacity = m_endedCapacity > 0 ? m_endedCapacity * 2 : s_minCapacity;
+		PairKey * newEndedPairs = (PairKey *)realloc(m_endedPairs, sizeof(PairKey) * newCapacity);
+		if (newEndedPairs == NULL)
+		{
+			return false;
+		}
+		m_endedPairs = newEndedPairs;
+		m_endedCapacity = newCapacity;
+		return true;
+	}
+
+	Proxy * m_proxies;					///< Storage for every item
+	ProxyId * m_sortedProxies;			///< Items in order of their smallest x as of the last update, new items on the end
+	float * m_sortedMins;				///< Smallest x of each item in the sorted order, kept apart so the sweep reads them in a line
+	PairKey * m_endedPairs;				///< Scratch list of pairs that stopped overlapping
+	PairMap m_pairs;					///< Every pair that was overlapping on the last update
+	unsigned int m_numProxies;			///< How many items are in the broadphase
+	unsigned int m_numListening;		///< How many items have pairs reported
+	unsigned int m_numSorted;			///< How many ids are in the sorted order, including removed items not yet dropped
+	unsigned int m_proxyCapacity;		///< How many items there is storage for
+	unsigned int m_endedCapacity;		///< How many ended pairs there is scratch space for
+	unsigned int m_firstFreeProxy;		///< Head of the list of unused proxies
+	unsigned int m_firstRemovedProxy;	///< Head of the list of proxies removed since the last update
+	unsigned int m_updateStamp;			///< Incremented each update so pairs that were not found can be told apart
+};
+
+#endif // _CORE_SWEEP_AND_PRUNE_
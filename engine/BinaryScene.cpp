@@ -0,0 +1,253 @@
+#include <stdlib.h>
+
+#include "GameObject.h"
+#include "Log.h"
+
+#include "BinaryScene.h"
+
+using namespace std;	//< For fstream operations
+
+const unsigned int BinaryScene::s_magic = 0x424e4353;	// SCNB
+const unsigned int BinaryScene::s_version = 1;
+
+bool BinaryScene::Load(const char * a_filePath)
+{
+	Unload();
+
+	// Map the file copy on write so fixing up the pointers doesn't touch the file
+	m_file = CreateFile(a_filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	const DWORD fileSize = GetFileSize(m_file, NULL);
+	if (fileSize != INVALID_FILE_SIZE && fileSize >= sizeof(Header))
+	{
+		m_mapping = CreateFileMapping(m_file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (m_mapping != NULL)
+		{
+			m_view = MapViewOfFile(m_mapping, FILE_MAP_COPY, 0, 0, 0);
+		}
+	}
+	if (m_view == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to map compiled scene file %s", a_filePath);
+		Unload();
+		return false;
+	}
+
+	// Files from older versions of the code are compiled again from the text so no error
+	Header * header = (Header *)m_view;
+	const size_t recordsSize = sizeof(Header) + sizeof(Template) * header->m_numTemplates + sizeof(Object) * header->m_numObjects;
+	if (header->m_magic != s_magic || header->m_version != s_version || header->m_fileSize != fileSize || recordsSize > fileSize)
+	{
+		Unload();
+		return false;
+	}
+
+	// The string table has to end with a terminator so no string can run off the end of the file
+	if (fileSize > recordsSize && ((const char *)m_view)[fileSize - 1] != '\0')
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Compiled scene file %s is corrupt", a_filePath);
+		Unload();
+		return false;
+	}
+
+	// Records follow the header and strings follow the records
+	m_templates = (Template *)(header + 1);
+	m_objects = (Object *)(m_templates + header->m_numTemplates);
+	m_header = header;
+	bool fixedUp = FixUpString(header->m_name);
+	for (unsigned int i = 0; i < header->m_numTemplates && fixedUp; ++i)
+	{
+		Template & curTemplate = m_templates[i];
+		fixedUp =	FixUpString(curTemplate.m_path) &&
+					FixUpString(curTemplate.m_name) &&
+					FixUpString(curTemplate.m_model) &&
+					FixUpString(curTemplate.m_texture);
+	}
+	for (unsigned int i = 0; i < header->m_numObjects && fixedUp; ++i)
+	{
+		Object & curObject = m_objects[i];
+		fixedUp =	FixUpString(curObject.m_name) &&
+					curObject.m_template < header->m_numTemplates &&
+					curObject.m_parent < (int)i;
+	}
+
+	if (!fixedUp)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Compiled scene file %s is corrupt", a_filePath);
+		Unload();
+		return false;
+	}
+
+	return true;
+}
+
+void BinaryScene::Unload()
+{
+	if (m_view != NULL)
+	{
+		UnmapViewOfFile(m_view);
+	}
+	if (m_mapping != NULL)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+	}
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+	m_view = NULL;
+	m_header = NULL;
+	m_templates = NULL;
+	m_objects = NULL;
+}
+
+bool BinaryScene::Write(const char * a_filePath, const char * a_name, bool a_beginLoaded, bool a_parallelUpdate, const FileManager::Timestamp & a_sourceTimeStamp,
+						const Template * a_templates, unsigned int a_numTemplates, const Object * a_objects, unsigned int a_numObjects)
+{
+	// Work out the size of the whole file so it can be built in memory and written in one go
+	const size_t recordsSize = sizeof(Header) + sizeof(Template) * a_numTemplates + sizeof(Object) * a_numObjects;
+	size_t fileSize = recordsSize + GetStringSize(a_name);
+	for (unsigned int i = 0; i < a_numTemplates; ++i)
+	{
+		const Template & curTemplate = a_templates[i];
+		fileSize += GetStringSize(curTemplate.m_path) + GetStringSize(curTemplate.m_name) + GetStringSize(curTemplate.m_model) + GetStringSize(curTemplate.m_texture);
+	}
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		fileSize += GetStringSize(a_objects[i].m_name);
+	}
+
+	char * fileBuf = (char *)malloc(fileSize);
+	if (fileBuf == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to compile scene file %s", a_filePath);
+		return false;
+	}
+	memset(fileBuf, 0, fileSize);
+
+	// Records are copied as they are with the strings swapped for offsets
+	size_t stringOffset = recordsSize;
+	Header * header = (Header *)fileBuf;
+	header->m_magic = s_magic;
+	header->m_version = s_version;
+	header->m_fileSize = (unsigned int)fileSize;
+	header->m_flags = (a_beginLoaded ? eFlagBeginLoaded : 0) | (a_parallelUpdate ? eFlagParallelUpdate : 0);
+	header->m_sourceTimeStamp = a_sourceTimeStamp;
+	header->m_name = WriteString(a_name, fileBuf, stringOffset);
+	header->m_numTemplates = a_numTemplates;
+	header->m_numObjects = a_numObjects;
+
+	Template * templates = (Template *)(header + 1);
+	for (unsigned int i = 0; i < a_numTemplates; ++i)
+	{
+		templates[i] = a_templates[i];
+		templates[i].m_path = WriteString(a_templates[i].m_path, fileBuf, stringOffset);
+		templates[i].m_name = WriteString(a_templates[i].m_name, fileBuf, stringOffset);
+		templates[i].m_model = WriteString(a_templates[i].m_model, fileBuf, stringOffset);
+		templates[i].m_texture = WriteString(a_templates[i].m_texture, fileBuf, stringOffset);
+	}
+
+	Object * objects = (Object *)(templates + a_numTemplates);
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		objects[i] = a_objects[i];
+		objects[i].m_name = WriteString(a_objects[i].m_name, fileBuf, stringOffset);
+	}
+
+	// Write out the whole file
+	bool written = false;
+	ofstream file(a_filePath, ios::out | ios::binary | ios::trunc);
+	if (file.is_open())
+	{
+		file.write(fileBuf, fileSize);
+		written = file.good();
+		file.close();
+	}
+	free(fileBuf);
+
+	if (!written)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to write compiled scene file %s", a_filePath);
+	}
+	return written;
+}
+
+bool BinaryScene::ReadTemplate(GameFile & a_templateFile, Template & a_template_OUT)
+{
+	GameFile::Object * object = a_templateFile.FindObject(STRING_HASH("gameObject"));
+	if (object == NULL)
+	{
+		return false;
+	}
+
+	// Name
+	if (GameFile::Property * name = object->FindProperty(STRING_HASH("name")))
+	{
+		a_template_OUT.m_name = name->GetString();
+	}
+	// Model file
+	if (GameFile::Property * model = object->FindProperty(STRING_HASH("model")))
+	{
+		a_template_OUT.m_model = model->GetString();
+	}
+	// Clipping type
+	if (GameFile::Property * clipType = object->FindProperty(STRING_HASH("clipType")))
+	{
+		if (strstr(clipType->GetString(), "sphere") != NULL)
+		{
+			a_template_OUT.m_clipType = GameObject::eClipTypeSphere;
+		}
+		else if (strstr(clipType->GetString(), "axisbox") != NULL)
+		{
+			a_template_OUT.m_clipType = GameObject::eClipTypeAxisBox;
+		}
+	}
+	// Clipping size
+	if (GameFile::Property * clipSize = object->FindProperty(STRING_HASH("clipSize")))
+	{
+		a_template_OUT.m_clipSize = clipSize->GetVector();
+	}
+	// Objects that can't update alongside others
+	if (GameFile::Property * mainThread = object->FindProperty(STRING_HASH("updateOnMainThread")))
+	{
+		a_template_OUT.m_updateOnMainThread = mainThread->GetBool();
+	}
+	// TODO Pos, rot, shader, etc
+
+	return true;
+}
+
+bool BinaryScene::FixUpString(const char *& a_string)
+{
+	// No string is written as 0, the header is always at the start so no string can be
+	const size_t offset = (size_t)a_string;
+	if (offset == 0)
+	{
+		return true;
+	}
+	if (offset < sizeof(Header) || offset >= m_header->m_fileSize)
+	{
+		return false;
+	}
+	a_string = (const char *)m_view + offset;
+	return true;
+}
+
+const char * BinaryScene::WriteString(const char * a_string, char * a_fileBuf, size_t & a_offset)
+{
+	if (a_string == NULL)
+	{
+		return NULL;
+	}
+
+	const size_t stringSize = GetStringSize(a_string);
+	const size_t stringOffset = a_offset;
+	memcpy(a_fileBuf + stringOffset, a_string, stringSize);
+	a_offset += stringSize;
+	return (const char *)stringOffset;
+}
@@ -0,0 +1,141 @@
+#ifndef _ENGINE_BINARY_SCENE_
+#define _ENGINE_BINARY_SCENE_
+#pragma once
+
+#include <windows.h>
+
+#include "../core/Vector.h"
+
+#include "FileManager.h"
+#include "GameFile.h"
+
+//\brief A BinaryScene is a scene compiled out of it's GameFile text and the templates it uses into
+//		 flat arrays of records that can be used straight from a memory mapped file. Templates are
+//		 flattened down to the properties needed to create an object along with the model and texture
+//		 they use, objects are listed parents first with the index of the object they are attached to.
+//		 The file looks like this, string pointers are written as offsets from the start of the file
+//		 and fixed up on load:
+//
+//		 Header | Template records | Object records | Strings
+class BinaryScene
+{
+public:
+
+	//\brief Everything needed to create an object from a template without reading the template file
+	struct Template
+	{
+		Template()
+			: m_path(NULL)
+			, m_name(NULL)
+			, m_model(NULL)
+			, m_texture(NULL)
+			, m_clipType(0)
+			, m_clipSize(0.0f)
+			, m_updateOnMainThread(false) { }
+
+		const char * m_path;					///< Template name as written in the scene, how objects refer to it
+		const char * m_name;					///< Default name for objects created from the template, NULL for none
+		const char * m_model;					///< Path of the model to draw, NULL for none
+		const char * m_texture;					///< Fully qualified path of the model's diffuse texture, NULL for none
+		FileManager::Timestamp m_timeStamp;		///< Modification time of the template file when it was compiled
+		unsigned int m_clipType;				///< Clip type of the object, one of GameObject::eClipType
+		Vector m_clipSize;						///< Dimensions of the clip volume
+		bool m_updateOnMainThread;				///< If the object can't update in parallel with others
+	};
+
+	//\brief An object placed in the scene
+	struct Object
+	{
+		const char * m_name;					///< Name of the object in the scene
+		unsigned int m_template;				///< Index of the template to create the object from
+		int m_parent;							///< Index of the object this one is attached to, always lower than this one, -1 for none
+		Vector m_localPos;						///< Position relative to the parent or the world without one
+	};
+
+	//\brief No work done in the constructor, only Load
+	BinaryScene()
+		: m_file(INVALID_HANDLE_VALUE)
+		, m_mapping(NULL)
+		, m_view(NULL)
+		, m_header(NULL)
+		, m_templates(NULL)
+		, m_objects(NULL) { }
+	~BinaryScene() { Unload(); }
+
+	//\brief Map a compiled scene into memory and fix up the pointers inside it
+	//\param a_filePath the fully qualified path to the .scnb file
+	//\return true if the file was mapped and is the same version as this code
+	bool Load(const char * a_filePath);
+	void Unload();
+	inline bool IsLoaded() const { return m_header != NULL; }
+
+	//\brief Compile a scene to a file that can be loaded with Load
+	//\param a_filePath the fully qualified path to write to
+	//\param a_name the name of the scene
+	//\param a_sourceTimeStamp the modification time of the text scene, to tell when the compiled scene is stale
+	//\param a_templates, a_numTemplates the templates the objects are created from
+	//\param a_objects, a_numObjects the objects in the scene, parents before their children
+	//\return true if the file was written
+	static bool Write(const char * a_filePath, const char * a_name, bool a_beginLoaded, bool a_parallelUpdate, const FileManager::Timestamp & a_sourceTimeStamp,
+					  const Template * a_templates, unsigned int a_numTemplates, const Object * a_objects, unsigned int a_numObjects);
+
+	//\brief Read the object properties out of a template file, the strings point into the game file
+	//\param a_templateFile a loaded template file
+	//\param a_template_OUT is filled with the properties found, the model texture is not filled
+	//\return true if the file had a game object to read from
+	static bool ReadTemplate(GameFile & a_templateFile, Template & a_template_OUT);
+
+	//\brief Accessors for the scene properties and records, only valid while loaded
+	inline const char * GetName() const { return m_header->m_name; }
+	inline bool IsBeginLoaded() const { return (m_header->m_flags & eFlagBeginLoaded) != 0; }
+	inline bool IsParallelUpdate() const { return (m_header->m_flags & eFlagParallelUpdate) != 0; }
+	inline const FileManager::Timestamp & GetSourceTimeStamp() const { return m_header->m_sourceTimeStamp; }
+	inline unsigned int GetNumTemplates() const { return m_header->m_numTemplates; }
+	inline const Template & GetTemplate(unsigned int a_index) const { return m_templates[a_index]; }
+	inline unsigned int GetNumObjects() const { return m_header->m_numObjects; }
+	inline const Object & GetObject(unsigned int a_index) const { return m_objects[a_index]; }
+
+private:
+
+	static const unsigned int s_magic;			///< Identifies a compiled scene file
+	static const unsigned int s_version;		///< Bumped whenever the layout of the records changes
+
+	//\brief Scene settings stored as bits in the header
+	enum eFlags
+	{
+		eFlagBeginLoaded = 1,
+		eFlagParallelUpdate = 2,
+	};
+
+	//\brief The start of every compiled scene file
+	struct Header
+	{
+		unsigned int m_magic;						///< Always s_magic
+		unsigned int m_version;						///< The s_version the file was compiled with
+		unsigned int m_fileSize;					///< Size of the whole file in bytes
+		unsigned int m_flags;						///< Combination of eFlags
+		FileManager::Timestamp m_sourceTimeStamp;	///< Modification time of the text scene when it was compiled
+		const char * m_name;						///< Name of the scene
+		unsigned int m_numTemplates;				///< How many template records follow the header
+		unsigned int m_numObjects;					///< How many object records follow the templates
+	};
+
+	//\brief Turn a string offset written to the file back into a pointer
+	//\return false if the offset is outside the file
+	bool FixUpString(const char *& a_string);
+
+	//\brief Size of a string in the string table, including the terminator
+	static inline size_t GetStringSize(const char * a_string) { return a_string != NULL ? strlen(a_string) + 1 : 0; }
+
+	//\brief Copy a string into the string table and get the offset it is written to
+	static const char * WriteString(const char * a_string, char * a_fileBuf, size_t & a_offset);
+
+	HANDLE m_file;						///< Open handle to the file while it's mapped
+	HANDLE m_mapping;					///< The file mapping object
+	void * m_view;						///< Where the file is mapped in memory, copy on write so pointers can be fixed up
+	Header * m_header;					///< The header at the start of the view
+	Template * m_templates;				///< Template records in the view
+	Object * m_objects;					///< Object records in the view
+};
+
+#endif // _ENGINE_BINARY_SCENE_
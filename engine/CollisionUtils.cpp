@@ -1,15 +1,23 @@
+#include "../core/Float4.h"
 #include "../core/MathUtils.h"
 
 #include "CollisionUtils.h"
 
+//\brief Read one component of a vector, 0 to 2 for x to z
+static inline float GetAxis(const Vector & a_vec, unsigned int a_axis)
+{
+	return a_axis == 0 ? a_vec.GetX() : (a_axis == 1 ? a_vec.GetY() : a_vec.GetZ());
+}
+
 extern bool CollisionUtils::IntersectLinePlane(Vector a_lineStart, Vector a_lineEnd, Vector a_planeCentre, Vector a_planeNormal, Vector & a_intesection_OUT)
 {
-	// Check the line and plane aren't parallel
+	// Check the line and plane aren't parallel, the length of the normal cancels out so it doesn't need to be one
 	Vector line = a_lineEnd - a_lineStart;
-	if (a_planeNormal.LengthSquared() == 1.0f && 
-		!MathUtils::IsZeroEpsilon(line.Dot(a_planeNormal)))
+	const float lineDotNormal = line.Dot(a_planeNormal);
+	if (!MathUtils::IsZeroEpsilon(a_planeNormal.LengthSquared()) && 
+		!MathUtils::IsZeroEpsilon(lineDotNormal))
 	{	
-		float intersectAmount = (a_planeNormal.Dot(a_planeCentre - a_lineStart)) / (a_planeNormal.Dot(a_lineEnd - a_lineStart));
+		float intersectAmount = (a_planeNormal.Dot(a_planeCentre - a_lineStart)) / lineDotNormal;
 		a_intesection_OUT = a_lineStart + (line * intersectAmount);
 		return true;
 	}
@@ -21,88 +29,106 @@ extern bool CollisionUtils::IntersectLinePlane(Vector a_lineStart, Vector a_line
 
 extern bool CollisionUtils::IntersectLineAxisBox(Vector a_lineStart, Vector a_lineEnd, Vector a_boxPos, Vector a_boxDimensions, Vector & a_intersection_OUT)
 {
-	// Check the dimensions of the line against the box
-	const Vector halfDim = a_boxDimensions * 0.5f;
-
-	// Check the front plane of the box first
-	Vector planeCentre = Vector(a_boxPos.GetX(), a_boxPos.GetY() - halfDim.GetY(), a_boxPos.GetZ());
-	if (IntersectLinePlane(a_lineStart, a_lineEnd, planeCentre, Vector(0.0f, -1.0f, 0.0f), a_intersection_OUT))
+	float hitFraction = 0.0f;
+	if (IntersectLineAxisBox(a_lineStart, a_lineEnd, a_boxPos, a_boxDimensions, hitFraction))
 	{
-		if (fabsf(a_intersection_OUT.GetX() - planeCentre.GetX()) <= halfDim.GetX() &&
-			fabsf(a_intersection_OUT.GetY() - planeCentre.GetY()) <= halfDim.GetY() &&
-			fabsf(a_intersection_OUT.GetZ() - planeCentre.GetZ()) <= halfDim.GetZ())
-		{
-			return true;
-		}
+		a_intersection_OUT = a_lineStart + ((a_lineEnd - a_lineStart) * hitFraction);
+		return true;
 	}
+	return false;
+}
 
-	// Check back plane
-	planeCentre = Vector(a_boxPos.GetX(), a_boxPos.GetY() + halfDim.GetY(), a_boxPos.GetZ());
-	if (IntersectLinePlane(a_lineStart, a_lineEnd, planeCentre, Vector(0.0f, 1.0f, 0.0f), a_intersection_OUT))
+extern bool CollisionUtils::IntersectLineAxisBox(Vector a_lineStart, Vector a_lineEnd, Vector a_boxPos, Vector a_boxDimensions, float & a_hitFraction_OUT)
+{
+	// Clip the line against the pair of planes on each axis, it hits if there is any of the line left
+	Vector halfDim = a_boxDimensions * 0.5f;
+	Vector line = a_lineEnd - a_lineStart;
+	float entry = 0.0f;
+	float exit = 1.0f;
+	for (int axis = 0; axis < 3; ++axis)
 	{
-		if (fabsf(a_intersection_OUT.GetX() - planeCentre.GetX()) <= halfDim.GetX() &&
-			fabsf(a_intersection_OUT.GetY() - planeCentre.GetY()) <= halfDim.GetY() &&
-			fabsf(a_intersection_OUT.GetZ() - planeCentre.GetZ()) <= halfDim.GetZ())
+		const float start = a_lineStart.GetValues()[axis];
+		const float dir = line.GetValues()[axis];
+		const float boxMin = a_boxPos.GetValues()[axis] - halfDim.GetValues()[axis];
+		const float boxMax = a_boxPos.GetValues()[axis] + halfDim.GetValues()[axis];
+		if (MathUtils::IsZeroEpsilon(dir))
 		{
-			return true;
+			// Parallel to these planes so the line has to start between them
+			if (start < boxMin || start > boxMax)
+			{
+				return false;
+			}
+			continue;
 		}
-	}
 
-	// Check left plane
-	planeCentre = Vector(a_boxPos.GetX() - halfDim.GetX(), a_boxPos.GetY(), a_boxPos.GetZ());
-	if (IntersectLinePlane(a_lineStart, a_lineEnd, planeCentre, Vector(-1.0f, 0.0f, 0.0f), a_intersection_OUT))
-	{
-		if (fabsf(a_intersection_OUT.GetX() - planeCentre.GetX()) <= halfDim.GetX() &&
-			fabsf(a_intersection_OUT.GetY() - planeCentre.GetY()) <= halfDim.GetY() &&
-			fabsf(a_intersection_OUT.GetZ() - planeCentre.GetZ()) <= halfDim.GetZ())
+		float entryAxis = (boxMin - start) / dir;
+		float exitAxis = (boxMax - start) / dir;
+		if (entryAxis > exitAxis)
 		{
-			return true;
+			const float temp = entryAxis;
+			entryAxis = exitAxis;
+			exitAxis = temp;
 		}
-	}
-
-	// Check right plane
-	planeCentre = Vector(a_boxPos.GetX() + halfDim.GetX(), a_boxPos.GetY(), a_boxPos.GetZ());
-	if (IntersectLinePlane(a_lineStart, a_lineEnd, planeCentre, Vector(1.0f, 0.0f, 0.0f), a_intersection_OUT))
-	{
-		if (fabsf(a_intersection_OUT.GetX() - planeCentre.GetX()) <= halfDim.GetX() &&
-			fabsf(a_intersection_OUT.GetY() - planeCentre.GetY()) <= halfDim.GetY() &&
-			fabsf(a_intersection_OUT.GetZ() - planeCentre.GetZ()) <= halfDim.GetZ())
+		entry = entryAxis > entry ? entryAxis : entry;
+		exit = exitAxis < exit ? exitAxis : exit;
+		if (entry > exit)
 		{
-			return true;
+			return false;
 		}
 	}
 
-	// Check top plane
-	planeCentre = Vector(a_boxPos.GetX(), a_boxPos.GetY(), a_boxPos.GetZ() + halfDim.GetZ());
-	if (IntersectLinePlane(a_lineStart, a_lineEnd, planeCentre, Vector(0.0f, 0.0f, 1.0f), a_intersection_OUT))
+	a_hitFraction_OUT = entry;
+	return true;
+}
+
+extern bool CollisionUtils::IntersectLineBox(Vector a_lineStart, Vector a_lineEnd, Vector a_boxPos, const Matrix & a_boxRotation, Vector a_boxDimensions, float & a_hitFraction_OUT)
+{
+	// In the box's space the box is axis aligned at the origin, fractions along the line are the same in either space
+	const Vector toStart = a_lineStart - a_boxPos;
+	const Vector toEnd = a_lineEnd - a_boxPos;
+	const Vector right = a_boxRotation.GetRight();
+	const Vector look = a_boxRotation.GetLook();
+	const Vector up = a_boxRotation.GetUp();
+	const Vector localStart(toStart.Dot(right), toStart.Dot(look), toStart.Dot(up));
+	const Vector localEnd(toEnd.Dot(right), toEnd.Dot(look), toEnd.Dot(up));
+	return IntersectLineAxisBox(localStart, localEnd, Vector::Zero(), a_boxDimensions, a_hitFraction_OUT);
+}
+
+extern bool CollisionUtils::IntersectLineSphere(Vector a_lineStart, Vector a_lineEnd, Vector a_spherePos, float a_sphereRadius)
+{
+	float hitFraction = 0.0f;
+	return IntersectLineSphere(a_lineStart, a_lineEnd, a_spherePos, a_sphereRadius, hitFraction);
+}
+
+extern bool CollisionUtils::IntersectLineSphere(Vector a_lineStart, Vector a_lineEnd, Vector a_spherePos, float a_sphereRadius, float & a_hitFraction_OUT)
+{
+	// Starting inside the sphere is a hit straight away
+	const Vector toStart = a_lineStart - a_spherePos;
+	const float startDistSq = toStart.LengthSquared() - (a_sphereRadius * a_sphereRadius);
+	if (startDistSq <= 0.0f)
 	{
-		if (fabsf(a_intersection_OUT.GetX() - planeCentre.GetX()) <= halfDim.GetX() &&
-			fabsf(a_intersection_OUT.GetY() - planeCentre.GetY()) <= halfDim.GetY() &&
-			fabsf(a_intersection_OUT.GetZ() - planeCentre.GetZ()) <= halfDim.GetZ())
-		{
-			return true;
-		}
+		a_hitFraction_OUT = 0.0f;
+		return true;
 	}
 
-	// Check bottom plane
-	planeCentre = Vector(a_boxPos.GetX(), a_boxPos.GetY(), a_boxPos.GetZ() - halfDim.GetZ());
-	if (IntersectLinePlane(a_lineStart, a_lineEnd, planeCentre, Vector(0.0f, 0.0f, -1.0f), a_intersection_OUT))
+	// Solve for the first point along the line at the sphere's radius
+	const Vector line = a_lineEnd - a_lineStart;
+	const float lineLengthSq = line.LengthSquared();
+	const float halfB = toStart.Dot(line);
+	const float discriminant = (halfB * halfB) - (lineLengthSq * startDistSq);
+	if (halfB >= 0.0f || discriminant < 0.0f || MathUtils::IsZeroEpsilon(lineLengthSq))
 	{
-		if (fabsf(a_intersection_OUT.GetX() - planeCentre.GetX()) <= halfDim.GetX() &&
-			fabsf(a_intersection_OUT.GetY() - planeCentre.GetY()) <= halfDim.GetY() &&
-			fabsf(a_intersection_OUT.GetZ() - planeCentre.GetZ()) <= halfDim.GetZ())
-		{
-			return true;
-		}
+		return false;
 	}
 
-	return false;
-}
+	const float hitFraction = (-halfB - sqrtf(discriminant)) / lineLengthSq;
+	if (hitFraction > 1.0f)
+	{
+		return false;
+	}
 
-extern bool CollisionUtils::IntersectLineSphere(Vector a_lineStart, Vector a_lineEnd, Vector a_spherePos, float a_sphereRadius)
-{
-	// TODO actually implement this
-	return false;
+	a_hitFraction_OUT = hitFraction;
+	return true;
 }
 
 extern bool CollisionUtils::IntersectPointAxisBox(Vector a_point, Vector a_boxPos, Vector a_boxDimensions)
@@ -121,7 +147,181 @@ extern bool CollisionUtils::IntersectPointAxisBox(Vector a_point, Vector a_boxPo
 	return false;
 }
 
+extern bool CollisionUtils::IntersectPointBox(Vector a_point, Vector a_boxPos, const Matrix & a_boxRotation, Vector a_boxDimensions)
+{
+	const Vector toPoint = a_point - a_boxPos;
+	const Vector localPoint(toPoint.Dot(a_boxRotation.GetRight()), toPoint.Dot(a_boxRotation.GetLook()), toPoint.Dot(a_boxRotation.GetUp()));
+	return IntersectPointAxisBox(localPoint, Vector::Zero(), a_boxDimensions);
+}
+
 extern bool CollisionUtils::IntersectPointSphere(Vector a_point, Vector a_spherePos, float a_sphereRadius)
 {
 	return (a_point - a_spherePos).LengthSquared() <= (a_sphereRadius * a_sphereRadius);
+}
+
+extern bool CollisionUtils::IntersectSphereSphere(Vector a_spherePos1, float a_sphereRadius1, Vector a_spherePos2, float a_sphereRadius2)
+{
+	const float radii = a_sphereRadius1 + a_sphereRadius2;
+	return (a_spherePos1 - a_spherePos2).LengthSquared() <= radii * radii;
+}
+
+extern bool CollisionUtils::IntersectAxisBoxAxisBox(Vector a_boxPos1, Vector a_boxDimensions1, Vector a_boxPos2, Vector a_boxDimensions2)
+{
+	// Boxes touch when the gap between their middles is no more than half their combined size on every axis
+	const Vector offset = a_boxPos1 - a_boxPos2;
+	const Vector halfSizes = (a_boxDimensions1 + a_boxDimensions2) * 0.5f;
+	return	fabsf(offset.GetX()) <= halfSizes.GetX() &&
+			fabsf(offset.GetY()) <= halfSizes.GetY() &&
+			fabsf(offset.GetZ()) <= halfSizes.GetZ();
+}
+
+extern bool CollisionUtils::IntersectSphereAxisBox(Vector a_spherePos, float a_sphereRadius, Vector a_boxPos, Vector a_boxDimensions)
+{
+	// Find the closest point in the box to the sphere by clamping the centre to the box on each axis
+	const Vector halfDim = a_boxDimensions * 0.5f;
+	float distanceSq = 0.0f;
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		const float centre = GetAxis(a_spherePos, axis);
+		const float boxMin = GetAxis(a_boxPos, axis) - GetAxis(halfDim, axis);
+		const float boxMax = GetAxis(a_boxPos, axis) + GetAxis(halfDim, axis);
+		const float outside = centre < boxMin ? boxMin - centre : (centre > boxMax ? centre - boxMax : 0.0f);
+		distanceSq += outside * outside;
+	}
+	return distanceSq <= a_sphereRadius * a_sphereRadius;
+}
+
+extern bool CollisionUtils::IntersectSphereBox(Vector a_spherePos, float a_sphereRadius, Vector a_boxPos, const Matrix & a_boxRotation, Vector a_boxDimensions)
+{
+	const Vector toSphere = a_spherePos - a_boxPos;
+	const Vector localSphere(toSphere.Dot(a_boxRotation.GetRight()), toSphere.Dot(a_boxRotation.GetLook()), toSphere.Dot(a_boxRotation.GetUp()));
+	return IntersectSphereAxisBox(localSphere, a_sphereRadius, Vector::Zero(), a_boxDimensions);
+}
+
+extern unsigned int CollisionUtils::IntersectLineAxisBoxes(Vector a_lineStart, Vector a_lineEnd, const Vector * a_boxPositions, const Vector * a_boxDimensions, unsigned int a_numBoxes,
+														   bool * a_hits_OUT, float * a_hitFractions_OUT)
+{
+	// The line is the same for every box so it's components are spread across all four lanes once
+	const Vector line = a_lineEnd - a_lineStart;
+	Float4 lineStart[3];
+	Float4 invDir[3];
+	bool parallel[3];
+	for (unsigned int axis = 0; axis < 3; ++axis)
+	{
+		const float dir = GetAxis(line, axis);
+		parallel[axis] = MathUtils::IsZeroEpsilon(dir);
+		lineStart[axis] = Float4::Splat(GetAxis(a_lineStart, axis));
+		invDir[axis] = Float4::Splat(parallel[axis] ? 0.0f : 1.0f / dir);
+	}
+	const Float4 zero = Float4::Splat(0.0f);
+	const Float4 one = Float4::Splat(1.0f);
+
+	unsigned int numHits = 0;
+	float hitFractions[4];
+	for (unsigned int first = 0; first < a_numBoxes; first += 4)
+	{
+		// Spare lanes at the end repeat the last box and their results are ignored
+		const unsigned int numLanes = a_numBoxes - first < 4 ? a_numBoxes - first : 4;
+		const unsigned int i0 = first;
+		const unsigned int i1 = first + (numLanes > 1 ? 1 : 0);
+		const unsigned int i2 = first + (numLanes > 2 ? 2 : numLanes - 1);
+		const unsigned int i3 = first + numLanes - 1;
+
+		// Clip the line against the slabs on each axis for all four boxes at once, a lane misses if there is none of the line left
+		Float4 entry = zero;
+		Float4 exit = one;
+		int missMask = 0;
+		for (unsigned int axis = 0; axis < 3; ++axis)
+		{
+			const Float4 boxPos(GetAxis(a_boxPositions[i0], axis), GetAxis(a_boxPositions[i1], axis), GetAxis(a_boxPositions[i2], axis), GetAxis(a_boxPositions[i3], axis));
+			const Float4 halfDim = Float4(GetAxis(a_boxDimensions[i0], axis), GetAxis(a_boxDimensions[i1], axis), GetAxis(a_boxDimensions[i2], axis), GetAxis(a_boxDimensions[i3], axis)) * 0.5f;
+			const Float4 boxMin = boxPos - halfDim;
+			const Float4 boxMax = boxPos + halfDim;
+			if (parallel[axis])
+			{
+				// Parallel to these planes so the line has to start between them
+				missMask |= (lineStart[axis] - boxMin).GetNegativeMask() | (boxMax - lineStart[axis]).GetNegativeMask();
+				continue;
+			}
+
+			const Float4 toMin = (boxMin - lineStart[axis]) * invDir[axis];
+			const Float4 toMax = (boxMax - lineStart[axis]) * invDir[axis];
+			entry = Float4::Max(entry, Float4::Min(toMin, toMax));
+			exit = Float4::Min(exit, Float4::Max(toMin, toMax));
+		}
+		missMask |= (exit - entry).GetNegativeMask();
+
+		entry.Store(hitFractions);
+		for (unsigned int lane = 0; lane < numLanes; ++lane)
+		{
+			const bool hit = (missMask & (1 << lane)) == 0;
+			a_hits_OUT[first + lane] = hit;
+			if (hit)
+			{
+				a_hitFractions_OUT[first + lane] = hitFractions[lane];
+				++numHits;
+			}
+		}
+	}
+
+	return numHits;
+}
+
+extern unsigned int CollisionUtils::IntersectLineSpheres(Vector a_lineStart, Vector a_lineEnd, const Vector * a_spherePositions, const float * a_sphereRadii, unsigned int a_numSpheres,
+														 bool * a_hits_OUT, float * a_hitFractions_OUT)
+{
+	// The line is the same for every sphere so it's components are spread across all four lanes once
+	const Vector line = a_lineEnd - a_lineStart;
+	const float lineLengthSq = line.LengthSquared();
+	const Float4 startX = Float4::Splat(a_lineStart.GetX());
+	const Float4 startY = Float4::Splat(a_lineStart.GetY());
+	const Float4 startZ = Float4::Splat(a_lineStart.GetZ());
+	const Float4 lineX = Float4::Splat(line.GetX());
+	const Float4 lineY = Float4::Splat(line.GetY());
+	const Float4 lineZ = Float4::Splat(line.GetZ());
+	const Float4 lineLengthSq4 = Float4::Splat(lineLengthSq);
+	const Float4 invLineLengthSq = Float4::Splat(MathUtils::IsZeroEpsilon(lineLengthSq) ? 0.0f : 1.0f / lineLengthSq);
+	const Float4 zero = Float4::Splat(0.0f);
+	const Float4 one = Float4::Splat(1.0f);
+
+	unsigned int numHits = 0;
+	float hitFractions[4];
+	for (unsigned int first = 0; first < a_numSpheres; first += 4)
+	{
+		// Spare lanes at the end repeat the last sphere and their results are ignored
+		const unsigned int numLanes = a_numSpheres - first < 4 ? a_numSpheres - first : 4;
+		const Vector & p0 = a_spherePositions[first];
+		const Vector & p1 = a_spherePositions[first + (numLanes > 1 ? 1 : 0)];
+		const Vector & p2 = a_spherePositions[first + (numLanes > 2 ? 2 : numLanes - 1)];
+		const Vector & p3 = a_spherePositions[first + numLanes - 1];
+		const Float4 radius(a_sphereRadii[first], a_sphereRadii[first + (numLanes > 1 ? 1 : 0)], a_sphereRadii[first + (numLanes > 2 ? 2 : numLanes - 1)], a_sphereRadii[first + numLanes - 1]);
+		const Float4 toStartX = startX - Float4(p0.GetX(), p1.GetX(), p2.GetX(), p3.GetX());
+		const Float4 toStartY = startY - Float4(p0.GetY(), p1.GetY(), p2.GetY(), p3.GetY());
+		const Float4 toStartZ = startZ - Float4(p0.GetZ(), p1.GetZ(), p2.GetZ(), p3.GetZ());
+
+		// Solve for the first point along the line at each sphere's radius, lines starting inside hit at the start
+		const Float4 startDistSq = (toStartX * toStartX) + (toStartY * toStartY) + (toStartZ * toStartZ) - (radius * radius);
+		const Float4 halfB = (toStartX * lineX) + (toStartY * lineY) + (toStartZ * lineZ);
+		const Float4 discriminant = (halfB * halfB) - (lineLengthSq4 * startDistSq);
+		const Float4 hitFraction = Float4::Max(zero, (zero - halfB - Float4::Sqrt(Float4::Max(discriminant, zero))) * invLineLengthSq);
+
+		// Hit if inside, or heading towards the sphere with a real solution that is on the line
+		const int insideMask = startDistSq.GetNegativeMask();
+		const int enterMask = halfB.GetNegativeMask() & ~discriminant.GetNegativeMask() & ~(one - hitFraction).GetNegativeMask();
+		const int hitMask = insideMask | enterMask;
+
+		hitFraction.Store(hitFractions);
+		for (unsigned int lane = 0; lane < numLanes; ++lane)
+		{
+			const bool hit = (hitMask & (1 << lane)) != 0;
+			a_hits_OUT[first + lane] = hit;
+			if (hit)
+			{
+				a_hitFractions_OUT[first + lane] = hitFractions[lane];
+				++numHits;
+			}
+		}
+	}
+
+	return numHits;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define _ENGINE_COLLISION_UTILS_H_
 #pragma once
 
+#include "../core/Matrix.h"
 #include "../core/Vector.h"
 
 namespace CollisionUtils
@@ -10,7 +11,7 @@ namespace CollisionUtils
 	//\param a_lineStart is the start of the line segment
 	//\param a_lineEnd is the end of the line segment
 	//\param a_planeCentre is a point on the plane
-	//\param a_planeNormal is the normal of the plane
+	//\param a_planeNormal is the normal of the plane, any length other than zero
 	//\param a_intersection_OUT is the point at which the plane intersects the line, if any
 	//\return bool true if there is an intersection, false otherwise
 	extern bool IntersectLinePlane(Vector a_lineStart, Vector a_lineEnd, Vector a_planeCentre, Vector a_planeNormal, Vector & a_intesection_OUT);
@@ -22,6 +23,20 @@ namespace CollisionUtils
 	//\return bool true if the line touches the box
 	extern bool IntersectLineAxisBox(Vector a_lineStart, Vector a_lineEnd, Vector a_boxPos, Vector a_boxDimensions, Vector & a_intersection_OUT);
 
+	//\brief Intersection check between a line segment and an axis aligned box that reports where the line enters the box
+	//\param a_hitFraction_OUT how far along the line the box is touched, 0 at the start and 1 at the end
+	//\return bool true if the line touches the box
+	extern bool IntersectLineAxisBox(Vector a_lineStart, Vector a_lineEnd, Vector a_boxPos, Vector a_boxDimensions, float & a_hitFraction_OUT);
+
+	//\brief Intersection check between a line segment and a box that can be rotated, the line is taken into the box's space
+	//		 and clipped against it the same way as an axis aligned box
+	//\param a_boxPos the middle of the box
+	//\param a_boxRotation orientation of the box, the right, look and up axes have to be unit length and at right angles
+	//\param a_boxDimensions the size of the box along it's right, look and up axes
+	//\param a_hitFraction_OUT how far along the line the box is touched, 0 if the line starts inside
+	//\return bool true if the line touches the box
+	extern bool IntersectLineBox(Vector a_lineStart, Vector a_lineEnd, Vector a_boxPos, const Matrix & a_boxRotation, Vector a_boxDimensions, float & a_hitFraction_OUT);
+
 	//\brief Intersection check between a line and a sphere
 	//\param a_lineStart is the start of the line segment
 	//\param a_lineEnd is the end of the line segment
@@ -30,6 +45,11 @@ namespace CollisionUtils
 	//\return True if and part of the line is on or inside the sphere
 	extern bool IntersectLineSphere(Vector a_lineStart, Vector a_lineEnd, Vector a_spherePos, float a_sphereRadius);
 
+	//\brief Intersection check between a line and a sphere that reports where the line enters the sphere
+	//\param a_hitFraction_OUT how far along the line the sphere is touched, 0 if the line starts inside
+	//\return True if and part of the line is on or inside the sphere
+	extern bool IntersectLineSphere(Vector a_lineStart, Vector a_lineEnd, Vector a_spherePos, float a_sphereRadius, float & a_hitFraction_OUT);
+
 	//\brief Intersection between a point and an axis aligned box
 	//\param a_point worldpos vector of the point
 	//\param a_boxPos the middle of the box
@@ -37,12 +57,44 @@ namespace CollisionUtils
 	//\return true if the point is on or inside the box
 	extern bool IntersectPointAxisBox(Vector a_point, Vector a_boxPos, Vector a_boxDimensions);
 
+	//\brief Intersection between a point and a box that can be rotated
+	//\param a_boxRotation orientation of the box, the right, look and up axes have to be unit length and at right angles
+	//\return true if the point is on or inside the box
+	extern bool IntersectPointBox(Vector a_point, Vector a_boxPos, const Matrix & a_boxRotation, Vector a_boxDimensions);
+
 	//\brief Intersection between a point and a sphere
 	//\param a_point worldpos vector of the point
 	//\param a_spherePos the middle of the sphere
 	//\param a_sphereRadius is the size of the sphere
 	//\return true if the point is on or inside the box
 	extern bool IntersectPointSphere(Vector a_point, Vector a_spherePos, float a_sphereRadius);
+
+	//\brief Overlap checks between pairs of volumes
+	//\return true if the volumes touch or one is inside the other
+	extern bool IntersectSphereSphere(Vector a_spherePos1, float a_sphereRadius1, Vector a_spherePos2, float a_sphereRadius2);
+	extern bool IntersectAxisBoxAxisBox(Vector a_boxPos1, Vector a_boxDimensions1, Vector a_boxPos2, Vector a_boxDimensions2);
+	extern bool IntersectSphereAxisBox(Vector a_spherePos, float a_sphereRadius, Vector a_boxPos, Vector a_boxDimensions);
+
+	//\brief Overlap check between a sphere and a box that can be rotated, the sphere is taken into the box's space
+	//\param a_boxRotation orientation of the box, the right, look and up axes have to be unit length and at right angles
+	//\return true if the volumes touch or one is inside the other
+	extern bool IntersectSphereBox(Vector a_spherePos, float a_sphereRadius, Vector a_boxPos, const Matrix & a_boxRotation, Vector a_boxDimensions);
+
+	//\brief Test one line segment against many axis aligned boxes, four at a time. Gives the same results as IntersectLineAxisBox.
+	//\param a_boxPositions, a_boxDimensions arrays of a_numBoxes box middles and sizes
+	//\param a_hits_OUT pointer to storage for a flag per box, true if the line touches the box
+	//\param a_hitFractions_OUT pointer to storage for how far along the line each box is touched, only written for boxes that are hit
+	//\return how many of the boxes the line touches
+	extern unsigned int IntersectLineAxisBoxes(Vector a_lineStart, Vector a_lineEnd, const Vector * a_boxPositions, const Vector * a_boxDimensions, unsigned int a_numBoxes,
+											   bool * a_hits_OUT, float * a_hitFractions_OUT);
+
+	//\brief Test one line segment against many spheres, four at a time. Gives the same results as IntersectLineSphere.
+	//\param a_spherePositions, a_sphereRadii arrays of a_numSpheres sphere centres and sizes
+	//\param a_hits_OUT pointer to storage for a flag per sphere, true if the line touches the sphere
+	//\param a_hitFractions_OUT pointer to storage for how far along the line each sphere is touched, only written for spheres that are hit
+	//\return how many of the spheres the line touches
+	extern unsigned int IntersectLineSpheres(Vector a_lineStart, Vector a_lineEnd, const Vector * a_spherePositions, const float * a_sphereRadii, unsigned int a_numSpheres,
+											 bool * a_hits_OUT, float * a_hitFractions_OUT);
 }
 
 #endif /* _ENGINE_COLLISION_UTILS_H_ */
@@ -0,0 +1,67 @@
+#include "Components\ComponentRootMotion.h"
+
+#include "GameObject.h"
+
+#include "ComponentManager.h"
+
+template<> ComponentManager * Singleton<ComponentManager>::s_instance = NULL;
+
+const unsigned int ComponentManager::s_maxComponentsPerType = 16384;	// Every object in a full scene
+
+bool ComponentManager::Startup()
+{
+	// Each type of component needs it's storage registered here
+	bool startupOk = true;
+	startupOk &= RegisterComponentType<ComponentRootMotion>();
+
+	if (!startupOk)
+	{
+		Log::Get().WriteEngineErrorNoParams("Component manager failed to create storage for all component types.");
+	}
+	return startupOk;
+}
+
+bool ComponentManager::Shutdown()
+{
+	for (unsigned int i = 0; i < Component::eComponentTypeCount; ++i)
+	{
+		delete m_stores[i];
+		m_stores[i] = NULL;
+	}
+	return true;
+}
+
+bool ComponentManager::Update(float a_dt, Scene * a_scene)
+{
+	for (unsigned int i = 0; i < Component::eComponentTypeCount; ++i)
+	{
+		if (ComponentStoreBase * store = m_stores[i])
+		{
+			store->Update(a_dt, a_scene);
+		}
+	}
+	return true;
+}
+
+bool ComponentManager::IsUpdating(GameObject * a_gameObject, Scene * a_scene)
+{
+	return a_gameObject != NULL && a_gameObject->GetScene() == a_scene && a_gameObject->IsActive();
+}
+
+Component * ComponentManager::GetComponent(Component::eComponentType a_type, ComponentHandle a_handle)
+{
+	ComponentStoreBase * store = m_stores[a_type];
+	return store != NULL ? store->Get(a_handle) : NULL;
+}
+
+bool ComponentManager::DestroyComponent(Component::eComponentType a_type, ComponentHandle a_handle)
+{
+	ComponentStoreBase * store = m_stores[a_type];
+	return store != NULL ? store->Destroy(a_handle) : false;
+}
+
+unsigned int ComponentManager::GetNumComponents(Component::eComponentType a_type)
+{
+	ComponentStoreBase * store = m_stores[a_type];
+	return store != NULL ? store->GetCount() : 0;
+}
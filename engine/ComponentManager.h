@@ -0,0 +1,159 @@
+#ifndef _ENGINE_COMPONENT_MANAGER_
+#define _ENGINE_COMPONENT_MANAGER_
+#pragma once
+
+#include "../core/PackedArray.h"
+
+#include "Log.h"
+#include "Singleton.h"
+
+#include "Components\Component.h"
+
+class GameObject;
+class Scene;
+
+//\brief ComponentManager stores all the components of each type packed together in their own array.
+//		 Each type is updated by a single loop over it's array instead of each object visiting it's
+//		 components, and objects refer to their components by handle so lookups need no searching or casts.
+//		 Component types are registered on startup and must declare their type as s_componentType.
+class ComponentManager : public Singleton<ComponentManager>
+{
+public:
+
+	//\brief Components are referred to by handles into the array for their type
+	typedef PackedArray<Component>::Handle ComponentHandle;
+	static const ComponentHandle s_invalidHandle = PackedArray<Component>::s_invalidHandle;
+
+	ComponentManager() { memset(&m_stores[0], 0, sizeof(ComponentStoreBase *) * Component::eComponentTypeCount); }
+	~ComponentManager() { Shutdown(); }
+
+	//\brief Create the storage for each type of component on startup and destroy all components on shutdown
+	//\return true if every type has storage
+	bool Startup();
+	bool Shutdown();
+
+	//\brief Run the update for each type of component over the components whose objects are active in a scene,
+	//		 called by the scene as part of it's update so components only move objects that are being simulated
+	//\param a_scene the scene being updated, components of objects in other scenes or not active are skipped
+	//\return true if all the types were updated
+	bool Update(float a_dt, Scene * a_scene);
+
+	//\brief Create a component of a type and attach it to an object
+	//\param a_parentGameObject the object the component belongs to
+	//\param a_handle_OUT is set to the handle of the new component, invalid on failure
+	//\return a pointer to the component that is only valid until another component of the same type is created or destroyed
+	template <typename T>
+	T * CreateComponent(GameObject * a_parentGameObject, ComponentHandle & a_handle_OUT)
+	{
+		a_handle_OUT = s_invalidHandle;
+		ComponentStore<T> * store = static_cast<ComponentStore<T> *>(m_stores[T::s_componentType]);
+		if (store == NULL)
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot create a component of type %d, the type has not been registered.", (int)T::s_componentType);
+			return NULL;
+		}
+
+		T * newComponent = store->m_components.Add(a_handle_OUT);
+		if (newComponent == NULL)
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot create a component of type %d, all %u components are in use.", (int)T::s_componentType, store->m_components.GetMaxCapacity());
+			return NULL;
+		}
+
+		newComponent->Startup(a_parentGameObject);
+		return newComponent;
+	}
+
+	//\brief Get a component from it's handle
+	//\return a pointer to the component or NULL if the handle is stale or invalid
+	template <typename T>
+	inline T * GetComponent(ComponentHandle a_handle)
+	{
+		ComponentStore<T> * store = static_cast<ComponentStore<T> *>(m_stores[T::s_componentType]);
+		return store != NULL ? store->m_components.Get(a_handle) : NULL;
+	}
+	Component * GetComponent(Component::eComponentType a_type, ComponentHandle a_handle);
+
+	//\brief Shutdown a component and remove it from the array for it's type
+	//\return true if the handle referred to a live component
+	bool DestroyComponent(Component::eComponentType a_type, ComponentHandle a_handle);
+
+	//\brief Get how many components of a type exist
+	unsigned int GetNumComponents(Component::eComponentType a_type);
+
+private:
+
+	//\brief Storage for one type of component, the base lets the manager hold all types in one array
+	class ComponentStoreBase
+	{
+	public:
+		virtual ~ComponentStoreBase() { }
+		virtual void Update(float a_dt, Scene * a_scene) = 0;
+		virtual Component * Get(ComponentHandle a_handle) = 0;
+		virtual bool Destroy(ComponentHandle a_handle) = 0;
+		virtual unsigned int GetCount() = 0;
+	};
+
+	template <typename T>
+	class ComponentStore : public ComponentStoreBase
+	{
+	public:
+		ComponentStore(unsigned int a_maxComponents) { m_components.Init(a_maxComponents); }
+
+		//\brief Update each run of components next to each other in the array whose objects are updating in one batch
+		virtual void Update(float a_dt, Scene * a_scene)
+		{
+			T * components = m_components.GetData();
+			const unsigned int numComponents = m_components.GetCount();
+			unsigned int runStart = 0;
+			for (unsigned int i = 0; i <= numComponents; ++i)
+			{
+				if (i == numComponents || !IsUpdating(components[i].T::GetParentGameObject(), a_scene))
+				{
+					if (i > runStart)
+					{
+						T::UpdateAll(components + runStart, i - runStart, a_dt);
+					}
+					runStart = i + 1;
+				}
+			}
+		}
+
+		virtual Component * Get(ComponentHandle a_handle) { return m_components.Get(a_handle); }
+
+		virtual bool Destroy(ComponentHandle a_handle)
+		{
+			if (T * component = m_components.Get(a_handle))
+			{
+				component->Shutdown();
+				return m_components.Remove(a_handle);
+			}
+			return false;
+		}
+
+		virtual unsigned int GetCount() { return m_components.GetCount(); }
+
+		PackedArray<T> m_components;	///< Every component of this type packed together
+	};
+
+	//\brief Create the storage for a type of component
+	//\return true if the storage was created
+	template <typename T>
+	bool RegisterComponentType()
+	{
+		if (m_stores[T::s_componentType] == NULL)
+		{
+			m_stores[T::s_componentType] = new ComponentStore<T>(s_maxComponentsPerType);
+		}
+		return m_stores[T::s_componentType] != NULL;
+	}
+
+	//\brief If an object is active in a scene, components of objects that are not don't update
+	static bool IsUpdating(GameObject * a_gameObject, Scene * a_scene);
+
+	static const unsigned int s_maxComponentsPerType;					///< How many components of a single type can exist at once
+
+	ComponentStoreBase * m_stores[Component::eComponentTypeCount];		///< Storage for each type of component
+};
+
+#endif // _ENGINE_COMPONENT_MANAGER_
@@ -33,6 +33,24 @@ public:
 	virtual bool Update(float a_dt) = 0;
 	virtual bool Shutdown() { return true; }
 
+	//\brief Update every component of a type at once, types hide this with a batched version when they can do better than one at a time
+	//\param a_components pointer to the first of a_numComponents packed components of the same type
+	template <typename T>
+	static void UpdateAll(T * a_components, unsigned int a_numComponents, float a_dt)
+	{
+		// Naming the type resolves the update at compile time so there is no virtual call per component
+		for (unsigned int i = 0; i < a_numComponents; ++i)
+		{
+			a_components[i].T::Update(a_dt);
+		}
+	}
+
+	//\brief Save and restore everything that Update can change, for checking updates give the same result
+	//\param a_state_OUT, a_state point to GetStateSize() bytes of storage
+	virtual unsigned int GetStateSize() { return 0; }
+	virtual void SaveState(void * a_state_OUT) { }
+	virtual void RestoreState(const void * a_state) { }
+
 	virtual GameObject * GetParentGameObject() { return m_parentGameObject; }
 
 protected:
@@ -2,7 +2,9 @@
 #define _ENGINE_COMPONENT_ROOT_MOTION_
 #pragma once
 
-#include "../../core/MathUtils.h"
+#include <float.h>
+
+#include "../../core/Float4.h"
 #include "../../core/Vector.h"
 
 #include "../GameObject.h"
@@ -10,61 +12,97 @@
 #include "Component.h"
 
 /// \brief Root motion component can move game objects about in the world over time.
+///		   All root motion components are advanced together by UpdateAll which copies the move in
+///		   progress for each into structure of arrays form and moves four objects at a time.
 class ComponentRootMotion : public Component
 {
 public:
 
-	//\brief eMoveType is the type of movement supported
+	//\brief eMoveType is the shape of the curve from the start of a move to the end
 	enum eMoveType
 	{
-		eMoveTypeLinear = 0,
-		eMoveTypeAccelerate,
-		eMoveTypeDecelerate,
-		eMoveTypeAccelAndDecel,
-		
+		eMoveTypeLinear = 0,		///< Constant speed
+		eMoveTypeAccelerate,		///< Start slow and arrive at speed
+		eMoveTypeDecelerate,		///< Start at speed and slow to arrive
+		eMoveTypeAccelAndDecel,		///< Start and arrive slowly
+
 		eMoveTypeCount,
 	};
 
+	static const Component::eComponentType s_componentType = Component::eComponentTypeRootMotion;
+
 	ComponentRootMotion()
 		: m_numMoves(0)
 		, m_currentMoveProgress(0.0f)
 		, m_currentMoveTimer(0.0f)
-		, m_currentMove(NULL)
+		, m_currentMoveInvTime(0.0f)
+		, m_currentMoveStart(0.0f)
+		, m_currentMoveStarted(false)
+		, m_currentMove(sc_noMove)
 	{ }
-	
-	virtual Component::eComponentType GetComponentType() { return Component::eComponentTypeRootMotion; }
 
+	virtual Component::eComponentType GetComponentType() { return s_componentType; }
+
+	//\brief Advance a single component, UpdateAll is much faster for many
 	virtual bool Update(float a_dt)
 	{
-		if (m_currentMove != NULL)
+		const bool hasMove = m_currentMove != sc_noMove;
+		UpdateAll(this, 1, a_dt);
+		return hasMove;
+	}
+
+	//\brief Advance every component in an array by the same time
+	//\param a_components pointer to the first of a_numComponents packed components
+	static void UpdateAll(ComponentRootMotion * a_components, unsigned int a_numComponents, float a_dt)
+	{
+		for (unsigned int batchStart = 0; batchStart < a_numComponents; batchStart += sc_batchSize)
 		{
-			// Burn down the move timer
-			if (m_currentMoveTimer < m_currentMove->m_startDelay)
-			{
-				m_currentMoveTimer += a_dt;
-			}
-			else // Movement has begun
+			// Copy each move in progress into a lane of the batch, spare lanes at the end are left with no movement
+			Batch batch;
+			unsigned int numLanes = 0;
+			const unsigned int batchEnd = batchStart + sc_batchSize < a_numComponents ? batchStart + sc_batchSize : a_numComponents;
+			for (unsigned int i = batchStart; i < batchEnd; ++i)
 			{
-				// Check we haven't reached the destination
-				const Vector curPos = m_parentGameObject->GetPos();
-				Vector toDest = m_currentMove->m_destination - curPos;
-				if (toDest.LengthSquared() > EPSILON)
-				{
-					m_currentMoveProgress = MathUtils::LerpFloat(m_currentMoveProgress, 1.0f, a_dt/m_currentMove->m_moveSpeed);
-					m_parentGameObject->SetPos(curPos + (toDest * m_currentMoveProgress));
-				}
-				else // The move is over
+				ComponentRootMotion & curComp = a_components[i];
+				if (curComp.m_currentMove != sc_noMove)
 				{
-					EndCurrentMove();
+					curComp.AddToBatch(batch, numLanes++);
 				}
 			}
+			const unsigned int numPaddedLanes = (numLanes + 3) & ~3u;
+			for (unsigned int lane = numLanes; lane < numPaddedLanes; ++lane)
+			{
+				batch.ClearLane(lane);
+			}
 
-			return true;
-		}
+			// Four moves at a time, the easing curve is a cubic with per lane coefficients so every move type takes the same path
+			const Float4 dt = Float4::Splat(a_dt);
+			const Float4 zero = Float4::Splat(0.0f);
+			const Float4 one = Float4::Splat(1.0f);
+			for (unsigned int lane = 0; lane < numPaddedLanes; lane += 4)
+			{
+				const Float4 timer = Float4::Load(&batch.m_timer[lane]) + dt;
+				const Float4 moveTime = timer - Float4::Load(&batch.m_delay[lane]);
+				const Float4 progress = Float4::Min(Float4::Max(moveTime * Float4::Load(&batch.m_invTime[lane]), zero), one);
+				Float4 eased = Float4::MulAdd(progress, Float4::Load(&batch.m_easeCubic[lane]), Float4::Load(&batch.m_easeSquare[lane]));
+				eased = Float4::MulAdd(progress, eased, Float4::Load(&batch.m_easeLinear[lane]));
+				eased = eased * progress;
+
+				timer.Store(&batch.m_timer[lane]);
+				progress.Store(&batch.m_progress[lane]);
+				Float4::MulAdd(Float4::Load(&batch.m_deltaX[lane]), eased, Float4::Load(&batch.m_startX[lane])).Store(&batch.m_startX[lane]);
+				Float4::MulAdd(Float4::Load(&batch.m_deltaY[lane]), eased, Float4::Load(&batch.m_startY[lane])).Store(&batch.m_startY[lane]);
+				Float4::MulAdd(Float4::Load(&batch.m_deltaZ[lane]), eased, Float4::Load(&batch.m_startZ[lane])).Store(&batch.m_startZ[lane]);
+			}
 
-		return false;
+			// Write the results back and move the objects in one pass
+			for (unsigned int lane = 0; lane < numLanes; ++lane)
+			{
+				batch.m_components[lane]->ApplyBatch(batch, lane);
+			}
+		}
 	}
-	
+
 	virtual bool Shutdown()
 	{
 		CancelAllMoves();
@@ -72,34 +110,29 @@ public:
 		return true;
 	}
 
+	//\brief Add a move to the end of the queue that travels at a speed
+	//\param a_worldPos where the move ends
+	//\param a_moveSpeed how fast to travel in world units per second, the easing curve changes the speed but not the time taken
+	//\param a_startDelay how long to wait after the previous move before starting this one
+	//\param a_moveType the easing curve for the move
 	inline void QueueMove(const Vector & a_worldPos, float a_moveSpeed, float a_startDelay = 0.0f, eMoveType a_moveType = ComponentRootMotion::eMoveTypeLinear)
 	{
-		if (Move * newMove = AllocateMove())
+		if (Move * newMove = QueueNewMove(a_worldPos, a_startDelay, a_moveType))
 		{
-			newMove->m_destination = a_worldPos;
-			newMove->m_startDelay = a_startDelay;
 			newMove->m_moveSpeed = a_moveSpeed;
-
-			// Link new move to the last queued move
-			if (m_currentMove != newMove)
-			{
-				Move * lastMove = m_currentMove;
-				while (lastMove != NULL)
-				{
-					if (lastMove->m_nextMove == NULL)
-					{
-						lastMove->m_nextMove = newMove;
-						break;
-					}
-					lastMove = lastMove->m_nextMove;
-				}
-			}
+			newMove->m_moveOverTime = false;
 		}
 	}
 
-	void QueueMoveOverTime(const Vector & a_worldPos, float a_moveTime, float a_startDelay = 0.0f, eMoveType a_moveType = ComponentRootMotion::eMoveTypeLinear)
+	//\brief Add a move to the end of the queue that takes a fixed time
+	//\param a_moveTime how long the move takes in seconds, not including the delay
+	inline void QueueMoveOverTime(const Vector & a_worldPos, float a_moveTime, float a_startDelay = 0.0f, eMoveType a_moveType = ComponentRootMotion::eMoveTypeLinear)
 	{
-		// TODO
+		if (Move * newMove = QueueNewMove(a_worldPos, a_startDelay, a_moveType))
+		{
+			newMove->m_moveTime = a_moveTime;
+			newMove->m_moveOverTime = true;
+		}
 	}
 
 	void CancelAllMoves(bool a_warpToFinalDest = false)
@@ -107,17 +140,17 @@ public:
 		// Remove and free up all moves
 		bool foundFinalDest = false;
 		Vector finalDest(0.0f);
-		Move * curMove = m_currentMove;
-		while (curMove != NULL)
+		unsigned int curMove = m_currentMove;
+		while (curMove != sc_noMove)
 		{
-			curMove->m_inUse = false;
-			if (curMove->m_nextMove == NULL)
+			m_moves[curMove].m_inUse = false;
+			if (m_moves[curMove].m_nextMove == sc_noMove)
 			{
-				finalDest = curMove->m_destination;
+				finalDest = m_moves[curMove].m_destination;
 				foundFinalDest = true;
 				break;
 			}
-			curMove = curMove->m_nextMove;
+			curMove = m_moves[curMove].m_nextMove;
 		}
 
 		// Warp the game object to the last location
@@ -131,12 +164,46 @@ public:
 
 		m_currentMoveTimer = 0.0f;
 		m_currentMoveProgress = 0.0f;
+		m_currentMoveStarted = false;
+		m_currentMove = sc_noMove;
 		m_numMoves = 0;
 	}
 
+	virtual unsigned int GetStateSize()
+	{
+		return sizeof(m_numMoves) + sizeof(m_currentMoveProgress) + sizeof(m_currentMoveTimer) + sizeof(m_currentMoveInvTime) +
+			   sizeof(m_currentMoveStart) + sizeof(m_currentMoveStarted) + sizeof(m_currentMove) + sizeof(m_moves);
+	}
+
+	virtual void SaveState(void * a_state_OUT)
+	{
+		unsigned char * state = (unsigned char *)a_state_OUT;
+		memcpy(state, &m_numMoves, sizeof(m_numMoves));								state += sizeof(m_numMoves);
+		memcpy(state, &m_currentMoveProgress, sizeof(m_currentMoveProgress));		state += sizeof(m_currentMoveProgress);
+		memcpy(state, &m_currentMoveTimer, sizeof(m_currentMoveTimer));				state += sizeof(m_currentMoveTimer);
+		memcpy(state, &m_currentMoveInvTime, sizeof(m_currentMoveInvTime));			state += sizeof(m_currentMoveInvTime);
+		memcpy(state, &m_currentMoveStart, sizeof(m_currentMoveStart));				state += sizeof(m_currentMoveStart);
+		memcpy(state, &m_currentMoveStarted, sizeof(m_currentMoveStarted));			state += sizeof(m_currentMoveStarted);
+		memcpy(state, &m_currentMove, sizeof(m_currentMove));						state += sizeof(m_currentMove);
+		memcpy(state, &m_moves[0], sizeof(m_moves));
+	}
+
+	virtual void RestoreState(const void * a_state)
+	{
+		const unsigned char * state = (const unsigned char *)a_state;
+		memcpy(&m_numMoves, state, sizeof(m_numMoves));								state += sizeof(m_numMoves);
+		memcpy(&m_currentMoveProgress, state, sizeof(m_currentMoveProgress));		state += sizeof(m_currentMoveProgress);
+		memcpy(&m_currentMoveTimer, state, sizeof(m_currentMoveTimer));				state += sizeof(m_currentMoveTimer);
+		memcpy(&m_currentMoveInvTime, state, sizeof(m_currentMoveInvTime));			state += sizeof(m_currentMoveInvTime);
+		memcpy(&m_currentMoveStart, state, sizeof(m_currentMoveStart));				state += sizeof(m_currentMoveStart);
+		memcpy(&m_currentMoveStarted, state, sizeof(m_currentMoveStarted));			state += sizeof(m_currentMoveStarted);
+		memcpy(&m_currentMove, state, sizeof(m_currentMove));						state += sizeof(m_currentMove);
+		memcpy(&m_moves[0], state, sizeof(m_moves));
+	}
+
 	bool GetTimeTillDeparture();
 	bool GetTimeTillArrival();
-	bool IsMoving() { return m_numMoves > 0 && m_currentMoveTimer < m_moves[0].m_startDelay; }
+	bool IsMoving() { return m_currentMove != sc_noMove && m_currentMoveTimer >= m_moves[m_currentMove].m_startDelay; }
 	bool IsMoveQueued();
 
 private:
@@ -147,23 +214,167 @@ private:
 		Move()
 			: m_startDelay(0)
 			, m_moveSpeed(0.0f)
-			, m_destination(0.0f) 
+			, m_destination(0.0f)
+			, m_moveType(eMoveTypeLinear)
 			, m_inUse(false)
 			, m_moveOverTime(false)
-			, m_nextMove(NULL) {}
+			, m_nextMove(sc_noMove) {}
 		float m_startDelay;
 		union
 		{
 			float m_moveSpeed;
 			float m_moveTime;
 		};
+		eMoveType m_moveType;
 		bool m_inUse;
 		bool m_moveOverTime;
 		Vector m_destination;
-		Move * m_nextMove;
+		unsigned int m_nextMove;
 	};
 
-	Move * AllocateMove()
+	static const unsigned int sc_maxMoves = 16;
+	static const unsigned int sc_noMove = sc_maxMoves;		///< Move index for the end of the queue
+	static const unsigned int sc_batchSize = 256;			///< How many components are gathered into structure of arrays form at once
+
+	//\brief The moves in progress for a batch of components with each value in it's own array so four lanes load at once
+	struct Batch
+	{
+		//\brief Give a lane no movement so it can be processed along with the others
+		inline void ClearLane(unsigned int a_lane)
+		{
+			m_startX[a_lane] = m_startY[a_lane] = m_startZ[a_lane] = 0.0f;
+			m_deltaX[a_lane] = m_deltaY[a_lane] = m_deltaZ[a_lane] = 0.0f;
+			m_timer[a_lane] = m_delay[a_lane] = m_invTime[a_lane] = m_progress[a_lane] = 0.0f;
+			m_easeLinear[a_lane] = m_easeSquare[a_lane] = m_easeCubic[a_lane] = 0.0f;
+		}
+
+		ComponentRootMotion * m_components[sc_batchSize];	///< Which component each lane belongs to
+		float m_startX[sc_batchSize];						///< Where the move started, overwritten with the new position
+		float m_startY[sc_batchSize];
+		float m_startZ[sc_batchSize];
+		float m_deltaX[sc_batchSize];						///< Destination minus start
+		float m_deltaY[sc_batchSize];
+		float m_deltaZ[sc_batchSize];
+		float m_timer[sc_batchSize];						///< Time since the move became current, including the delay
+		float m_delay[sc_batchSize];						///< How long to wait before moving
+		float m_invTime[sc_batchSize];						///< One over how long the move takes
+		float m_progress[sc_batchSize];						///< How far through the move in time from 0 to 1
+		float m_easeLinear[sc_batchSize];					///< Coefficients of the easing curve progress * (linear + progress * (square + progress * cubic))
+		float m_easeSquare[sc_batchSize];
+		float m_easeCubic[sc_batchSize];
+	};
+
+	//\brief Copy the current move into a lane of a batch, starting it first if this is the first time it is seen
+	inline void AddToBatch(Batch & a_batch_OUT, unsigned int a_lane)
+	{
+		const Move & currentMove = m_moves[m_currentMove];
+		if (!m_currentMoveStarted)
+		{
+			StartCurrentMove();
+		}
+
+		// Linear is t, accelerate is t^2, decelerate is 2t - t^2 and both is the smoothstep 3t^2 - 2t^3
+		static const float s_easeCoefficients[eMoveTypeCount][3] =
+		{
+			{ 1.0f, 0.0f, 0.0f },
+			{ 0.0f, 1.0f, 0.0f },
+			{ 2.0f, -1.0f, 0.0f },
+			{ 0.0f, 3.0f, -2.0f },
+		};
+		const float * easeCoefficients = s_easeCoefficients[currentMove.m_moveType];
+		const Vector delta = currentMove.m_destination - m_currentMoveStart;
+
+		a_batch_OUT.m_components[a_lane] = this;
+		a_batch_OUT.m_startX[a_lane] = m_currentMoveStart.GetX();
+		a_batch_OUT.m_startY[a_lane] = m_currentMoveStart.GetY();
+		a_batch_OUT.m_startZ[a_lane] = m_currentMoveStart.GetZ();
+		a_batch_OUT.m_deltaX[a_lane] = delta.GetX();
+		a_batch_OUT.m_deltaY[a_lane] = delta.GetY();
+		a_batch_OUT.m_deltaZ[a_lane] = delta.GetZ();
+		a_batch_OUT.m_timer[a_lane] = m_currentMoveTimer;
+		a_batch_OUT.m_delay[a_lane] = currentMove.m_startDelay;
+		a_batch_OUT.m_invTime[a_lane] = m_currentMoveInvTime;
+		a_batch_OUT.m_progress[a_lane] = m_currentMoveProgress;
+		a_batch_OUT.m_easeLinear[a_lane] = easeCoefficients[0];
+		a_batch_OUT.m_easeSquare[a_lane] = easeCoefficients[1];
+		a_batch_OUT.m_easeCubic[a_lane] = easeCoefficients[2];
+	}
+
+	//\brief Take the results for this component from a lane of a batch and move the parent object
+	inline void ApplyBatch(const Batch & a_batch, unsigned int a_lane)
+	{
+		m_currentMoveTimer = a_batch.m_timer[a_lane];
+		m_currentMoveProgress = a_batch.m_progress[a_lane];
+
+		// Objects waiting to start are left alone so their bounds are not touched
+		if (m_currentMoveTimer > m_moves[m_currentMove].m_startDelay)
+		{
+			if (m_currentMoveProgress >= 1.0f)
+			{
+				m_parentGameObject->SetPos(m_moves[m_currentMove].m_destination);
+				EndCurrentMove();
+			}
+			else
+			{
+				m_parentGameObject->SetPos(Vector(a_batch.m_startX[a_lane], a_batch.m_startY[a_lane], a_batch.m_startZ[a_lane]));
+			}
+		}
+	}
+
+	//\brief Record where the object is as the start of the current move and work out how long it will take
+	inline void StartCurrentMove()
+	{
+		const Move & currentMove = m_moves[m_currentMove];
+		m_currentMoveStart = m_parentGameObject->GetPos();
+		m_currentMoveStarted = true;
+
+		// Moves that take no time finish on the first update after their delay
+		float moveTime = currentMove.m_moveTime;
+		if (!currentMove.m_moveOverTime)
+		{
+			const float distance = (currentMove.m_destination - m_currentMoveStart).Length();
+			moveTime = currentMove.m_moveSpeed > 0.0f ? distance / currentMove.m_moveSpeed : 0.0f;
+		}
+		m_currentMoveInvTime = moveTime > 0.0f ? 1.0f / moveTime : FLT_MAX;
+	}
+
+	//\brief Allocate a move and link it to the end of the queue
+	//\return the new move for the caller to fill out or NULL if the queue is full
+	Move * QueueNewMove(const Vector & a_worldPos, float a_startDelay, eMoveType a_moveType)
+	{
+		const unsigned int newMoveIndex = AllocateMove();
+		if (newMoveIndex == sc_noMove)
+		{
+			return NULL;
+		}
+
+		Move & newMove = m_moves[newMoveIndex];
+		newMove.m_destination = a_worldPos;
+		newMove.m_startDelay = a_startDelay;
+		newMove.m_moveType = a_moveType < eMoveTypeCount ? a_moveType : eMoveTypeLinear;
+		newMove.m_nextMove = sc_noMove;
+
+		// Link new move to the last queued move
+		if (m_currentMove != newMoveIndex)
+		{
+			unsigned int lastMove = m_currentMove;
+			while (lastMove != sc_noMove)
+			{
+				if (m_moves[lastMove].m_nextMove == sc_noMove)
+				{
+					m_moves[lastMove].m_nextMove = newMoveIndex;
+					break;
+				}
+				lastMove = m_moves[lastMove].m_nextMove;
+			}
+		}
+
+		return &newMove;
+	}
+
+	//\brief Find an unused move and make it current if nothing else is queued
+	//\return the index of the move in the array or sc_noMove if all moves are in use
+	unsigned int AllocateMove()
 	{
 		if (m_numMoves < sc_maxMoves)
 		{
@@ -173,11 +384,12 @@ private:
 				{
 					if (m_numMoves == 0)
 					{
-						m_currentMove = &m_moves[i];
+						m_currentMove = i;
+						m_currentMoveStarted = false;
 					}
 					++m_numMoves;
 					m_moves[i].m_inUse = true;
-					return &m_moves[i];
+					return i;
 				}
 			}
 		}
@@ -185,23 +397,26 @@ private:
 		{
 			//assert
 		}
-		return NULL;
+		return sc_noMove;
 	}
 
 	void EndCurrentMove()
 	{
 		m_numMoves--;
-		m_currentMove->m_inUse = false;
-		m_currentMove = m_currentMove->m_nextMove;
+		m_moves[m_currentMove].m_inUse = false;
+		m_currentMove = m_moves[m_currentMove].m_nextMove;
 		m_currentMoveProgress = 0.0f;
 		m_currentMoveTimer = 0.0f;
+		m_currentMoveStarted = false;
 	}
 
-	static const unsigned int sc_maxMoves = 16;
 	unsigned int m_numMoves;
-	float m_currentMoveProgress;
-	float m_currentMoveTimer;
-	Move * m_currentMove;
+	float m_currentMoveProgress;					///< How far through the current move in time from 0 to 1
+	float m_currentMoveTimer;						///< Time since the current move became current, including it's delay
+	float m_currentMoveInvTime;						///< One over how long the current move takes, set when it starts
+	Vector m_currentMoveStart;						///< Where the object was when the current move started
+	bool m_currentMoveStarted;						///< If the start position and time of the current move have been set
+	unsigned int m_currentMove;						///< Index of the move in progress, moves are linked by index so the component can be copied
 	Move m_moves[sc_maxMoves];						///< Unordered list to queue up to 16 moves
 };
 
@@ -465,6 +465,7 @@ bool DebugMenu::HandleMenuAction(Widget * a_widget)
 					if (m_gameObjectToEdit)
 					{
 						worldMan.DestroyObject(m_gameObjectToEdit->GetId());
+						m_gameObjectToEdit = NULL;
 					}
 					worldMan.CreateObject<GameObject>(m_resourceSelectList->GetSelectedListItem());
 					m_dirtyFlags.Set(eDirtyFlagScene);
@@ -678,7 +679,7 @@ bool DebugMenu::OnSelect(bool a_active)
 		Vector pickEnd = camPos + camMat.GetLook() * pickDepth;
 		pickEnd += camMat.Transform(mouseInput);
 
-		// Pick an arbitrary object (would have to sort to get the closest)
+		// Pick the object closest to the camera
 		if (m_gameObjectToEdit = curScene->GetSceneObject(camPos, pickEnd))
 		{
 			m_editType = eEditTypeGameObject;
@@ -4,6 +4,7 @@
 #include <strsafe.h>
 
 #include "Log.h"
+#include "MemoryManager.h"
 
 #include "FileManager.h"
 
@@ -69,9 +70,18 @@ bool FileManager::FillFileList(const char * a_path, FileList & a_fileList_OUT, c
 			// Don't add the dot and dot dot dirs
 			if (findFileData.cFileName[0] != '.')
 			{
-				// Allocate a new file and set its properties
-				FileListNode * newFile = new FileListNode();
-				newFile->SetData(new FileInfo());
+				// Allocate a new file from the file arena and set its properties
+				MemoryManager & memMan = MemoryManager::Get();
+				FileListNode * newFile = memMan.New<FileListNode>(MemoryManager::eArenaFile);
+				FileInfo * newFileInfo = memMan.New<FileInfo>(MemoryManager::eArenaFile);
+				if (newFile == NULL || newFileInfo == NULL)
+				{
+					Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory for file %s when indexing path %s", findFileData.cFileName, a_path);
+					memMan.Delete(MemoryManager::eArenaFile, newFile);
+					memMan.Delete(MemoryManager::eArenaFile, newFileInfo);
+					break;
+				}
+				newFile->SetData(newFileInfo);
 				sprintf(newFile->GetData()->m_name, "%s", findFileData.cFileName);
 				newFile->GetData()->m_sizeBytes = 0;
 				newFile->GetData()->m_isDir = (findFileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
@@ -159,6 +169,7 @@ bool FileManager::FillFileList(const char * a_path, FileList & a_fileList_OUT, c
 void FileManager::EmptyFileList(FileList & a_fileList_OUT)
 {
 	// Iterate through all objects in this file and clean up memory
+	MemoryManager & memMan = MemoryManager::Get();
 	FileListNode * next = a_fileList_OUT.GetHead();
 	while(next != NULL)
 	{
@@ -167,8 +178,8 @@ void FileManager::EmptyFileList(FileList & a_fileList_OUT)
 		next = cur->GetNext();
 
 		a_fileList_OUT.Remove(cur);
-		delete cur->GetData();
-		delete cur;
+		memMan.Delete(MemoryManager::eArenaFile, cur->GetData());
+		memMan.Delete(MemoryManager::eArenaFile, cur);
 	}
 }
 
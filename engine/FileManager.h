@@ -5,6 +5,7 @@
 #include "../core/Delegate.h"
 #include "../core/LinkedList.h"
 
+#include "MemoryManager.h"
 #include "Singleton.h"
 #include "StringUtils.h"
 
@@ -100,9 +101,9 @@ public:
 	inline bool FillManagedFileList(TObj * a_callerObject, TMethod a_callback, const char * a_filePath, FileList &a_fileList_OUT, const char * a_fileSubstring = NULL)
 	{
 		// Add an event to the list of items to be processed
-		// TODO memory management! Kill std new with a rusty fork
-		FileEventNode * newFileNode = new FileEventNode();
-		newFileNode->SetData(new FileEvent());
+		MemoryManager & memMan = MemoryManager::Get();
+		FileEventNode * newFileNode = memMan.New<FileEventNode>(MemoryManager::eArenaFile);
+		newFileNode->SetData(memMan.New<FileEvent>(MemoryManager::eArenaFile));
 	
 		// Set data for the new event
 		FileEvent * newEvent = newFileNode->GetData();
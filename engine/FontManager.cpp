@@ -281,13 +281,15 @@ bool FontManager::DrawDebugString3D(const char * a_string, float a_size, Vector
 
 StringHash * FontManager::GetLoadedFontName(const char * a_fontName)
 {
+	const unsigned int fontNameHash = StringHash::GenerateCRC(a_fontName, false);
 	FontListNode * curFont = m_fonts.GetHead();
 	while(curFont != NULL)
 	{
-		if (curFont->GetData()->m_fontName == StringHash(a_fontName))
+		if (curFont->GetData()->m_fontName == fontNameHash)
 		{
 			return &curFont->GetData()->m_fontName;
 		}
+		curFont = curFont->GetNext();
 	}
 
 	return NULL;
@@ -1,4 +1,5 @@
 #include "Log.h"
+#include "MemoryManager.h"
 
 #include "GameFile.h"
 
@@ -141,6 +142,7 @@ unsigned int GameFile::ReadObjectAndProperties(const char * a_objectName, ifstre
 void GameFile::Unload()
 {
 	// Iterate through all objects and delete inclusive of properties
+	MemoryManager & memMan = MemoryManager::Get();
 	LinkedListNode<Object> * nextObject = m_objects.GetHead();
 	while(nextObject != NULL)
 	{
@@ -152,8 +154,9 @@ void GameFile::Unload()
 			nextProperty = nextProperty->GetNext();
 
 			nextObject->GetData()->m_properties.Remove(curProperty);
-			delete curProperty->GetData();
-			delete curProperty;
+			memMan.Free(MemoryManager::eArenaGameFile, curProperty->GetData()->m_data);
+			memMan.Delete(MemoryManager::eArenaGameFile, curProperty->GetData());
+			memMan.Delete(MemoryManager::eArenaGameFile, curProperty);
 		}
 
 		// Cache off working node as above
@@ -161,8 +164,8 @@ void GameFile::Unload()
 		nextObject = nextObject->GetNext();
 
 		m_objects.Remove(curObject);
-		delete curObject->GetData();
-		delete curObject;	
+		memMan.Delete(MemoryManager::eArenaGameFile, curObject->GetData());
+		memMan.Delete(MemoryManager::eArenaGameFile, curObject);
 	}	
 }
 
@@ -277,11 +280,21 @@ bool GameFile::GetVector2(const char * a_object, const char * a_property, Vector
 
 GameFile::Object * GameFile::AddObject(const char * a_objectName, Object * a_parent)
 {
-	LinkedListNode<Object> * newObject = new LinkedListNode<Object>();
-	newObject->SetData(new Object());
+	// Objects and their list nodes come from the game file arena
+	MemoryManager & memMan = MemoryManager::Get();
+	LinkedListNode<Object> * newObject = memMan.New<LinkedListNode<Object> >(MemoryManager::eArenaGameFile);
+	Object * newObjectData = memMan.New<Object>(MemoryManager::eArenaGameFile);
+	if (newObject == NULL || newObjectData == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory for game file object %s.", a_objectName);
+		memMan.Delete(MemoryManager::eArenaGameFile, newObject);
+		memMan.Delete(MemoryManager::eArenaGameFile, newObjectData);
+		return NULL;
+	}
+	newObject->SetData(newObjectData);
 
 	// Set name
-	newObject->GetData()->m_name = StringHash(a_objectName);
+	newObject->GetData()->m_name = StringHash(a_objectName, true);
 
 	// Set parent child relationship
 	if (a_parent != NULL)
@@ -310,10 +323,24 @@ GameFile::Object * GameFile::AddObject(const char * a_objectName, Object * a_par
 
 GameFile::Property * GameFile::AddProperty(GameFile::Object * a_parentObject, const char * a_propertyName, const char * a_value)
 {
-	LinkedListNode<Property> * newProperty = new LinkedListNode<Property>();
-	newProperty->SetData(new Property());
-	newProperty->GetData()->m_name = StringHash(a_propertyName);
-	ALLOC_CSTRING_COPY(newProperty->GetData()->m_data, a_value);
+	// Properties, their list nodes and values come from the game file arena
+	MemoryManager & memMan = MemoryManager::Get();
+	const size_t valueSizeBytes = strlen(a_value) + 1;
+	LinkedListNode<Property> * newProperty = memMan.New<LinkedListNode<Property> >(MemoryManager::eArenaGameFile);
+	Property * newPropertyData = memMan.New<Property>(MemoryManager::eArenaGameFile);
+	void * newValue = memMan.Allocate(MemoryManager::eArenaGameFile, valueSizeBytes);
+	if (newProperty == NULL || newPropertyData == NULL || newValue == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory for game file property %s.", a_propertyName);
+		memMan.Delete(MemoryManager::eArenaGameFile, newProperty);
+		memMan.Delete(MemoryManager::eArenaGameFile, newPropertyData);
+		memMan.Free(MemoryManager::eArenaGameFile, newValue);
+		return NULL;
+	}
+	newProperty->SetData(newPropertyData);
+	newProperty->GetData()->m_name = StringHash(a_propertyName, true);
+	memcpy(newValue, a_value, valueSizeBytes);
+	newProperty->GetData()->m_data = newValue;
 
 	a_parentObject->m_properties.Insert(newProperty);
 
@@ -321,13 +348,18 @@ GameFile::Property * GameFile::AddProperty(GameFile::Object * a_parentObject, co
 }
 
 GameFile::Object * GameFile::FindObject(const char * a_name)
+{
+	return FindObject(StringHash::GenerateCRC(a_name, false));
+}
+
+GameFile::Object * GameFile::FindObject(unsigned int a_nameHash)
 {
 	// Iterate through all objects in this file looking for a name match
 	LinkedListNode<Object> * cur = m_objects.GetHead();
 	while(cur != NULL)
 	{
 		// Quit out of the loop if found
-		if (cur->GetData()->m_name == StringHash::GenerateCRC(a_name))
+		if (cur->GetData()->m_name == a_nameHash)
 		{
 			return cur->GetData();
 		}
@@ -338,13 +370,18 @@ GameFile::Object * GameFile::FindObject(const char * a_name)
 }
 
 GameFile::Property * GameFile::FindProperty(Object * a_parent, const char * a_propertyName)
+{
+	return FindProperty(a_parent, StringHash::GenerateCRC(a_propertyName, false));
+}
+
+GameFile::Property * GameFile::FindProperty(Object * a_parent, unsigned int a_propertyNameHash)
 {
 	// Iterate through all objects in the parent's property list till a name match is found
 	LinkedListNode<Property> * cur = a_parent->m_properties.GetHead();
 	while(cur != NULL)
 	{
 		// Quit out of the loop if found
-		if (cur->GetData()->m_name == StringHash::GenerateCRC(a_propertyName))
+		if (cur->GetData()->m_name == a_propertyNameHash)
 		{
 			return cur->GetData();
 		}
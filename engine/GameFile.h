@@ -114,6 +114,10 @@ public:
 		{
 			return GameFile::FindProperty(this, a_propertyName);
 		}
+		Property * FindProperty(unsigned int a_propertyNameHash)
+		{
+			return GameFile::FindProperty(this, a_propertyNameHash);
+		}
 
 		inline void Serialise(std::ofstream & a_stream, unsigned int a_indentLevel = 0)
 		{
@@ -169,6 +173,7 @@ public:
 	void Unload();
 	inline bool Reload() { Unload(); return Load(m_filePath); }
 	inline bool IsLoaded() { return m_objects.GetLength() > 0; }
+	inline const char * GetFilePath() { return m_filePath; }
 
 	//\brief Write data from memory to file preserving inheritance
 	bool Write(const char * a_filePath);
@@ -198,8 +203,14 @@ public:
 	//\return A pointer to the object data or NULL if there was no object found by name
 	Object * FindObject(const char * a_name);
 
+	//\brief Find an object by a name that has already been hashed, use STRING_HASH for literals
+	//\param a_nameHash is the hash of the name as StringHash would generate it
+	//\return A pointer to the object data or NULL if there was no object found by name
+	Object * FindObject(unsigned int a_nameHash);
+
 	//brief Static helper function to find a property of an object, can be used at the file or object level
 	static Property * FindProperty(Object * a_parent, const char * a_propertyName);
+	static Property * FindProperty(Object * a_parent, unsigned int a_propertyNameHash);
 
 private:
 
@@ -1,7 +1,11 @@
+#include <float.h>
+
 #include "CollisionUtils.h"
 #include "DebugMenu.h"
 #include "FontManager.h"
+#include "ModelManager.h"
 #include "RenderManager.h"
+#include "WorldManager.h"
 
 #include "GameObject.h"
 
@@ -15,15 +19,7 @@ bool GameObject::Update(float a_dt)
 		m_lifeTime += a_dt;
 	}
 
-	// Update components
-	for (unsigned int i = 0; i < Component::eComponentTypeCount; ++i)
-	{
-		Component * curComp = m_components[(unsigned int)i];
-		if (curComp != NULL)
-		{
-			curComp->Update(a_dt);
-		}
-	}
+	// Components are updated by type in the component manager
 
 	return true;
 }
@@ -32,35 +28,35 @@ bool GameObject::Draw()
 {
 	if (m_state == eGameObjectState_Active)
 	{
-		// Normal mesh rendering
+		// Normal mesh rendering, blended between simulation steps so it moves smoothly at any frame rate
 		RenderManager & rMan = RenderManager::Get();
 
 		if (m_model != NULL && m_model->IsLoaded())
 		{
-			rMan.AddModel(RenderManager::eBatchWorld, m_model, &m_worldMat);
+			rMan.AddModel(RenderManager::eBatchWorld, m_model, &m_drawMat);
 		}
 		
 		// Draw the object's name, position, orientation and clip volume over the top
 		if (DebugMenu::Get().IsDebugMenuEnabled() && !DebugMenu::Get().IsDebugMenuActive())
 		{
-			rMan.AddDebugMatrix(m_worldMat);
+			rMan.AddDebugMatrix(m_drawMat);
 
 			// Draw different debug render shapes accoarding to clip type
 			switch (m_clipType)
 			{
 				case eClipTypeSphere:
 				{
-					rMan.AddDebugSphere(m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize.GetX(), sc_colourPink); 
+					rMan.AddDebugSphere(m_drawMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize.GetX(), sc_colourPink); 
 					break;
 				}
 				case eClipTypeAxisBox:
 				{
-					rMan.AddDebugAxisBox(m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize, sc_colourPink); 
+					rMan.AddDebugAxisBox(m_drawMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize, sc_colourPink); 
 				}
 				default: break;
 			}
 
-			FontManager::Get().DrawDebugString3D(m_name, 1.0f, m_worldMat.GetPos());
+			FontManager::Get().DrawDebugString3D(m_name, 1.0f, m_drawMat.GetPos());
 		}
 
 		return true;
@@ -76,41 +72,319 @@ bool GameObject::CollidesWith(Vector a_worldPos)
 	{
 		case eClipTypeSphere:
 		{
-			return CollisionUtils::IntersectPointSphere(a_worldPos + m_clipVolumeOffset, m_worldMat.GetPos(), m_clipVolumeSize.GetX());
+			return CollisionUtils::IntersectPointSphere(a_worldPos, m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize.GetX());
 		}
 		case eClipTypeAxisBox:
 		{
-			return CollisionUtils::IntersectPointAxisBox(a_worldPos + m_clipVolumeOffset, m_worldMat.GetPos(), m_clipVolumeSize);
+			return CollisionUtils::IntersectPointAxisBox(a_worldPos, m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize);
+		}
+		case eClipTypeBox:
+		{
+			return CollisionUtils::IntersectPointBox(a_worldPos, m_worldMat.GetPos() + m_clipVolumeOffset, m_worldMat, m_clipVolumeSize);
 		}
 		default: return false;
 	}
 }
 
 bool GameObject::CollidesWith(Vector a_lineStart, Vector a_lineEnd)
+{ 
+	float hitFraction = 0.0f;
+	return CollidesWith(a_lineStart, a_lineEnd, hitFraction);
+}
+
+bool GameObject::CollidesWith(Vector a_lineStart, Vector a_lineEnd, float & a_hitFraction_OUT)
 { 
 	// Clip line against volume
-	Vector clipPoint(0.0f);
 	switch (m_clipType)
 	{
 		case eClipTypeSphere:
 		{
-			return CollisionUtils::IntersectLineSphere(a_lineStart, a_lineEnd, m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize.GetX());
+			return CollisionUtils::IntersectLineSphere(a_lineStart, a_lineEnd, m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize.GetX(), a_hitFraction_OUT);
 		}
 		case eClipTypeAxisBox:
 		{
-			return CollisionUtils::IntersectLineAxisBox(a_lineStart, a_lineEnd, m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize, clipPoint);
+			return CollisionUtils::IntersectLineAxisBox(a_lineStart, a_lineEnd, m_worldMat.GetPos() + m_clipVolumeOffset, m_clipVolumeSize, a_hitFraction_OUT);
+		}
+		case eClipTypeBox:
+		{
+			return CollisionUtils::IntersectLineBox(a_lineStart, a_lineEnd, m_worldMat.GetPos() + m_clipVolumeOffset, m_worldMat, m_clipVolumeSize, a_hitFraction_OUT);
+		}
+		default: return false;
+	}
+}
+
+bool GameObject::CollidesWith(GameObject * a_other)
+{
+	// Put the pair in order of clip type so each combination of shapes only needs handling once
+	if (a_other->m_clipType < m_clipType)
+	{
+		return a_other->CollidesWith(this);
+	}
+
+	const Vector clipPos = GetClipPos();
+	const Vector otherClipPos = a_other->GetClipPos();
+	switch (m_clipType)
+	{
+		case eClipTypeNone:
+		{
+			return a_other->CollidesWith(clipPos);
+		}
+		case eClipTypeSphere:
+		{
+			switch (a_other->m_clipType)
+			{
+				case eClipTypeSphere:	return CollisionUtils::IntersectSphereSphere(clipPos, m_clipVolumeSize.GetX(), otherClipPos, a_other->m_clipVolumeSize.GetX());
+				case eClipTypeAxisBox:	return CollisionUtils::IntersectSphereAxisBox(clipPos, m_clipVolumeSize.GetX(), otherClipPos, a_other->m_clipVolumeSize);
+				case eClipTypeBox:		return CollisionUtils::IntersectSphereBox(clipPos, m_clipVolumeSize.GetX(), otherClipPos, a_other->m_worldMat, a_other->m_clipVolumeSize);
+				default: return false;
+			}
+		}
+		case eClipTypeAxisBox:
+		{
+			switch (a_other->m_clipType)
+			{
+				case eClipTypeAxisBox:	return CollisionUtils::IntersectAxisBoxAxisBox(clipPos, m_clipVolumeSize, otherClipPos, a_other->m_clipVolumeSize);
+				case eClipTypeBox:		return CollisionUtils::IntersectSphereAxisBox(otherClipPos, (a_other->m_clipVolumeSize * 0.5f).Length(), clipPos, m_clipVolumeSize);
+				default: return false;
+			}
+		}
+		case eClipTypeBox:
+		{
+			return CollisionUtils::IntersectSphereBox(clipPos, (m_clipVolumeSize * 0.5f).Length(), otherClipPos, a_other->m_worldMat, a_other->m_clipVolumeSize);
 		}
 		default: return false;
 	}
 }
 
+void GameObject::GetClipBounds(Vector & a_min_OUT, Vector & a_max_OUT)
+{
+	// Spheres are sized by radius and boxes by their full dimensions
+	const Vector clipPos = m_worldMat.GetPos() + m_clipVolumeOffset;
+	switch (m_clipType)
+	{
+		case eClipTypeSphere:
+		{
+			a_min_OUT = clipPos - m_clipVolumeSize.GetX();
+			a_max_OUT = clipPos + m_clipVolumeSize.GetX();
+			break;
+		}
+		case eClipTypeAxisBox:
+		{
+			const Vector halfSize = m_clipVolumeSize * 0.5f;
+			a_min_OUT = clipPos - halfSize;
+			a_max_OUT = clipPos + halfSize;
+			break;
+		}
+		case eClipTypeBox:
+		{
+			// Any rotation of the box fits inside the sphere through it's corners
+			const float halfDiagonal = (m_clipVolumeSize * 0.5f).Length();
+			a_min_OUT = clipPos - halfDiagonal;
+			a_max_OUT = clipPos + halfDiagonal;
+			break;
+		}
+		default:
+		{
+			a_min_OUT = m_worldMat.GetPos();
+			a_max_OUT = m_worldMat.GetPos();
+			break;
+		}
+	}
+}
+
+void GameObject::GetCullVolume(Frustum::Volume & a_volume_OUT)
+{
+	a_volume_OUT.m_centre = m_worldMat.GetPos() + m_clipVolumeOffset;
+	a_volume_OUT.m_halfSize = Vector::Zero();
+	a_volume_OUT.m_radius = 0.0f;
+	switch (m_clipType)
+	{
+		case eClipTypeSphere:
+		{
+			a_volume_OUT.m_radius = m_clipVolumeSize.GetX();
+			break;
+		}
+		case eClipTypeAxisBox:
+		{
+			a_volume_OUT.m_halfSize = m_clipVolumeSize * 0.5f;
+			break;
+		}
+		case eClipTypeBox:
+		{
+			a_volume_OUT.m_radius = (m_clipVolumeSize * 0.5f).Length();
+			break;
+		}
+		default:
+		{
+			// Without a size the model could be any shape so it has to be drawn
+			a_volume_OUT.m_radius = FLT_MAX;
+			break;
+		}
+	}
+}
+
+void GameObject::SetWorldMat(const Matrix & a_mat)
+{
+	m_worldMat = a_mat;
+	m_localMat = m_parent != NULL ? a_mat.Multiply(m_parent->m_worldMat.GetInverseAffine()) : a_mat;
+	OnBoundsChanged();
+}
+
+void GameObject::SetLocalMat(const Matrix & a_mat)
+{
+	// World transforms of objects with a parent are recalculated by the scene
+	m_localMat = a_mat;
+	if (m_parent == NULL)
+	{
+		m_worldMat = a_mat;
+	}
+	OnBoundsChanged();
+}
+
+bool GameObject::AddChild(GameObject * a_child, bool a_keepWorldTransform)
+{
+	if (a_child == NULL)
+	{
+		return false;
+	}
+
+	// Attaching an ancestor would make a loop
+	for (GameObject * ancestor = this; ancestor != NULL; ancestor = ancestor->m_parent)
+	{
+		if (ancestor == a_child)
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot attach object %s to %s, it is already above it in the hierarchy.", a_child->GetName(), m_name);
+			return false;
+		}
+	}
+
+	if (a_child->m_parent != NULL)
+	{
+		a_child->m_parent->RemoveChild(a_child);
+	}
+
+	// New children go on the front of the sibling list
+	a_child->m_parent = this;
+	a_child->m_next = m_child;
+	m_child = a_child;
+
+	// The child's transform was it's world transform until now
+	if (a_keepWorldTransform)
+	{
+		a_child->SetWorldMat(a_child->m_worldMat);
+	}
+	else
+	{
+		a_child->SetLocalMat(a_child->m_localMat);
+	}
+	return true;
+}
+
+bool GameObject::RemoveChild(GameObject * a_child)
+{
+	if (a_child == NULL || a_child->m_parent != this)
+	{
+		return false;
+	}
+
+	// Unlink from the sibling list
+	GameObject ** link = &m_child;
+	while (*link != a_child)
+	{
+		link = &(*link)->m_next;
+	}
+	*link = a_child->m_next;
+	a_child->m_parent = NULL;
+	a_child->m_next = NULL;
+
+	// Without a parent the local transform is the world transform
+	a_child->m_localMat = a_child->m_worldMat;
+	return true;
+}
+
+void GameObject::OnBoundsChanged()
+{
+	if (m_scene != NULL)
+	{
+		m_scene->UpdateObjectBounds(this);
+	}
+}
+
+void GameObject::SetReportOverlaps(bool a_report)
+{
+	m_reportOverlaps = a_report;
+	if (m_scene != NULL)
+	{
+		m_scene->UpdateObjectOverlaps(this);
+	}
+}
+
+unsigned int GameObject::GetStateSize()
+{
+	unsigned int stateSize = sizeof(m_localMat) + sizeof(m_worldMat) + sizeof(m_lifeTime) + sizeof(m_state);
+	for (unsigned int i = 0; i < Component::eComponentTypeCount; ++i)
+	{
+		if (Component * curComp = ComponentManager::Get().GetComponent((Component::eComponentType)i, m_components[i]))
+		{
+			stateSize += curComp->GetStateSize();
+		}
+	}
+	return stateSize;
+}
+
+void GameObject::SaveState(void * a_state_OUT)
+{
+	unsigned char * state = (unsigned char *)a_state_OUT;
+	memcpy(state, &m_localMat, sizeof(m_localMat));		state += sizeof(m_localMat);
+	memcpy(state, &m_worldMat, sizeof(m_worldMat));		state += sizeof(m_worldMat);
+	memcpy(state, &m_lifeTime, sizeof(m_lifeTime));		state += sizeof(m_lifeTime);
+	memcpy(state, &m_state, sizeof(m_state));			state += sizeof(m_state);
+	for (unsigned int i = 0; i < Component::eComponentTypeCount; ++i)
+	{
+		if (Component * curComp = ComponentManager::Get().GetComponent((Component::eComponentType)i, m_components[i]))
+		{
+			curComp->SaveState(state);
+			state += curComp->GetStateSize();
+		}
+	}
+}
+
+void GameObject::RestoreState(const void * a_state)
+{
+	const unsigned char * state = (const unsigned char *)a_state;
+	memcpy(&m_localMat, state, sizeof(m_localMat));		state += sizeof(m_localMat);
+	memcpy(&m_worldMat, state, sizeof(m_worldMat));		state += sizeof(m_worldMat);
+	memcpy(&m_lifeTime, state, sizeof(m_lifeTime));		state += sizeof(m_lifeTime);
+	memcpy(&m_state, state, sizeof(m_state));			state += sizeof(m_state);
+	for (unsigned int i = 0; i < Component::eComponentTypeCount; ++i)
+	{
+		if (Component * curComp = ComponentManager::Get().GetComponent((Component::eComponentType)i, m_components[i]))
+		{
+			curComp->RestoreState(state);
+			state += curComp->GetStateSize();
+		}
+	}
+
+	// Put the object back where it was in the scene's spatial structures and partitions too, both transforms are restored as the parent may not be yet
+	OnBoundsChanged();
+	OnStateChanged();
+}
+
+void GameObject::OnStateChanged()
+{
+	if (m_scene != NULL)
+	{
+		m_scene->UpdateObjectState(this);
+	}
+}
+
 void GameObject::Serialise(GameFile * outputFile, GameFile::Object * a_parent)
 {
 	if (a_parent != NULL)
 	{
-		// Get string versions of numeric values
+		// Get string versions of numeric values, children are written inside their parent so the position is local
 		char posBuf[StringUtils::s_maxCharsPerName];
-		m_worldMat.GetPos().GetString(posBuf);
+		m_localMat.GetPos().GetString(posBuf);
 
 		// Output all properties
 		GameFile::Object * fileObject = outputFile->AddObject("gameObject", a_parent);
@@ -123,7 +397,7 @@ void GameObject::Serialise(GameFile * outputFile, GameFile::Object * a_parent)
 		while (child != NULL)
 		{
 			child->Serialise(outputFile, fileObject);
-			child = child->GetChild();
+			child = child->GetNext();
 		}
 	}
 }
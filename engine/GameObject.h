@@ -5,8 +5,10 @@
 #include <iostream>
 #include <fstream>
 
+#include "../core/Frustum.h"
 #include "../core/Matrix.h"
 
+#include "ComponentManager.h"
 #include "GameFile.h"
 #include "StringUtils.h"
 
@@ -14,6 +16,7 @@
 
 class GameObjectComponent;
 class Model;
+class Scene;
 
 //\brief A GameObject is the container for all entities involved in the gameplay.
 //		 It is lightweight yet has provisions for all basic game related functions like
@@ -46,22 +49,41 @@ public:
 		eClipTypeCount,
 	};
 
+	//\brief How an overlap with another object changed in the last simulation step, in the same order as SweepAndPrune::eOverlap
+	enum eOverlap
+	{
+		eOverlapBegin = 0,			///< The objects started overlapping
+		eOverlapStay,				///< The objects were already overlapping
+		eOverlapEnd,				///< The objects stopped overlapping or the other object left the scene
+
+		eOverlapCount,
+	};
+
 	//\brief Creation and destruction
 	GameObject() 
 		: m_id(0) 
+		, m_parent(NULL)
 		, m_child(NULL)
 		, m_next(NULL)
 		, m_model(NULL)
+		, m_scene(NULL)
 		, m_state(eGameObjectState_New)
 		, m_lifeTime(0.0f)
+		, m_updateOnMainThread(false)
+		, m_reportOverlaps(false)
 		, m_clipType(eClipTypeNone)
 		, m_clipVolumeSize(0.0f)
 		, m_clipVolumeOffset(0.0f)
+		, m_transformDirty(false)
+		, m_destroyQueued(0)
+		, m_localMat(Matrix::Identity())
 		, m_worldMat(Matrix::Identity())
+		, m_prevWorldMat(Matrix::Identity())
+		, m_drawMat(Matrix::Identity())
 		{ 
 			SetName("UNAMED_GAME_OBJECT");
 			SetTemplate("");
-			memset(&m_components[0], 0, sizeof(Component *) * Component::eComponentTypeCount);
+			memset(&m_components[0], 0, sizeof(ComponentManager::ComponentHandle) * Component::eComponentTypeCount);
 		}
 
 	~GameObject() { Destroy(); }
@@ -72,39 +94,46 @@ public:
 	virtual bool Draw();
 	virtual bool Shutdown() { return true; }
 
-	//\brief Component accessors
+	//\brief Called after each simulation step for every object whose clip volume overlaps this one's, if overlaps are reported
+	//\param a_other the other object, NULL when an overlap ends because the other object has left the scene
+	//\param a_overlap if the overlap began, carried on or ended this step
+	virtual void OnOverlap(GameObject * a_other, eOverlap a_overlap) { }
+
+	//\brief Component accessors, components live in the component manager and pointers to them are only valid until another component of the same type is added or removed
 	template <typename T>
 	inline bool AddComponent()
 	{
-		if (T * newComponent = new T())
+		// Only one component of each type, adding again replaces it
+		RemoveComponent(T::s_componentType);
+
+		ComponentManager::ComponentHandle newHandle = ComponentManager::s_invalidHandle;
+		if (ComponentManager::Get().CreateComponent<T>(this, newHandle) != NULL)
 		{
-			newComponent->Startup(this);
-			m_components[(unsigned int)newComponent->GetComponentType()] = dynamic_cast<Component *>(newComponent);
+			m_components[(unsigned int)T::s_componentType] = newHandle;
 			return true;
 		}
 		return false;
 	}
 	inline bool HasComponent(Component::eComponentType a_type)
 	{
-		return m_components[(unsigned int)a_type] != NULL;
+		return m_components[(unsigned int)a_type] != ComponentManager::s_invalidHandle;
 	}
 	template <typename T>
 	inline T * GetComponent(Component::eComponentType a_type)
 	{
-		Component * curComp = m_components[(unsigned int)a_type];
-		if (curComp != NULL)
+		if (a_type == T::s_componentType)
 		{
-			return dynamic_cast<T *>(curComp);
+			return ComponentManager::Get().GetComponent<T>(m_components[(unsigned int)a_type]);
 		}
 		return NULL;
 	}
 	inline bool RemoveComponent(Component::eComponentType a_type)
 	{
-		Component * curComp = m_components[(unsigned int)a_type];
-		if (curComp != NULL)
+		ComponentManager::ComponentHandle & curHandle = m_components[(unsigned int)a_type];
+		if (curHandle != ComponentManager::s_invalidHandle)
 		{
-			delete curComp;
-			m_components[(unsigned int)a_type] = NULL;
+			ComponentManager::Get().DestroyComponent(a_type, curHandle);
+			curHandle = ComponentManager::s_invalidHandle;
 			return true;
 		}
 
@@ -119,41 +148,104 @@ public:
 	}
 
 	//\brief State mutators and accessors
-	inline void SetSleeping() { if (m_state == eGameObjectState_Active) m_state = eGameObjectState_Sleep; }
-	inline void SetActive()	  { if (m_state == eGameObjectState_Sleep) m_state = eGameObjectState_Active; }
+	inline void SetSleeping() { if (m_state == eGameObjectState_Active) { m_state = eGameObjectState_Sleep; OnStateChanged(); } }
+	inline void SetActive()	  { if (m_state == eGameObjectState_Sleep) { m_state = eGameObjectState_Active; OnStateChanged(); } }
 	inline bool IsActive()	  { return m_state == eGameObjectState_Active; }
 	inline bool IsSleeping()  { return m_state == eGameObjectState_Sleep; }
+	inline void SetUpdateOnMainThread(bool a_mainThread) { m_updateOnMainThread = a_mainThread; }
+	inline bool IsUpdatedOnMainThread() { return m_updateOnMainThread; }
+
+	//\brief Ask the scene to call OnOverlap for this object, not safe to call from a parallel update
+	void SetReportOverlaps(bool a_report);
+	inline bool IsReportingOverlaps() { return m_reportOverlaps; }
 	inline void SetId(unsigned int a_newId) { m_id = a_newId; }
-	inline void SetClipType(eClipType a_newClipType) { m_clipType = a_newClipType; }
-	inline void SetClipSize(const Vector & a_clipSize) { m_clipVolumeSize = a_clipSize; }
-	inline void SetClipOffset(const Vector & a_clipOffset) { m_clipVolumeOffset = a_clipOffset; }
-	inline void SetWorldMat(const Matrix & a_mat) { m_worldMat = a_mat; }
+	inline void SetClipType(eClipType a_newClipType) { m_clipType = a_newClipType; OnBoundsChanged(); }
+	inline void SetClipSize(const Vector & a_clipSize) { m_clipVolumeSize = a_clipSize; OnBoundsChanged(); }
+	inline void SetClipOffset(const Vector & a_clipOffset) { m_clipVolumeOffset = a_clipOffset; OnBoundsChanged(); }
+	inline void SetScene(Scene * a_scene) { m_scene = a_scene; }
 	inline unsigned int GetId() { return m_id; }
 	inline const char * GetName() { return m_name; }
 	inline const char * GetTemplate() { return m_template; }
 	inline Model * GetModel() { return m_model; }
+	inline Scene * GetScene() { return m_scene; }
 	inline Matrix GetWorldMat() { return m_worldMat; }
+	inline Matrix GetLocalMat() { return m_localMat; }
 	inline Vector GetPos() { return m_worldMat.GetPos(); }
+	inline const Matrix & GetDrawMat() { return m_drawMat; }
+	inline float GetLifeTime() { return m_lifeTime; }
 	inline Vector GetClipSize() { return m_clipVolumeSize; }
+	inline eClipType GetClipType() { return m_clipType; }
+	inline Vector GetClipPos() { return m_worldMat.GetPos() + m_clipVolumeOffset; }
+
+	//\brief Get the world space box that encloses the clip volume, just the position if there is no clip volume
+	//\param a_min_OUT, a_max_OUT are set to the corners of the box
+	void GetClipBounds(Vector & a_min_OUT, Vector & a_max_OUT);
+
+	//\brief Get the volume to test against the view before drawing, objects with no clip volume are never culled
+	//\param a_volume_OUT is set to the world space clip volume
+	void GetCullVolume(Frustum::Volume & a_volume_OUT);
 	inline bool HasTemplate() { return strlen(m_template) > 0; }
 
-	//\brief Child object accessors
+	//\brief Set where the object is in the world, for objects with a parent the local transform is worked out from the parent's world transform
+	//\param a_mat, a_newPos the world transform or position, children follow once the scene updates transforms
+	void SetWorldMat(const Matrix & a_mat);
+	inline void SetPos(const Vector & a_newPos) { Matrix newMat = m_worldMat; newMat.SetPos(a_newPos); SetWorldMat(newMat); }
+
+	//\brief Set where the object is relative to it's parent, the same as the world transform for objects without a parent.
+	//		 The world transforms of the object and it's children are brought up to date when the scene updates transforms,
+	//		 so an object with a parent can move itself this way in a parallel update without reading the parent.
+	//\param a_mat, a_newPos the local transform or position
+	void SetLocalMat(const Matrix & a_mat);
+	inline void SetLocalPos(const Vector & a_newPos) { Matrix newMat = m_localMat; newMat.SetPos(a_newPos); SetLocalMat(newMat); }
+
+	//\brief Forget where the object was last step so it is drawn where it is now, call after teleporting so it doesn't slide across the world
+	inline void ResetInterpolation() { m_prevWorldMat = m_worldMat; m_drawMat = m_worldMat; }
+
+	//\brief Attach an object so it follows this object's transform, it is detached from any parent it already has
+	//\param a_child the object to attach, can't be this object or one of it's ancestors
+	//\param a_keepWorldTransform true if the child should stay where it is, false to use it's current transform as the offset from this object
+	//\return true if the object was attached
+	bool AddChild(GameObject * a_child, bool a_keepWorldTransform = true);
+
+	//\brief Detach a child object, it stays where it is in the world
+	//\return true if the object was a child of this object
+	bool RemoveChild(GameObject * a_child);
+	inline void RemoveAllChildren() { while (m_child != NULL) { RemoveChild(m_child); } }
+
+	//\brief Hierarchy accessors
+	inline GameObject * GetParent() { return m_parent; }
 	inline GameObject * GetChild() { return m_child; }
 	inline GameObject * GetNext() { return m_next; }
+	inline bool IsInHierarchy() { return m_parent != NULL || m_child != NULL; }
 
 	//\brief Collision functions
 	//\param The vector(s) to check intersection against the game object
+	//\param a_hitFraction_OUT how far along the line the clip volume is first touched
 	//\return bool true if there is an intersection, false if none
 	bool CollidesWith(Vector a_worldPos);
 	bool CollidesWith(Vector a_lineStart, Vector a_lineEnd);
+	bool CollidesWith(Vector a_lineStart, Vector a_lineEnd, float & a_hitFraction_OUT);
+
+	//\brief Check if the clip volumes of two objects overlap, an object with no clip volume is treated as a point.
+	//		 There is no exact test between boxes that are rotated differently so a rotated box tested against
+	//		 another box is treated as the sphere through it's corners.
+	//\param a_other the object to test against
+	//\return true if the volumes touch or one is inside the other
+	bool CollidesWith(GameObject * a_other);
 
 	//\brief Resource mutators and accessors
 	inline void SetModel(Model * a_newModel) { m_model = a_newModel; }
 	//inline void SetScript(Script * a_newScript) { m_script = a_newScript; }
-	inline void SetState(eGameObjectState a_newState) { m_state = a_newState; }
+	inline void SetState(eGameObjectState a_newState) { m_state = a_newState; OnStateChanged(); }
+	inline eGameObjectState GetState() { return m_state; }
 	inline void SetName(const char * a_name) { sprintf(m_name, "%s", a_name); }
 	inline void SetTemplate(const char * a_templateName) { sprintf(m_template, "%s", a_templateName); }
-	inline void SetPos(const Vector & a_newPos) { m_worldMat.SetPos(a_newPos); }
+
+	//\brief Save and restore everything an update can change, so the same update can be run twice and compared
+	//\param a_state_OUT, a_state point to GetStateSize() bytes of storage
+	unsigned int GetStateSize();
+	void SaveState(void * a_state_OUT);
+	void RestoreState(const void * a_state);
 
 	//\brief Add the game object, all instance properties and children to game file object
 	//\param a_outputFile is a gamefile object that will be appended
@@ -162,6 +254,23 @@ public:
 
 private:
 
+	//\brief The scene walks the hierarchy to bring world transforms up to date
+	friend class Scene;
+
+	//\brief The world claims objects for destruction through their queued flag
+	friend class WorldManager;
+
+	//\brief Let the scene know the object has moved or changed size so spatial queries stay correct
+	void OnBoundsChanged();
+
+	//\brief Let the scene know the object's state has changed so it is only updated and drawn when active
+	void OnStateChanged();
+
+	//\brief Keep the world transform from before a simulation step and blend towards the new one for drawing
+	//\param a_interpolation how far between the previous and current step the frame being drawn is, 0 to 1
+	inline void StorePrevWorldMat() { m_prevWorldMat = m_worldMat; }
+	inline void Interpolate(float a_interpolation) { m_drawMat = Matrix::Lerp(m_prevWorldMat, m_worldMat, a_interpolation); }
+
 	//\brief Destruction is private as it should only be handled by object management
 	inline void Destroy() 
 	{
@@ -170,20 +279,29 @@ private:
 	}
 
 	//\ingroup Component management
-	Component * m_components[Component::eComponentTypeCount];
+	ComponentManager::ComponentHandle m_components[Component::eComponentTypeCount];	///< Handle to each type of component the object has
 
 	//\ingroup Local properties
-	unsigned int		  m_id;					///< Unique identifier, objects can be resolved from ids
+	unsigned int		  m_id;					///< Unique identifier, a handle to the world object pool so objects can be resolved from ids
+	GameObject *		  m_parent;				///< Object this object is attached to, NULL for objects at the top of a hierarchy
 	GameObject *		  m_child;				///< Pointer to first child game obhject
 	GameObject *		  m_next;				///< Pointer to sibling game objects
 	Model *				  m_model;				///< Pointer to a mesh for display purposes
+	Scene *				  m_scene;				///< The scene the object is in, NULL until added to one
 	//Script			  m_script;				///< The LUA script for user defined behavior
 	eGameObjectState	  m_state;				///< What state the object is in
 	float				  m_lifeTime;			///< How long this guy has been active
+	bool				  m_updateOnMainThread;	///< If the object touches things that are not thread safe and can't update in parallel with others
+	bool				  m_reportOverlaps;		///< If the object is told about other objects it overlaps
 	eClipType			  m_clipType;			///< What kind of shape represents the bounds of the object
 	Vector				  m_clipVolumeSize;		///< Dimensions of the clipping volume for culling and picking
 	Vector				  m_clipVolumeOffset;	///< How far from the pivot of the object the clip volume is
+	bool				  m_transformDirty;		///< Set while the object is waiting in the scene for it's world transform and it's children's to be recalculated
+	volatile long		  m_destroyQueued;		///< Set by the first thread to queue the object for destruction, the pool constructs a new object before the slot is reused
+	Matrix				  m_localMat;			///< Position and orientation relative to the parent, the same as the world matrix without a parent
 	Matrix				  m_worldMat;			///< Position and orientation in the world
+	Matrix				  m_prevWorldMat;		///< World transform at the start of the last simulation step
+	Matrix				  m_drawMat;			///< World transform blended between steps for the frame being drawn
 	char				  m_name[StringUtils::s_maxCharsPerName];		///< Every creature needs a name
 	char				  m_template[StringUtils::s_maxCharsPerName];	///< Every persistent, serializable creature needs a template
 };
@@ -14,6 +14,7 @@ bool InputManager::Startup(bool a_fullScreen)
 bool InputManager::Shutdown()
 {
 	// Clean up any registered events
+	MemoryManager & memMan = MemoryManager::Get();
 	InputEventNode * next = m_events.GetHead();
 	while(next != NULL)
 	{
@@ -22,8 +23,8 @@ bool InputManager::Shutdown()
 		next = cur->GetNext();
 
 		m_events.Remove(cur);
-		delete cur->GetData();
-		delete cur;
+		memMan.Delete(MemoryManager::eArenaInput, cur->GetData());
+		memMan.Delete(MemoryManager::eArenaInput, cur);
 	}
 
 	return true;
@@ -286,4 +287,24 @@ bool InputManager::ProcessKeyDown(SDLKey a_key)
 	}
 
 	return false;
+}
+
+bool InputManager::AllocateEvent(InputEventNode *& a_node_OUT)
+{
+	// Both the node and the event come from the input arena
+	MemoryManager & memMan = MemoryManager::Get();
+	InputEventNode * newNode = memMan.New<InputEventNode>(MemoryManager::eArenaInput);
+	InputEvent * newEvent = memMan.New<InputEvent>(MemoryManager::eArenaInput);
+	if (newNode == NULL || newEvent == NULL)
+	{
+		Log::Get().WriteEngineErrorNoParams("Unable to allocate memory to register an input event.");
+		memMan.Delete(MemoryManager::eArenaInput, newNode);
+		memMan.Delete(MemoryManager::eArenaInput, newEvent);
+		a_node_OUT = NULL;
+		return false;
+	}
+
+	newNode->SetData(newEvent);
+	a_node_OUT = newNode;
+	return true;
 }
\ No newline at end of file
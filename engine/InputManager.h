@@ -9,6 +9,7 @@
 #include "../core/Vector.h"
 
 #include "DebugMenu.h"
+#include "MemoryManager.h"
 #include "Singleton.h"
 
 class InputManager : public Singleton<InputManager>
@@ -88,9 +89,11 @@ public:
 	void RegisterMouseCallback(TObj * a_callerObject, TMethod a_callback, eMouseButton a_button, eInputType a_type = eInputTypeMouseUp, bool a_oneShot = false)
 	{
 		// Add an event to the list of items to be processed
-		// TODO memory management! Kill std new with a rusty fork
-		InputEventNode * newInputNode = new InputEventNode();
-		newInputNode->SetData(new InputEvent());
+		InputEventNode * newInputNode = NULL;
+		if (!AllocateEvent(newInputNode))
+		{
+			return;
+		}
 	
 		// Set data for the new event
 		InputEvent * newInput = newInputNode->GetData();
@@ -110,8 +113,11 @@ public:
 	void RegisterKeyCallback(TObj * a_callerObject, TMethod a_callback, SDLKey a_key, eInputType a_type = eInputTypeKeyDown, bool a_oneShot = false)
 	{
 		// Add an event to the list of items to be processed
-		InputEventNode * newInputNode = new InputEventNode();
-		newInputNode->SetData(new InputEvent());
+		InputEventNode * newInputNode = NULL;
+		if (!AllocateEvent(newInputNode))
+		{
+			return;
+		}
 	
 		// Set data for the new event
 		InputEvent * newInput = newInputNode->GetData();
@@ -184,6 +190,11 @@ private:
 	//\return true if at least one event was found
 	bool GetEvents(eInputType a_type, InputSource a_src, InputEventList & a_events_OUT);
 
+	//\brief Helper function to allocate an event and it's list node from the input arena
+	//\param a_node_OUT is a ref to a pointer that will be set to the new node with an event attached
+	//\return true if the memory was allocated, an error is logged if not
+	bool AllocateEvent(InputEventNode *& a_node_OUT);
+
 	static const unsigned int s_maxDepressedKeys = 8;	///< How many keys can be held on the keyboard at once
 
 	InputEvent m_alphaKeys;		///< Special input event to catch all keys being pressed
@@ -0,0 +1,24 @@
+#include "Log.h"
+
+#include "JobManager.h"
+
+template<> JobManager * Singleton<JobManager>::s_instance = NULL;
+
+bool JobManager::Startup(int a_numWorkers)
+{
+	const unsigned int numWorkers = a_numWorkers >= 0 ? (unsigned int)a_numWorkers : JobSystem::s_numWorkersAuto;
+	if (!JobSystem::Startup(numWorkers))
+	{
+		Log::Get().WriteEngineErrorNoParams("Job system failed to start, jobs will not run in parallel.");
+		return false;
+	}
+
+	Log::Get().Write(Log::LL_INFO, Log::LC_ENGINE, "Job system started with %u worker threads on %u cores.", GetNumWorkers(), GetNumCores());
+	return true;
+}
+
+bool JobManager::Shutdown()
+{
+	JobSystem::Shutdown();
+	return true;
+}
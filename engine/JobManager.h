@@ -0,0 +1,24 @@
+#ifndef _ENGINE_JOB_MANAGER_
+#define _ENGINE_JOB_MANAGER_
+#pragma once
+
+#include "../core/JobSystem.h"
+
+#include "Singleton.h"
+
+//\brief JobManager owns the engine's job system so any subsystem can split it's work
+//		 across the worker threads. It must be started from the main thread before use.
+class JobManager : public Singleton<JobManager>, public JobSystem
+{
+public:
+
+	//\brief Start the worker threads, the calling thread becomes the main thread for jobs
+	//\param a_numWorkers how many worker threads to start, negative for one per spare core
+	//\return true if the job system is running
+	bool Startup(int a_numWorkers);
+
+	//\brief Stop the worker threads, jobs that have not started are not run
+	bool Shutdown();
+};
+
+#endif // _ENGINE_JOB_MANAGER_
@@ -1,3 +1,5 @@
+#include "MemoryManager.h"
+
 #include "Log.h"
 
 template<> Log * Singleton<Log>::s_instance = NULL;
@@ -18,6 +20,7 @@ const Colour Log::s_logDisplayColour[LL_COUNT]=
 
 bool Log::Shutdown()
 {
+	MemoryManager & memMan = MemoryManager::Get();
 	LogDisplayNode * next = m_displayList.GetHead();
 	while(next != NULL)
 	{
@@ -26,8 +29,8 @@ bool Log::Shutdown()
 		next = cur->GetNext();
 
 		m_displayList.Remove(cur);
-		delete cur->GetData();
-		delete cur;
+		memMan.Delete(MemoryManager::eArenaLog, cur->GetData());
+		memMan.Delete(MemoryManager::eArenaLog, cur);
 	}
 
 	return true;
@@ -64,9 +67,7 @@ void Log::Write(LogLevel a_level, LogCategory a_category, const char * a_message
 	// Also add to the list which is diaplyed on screen
 	if (m_renderToScreen)
 	{
-		LogDisplayNode * newLogEntry = new LogDisplayNode();
-		newLogEntry->SetData(new LogDisplayEntry(finalString, a_level));
-		m_displayList.Insert(newLogEntry);
+		AddDisplayEntry(finalString, a_level);
 	}
 }
 
@@ -75,9 +76,15 @@ void Log::WriteOnce(LogLevel a_level, LogCategory a_category, const char * a_mes
 	// Add message to write once list
 	unsigned int msgHash = StringHash::GenerateCRC(a_message, false);
 	unsigned int unused;
-	if (!m_writeOnceList.Get(msgHash, unused))
+	EnterCriticalSection(&m_lock);
+	const bool firstWrite = !m_writeOnceList.Get(msgHash, unused);
+	if (firstWrite)
 	{
 		m_writeOnceList.Insert(msgHash, msgHash);
+	}
+	LeaveCriticalSection(&m_lock);
+	if (firstWrite)
+	{
 
 		char levelBuf[128];
 		char categoryBuf[128];
@@ -108,15 +115,15 @@ void Log::WriteOnce(LogLevel a_level, LogCategory a_category, const char * a_mes
 		// Also add to the list which is diaplyed on screen
 		if (m_renderToScreen)
 		{
-			LogDisplayNode * newLogEntry = new LogDisplayNode();
-			newLogEntry->SetData(new LogDisplayEntry(finalString, a_level));
-			m_displayList.Insert(newLogEntry);
+			AddDisplayEntry(finalString, a_level);
 		}
 	}
 }
 void Log::Update(float a_dt)
 {
 	// Walk through the list printing out debug lists
+	EnterCriticalSection(&m_lock);
+	MemoryManager & memMan = MemoryManager::Get();
 	LogDisplayNode * curEntry = m_displayList.GetHead();
 	float logDisplayPosY = 1.0f;
 	int logEntryCount = 0;
@@ -139,9 +146,30 @@ void Log::Update(float a_dt)
 		}
 		else // This log entry is dead, remove it
 		{
-			delete logEntry;
+			memMan.Delete(MemoryManager::eArenaLog, logEntry);
 			m_displayList.Remove(toDelete);
-			delete toDelete;
+			memMan.Delete(MemoryManager::eArenaLog, toDelete);
 		}
 	}
+	LeaveCriticalSection(&m_lock);
+}
+
+void Log::AddDisplayEntry(const char * a_message, LogLevel a_level)
+{
+	// Display entries come from the log arena, there's no logging a failure here so the line is just not shown
+	MemoryManager & memMan = MemoryManager::Get();
+	EnterCriticalSection(&m_lock);
+	LogDisplayNode * newLogNode = memMan.New<LogDisplayNode>(MemoryManager::eArenaLog);
+	void * newLogEntryMem = memMan.Allocate(MemoryManager::eArenaLog, sizeof(LogDisplayEntry));
+	if (newLogNode != NULL && newLogEntryMem != NULL)
+	{
+		newLogNode->SetData(new (newLogEntryMem) LogDisplayEntry(a_message, a_level));
+		m_displayList.Insert(newLogNode);
+	}
+	else
+	{
+		memMan.Delete(MemoryManager::eArenaLog, newLogNode);
+		memMan.Free(MemoryManager::eArenaLog, newLogEntryMem);
+	}
+	LeaveCriticalSection(&m_lock);
 }
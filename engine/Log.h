@@ -38,8 +38,8 @@ public:
     };
 
 	// Log does nothing on startup but needs to cleanup
-	Log() : m_renderToScreen(true) {};
-	~Log() { Shutdown(); }
+	Log() : m_renderToScreen(true) { InitializeCriticalSection(&m_lock); }
+	~Log() { Shutdown(); DeleteCriticalSection(&m_lock); }
 
 	//\brief Clean up any allocated memory for log lines still being displayed
 	//\return true if all cleanup tasks were successful
@@ -102,12 +102,18 @@ private:
 	typedef LinkedListNode<LogDisplayEntry> LogDisplayNode;
 	typedef LinkedList<LogDisplayEntry> LogDisplayList;
 
+	//\brief Allocate a display entry for a formatted log line and add it to the display list
+	//\param a_message the fully formatted line to display
+	//\param a_level the importance of the entry which decides the colour and display time
+	void AddDisplayEntry(const char * a_message, LogLevel a_level);
+
 	const static float	s_logDisplayTime[LL_COUNT];			// How long to display each log category on screen
 	const static Colour s_logDisplayColour[LL_COUNT];		// What colours to display each log category in
 
 	LogDisplayList m_displayList;							// All log entries that are being displayed at a time
 	HashMap<unsigned int, unsigned int> m_writeOnceList;	// When a message is logged only once, it's hash is added to this map
 	bool m_renderToScreen;									// If log entries should be rendered to the screen
+	CRITICAL_SECTION m_lock;								// Entries can be written from worker threads while the main thread displays them
 };
 
 #endif // _CORE_SYSTEM_LOG_
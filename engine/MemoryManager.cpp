@@ -0,0 +1,91 @@
+#include <stdio.h>
+
+#include "MemoryManager.h"
+
+template<> MemoryManager * Singleton<MemoryManager>::s_instance = NULL;
+
+const size_t MemoryManager::s_arenaPageSizeBytes[eArenaCount] = 
+{
+	64 * 1024,		// Render batches are large so get their own pages
+	256 * 1024,		// Models
+	64 * 1024,		// Game files
+	16 * 1024,		// File lists
+	64 * 1024,		// Log
+	16 * 1024,		// Input
+	16 * 1024,		// Strings
+	64 * 1024		// World, scenes are bigger than a page so get one each
+};
+
+const unsigned int MemoryManager::s_arenaMaxPages[eArenaCount] = 
+{
+	64,				// Render
+	1024,			// Models
+	1024,			// Game files
+	64,				// File lists
+	64,				// Log
+	16,				// Input
+	256,			// Strings
+	256				// World
+};
+
+const char * MemoryManager::s_arenaNames[eArenaCount] = 
+{
+	"Render",
+	"Model",
+	"GameFile",
+	"File",
+	"Log",
+	"Input",
+	"String",
+	"World"
+};
+
+const unsigned int MemoryManager::s_compactPagesPerFrame = 4;
+
+MemoryManager::MemoryManager()
+{
+	// Can't log here as the log allocates from the manager being constructed, 
+	// failed arenas will fail every allocation and the caller reports it
+	for (unsigned int i = 0; i < eArenaCount; ++i)
+	{
+		m_arenas[i].Init(s_arenaPageSizeBytes[i], s_arenaMaxPages[i]);
+		InitializeCriticalSection(&m_arenaLocks[i]);
+	}
+}
+
+MemoryManager::~MemoryManager()
+{
+	Shutdown();
+	for (unsigned int i = 0; i < eArenaCount; ++i)
+	{
+		DeleteCriticalSection(&m_arenaLocks[i]);
+	}
+}
+
+bool MemoryManager::Shutdown()
+{
+	// Anything left allocated at this point is a leak
+	bool noLeaks = true;
+	for (unsigned int i = 0; i < eArenaCount; ++i)
+	{
+		if (unsigned int numAllocations = m_arenas[i].GetNumAllocations())
+		{
+			printf("MemoryManager: %u allocations totalling %u bytes leaked from the %s arena.\n", numAllocations, (unsigned int)m_arenas[i].GetLiveBytes(), s_arenaNames[i]);
+			noLeaks = false;
+		}
+		m_arenas[i].Done();
+	}
+
+	return noLeaks;
+}
+
+void MemoryManager::Update(float a_dt)
+{
+	// Spread defragmentation over many frames so the cost is never noticeable
+	for (unsigned int i = 0; i < eArenaCount; ++i)
+	{
+		LockArena((eMemoryArena)i);
+		m_arenas[i].Compact(s_compactPagesPerFrame);
+		UnlockArena((eMemoryArena)i);
+	}
+}
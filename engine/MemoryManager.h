@@ -0,0 +1,83 @@
+#ifndef _ENGINE_MEMORY_MANAGER_
+#define _ENGINE_MEMORY_MANAGER_
+#pragma once
+
+#include <windows.h>
+
+#include "../core/PageAllocator.h"
+
+#include "Singleton.h"
+
+//\brief MemoryManager owns a page allocator for each engine subsystem so allocations
+//		 of similar lifetime and size are kept together instead of scattered through the heap.
+//		 Arenas are setup on first use so systems that allocate before startup, like the log
+//		 and the config file, work as soon as they are constructed.
+class MemoryManager : public Singleton<MemoryManager>
+{
+public:
+
+	//\brief Each subsystem allocates from it's own arena
+	enum eMemoryArena
+	{
+		eArenaRender = 0,		///< Render batches and primitives
+		eArenaModel,			///< Mesh data for loaded models
+		eArenaGameFile,			///< Objects, properties and values of parsed game files
+		eArenaFile,				///< File lists and file events
+		eArenaLog,				///< Log lines displayed on screen
+		eArenaInput,			///< Registered input events
+		eArenaString,			///< Interned text of string hashes
+		eArenaWorld,			///< Scenes, scene loads, the files read while streaming them in and template prototypes
+
+		eArenaCount,
+	};
+
+	//\brief Arenas are initialised on construction, no pages are allocated until they are used
+	MemoryManager();
+	~MemoryManager();
+
+	//\brief Report anything still allocated in each arena and release all pages
+	//\return true if there were no outstanding allocations
+	bool Shutdown();
+
+	//\brief Update runs a slice of compaction on each arena every frame
+	//\param a_dt float of the time that has passed since the last update call
+	void Update(float a_dt);
+
+	//\brief Allocate memory that never moves from a subsystem's arena
+	//\return a pointer to zeroed memory or NULL if the arena is out of pages
+	inline void * Allocate(eMemoryArena a_arena, size_t a_sizeBytes) { LockArena(a_arena); void * mem = m_arenas[a_arena].Allocate(a_sizeBytes); UnlockArena(a_arena); return mem; }
+	inline bool Free(eMemoryArena a_arena, void * a_ptr) { LockArena(a_arena); const bool freed = m_arenas[a_arena].Free(a_ptr); UnlockArena(a_arena); return freed; }
+
+	//\brief Allocate memory that compaction can move, only keep the handle and resolve it with GetMovable when needed
+	inline PageAllocator::Handle AllocateMovable(eMemoryArena a_arena, size_t a_sizeBytes) { LockArena(a_arena); const PageAllocator::Handle handle = m_arenas[a_arena].AllocateMovable(a_sizeBytes); UnlockArena(a_arena); return handle; }
+	inline void * GetMovable(eMemoryArena a_arena, PageAllocator::Handle a_handle) { LockArena(a_arena); void * mem = m_arenas[a_arena].Get(a_handle); UnlockArena(a_arena); return mem; }
+	inline bool Free(eMemoryArena a_arena, PageAllocator::Handle a_handle) { LockArena(a_arena); const bool freed = m_arenas[a_arena].Free(a_handle); UnlockArena(a_arena); return freed; }
+
+	//\brief Construct and destruct objects in a subsystem's arena as a replacement for new and delete
+	template <typename T>
+	inline T * New(eMemoryArena a_arena) { LockArena(a_arena); T * object = m_arenas[a_arena].New<T>(); UnlockArena(a_arena); return object; }
+	template <typename T>
+	inline void Delete(eMemoryArena a_arena, T * a_object) { LockArena(a_arena); m_arenas[a_arena].Delete(a_object); UnlockArena(a_arena); }
+
+	//\brief Arenas can be used from any thread. Compaction only runs on the main thread in Update so pointers to movable
+	//		 memory resolved on the main thread stay valid until the next update, other threads have to hold the arena's
+	//		 lock from resolving a handle until they are done with the pointer.
+	inline void LockArena(eMemoryArena a_arena) { EnterCriticalSection(&m_arenaLocks[a_arena]); }
+	inline void UnlockArena(eMemoryArena a_arena) { LeaveCriticalSection(&m_arenaLocks[a_arena]); }
+
+	//\brief Access to an arena for reporting usage
+	inline const PageAllocator & GetArena(eMemoryArena a_arena) const { return m_arenas[a_arena]; }
+	static const char * GetArenaName(eMemoryArena a_arena) { return s_arenaNames[a_arena]; }
+
+private:
+
+	static const size_t s_arenaPageSizeBytes[eArenaCount];	///< How big each page is for each arena
+	static const unsigned int s_arenaMaxPages[eArenaCount];	///< How many pages each arena can have at once
+	static const char * s_arenaNames[eArenaCount];			///< For reporting
+	static const unsigned int s_compactPagesPerFrame;		///< How many pages of each arena are checked for compaction each update
+
+	PageAllocator m_arenas[eArenaCount];					///< One allocator per subsystem
+	CRITICAL_SECTION m_arenaLocks[eArenaCount];				///< Held while an arena is allocating, freeing or compacting
+};
+
+#endif // _ENGINE_MEMORY_MANAGER_
@@ -183,13 +183,19 @@ bool Model::Load(const char *a_modelFilePath, LinearAllocator<Vector> & a_vertPo
 			}
 		}
 
-		// Now we know the size of the mesh, allocate memory for verts
-		// TODO Use a resizable memory structure for mesh data
-		m_verts = (Vector *)malloc(sizeof(Vector) * m_numFaces * s_vertsPerTri);
-		m_normals = (Vector *)malloc(sizeof(Vector) * m_numFaces * s_vertsPerTri);
-		m_uvs = (TexCoord *)malloc(sizeof(TexCoord) * m_numFaces * s_vertsPerTri);
-		if (m_verts != NULL && m_normals != NULL && m_uvs != NULL)
+		// Now we know the size of the mesh, allocate movable memory for verts from the model arena
+		MemoryManager & memMan = MemoryManager::Get();
+		m_verts = memMan.AllocateMovable(MemoryManager::eArenaModel, sizeof(Vector) * m_numFaces * s_vertsPerTri);
+		m_normals = memMan.AllocateMovable(MemoryManager::eArenaModel, sizeof(Vector) * m_numFaces * s_vertsPerTri);
+		m_uvs = memMan.AllocateMovable(MemoryManager::eArenaModel, sizeof(TexCoord) * m_numFaces * s_vertsPerTri);
+		if (m_verts != PageAllocator::s_invalidHandle && m_normals != PageAllocator::s_invalidHandle && m_uvs != PageAllocator::s_invalidHandle)
 		{
+			// Resolve the handles once, the arena is locked so compaction can't move them while loading on another thread
+			memMan.LockArena(MemoryManager::eArenaModel);
+			Vector * modelVerts = GetVertices();
+			Vector * modelNormals = GetNormals();
+			TexCoord * modelUvs = GetUvs();
+
 			// Create an alias to the loading memory pools so the data can be accessed randomly
 			Vector * verts = a_vertPool.GetHead();
 			Vector * normals = a_normalPool.GetHead();
@@ -203,19 +209,19 @@ bool Model::Load(const char *a_modelFilePath, LinearAllocator<Vector> & a_vertPo
 			for (unsigned int i = 0; i < m_numFaces; ++i)
 			{                
 				// Set the face data up
-				m_verts[vertCount]		= verts[vertIndices[0]];
-				m_normals[vertCount]	= normals[normIndices[0]];
-				m_uvs[vertCount]		= uvs[uvIndices[0]];
+				modelVerts[vertCount]	= verts[vertIndices[0]];
+				modelNormals[vertCount]	= normals[normIndices[0]];
+				modelUvs[vertCount]		= uvs[uvIndices[0]];
 				vertCount++;
 
-				m_verts[vertCount]		= verts[vertIndices[1]];
-				m_normals[vertCount]	= normals[normIndices[1]];
-				m_uvs[vertCount]		= uvs[uvIndices[1]];
+				modelVerts[vertCount]	= verts[vertIndices[1]];
+				modelNormals[vertCount]	= normals[normIndices[1]];
+				modelUvs[vertCount]		= uvs[uvIndices[1]];
 				vertCount++;
 
-				m_verts[vertCount]		= verts[vertIndices[2]];
-				m_normals[vertCount]	= normals[normIndices[2]];
-				m_uvs[vertCount]		= uvs[uvIndices[2]];
+				modelVerts[vertCount]	= verts[vertIndices[2]];
+				modelNormals[vertCount]	= normals[normIndices[2]];
+				modelUvs[vertCount]		= uvs[uvIndices[2]];
 
 				// Advance to the next face
 				vertIndices += 3;
@@ -223,6 +229,7 @@ bool Model::Load(const char *a_modelFilePath, LinearAllocator<Vector> & a_vertPo
 				normIndices += 3;
 				vertCount++;
 			}
+			memMan.UnlockArena(MemoryManager::eArenaModel);
 		}
 		else
 		{
@@ -311,10 +318,14 @@ bool Model::LoadMaterial(const char * a_materialFileName, const char * a_materia
 
 bool Model::Unload()
 {
-	// Deallocate memory here
-	free(m_verts);
-	free(m_normals);
-	free(m_uvs);
+	// Return mesh data to the model arena
+	MemoryManager & memMan = MemoryManager::Get();
+	memMan.Free(MemoryManager::eArenaModel, m_verts);
+	memMan.Free(MemoryManager::eArenaModel, m_normals);
+	memMan.Free(MemoryManager::eArenaModel, m_uvs);
+	m_verts = PageAllocator::s_invalidHandle;
+	m_normals = PageAllocator::s_invalidHandle;
+	m_uvs = PageAllocator::s_invalidHandle;
 
 	m_loaded = false;
 	return true;
@@ -4,6 +4,8 @@
 #include "../core/LinearAllocator.h"
 #include "../core/Vector.h"
 
+#include "MemoryManager.h"
+
 class TexCoord;
 class Texture;
 
@@ -19,6 +21,9 @@ public:
 		, m_diffuseTex(NULL)
 		, m_normalTex(NULL)
 		, m_specularTex(NULL)
+		, m_verts(PageAllocator::s_invalidHandle)
+		, m_normals(PageAllocator::s_invalidHandle)
+		, m_uvs(PageAllocator::s_invalidHandle)
 		, m_numFaces(0) 
 		, m_displayListId(0) {}
 
@@ -34,12 +39,12 @@ public:
 	bool Unload();
 	inline bool IsLoaded() { return m_loaded; }
 
-	//\brief Accessors for the model's data
+	//\brief Accessors for the model's data, mesh data can be moved by compaction so don't hold onto the pointers
 	inline unsigned int GetNumFaces() const { return m_numFaces; }
 	inline unsigned int GetNumVertices() const { return m_numFaces * s_vertsPerTri; }
-	inline Vector * GetVertices() const { return m_verts; }
-	inline Vector * GetNormals() const { return m_normals; }
-	inline TexCoord * GetUvs() const { return m_uvs; }
+	inline Vector * GetVertices() const { return (Vector *)MemoryManager::Get().GetMovable(MemoryManager::eArenaModel, m_verts); }
+	inline Vector * GetNormals() const { return (Vector *)MemoryManager::Get().GetMovable(MemoryManager::eArenaModel, m_normals); }
+	inline TexCoord * GetUvs() const { return (TexCoord *)MemoryManager::Get().GetMovable(MemoryManager::eArenaModel, m_uvs); }
 
 	//\brief Accessors for rendering buffer Ids
 	inline bool IsDisplayListGenerated() const { return m_displayListGenerated; }
@@ -66,9 +71,9 @@ private:
 	Texture * m_normalTex;					///< For drawing normal depth mapping
 	Texture * m_specularTex;				///< The shininess map
 
-	Vector * m_verts;						///< Storage for the verts of the model
-	Vector * m_normals;						///< Storage for the normals
-	TexCoord * m_uvs;						///< Storage for the tex coords
+	PageAllocator::Handle m_verts;			///< Handle to storage for the verts of the model
+	PageAllocator::Handle m_normals;		///< Handle to storage for the normals
+	PageAllocator::Handle m_uvs;			///< Handle to storage for the tex coords
 	unsigned int m_numFaces;				///< All indexed by face
 
 	unsigned int m_displayListId;			///< Assigned by the render manager when added for rendering
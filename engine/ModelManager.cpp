@@ -16,6 +16,15 @@ ModelManager::ModelManager(float a_updateFreq)
 	: m_updateFreq(a_updateFreq)
 	, m_updateTimer(0.0f)
 {
+	InitializeCriticalSection(&m_mapLock);
+	InitializeCriticalSection(&m_loadLock);
+}
+
+ModelManager::~ModelManager()
+{
+	Shutdown();
+	DeleteCriticalSection(&m_loadLock);
+	DeleteCriticalSection(&m_mapLock);
 }
 
 bool ModelManager::Startup(const char * a_modelPath)
@@ -61,10 +70,13 @@ bool ModelManager::Update(float a_dt)
 		m_updateTimer = 0.0f;
 		bool modelReloaded = false;
 
+		// Models can't be reloaded while another thread is using the loading pools
+		EnterCriticalSection(&m_loadLock);
+
 		// Each model in the pool gets tested
-		ManagedModel * curModel = NULL;
-		while ( m_modelMap.GetNext(curModel) && curModel != NULL)
+		for (modelMap::Iterator curModelIt = m_modelMap.Begin(); curModelIt != m_modelMap.End(); ++curModelIt)
 		{
+			ManagedModel * curModel = curModelIt.GetValue();
 			FileManager::Timestamp curTimestamp;
 			if (FileManager::Get().GetFileTimeStamp(curModel->m_path, curTimestamp))
 			{
@@ -81,6 +93,7 @@ bool ModelManager::Update(float a_dt)
 				}
 			}
 		}
+		LeaveCriticalSection(&m_loadLock);
 		
 		return modelReloaded;
 	}
@@ -100,45 +113,64 @@ Model * ModelManager::GetModel(const char * a_modelPath)
 	}
 	
 	// Get the identifier for the new model
-	StringHash modelHash(fileNameBuf);
-	unsigned int modelId = modelHash.GetHash();
+	unsigned int modelId = StringHash::GenerateCRC(fileNameBuf, false);
+
+	// If it already exists just return the cached copy
+	ManagedModel * foundModel = NULL;
+	EnterCriticalSection(&m_mapLock);
+	m_modelMap.Get(modelId, foundModel);
+	LeaveCriticalSection(&m_mapLock);
+	if (foundModel != NULL)
+	{
+		return &foundModel->m_model;
+	}
 
-	// If it already exists
-	if (IsModelLoaded(modelId))
+	// Only one model loads at a time, another thread may have loaded this one while waiting
+	EnterCriticalSection(&m_loadLock);
+	EnterCriticalSection(&m_mapLock);
+	m_modelMap.Get(modelId, foundModel);
+	ManagedModel * newModel = foundModel == NULL ? m_modelPool.Allocate(sizeof(ManagedModel)) : NULL;
+	LeaveCriticalSection(&m_mapLock);
+	if (foundModel != NULL)
 	{
-		// Just returned the cached copy
-		ManagedModel * foundModel = NULL;
-		m_modelMap.Get(modelId, foundModel);
+		LeaveCriticalSection(&m_loadLock);
 		return &foundModel->m_model;
 	}
-	else if (ManagedModel * newModel = m_modelPool.Allocate(sizeof(ManagedModel)))
+	else if (newModel != NULL)
 	{
-		// Insert the newly allocated model
+		// Models are only added to the map once fully loaded so other threads never see one half done
+		Model * loadedModel = NULL;
 		if (newModel->m_model.Load(fileNameBuf, m_loadingVertPool, m_loadingNormalPool, m_loadingUvPool))
 		{
 			FileManager::Get().GetFileTimeStamp(fileNameBuf, newModel->m_timeStamp);
 			sprintf(newModel->m_path, "%s", fileNameBuf);
+			EnterCriticalSection(&m_mapLock);
 			m_modelMap.Insert(modelId, newModel);
-
-			// Reset the temporary loading pools ready for the next load
-			m_loadingVertPool.Reset();
-			m_loadingNormalPool.Reset();
-			m_loadingUvPool.Reset();
+			LeaveCriticalSection(&m_mapLock);
 
 			// Return the pointer to the actual model
-			return &newModel->m_model;
+			loadedModel = &newModel->m_model;
 		}
 		else
 		{
 			//delete newModel;
+			EnterCriticalSection(&m_mapLock);
 			m_modelPool.DeAllocate(sizeof(ManagedModel));
+			LeaveCriticalSection(&m_mapLock);
 			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Model load failed for %s", fileNameBuf);
-			return NULL;
 		}
+
+		// Reset the temporary loading pools ready for the next load
+		m_loadingVertPool.Reset();
+		m_loadingNormalPool.Reset();
+		m_loadingUvPool.Reset();
+		LeaveCriticalSection(&m_loadLock);
+		return loadedModel;
 	}
 	else // Report the error
 	{
-		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Model allocation failed for %s, fileNameBuf");
+		LeaveCriticalSection(&m_loadLock);
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Model allocation failed for %s", fileNameBuf);
 		return NULL;
 	}
    return NULL;
@@ -148,10 +180,8 @@ bool ModelManager::IsModelLoaded(unsigned int a_modelPathHash)
 {
 	// Look through map for the target model
 	ManagedModel * foundModel = NULL;
-	if (m_modelMap.Get(a_modelPathHash, foundModel))
-	{
-		return true;
-	}
-	
-	return false;
+	EnterCriticalSection(&m_mapLock);
+	const bool modelLoaded = m_modelMap.Get(a_modelPathHash, foundModel);
+	LeaveCriticalSection(&m_mapLock);
+	return modelLoaded;
 }
\ No newline at end of file
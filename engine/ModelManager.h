@@ -1,6 +1,8 @@
 #ifndef _ENGINE_MODEL_MANAGER_H_
 #define _ENGINE_MODEL_MANAGER_H_
 
+#include <windows.h>
+
 #include "../core/HashMap.h"
 #include "../core/LinearAllocator.h"
 
@@ -19,7 +21,7 @@ public:
 	
 	//\brief Ctor calls through to startup
 	ModelManager(float a_updateFreq = s_updateFreq);
-	~ModelManager() { Shutdown(); }
+	~ModelManager();
 
 	//brief Initialise memory pools on startup, cleanup models on shutdown
 	bool Startup(const char * a_modelPath);
@@ -29,7 +31,7 @@ public:
 	//\return true if a model was old and needed to be reloaded
 	bool Update(float a_dt);
 
-	//\brief Get or load a TGA file into model memory
+	//\brief Get or load a TGA file into model memory, safe to call from any thread though only one model is parsed at a time
 	//\param a_tgaPath cstring to identify the model by
 	//\return model ID of the identified model
 	Model * GetModel(const char *a_modelPath);
@@ -38,13 +40,13 @@ public:
 	//\param a_tgaPathHash is the identified for the model
 	//\return -1 the category that the model is loaded into, none if not loaded
 	bool IsModelLoaded(unsigned int a_tgaPathHash);
-	inline bool IsModelLoaded(const char *a_tgaPath) { return IsModelLoaded(StringHash(a_tgaPath).GetHash()); }
+	inline bool IsModelLoaded(const char *a_tgaPath) { return IsModelLoaded(StringHash::GenerateCRC(a_tgaPath, false)); }
 
 	//\brief Reload a single model without changing the IDs
 	//\param a_cat the category the model is found in. If not supplied, an exhaustive search is performed
 	//\return true in the model was found and reloaded successfully
 	bool ReloadModel(unsigned int a_modelPathHash);
-	inline bool Reloadmodel(const char *a_modelPath) { return ReloadModel(StringHash(a_modelPath).GetHash()); }
+	inline bool Reloadmodel(const char *a_modelPath) { return ReloadModel(StringHash::GenerateCRC(a_modelPath, false)); }
 
 	//\brief Wholesale reload of models
 	bool ReloadAllModels();
@@ -85,6 +87,8 @@ private:
 	char m_modelPath[StringUtils::s_maxCharsPerLine];			///< Cache off model path 
 	float m_updateFreq;											///< How often the model manager should check for changes
 	float m_updateTimer;										///< If we are due for a scan and update of models
+	CRITICAL_SECTION m_mapLock;									///< Held while the model map or pool is read or changed
+	CRITICAL_SECTION m_loadLock;								///< Held for the whole of a model load as the loading pools are shared
 };
 
 #endif /* _ENGINE_MODEL_MANAGER_H_ */
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include "DebugMenu.h"
 #include "Log.h"
+#include "MemoryManager.h"
 #include "Texture.h"
 
 #include "RenderManager.h"
@@ -51,32 +52,33 @@ bool RenderManager::Startup(Colour a_clearColour)
 	glHint(GL_POINT_SMOOTH_HINT,GL_NICEST);
 	glEnable(GL_COLOR_MATERIAL);
 
-	// Storage for all the primitives
+	// Storage for all the primitives comes from the render arena
+	MemoryManager & memMan = MemoryManager::Get();
 	bool batchAlloc = true;
 	for (unsigned int i = 0; i < eBatchCount; ++i)
 	{
 		// Tris
-		m_tris[i] = (Tri *)malloc(sizeof(Tri) * s_maxPrimitivesPerBatch);
+		m_tris[i] = (Tri *)memMan.Allocate(MemoryManager::eArenaRender, sizeof(Tri) * s_maxPrimitivesPerBatch);
 		batchAlloc &= m_tris[i] != NULL;
 		m_triCount[i] = 0;
 
 		// Quads
-		m_quads[i] = (Quad *)malloc(sizeof(Quad) * s_maxPrimitivesPerBatch);
+		m_quads[i] = (Quad *)memMan.Allocate(MemoryManager::eArenaRender, sizeof(Quad) * s_maxPrimitivesPerBatch);
 		batchAlloc &= m_quads[i] != NULL;
 		m_quadCount[i] = 0;
 
 		// Lines
-		m_lines[i] = (Line *)malloc(sizeof(Line) * s_maxPrimitivesPerBatch);
+		m_lines[i] = (Line *)memMan.Allocate(MemoryManager::eArenaRender, sizeof(Line) * s_maxPrimitivesPerBatch);
 		batchAlloc &= m_lines[i] != NULL;
 		m_lineCount[i] = 0;
 
 		// Render models
-		m_models[i] = (RenderModel *)malloc(sizeof(RenderModel) * s_maxPrimitivesPerBatch);
+		m_models[i] = (RenderModel *)memMan.Allocate(MemoryManager::eArenaRender, sizeof(RenderModel) * s_maxPrimitivesPerBatch);
 		batchAlloc &= m_models[i] != NULL;
 		m_modelCount[i] = 0;
 
 		// Font characters
-		m_fontChars[i] = (FontChar *)malloc(sizeof(FontChar) * s_maxPrimitivesPerBatch);
+		m_fontChars[i] = (FontChar *)memMan.Allocate(MemoryManager::eArenaRender, sizeof(FontChar) * s_maxPrimitivesPerBatch);
 		batchAlloc &= m_fontChars[i] != NULL;
 		m_fontCharCount[i] = 0;
 	}
@@ -93,13 +95,19 @@ bool RenderManager::Startup(Colour a_clearColour)
 bool RenderManager::Shutdown()
 {
 	// Clean up storage for all primitives
+	MemoryManager & memMan = MemoryManager::Get();
 	for (unsigned int i = 0; i < eBatchCount; ++i)
 	{
-		free(m_tris[i]);
-		free(m_quads[i]);
-		free(m_lines[i]);
-		free(m_models[i]);
-		free(m_fontChars[i]);
+		memMan.Free(MemoryManager::eArenaRender, m_tris[i]);
+		memMan.Free(MemoryManager::eArenaRender, m_quads[i]);
+		memMan.Free(MemoryManager::eArenaRender, m_lines[i]);
+		memMan.Free(MemoryManager::eArenaRender, m_models[i]);
+		memMan.Free(MemoryManager::eArenaRender, m_fontChars[i]);
+		m_tris[i] = NULL;
+		m_quads[i] = NULL;
+		m_lines[i] = NULL;
+		m_models[i] = NULL;
+		m_fontChars[i] = NULL;
 		m_triCount[i] = 0;
 		m_quadCount[i] = 0;
 		m_lineCount[i] = 0;
@@ -151,6 +159,12 @@ bool RenderManager::Resize(unsigned int a_viewWidth, unsigned int a_viewHeight,
     return true;
 }
 
+void RenderManager::GetViewFrustum(const Matrix & a_viewMatrix, Frustum & a_frustum_OUT)
+{
+	const Matrix projection = Matrix::GetPerspective(MathUtils::Deg2Rad(s_fovAngleY), m_aspect, s_nearClipPlane, s_farClipPlane);
+	a_frustum_OUT.Set(a_viewMatrix.Multiply(projection));
+}
+
 void RenderManager::DrawScene(Matrix & a_viewMatrix)
 {
 	// Handle different rendering modes
@@ -575,6 +589,13 @@ void RenderManager::AddModel(eBatch a_batch, Model * a_model, Matrix * a_mat)
 		return;
 	}
 
+	// The display list bakes in the texture id so a model streamed in waits for it's texture upload before drawing
+	Texture * modelTex = a_model->GetDiffuseTexture();
+	if (modelTex != NULL && !modelTex->IsLoaded())
+	{
+		return;
+	}
+
 	// If we have not generated buffers for this model
 	if (!a_model->IsDisplayListGenerated())
 	{
@@ -7,6 +7,7 @@
 #include "Texture.h"
 
 #include "../core/Colour.h"
+#include "../core/Frustum.h"
 #include "../core/Matrix.h"
 #include "../core/Vector.h"
 
@@ -66,6 +67,11 @@ public:
 	inline unsigned int GetViewDepth() { return m_bpp; }
 	inline float GetViewAspect() { return m_aspect; }
 
+	//\brief Work out what the world batch can see using the same projection it is drawn with
+	//\param a_viewMatrix the matrix that will be passed to DrawScene, usually the camera matrix
+	//\param a_frustum_OUT is set to the planes bounding the view
+	void GetViewFrustum(const Matrix & a_viewMatrix, Frustum & a_frustum_OUT);
+
 	//\brief Set up a display list for a font character so drawing only involves calling a list
 	//\param a_size is an arbitrary width to height to generate the list at
 	//\param a_texCoord is the starting coordinate to draw
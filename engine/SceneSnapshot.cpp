@@ -0,0 +1,300 @@
+#include <string.h>
+
+#include "Log.h"
+
+#include "SceneSnapshot.h"
+
+const unsigned int SceneSnapshot::s_magic = 0x50414e53;	// SNAP
+const unsigned int SceneSnapshot::s_version = 1;
+const unsigned int SceneSnapshot::s_maxGapWords = 2;
+const unsigned int SceneSnapshot::s_skipBlockWords = 16;
+
+bool SceneSnapshot::Begin(unsigned int a_numObjects)
+{
+	const unsigned int recordsSize = sizeof(Header) + sizeof(Object) * a_numObjects;
+	if (!Reserve(recordsSize))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory for a snapshot of %u objects.", a_numObjects);
+		return false;
+	}
+
+	Header * header = GetHeader();
+	header->m_magic = s_magic;
+	header->m_version = s_version;
+	header->m_size = recordsSize;
+	header->m_flags = 0;
+	header->m_numObjects = a_numObjects;
+	header->m_stateSize = 0;
+	header->m_baseNumObjects = 0;
+	header->m_baseStateSize = 0;
+	m_numAdded = 0;
+	return true;
+}
+
+void SceneSnapshot::AddObject(unsigned int a_id, unsigned int a_stateSize)
+{
+	Header * header = GetHeader();
+	if (m_numAdded < header->m_numObjects)
+	{
+		Object & record = GetObjects()[m_numAdded++];
+		record.m_id = a_id;
+		record.m_offset = header->m_stateSize;
+		record.m_size = a_stateSize;
+
+		// Every object starts on a word so deltas compare whole words of the same object
+		header->m_stateSize += (a_stateSize + sizeof(unsigned int) - 1) & ~(sizeof(unsigned int) - 1);
+	}
+}
+
+bool SceneSnapshot::AllocateState()
+{
+	if (m_numAdded != GetHeader()->m_numObjects)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot allocate snapshot state, only %u of %u objects have been added.", m_numAdded, GetHeader()->m_numObjects);
+		return false;
+	}
+
+	const unsigned int size = GetHeader()->m_size + GetHeader()->m_stateSize;
+	if (!Reserve(size))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate %u bytes for a snapshot of %u objects.", size, m_numAdded);
+		return false;
+	}
+	GetHeader()->m_size = size;
+
+	// Padding after an object's state is cleared so it never shows up as a change in a delta
+	unsigned char * state = GetState();
+	const Object * objects = GetObjects();
+	for (unsigned int i = 0; i < m_numAdded; ++i)
+	{
+		const unsigned int paddedSize = (objects[i].m_size + sizeof(unsigned int) - 1) & ~(sizeof(unsigned int) - 1);
+		memset(state + objects[i].m_offset + objects[i].m_size, 0, paddedSize - objects[i].m_size);
+	}
+	return true;
+}
+
+bool SceneSnapshot::EncodeDelta(const SceneSnapshot & a_base, SceneSnapshot & a_delta_OUT) const
+{
+	if (!IsValid() || IsDelta() || !a_base.IsValid() || a_base.IsDelta() || &a_delta_OUT == this || &a_delta_OUT == &a_base)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot encode a snapshot delta, both snapshots must be full and the delta a different snapshot.");
+		return false;
+	}
+
+	// Objects are mostly the same from one snapshot to the next so their records are only stored when they differ
+	const Header * header = GetHeader();
+	const Header * baseHeader = a_base.GetHeader();
+	const bool sameObjects =	header->m_numObjects == baseHeader->m_numObjects &&
+								memcmp(GetObjects(), a_base.GetObjects(), sizeof(Object) * header->m_numObjects) == 0;
+	const unsigned int recordsSize = sameObjects ? 0 : sizeof(Object) * header->m_numObjects;
+
+	// At worst every change is a gap too long to join away from the last and each run has two words on top of it's state
+	const unsigned int numWords = header->m_stateSize / sizeof(unsigned int);
+	const unsigned int maxRuns = numWords / (s_maxGapWords + 2) + 1;
+	if (!a_delta_OUT.Reserve(sizeof(Header) + recordsSize + (numWords + maxRuns * 2) * sizeof(unsigned int)))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory for a snapshot delta of %u objects.", header->m_numObjects);
+		return false;
+	}
+
+	Header * deltaHeader = a_delta_OUT.GetHeader();
+	*deltaHeader = *header;
+	deltaHeader->m_flags = eFlagDelta | (sameObjects ? eFlagSameObjects : 0);
+	deltaHeader->m_baseNumObjects = baseHeader->m_numObjects;
+	deltaHeader->m_baseStateSize = baseHeader->m_stateSize;
+	unsigned char * deltaData = (unsigned char *)(deltaHeader + 1);
+	memcpy(deltaData, GetObjects(), recordsSize);
+
+	// Runs are the number of unchanged words to skip, the number of changed words and then the changed words.
+	// State past the end of the base is compared against zero.
+	const unsigned int * state = (const unsigned int *)GetState();
+	const unsigned int * baseState = (const unsigned int *)a_base.GetState();
+	const unsigned int numBaseWords = baseHeader->m_stateSize / sizeof(unsigned int);
+	unsigned int * runs = (unsigned int *)(deltaData + recordsSize);
+	unsigned int * curRun = runs;
+	unsigned int lastRunEnd = 0;
+	unsigned int curWord = 0;
+	const unsigned int numCommonWords = numWords < numBaseWords ? numWords : numBaseWords;
+	while (curWord < numWords)
+	{
+		// Most of the state is unchanged from step to step so it is skipped a block at a time
+		while (curWord + s_skipBlockWords <= numCommonWords && memcmp(state + curWord, baseState + curWord, s_skipBlockWords * sizeof(unsigned int)) == 0)
+		{
+			curWord += s_skipBlockWords;
+		}
+		if (curWord >= numWords)
+		{
+			break;
+		}
+		if (state[curWord] == (curWord < numBaseWords ? baseState[curWord] : 0))
+		{
+			++curWord;
+			continue;
+		}
+
+		// Carry the run on through short gaps of unchanged words, it's cheaper than the header for a new run
+		const unsigned int runStart = curWord;
+		unsigned int runLast = curWord;
+		for (++curWord; curWord < numWords && curWord - runLast <= s_maxGapWords + 1; ++curWord)
+		{
+			if (state[curWord] != (curWord < numBaseWords ? baseState[curWord] : 0))
+			{
+				runLast = curWord;
+			}
+		}
+
+		const unsigned int runLength = runLast + 1 - runStart;
+		*curRun++ = runStart - lastRunEnd;
+		*curRun++ = runLength;
+		memcpy(curRun, state + runStart, runLength * sizeof(unsigned int));
+		curRun += runLength;
+		lastRunEnd = runLast + 1;
+	}
+
+	deltaHeader->m_size = (unsigned int)((unsigned char *)curRun - a_delta_OUT.m_data);
+	return true;
+}
+
+bool SceneSnapshot::DecodeDelta(const SceneSnapshot & a_base, const SceneSnapshot & a_delta)
+{
+	if (!a_base.IsValid() || a_base.IsDelta() || !a_delta.IsValid() || !a_delta.IsDelta() || &a_base == this || &a_delta == this)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot decode a snapshot delta, it needs a full base snapshot and a delta that are both different to the result.");
+		return false;
+	}
+
+	const Header * deltaHeader = a_delta.GetHeader();
+	const Header * baseHeader = a_base.GetHeader();
+	if (deltaHeader->m_baseNumObjects != baseHeader->m_numObjects || deltaHeader->m_baseStateSize != baseHeader->m_stateSize)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot decode a snapshot delta against a base it was not encoded from.");
+		return false;
+	}
+
+	const unsigned int recordsSize = sizeof(Object) * deltaHeader->m_numObjects;
+	const bool sameObjects = (deltaHeader->m_flags & eFlagSameObjects) != 0;
+	if (!sameObjects && deltaHeader->m_size - sizeof(Header) < recordsSize)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Snapshot delta is corrupt, it is too small for the objects in it.");
+		return false;
+	}
+
+	const unsigned int size = sizeof(Header) + recordsSize + deltaHeader->m_stateSize;
+	if (!Reserve(size))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate %u bytes to decode a snapshot delta.", size);
+		return false;
+	}
+
+	Header * header = GetHeader();
+	*header = *deltaHeader;
+	header->m_size = size;
+	header->m_flags = 0;
+	header->m_baseNumObjects = 0;
+	header->m_baseStateSize = 0;
+	m_numAdded = header->m_numObjects;
+	const unsigned char * deltaData = (const unsigned char *)(deltaHeader + 1);
+	memcpy(GetObjects(), sameObjects ? (const unsigned char *)a_base.GetObjects() : deltaData, recordsSize);
+
+	// Start from the base and copy each run of changed words over it
+	unsigned int * state = (unsigned int *)GetState();
+	const unsigned int numWords = header->m_stateSize / sizeof(unsigned int);
+	const unsigned int numBaseWords = baseHeader->m_stateSize / sizeof(unsigned int);
+	const unsigned int numCopied = numWords < numBaseWords ? numWords : numBaseWords;
+	memcpy(state, a_base.GetState(), numCopied * sizeof(unsigned int));
+	memset(state + numCopied, 0, (numWords - numCopied) * sizeof(unsigned int));
+
+	const unsigned int * curRun = (const unsigned int *)(deltaData + (sameObjects ? 0 : recordsSize));
+	const unsigned int * runsEnd = (const unsigned int *)((const unsigned char *)a_delta.m_data + deltaHeader->m_size);
+	unsigned int curWord = 0;
+	while (curRun + 2 <= runsEnd)
+	{
+		curWord += curRun[0];
+		const unsigned int runLength = curRun[1];
+		curRun += 2;
+		if (curWord > numWords || runLength > numWords - curWord || runLength > (unsigned int)(runsEnd - curRun))
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Snapshot delta is corrupt, a run of changes is past the end of the state.");
+			return false;
+		}
+		memcpy(state + curWord, curRun, runLength * sizeof(unsigned int));
+		curWord += runLength;
+		curRun += runLength;
+	}
+
+	if (!HasValidObjects())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Snapshot delta is corrupt, an object's state is past the end of the state.");
+		return false;
+	}
+	return true;
+}
+
+bool SceneSnapshot::SetData(const void * a_data, unsigned int a_size)
+{
+	// Snapshots from older versions of the code are not an error, there's just nothing to restore
+	const Header * header = (const Header *)a_data;
+	if (a_data == NULL || a_size < sizeof(Header) || header->m_magic != s_magic || header->m_version != s_version || header->m_size != a_size)
+	{
+		return false;
+	}
+
+	// A full snapshot has to hold all the state it's records point to
+	if ((header->m_flags & eFlagDelta) == 0 &&
+		(header->m_numObjects > (a_size - sizeof(Header)) / sizeof(Object) ||
+		 sizeof(Header) + sizeof(Object) * header->m_numObjects + header->m_stateSize != a_size))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Snapshot is corrupt, the size does not match the objects in it.");
+		return false;
+	}
+
+	if (!Reserve(a_size))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate %u bytes for a snapshot.", a_size);
+		return false;
+	}
+	memcpy(m_data, a_data, a_size);
+	m_numAdded = header->m_numObjects;
+
+	if (!IsDelta() && !HasValidObjects())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Snapshot is corrupt, an object's state is past the end of the state.");
+		GetHeader()->m_magic = 0;
+		return false;
+	}
+	return true;
+}
+
+bool SceneSnapshot::HasValidObjects() const
+{
+	const unsigned int stateSize = GetHeader()->m_stateSize;
+	const Object * objects = GetObjects();
+	for (unsigned int i = 0; i < GetHeader()->m_numObjects; ++i)
+	{
+		if (objects[i].m_offset > stateSize || objects[i].m_size > stateSize - objects[i].m_offset)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SceneSnapshot::Reserve(unsigned int a_size)
+{
+	if (a_size <= m_capacity)
+	{
+		return true;
+	}
+
+	// Grow by half as much again so a growing world doesn't reallocate on every capture
+	const unsigned int newCapacity = a_size + a_size / 2;
+	unsigned char * newData = (unsigned char *)realloc(m_data, newCapacity);
+	if (newData == NULL)
+	{
+		return false;
+	}
+
+	m_data = newData;
+	m_capacity = newCapacity;
+	return true;
+}
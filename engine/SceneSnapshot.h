@@ -0,0 +1,131 @@
+#ifndef _ENGINE_SCENE_SNAPSHOT_
+#define _ENGINE_SCENE_SNAPSHOT_
+#pragma once
+
+#include <stdlib.h>
+
+//\brief A SceneSnapshot is a copy of everything an update can change for every object in a scene, packed
+//		 into one buffer so it is captured and restored with a copy per object and can be kept in memory or
+//		 written straight out to a file. A snapshot can be encoded as the changes since an earlier snapshot,
+//		 which is much smaller when little has changed, so a history for rewinding or replay stays cheap to keep.
+//		 The buffer looks like this, a delta leaves out the object records if they are the same as the base
+//		 and has runs of changed state in place of the state:
+//
+//		 Header | Object records | State
+//
+//		 Object ids are handles to the world's objects so a snapshot restores into the world it was captured from.
+class SceneSnapshot
+{
+public:
+
+	//\brief No memory is allocated until the first capture, the buffer is kept and reused after that
+	SceneSnapshot()
+		: m_data(NULL)
+		, m_capacity(0)
+		, m_numAdded(0) { }
+	~SceneSnapshot() { free(m_data); }
+
+	//\brief Capture a full snapshot by adding a record for each object, making room for their state and then having
+	//		 each object write it's state, Scene::SaveSnapshot does this
+	//\param a_numObjects how many objects will be added
+	//\return true if there was memory for the records
+	bool Begin(unsigned int a_numObjects);
+
+	//\brief Add the record for the next object
+	//\param a_id the unique id of the object
+	//\param a_stateSize how many bytes of state the object has
+	void AddObject(unsigned int a_id, unsigned int a_stateSize);
+
+	//\brief Make room for the state of every object added since Begin
+	//\return true if all the objects were added and there was memory for their state
+	bool AllocateState();
+
+	//\brief Encode the changes from an earlier full snapshot to this one
+	//\param a_base a full snapshot taken earlier, the delta can only be decoded against the same base
+	//\param a_delta_OUT is overwritten with the delta, reusing it's buffer
+	//\return true if both snapshots are full and there was memory for the delta
+	bool EncodeDelta(const SceneSnapshot & a_base, SceneSnapshot & a_delta_OUT) const;
+
+	//\brief Rebuild a full snapshot from a delta and the base it was encoded against, a history of deltas is
+	//		 decoded in order with each result being the base for the next delta
+	//\param a_base the full snapshot the delta was encoded against, can't be this snapshot
+	//\param a_delta a delta from EncodeDelta
+	//\return true if the delta was encoded against a base like this one and there was memory for the result
+	bool DecodeDelta(const SceneSnapshot & a_base, const SceneSnapshot & a_delta);
+
+	//\brief Copy a snapshot or delta from memory, such as one written to a file from GetData
+	//\param a_data, a_size the snapshot bytes
+	//\return true if the data is a snapshot from the same version of the code
+	bool SetData(const void * a_data, unsigned int a_size);
+
+	//\brief Accessors for the snapshot, the object accessors are only for full snapshots
+	inline bool IsValid() const { return m_data != NULL && GetHeader()->m_magic == s_magic; }
+	inline bool IsDelta() const { return (GetHeader()->m_flags & eFlagDelta) != 0; }
+	inline const void * GetData() const { return m_data; }
+	inline unsigned int GetDataSize() const { return m_data != NULL ? GetHeader()->m_size : 0; }
+	inline unsigned int GetNumObjects() const { return m_data != NULL ? GetHeader()->m_numObjects : 0; }
+	inline unsigned int GetObjectId(unsigned int a_index) const { return GetObjects()[a_index].m_id; }
+	inline unsigned int GetObjectStateSize(unsigned int a_index) const { return GetObjects()[a_index].m_size; }
+	inline const void * GetObjectState(unsigned int a_index) const { return GetState() + GetObjects()[a_index].m_offset; }
+	inline void * GetObjectState(unsigned int a_index) { return GetState() + GetObjects()[a_index].m_offset; }
+
+private:
+
+	static const unsigned int s_magic;			///< Identifies a snapshot
+	static const unsigned int s_version;		///< Bumped whenever the layout of the snapshot changes
+	static const unsigned int s_maxGapWords;	///< Unchanged words between two changes that are copied into one run rather than starting another
+	static const unsigned int s_skipBlockWords;	///< How many words are compared at once when looking for the next change
+
+	//\brief Kinds of snapshot stored as bits in the header
+	enum eFlags
+	{
+		eFlagDelta = 1,			///< State is runs of changes from a base snapshot
+		eFlagSameObjects = 2,	///< A delta with the same object records as it's base, they are not stored
+	};
+
+	//\brief The start of every snapshot
+	struct Header
+	{
+		unsigned int m_magic;			///< Always s_magic
+		unsigned int m_version;			///< The s_version the snapshot was taken with
+		unsigned int m_size;			///< Size of the whole snapshot in bytes
+		unsigned int m_flags;			///< Combination of eFlags
+		unsigned int m_numObjects;		///< How many objects were captured
+		unsigned int m_stateSize;		///< Bytes of state for all objects, once decoded for a delta
+		unsigned int m_baseNumObjects;	///< For a delta, how many objects the base it was encoded against has
+		unsigned int m_baseStateSize;	///< For a delta, how many bytes of state the base has
+	};
+
+	//\brief Where to find an object's state
+	struct Object
+	{
+		unsigned int m_id;				///< Unique id of the object
+		unsigned int m_offset;			///< Where the state starts from the start of the state, always word aligned
+		unsigned int m_size;			///< How many bytes of state the object has
+	};
+
+	//\brief Snapshots own their buffer so they are copied with SetData
+	SceneSnapshot(const SceneSnapshot & a_snapshot);
+	SceneSnapshot & operator = (const SceneSnapshot & a_snapshot);
+
+	//\brief Make sure the buffer can hold a number of bytes, keeping what is already in it
+	//\return true if there was memory
+	bool Reserve(unsigned int a_size);
+
+	//\brief Check every object record of a full snapshot points inside the state
+	bool HasValidObjects() const;
+
+	//\brief Get the parts of a full snapshot
+	inline Header * GetHeader() { return (Header *)m_data; }
+	inline const Header * GetHeader() const { return (const Header *)m_data; }
+	inline Object * GetObjects() { return (Object *)(GetHeader() + 1); }
+	inline const Object * GetObjects() const { return (const Object *)(GetHeader() + 1); }
+	inline unsigned char * GetState() { return (unsigned char *)(GetObjects() + GetHeader()->m_numObjects); }
+	inline const unsigned char * GetState() const { return (const unsigned char *)(GetObjects() + GetHeader()->m_numObjects); }
+
+	unsigned char * m_data;				///< The snapshot, starting with the header
+	unsigned int m_capacity;			///< How many bytes the buffer can hold
+	unsigned int m_numAdded;			///< How many objects have been added since Begin
+};
+
+#endif // _ENGINE_SCENE_SNAPSHOT_
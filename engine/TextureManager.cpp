@@ -1,5 +1,8 @@
+#include <new>
+
 #include "FileManager.h"
 #include "Log.h"
+#include "Time.h"
 
 #include "TextureManager.h"
 
@@ -19,7 +22,22 @@ const float TextureManager::s_updateFreq = 1.0f;
 TextureManager::TextureManager(float a_updateFreq)
 	: m_updateFreq(a_updateFreq)
 	, m_updateTimer(0.0f)
+	, m_mainThreadId(GetCurrentThreadId())
+	, m_pendingUploads(NULL)
+	, m_numPendingUploads(0)
+	, m_maxPendingUploads(0)
+{
+	InitializeCriticalSection(&m_lock);
+	for (unsigned int i = 0; i < eCategoryCount; ++i)
+	{
+		m_freeTextures[i] = NULL;
+	}
+}
+
+TextureManager::~TextureManager()
 {
+	Shutdown();
+	DeleteCriticalSection(&m_lock);
 }
 
 bool TextureManager::Startup(const char * a_texturePath, bool a_useLinearTextureFilter)
@@ -49,6 +67,9 @@ bool TextureManager::Startup(const char * a_texturePath, bool a_useLinearTexture
 	// Set filtering rule
 	m_filterMode = a_useLinearTextureFilter ? eTextureFilterLinear : eTextureFilterNearest;
 
+	// Textures requested from any other thread are uploaded later by this one
+	m_mainThreadId = GetCurrentThreadId();
+
 	return true;
 }
 
@@ -58,7 +79,12 @@ bool TextureManager::Shutdown()
 	for (unsigned int i = 0; i < eCategoryCount; ++i)
 	{
 		m_texturePool[i].Done();
+		m_freeTextures[i] = NULL;
 	}
+	free(m_pendingUploads);
+	m_pendingUploads = NULL;
+	m_numPendingUploads = 0;
+	m_maxPendingUploads = 0;
 
 	return true;
 }
@@ -75,13 +101,18 @@ bool TextureManager::Update(float a_dt)
 		m_updateTimer = 0.0f;
 		bool textureReloaded = false;
 
-		// For each texture category
+		// For each texture category, textures being added from other threads wait until the scan is done
+		EnterCriticalSection(&m_lock);
 		for (unsigned int i = 0; i < eCategoryCount; ++i)
 		{
-			// Each texture in the category gets tested
-			ManagedTexture * curTex = NULL;
-			while ( m_textureMap[i].GetNext(curTex) && curTex != NULL)
+			// Each texture in the category gets tested, apart from those another thread is still loading
+			for (TextureMap::Iterator curTexIt = m_textureMap[i].Begin(); curTexIt != m_textureMap[i].End(); ++curTexIt)
 			{
+				ManagedTexture * curTex = curTexIt.GetValue();
+				if (curTex->m_loading)
+				{
+					continue;
+				}
 				FileManager::Timestamp curTimeStamp;
 				if (FileManager::Get().GetFileTimeStamp(curTex->m_path, curTimeStamp))
 				{
@@ -94,6 +125,7 @@ bool TextureManager::Update(float a_dt)
 				}
 			}
 		}
+		LeaveCriticalSection(&m_lock);
 		return textureReloaded;
 	}
 }
@@ -112,19 +144,36 @@ Texture * TextureManager::GetTexture(const char *a_tgaPath, eTextureCategory a_c
 	}
 	
 	// Get the identifier for the new texture
-	StringHash texHash(fileNameBuf);
-	unsigned int texId = texHash.GetHash();
+	unsigned int texId = StringHash::GenerateCRC(fileNameBuf, false);
+	EnterCriticalSection(&m_lock);
 	eTextureCategory a_loadedCat = IsTextureLoaded(texId);
 
 	// If it already exists
 	if (a_loadedCat != eCategoryNone)
 	{
-		// Just returned the cached copy
-		ManagedTexture * foundTex = NULL;
-		m_textureMap[a_loadedCat].Get(texId, foundTex);
+		// Return the cached copy once it has loaded, it may still be waiting to upload if another thread asked for it
+		ManagedTexture * foundTex = WaitForLoad(texId, a_loadedCat);
+		LeaveCriticalSection(&m_lock);
+		if (foundTex == NULL)
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Texture load failed for %s", fileNameBuf);
+			return NULL;
+		}
 		return &foundTex->m_texture;
 	}
-	else if (ManagedTexture * newTex = m_texturePool[a_cat].Allocate(sizeof(ManagedTexture)))
+
+	// Blocks of textures that failed to load are used again before taking more of the pool
+	ManagedTexture * newTex = m_freeTextures[a_cat];
+	if (newTex != NULL)
+	{
+		m_freeTextures[a_cat] = newTex->m_nextFree;
+	}
+	else
+	{
+		newTex = m_texturePool[a_cat].Allocate(sizeof(ManagedTexture));
+	}
+
+	if (newTex != NULL)
 	{
 		// If the filter is not specified, use the default
 		if (a_currentFilter == eTextureFilterInvalid)
@@ -132,38 +181,145 @@ Texture * TextureManager::GetTexture(const char *a_tgaPath, eTextureCategory a_c
 			a_currentFilter = m_filterMode;
 		}
 
-		// Insert the newly allocated texture
-		if (newTex->m_texture.Load(fileNameBuf, a_currentFilter == eTextureFilterLinear))
+		// Insert the newly allocated texture before loading so other threads asking for it don't load it again. It's
+		// stamped and marked as loading first so a hot reload scan can't load it on the main thread at the same time.
+		new (&newTex->m_texture) Texture();
+		sprintf(newTex->m_path, "%s", fileNameBuf);
+		newTex->m_timeStamp = FileManager::Timestamp();
+		FileManager::Get().GetFileTimeStamp(fileNameBuf, newTex->m_timeStamp);
+		newTex->m_nextFree = NULL;
+		newTex->m_loading = true;
+		m_textureMap[a_cat].Insert(texId, newTex);
+		LeaveCriticalSection(&m_lock);
+
+		// Off the main thread only the file is read, the upload is queued for later
+		const bool onMainThread = IsMainThread();
+		const bool useLinearFilter = a_currentFilter == eTextureFilterLinear;
+		const bool loaded = onMainThread ? newTex->m_texture.Load(fileNameBuf, useLinearFilter) : newTex->m_texture.LoadData(fileNameBuf, useLinearFilter);
+
+		EnterCriticalSection(&m_lock);
+		if (loaded)
 		{
-			FileManager::Get().GetFileTimeStamp(fileNameBuf, newTex->m_timeStamp);
-			sprintf(newTex->m_path, "%s", fileNameBuf);
-			m_textureMap[a_cat].Insert(texId, newTex);
+			newTex->m_loading = false;
+			LeaveCriticalSection(&m_lock);
+			if (!onMainThread && !QueueUpload(newTex))
+			{
+				Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to grow the pending upload list, texture %s will not be uploaded", fileNameBuf);
+			}
 			return &newTex->m_texture;
 		}
 		else
 		{
+			// Threads waiting for the texture find it gone and report the failure themselves, the block is kept for the next texture
+			m_textureMap[a_cat].Remove(texId);
+			newTex->m_nextFree = m_freeTextures[a_cat];
+			m_freeTextures[a_cat] = newTex;
+			LeaveCriticalSection(&m_lock);
 			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Texture load failed for %s", fileNameBuf);
 			return NULL;
 		}
 	}
 	else // Report the error
 	{
+		LeaveCriticalSection(&m_lock);
 		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Texture allocation failed for %s", fileNameBuf);
 		return NULL;
 	}
    return NULL;
 }
 
+unsigned int TextureManager::UploadPendingTextures(unsigned int a_budgetMs)
+{
+	const unsigned int startTime = Time::GetSystemTime();
+	unsigned int numUploaded = 0;
+	while (numUploaded == 0 || Time::GetSystemTime() - startTime < a_budgetMs)
+	{
+		// Textures are taken off the list under the lock and uploaded outside it so decoding threads aren't held up
+		ManagedTexture * uploadTex = NULL;
+		EnterCriticalSection(&m_lock);
+		if (m_numPendingUploads > 0)
+		{
+			uploadTex = m_pendingUploads[--m_numPendingUploads];
+		}
+		LeaveCriticalSection(&m_lock);
+		if (uploadTex == NULL)
+		{
+			break;
+		}
+
+		// A hot reload on the main thread may have uploaded it already
+		if (uploadTex->m_texture.IsUploadPending() && !uploadTex->m_texture.Upload())
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Texture upload failed for %s", uploadTex->m_path);
+		}
+		++numUploaded;
+	}
+	return numUploaded;
+}
+
+TextureManager::ManagedTexture * TextureManager::WaitForLoad(unsigned int a_texId, eTextureCategory a_cat)
+{
+	// The loading thread needs the lock to finish so it's let go while waiting. The texture is looked up again
+	// each time as a failed load takes it out of the map and the block can be reused for another texture.
+	for (;;)
+	{
+		ManagedTexture * foundTex = NULL;
+		if (!m_textureMap[a_cat].Get(a_texId, foundTex))
+		{
+			return NULL;
+		}
+		if (!foundTex->m_loading)
+		{
+			return foundTex;
+		}
+		LeaveCriticalSection(&m_lock);
+		YieldProcessor();
+		EnterCriticalSection(&m_lock);
+	}
+}
+
+bool TextureManager::QueueUpload(ManagedTexture * a_texture)
+{
+	EnterCriticalSection(&m_lock);
+
+	// The list grows by doubling
+	bool queued = true;
+	if (m_numPendingUploads >= m_maxPendingUploads)
+	{
+		const unsigned int newMaxUploads = m_maxPendingUploads > 0 ? m_maxPendingUploads * 2 : s_minPendingUploads;
+		ManagedTexture ** newUploads = (ManagedTexture **)realloc(m_pendingUploads, sizeof(ManagedTexture *) * newMaxUploads);
+		if (newUploads != NULL)
+		{
+			m_pendingUploads = newUploads;
+			m_maxPendingUploads = newMaxUploads;
+		}
+		else
+		{
+			queued = false;
+		}
+	}
+	if (queued)
+	{
+		m_pendingUploads[m_numPendingUploads++] = a_texture;
+	}
+
+	LeaveCriticalSection(&m_lock);
+	return queued;
+}
+
 TextureManager::eTextureCategory TextureManager::IsTextureLoaded(unsigned int a_tgaPathHash)
 {
 	// Look through each category for the target texture
-	for (unsigned int i = 0; i < eCategoryCount; ++i)
+	eTextureCategory foundCat = eCategoryNone;
+	EnterCriticalSection(&m_lock);
+	for (unsigned int i = 0; i < eCategoryCount && foundCat == eCategoryNone; ++i)
 	{
 		ManagedTexture * foundTex = NULL;
 		if (m_textureMap[i].Get(a_tgaPathHash, foundTex))
 		{
-			return (eTextureCategory)i;
+			foundCat = (eTextureCategory)i;
 		}
 	}
-	return eCategoryNone;
+	LeaveCriticalSection(&m_lock);
+	return foundCat;
 }
\ No newline at end of file
@@ -42,7 +42,7 @@ public:
 
 	//\brief Ctor calls through to startup
 	TextureManager(float a_updateFreq = s_updateFreq);
-	~TextureManager() { Shutdown(); }
+	~TextureManager();
 
 	//brief Initialise memory pools on startup, cleanup textures on shutdown
 	bool Startup(const char * a_texturePath, bool a_useLinearTextureFilter = true);
@@ -52,22 +52,30 @@ public:
 	//\return true if a texture was old and needed to be reloaded
 	bool Update(float a_dt);
 
-	//\brief Get or load a TGA file into texture memory
+	//\brief Get or load a TGA file into texture memory, safe to call from any thread. Off the main thread the file
+	//		 is read and decoded straight away but the texture isn't loaded until UploadPendingTextures sends it to GL.
+	//		 A texture another thread is still loading is waited for so every caller sees the same success or failure.
 	//\param a_tgaPath cstring to identify the texture by
-	//\return texture ID of the identified texture
+	//\return texture ID of the identified texture, NULL if it could not be loaded
 	Texture * GetTexture(const char *a_tgaPath, eTextureCategory a_cat, eTextureFilter a_currentFilter = eTextureFilterInvalid);
 
+	//\brief Upload textures decoded on other threads, called on the main thread where the GL context is
+	//\param a_budgetMs how long to spend uploading, at least one texture is uploaded if any are waiting
+	//\return how many textures were uploaded
+	unsigned int UploadPendingTextures(unsigned int a_budgetMs);
+	inline unsigned int GetNumPendingUploads() { return m_numPendingUploads; }
+
 	//\brief Functions to check if a texture has already been loaded
 	//\param a_tgaPathHash is the identified for the texture
 	//\return -1 the category that the texture is loaded into, none if not loaded
 	eTextureCategory IsTextureLoaded(unsigned int a_tgaPathHash);
-	inline eTextureCategory IsTextureLoaded(const char *a_tgaPath) { return IsTextureLoaded(StringHash(a_tgaPath).GetHash()); }
+	inline eTextureCategory IsTextureLoaded(const char *a_tgaPath) { return IsTextureLoaded(StringHash::GenerateCRC(a_tgaPath, false)); }
 
 	//\brief Reload a single texture without changing the IDs
 	//\param a_cat the category the texture is found in. If not supplied, an exhaustive search is performed
 	//\return true in the texture was found and reloaded successfully
 	bool ReloadTexture(unsigned int a_tgaPathHash, eTextureCategory a_cat = eCategoryNone);
-	inline bool ReloadTexture(const char *a_tgaPath, eTextureCategory a_cat = eCategoryNone) { return ReloadTexture(StringHash(a_tgaPath).GetHash(), a_cat); }
+	inline bool ReloadTexture(const char *a_tgaPath, eTextureCategory a_cat = eCategoryNone) { return ReloadTexture(StringHash::GenerateCRC(a_tgaPath, false), a_cat); }
 
 	//\brief Wholesale reload of single or multiple categories
 	bool ReloadTextureCategory(eTextureCategory a_cat);
@@ -86,19 +94,39 @@ private:
 		Texture  m_texture;											///< The actual texture
 		FileManager::Timestamp m_timeStamp;							///< Datestamp for checking a newer version
 		char m_path[StringUtils::s_maxCharsPerLine];				///< The full path for reloading
+		ManagedTexture * m_nextFree;								///< Next block in the category's free list once a load has failed
+		bool m_loading;												///< Set while the thread that added the texture is loading it, hot reload skips it
 	};
 
 	typedef HashMap<unsigned int, ManagedTexture *> TextureMap;		///< Alias for a hash map of managed textures
 
+	//\brief GL calls can only be made from the thread that started the texture manager
+	inline bool IsMainThread() { return GetCurrentThreadId() == m_mainThreadId; }
+
+	//\brief Wait for another thread to finish loading a texture, called with the lock held and returns with it held
+	//\return the texture once it has loaded or NULL if the load failed and it was taken out of the map
+	ManagedTexture * WaitForLoad(unsigned int a_texId, eTextureCategory a_cat);
+
+	//\brief Add a decoded texture to the list waiting for the main thread to upload it
+	//\return true if there was room in the list
+	bool QueueUpload(ManagedTexture * a_texture);
+
 	static const unsigned int s_texurePoolSize[eCategoryCount];		///< How much memory is assigned for each category
 	static const float s_updateFreq;								///< How often the texture manager should check for updates
+	static const unsigned int s_minPendingUploads = 32;				///< Starting size of the list of textures waiting to upload
 
 	LinearAllocator<ManagedTexture> m_texturePool[eCategoryCount];	///< Memory pool for each texture category
 	TextureMap m_textureMap[eCategoryCount];						///< List of textures for each category
+	ManagedTexture * m_freeTextures[eCategoryCount];				///< Blocks of textures that failed to load, reused before allocating from the pool
 	char m_texturePath[StringUtils::s_maxCharsPerLine];				///< Cache off texture path 
 	float m_updateFreq;												///< How often the texture manager should check for changes
 	float m_updateTimer;											///< If we are due for a scan and update of textures
 	eTextureFilter m_filterMode;									///< Filtering rule to apply, can make exceptions on a per texture basis
+	DWORD m_mainThreadId;											///< Thread that owns the GL context
+	CRITICAL_SECTION m_lock;										///< Held while the maps, pools or pending list are changed
+	ManagedTexture ** m_pendingUploads;								///< Textures decoded on other threads waiting to be uploaded
+	unsigned int m_numPendingUploads;								///< How many textures are waiting to be uploaded
+	unsigned int m_maxPendingUploads;								///< How many textures fit in the pending list before it grows
 };
 
 #endif /* _ENGINE_TEXTURE_MANAGER_H_ */
\ No newline at end of file
@@ -2,11 +2,82 @@
 #define _ENGINE_TIMER_
 #pragma once
 
+#include <windows.h>
+
 #include <SDL.h>
 
 namespace Time
 {
     static const unsigned int GetSystemTime() { return SDL_GetTicks(); }
+
+    //\brief Seconds from the high resolution counter, for timing frames more finely than a millisecond
+    static double GetPreciseTimeSec()
+    {
+        LARGE_INTEGER frequency, counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+        return (double)counter.QuadPart / (double)frequency.QuadPart;
+    }
+};
+
+//\brief Turns variable frame times into a whole number of fixed length simulation steps. Time left over
+//       carries on to the next frame and the fraction of a step it makes up is used to blend drawing
+//       between the last two simulated states. The same frame times always give the same steps.
+class FixedTimestep
+{
+public:
+
+    FixedTimestep()
+    : m_stepTime(1.0 / s_defaultTickRate)
+    , m_accumulator(0.0)
+    , m_maxStepsPerFrame(s_defaultMaxStepsPerFrame)
+    , m_numDroppedFrames(0)
+    {
+    }
+
+    //\brief How many simulation steps make up a second, values that are not positive are ignored
+    inline void SetTickRate(float a_ticksPerSec) { if (a_ticksPerSec > 0.0f) { m_stepTime = 1.0 / a_ticksPerSec; } }
+
+    //\brief The most steps simulated in one frame, time past this is dropped so a slow frame can't make the next one slower still
+    inline void SetMaxStepsPerFrame(unsigned int a_maxSteps) { m_maxStepsPerFrame = a_maxSteps > 0 ? a_maxSteps : 1; }
+
+    //\brief Add the time a frame took
+    //\param a_frameTimeSec the length of the last frame in seconds
+    //\return how many fixed steps to simulate this frame, can be 0 when frames are shorter than a step
+    inline unsigned int Advance(double a_frameTimeSec)
+    {
+        m_accumulator += a_frameTimeSec > 0.0 ? a_frameTimeSec : 0.0;
+        unsigned int numSteps = (unsigned int)(m_accumulator / m_stepTime);
+        if (numSteps > m_maxStepsPerFrame)
+        {
+            numSteps = m_maxStepsPerFrame;
+            m_accumulator = numSteps * m_stepTime;
+            ++m_numDroppedFrames;
+        }
+        m_accumulator -= numSteps * m_stepTime;
+        return numSteps;
+    }
+
+    //\brief Throw away any time waiting to be simulated, after a load or a pause
+    inline void Reset() { m_accumulator = 0.0; }
+
+    inline float GetStepTime() const { return (float)m_stepTime; }
+
+    //\brief How far between the last simulated state and the next one the current frame is, 0 to 1
+    inline float GetInterpolation() const { return (float)(m_accumulator / m_stepTime); }
+
+    //\brief How many frames have needed more steps than the cap allows
+    inline unsigned int GetNumDroppedFrames() const { return m_numDroppedFrames; }
+
+private:
+
+        static const unsigned int s_defaultTickRate = 60;           // Steps per second when no rate is set
+        static const unsigned int s_defaultMaxStepsPerFrame = 5;    // Steps per frame when no cap is set
+
+        double m_stepTime;                  // Length of a step in seconds
+        double m_accumulator;               // Time not yet simulated, always less than a step between frames
+        unsigned int m_maxStepsPerFrame;    // Cap on steps in one frame
+        unsigned int m_numDroppedFrames;    // How many frames hit the cap
 };
 
 class Timer
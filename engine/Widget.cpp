@@ -442,24 +442,26 @@ void Widget::AddListItem(const char * a_newItemName)
 	// Allocate a new node and set data
 	if (LinkedListNode<StringHash> * newListItem = new LinkedListNode<StringHash>())
 	{
-		newListItem->SetData(new StringHash(a_newItemName));
+		newListItem->SetData(new StringHash(a_newItemName, true));
 		m_listItems.Insert(newListItem);
 	}
 }
 
 void Widget::RemoveListItem(const char * a_existingItemName)
 {
+	const unsigned int existingItemHash = StringHash::GenerateCRC(a_existingItemName, false);
 	LinkedListNode<StringHash> * cur = m_listItems.GetHead();
 	while(cur != NULL)
 	{
 		// Remove item and quit out of the loop if found
-		if (cur->GetData()->GetHash() == StringHash::GenerateCRC(a_existingItemName))
+		if (cur->GetData()->GetHash() == existingItemHash)
 		{
 			delete cur->GetData();
 			m_listItems.Remove(cur);
 			delete cur;
 			break;
 		}
+		cur = cur->GetNext();
 	}
 }
 
@@ -1,239 +1,1984 @@
+#include <limits.h>
+
+#include "CameraManager.h"
+#include "CollisionUtils.h"
+#include "ComponentManager.h"
 #include "GameFile.h"
+#include "JobManager.h"
+#include "MemoryManager.h"
 #include "ModelManager.h"
+#include "RenderManager.h"
+#include "TextureManager.h"
+#include "Time.h"
+
+#include "WorldManager.h"
+
+using namespace std;	//< For fstream operations
+
+template<> WorldManager * Singleton<WorldManager>::s_instance = NULL;
+
+const unsigned int WorldManager::s_maxGameObjects = 65536;	// Maximum addressable by an object handle
+const unsigned int WorldManager::s_defaultStreamingBudgetMs = 4;	// A quarter of a frame at 60hz
+const float WorldManager::s_prototypeUpdateFreq = 1.0f;
+const float Scene::s_gridCellSize = 8.0f;					// A few typical objects across
+const unsigned int Scene::s_gridNumBuckets = 4096;
+const float Scene::s_treeMargin = 0.5f;						// Objects can drift this far before the tree is refit
+
+Scene::~Scene()
+{
+	// Return all the objects in the scene to the world's pool
+	WorldManager & worldMan = WorldManager::Get();
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		worldMan.FreeObject(m_objects[i]);
+	}
+	m_numObjects = 0;
+
+	// The dense object array is the start of the block all the arrays parallel to it were carved from
+	MemoryManager & memMan = MemoryManager::Get();
+	memMan.Free(MemoryManager::eArenaWorld, m_objects);
+	for (unsigned int i = 0; i < m_numCommandBuffers; ++i)
+	{
+		memMan.Free(MemoryManager::eArenaWorld, m_commandBuffers[i].m_commands);
+	}
+	memMan.Free(MemoryManager::eArenaWorld, m_commandBuffers);
+	memMan.Free(MemoryManager::eArenaWorld, m_stateChanges.m_commands);
+	memMan.Free(MemoryManager::eArenaWorld, m_wakeTriggers);
+	memMan.Free(MemoryManager::eArenaWorld, m_addBounds);
+}
+
+bool Scene::AllocateObjectArrays()
+{
+	if (m_objects != NULL)
+	{
+		return true;
+	}
+
+	// The sparse table covers every id the world pool can hand out so a lookup is a single index
+	const unsigned int numSparseEntries = ObjectPool<GameObject>::s_maxCapacity;
+
+	// All the arrays come from one block of the world arena so the scene takes a single page, each array is a multiple of 16 bytes so all of them stay aligned
+	const size_t blockSizeBytes = (sizeof(GameObject *) * 2 + sizeof(ObjectGrid::ItemId) + sizeof(ObjectTree::LeafId) + sizeof(ObjectBroadphase::ProxyId) + sizeof(unsigned int)) * s_maxObjects +
+								  sizeof(unsigned short) * numSparseEntries;
+	MemoryManager & memMan = MemoryManager::Get();
+	unsigned char * block = (unsigned char *)memMan.Allocate(MemoryManager::eArenaWorld, blockSizeBytes);
+	if (block == NULL || !m_objectGrid.Init(s_gridCellSize, s_gridNumBuckets))
+	{
+		memMan.Free(MemoryManager::eArenaWorld, block);
+		m_objectGrid.Done();
+		return false;
+	}
+	m_objects = (GameObject **)block;								block += sizeof(GameObject *) * s_maxObjects;
+	m_transformQueue = (GameObject **)block;						block += sizeof(GameObject *) * s_maxObjects;
+	m_gridItems = (ObjectGrid::ItemId *)block;						block += sizeof(ObjectGrid::ItemId) * s_maxObjects;
+	m_treeLeaves = (ObjectTree::LeafId *)block;						block += sizeof(ObjectTree::LeafId) * s_maxObjects;
+	m_broadphaseProxies = (ObjectBroadphase::ProxyId *)block;		block += sizeof(ObjectBroadphase::ProxyId) * s_maxObjects;
+	m_dirtyTransforms = (unsigned int *)block;						block += sizeof(unsigned int) * s_maxObjects;
+	m_objectIndices = (unsigned short *)block;
+	m_objectTree.SetMargin(s_treeMargin);
+
+	memset(m_objectIndices, 0xff, sizeof(unsigned short) * numSparseEntries);
+	return true;
+}
+
+bool Scene::AddObject(GameObject * a_newObject)
+{
+	if (Scene * updatingScene = WorldManager::Get().GetParallelUpdateScene())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot add object %s to scene %s during a parallel update of scene %s, objects that add others should update on the main thread.", a_newObject->GetName(), m_name, updatingScene->GetName());
+		return false;
+	}
+	if (WorldManager::Get().GetVerifyingScene() != NULL)
+	{
+		return false;
+	}
+
+	// New objects go on the end of the dense array
+	if (m_numObjects < s_maxObjects && AllocateObjectArrays())
+	{
+		Vector boundsMin, boundsMax;
+		a_newObject->GetClipBounds(boundsMin, boundsMax);
+		m_objectIndices[GetSparseIndex(a_newObject->GetId())] = (unsigned short)m_numObjects;
+		m_gridItems[m_numObjects] = m_objectGrid.Insert(a_newObject, boundsMin, boundsMax);
+		m_treeLeaves[m_numObjects] = m_objectTree.Insert(a_newObject, boundsMin, boundsMax);
+		m_broadphaseProxies[m_numObjects] = m_broadphase.Insert(a_newObject->GetId(), boundsMin, boundsMax, a_newObject->IsReportingOverlaps());
+		m_objects[m_numObjects++] = a_newObject;
+		m_partitionEnds[ePartitionDying] = m_numObjects;
+		a_newObject->SetScene(this);
+		a_newObject->ResetInterpolation();
+		a_newObject->Startup();
+		a_newObject->SetState(GameObject::eGameObjectState_Active);
+		return true;
+	}
+
+	Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot add object %s to scene %s, the scene is full.", a_newObject->GetName(), m_name);
+	return false;
+}
+
+bool Scene::AddObjects(GameObject ** a_newObjects, unsigned int a_numObjects)
+{
+	if (Scene * updatingScene = WorldManager::Get().GetParallelUpdateScene())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot add %u objects to scene %s during a parallel update of scene %s, objects that add others should update on the main thread.", a_numObjects, m_name, updatingScene->GetName());
+		return false;
+	}
+	if (WorldManager::Get().GetVerifyingScene() != NULL)
+	{
+		return false;
+	}
+	if (a_numObjects > GetNumFreeObjects() || !AllocateObjectArrays())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot add %u objects to scene %s, the scene is full.", a_numObjects, m_name);
+		return false;
+	}
+	if (a_numObjects == 0)
+	{
+		return true;
+	}
+
+	// Bounds are gathered once and shared by the grid and tree
+	if (!AllocateAddBounds(a_numObjects))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to add %u objects to scene %s.", a_numObjects, m_name);
+		return false;
+	}
+	Vector * boundsMin = m_addBounds;
+	Vector * boundsMax = m_addBounds + a_numObjects;
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		a_newObjects[i]->GetClipBounds(boundsMin[i], boundsMax[i]);
+	}
+
+	// New objects go on the end of the dense array with their ids written straight into it
+	const unsigned int firstIndex = m_numObjects;
+	bool inserted = m_objectGrid.InsertBatch(a_newObjects, boundsMin, boundsMax, a_numObjects, &m_gridItems[firstIndex]);
+	if (inserted && !m_objectTree.InsertBatch(a_newObjects, boundsMin, boundsMax, a_numObjects, &m_treeLeaves[firstIndex]))
+	{
+		for (unsigned int i = 0; i < a_numObjects; ++i)
+		{
+			m_objectGrid.Remove(m_gridItems[firstIndex + i]);
+		}
+		inserted = false;
+	}
+	if (!inserted)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to add %u objects to scene %s.", a_numObjects, m_name);
+		return false;
+	}
+
+	// The broadphase only appends to it's order so there is nothing to gain from a batch
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		m_broadphaseProxies[firstIndex + i] = m_broadphase.Insert(a_newObjects[i]->GetId(), boundsMin[i], boundsMax[i], a_newObjects[i]->IsReportingOverlaps());
+	}
+
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		m_objectIndices[GetSparseIndex(a_newObjects[i]->GetId())] = (unsigned short)(firstIndex + i);
+		m_objects[firstIndex + i] = a_newObjects[i];
+		a_newObjects[i]->SetScene(this);
+		a_newObjects[i]->ResetInterpolation();
+	}
+	m_numObjects += a_numObjects;
+	m_partitionEnds[ePartitionDying] = m_numObjects;
+
+	// Objects are only started once they are all in the scene so they can find each other
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		a_newObjects[i]->Startup();
+		a_newObjects[i]->SetState(GameObject::eGameObjectState_Active);
+	}
+	return true;
+}
+
+bool Scene::RemoveObject(GameObject * a_object)
+{
+	if (GetSceneObject(a_object->GetId()) != a_object)
+	{
+		return false;
+	}
+
+	const unsigned int sparseIndex = GetSparseIndex(a_object->GetId());
+	const unsigned int removeIndex = m_objectIndices[sparseIndex];
+	m_objectGrid.Remove(m_gridItems[removeIndex]);
+	m_objectTree.Remove(m_treeLeaves[removeIndex]);
+	m_broadphase.Remove(m_broadphaseProxies[removeIndex]);
+	a_object->SetScene(NULL);
+	a_object->m_transformDirty = false;
+
+	// Swap the object past the end of the last partition so every partition stays packed
+	MoveObjectPartition(removeIndex, GetPartitionForIndex(removeIndex), ePartitionCount);
+	m_numObjects = m_partitionEnds[ePartitionDying];
+	m_objectIndices[sparseIndex] = s_invalidIndex;
+
+	return true;
+}
+
+void Scene::UpdateObjectState(GameObject * a_object)
+{
+	if (m_updatingInParallel)
+	{
+		RecordCommand(eCommandTypeUpdateState, a_object, Matrix::Identity());
+	}
+	else if (m_deferStateChanges)
+	{
+		if (!AddCommand(m_stateChanges, eCommandTypeUpdateState, a_object, Matrix::Identity()))
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to grow the state change list of scene %s, the state change of object %s is lost.", m_name, a_object->GetName());
+		}
+	}
+	else
+	{
+		ApplyObjectState(a_object);
+	}
+}
+
+void Scene::ApplyObjectState(GameObject * a_object)
+{
+	const unsigned int objectIndex = m_objectIndices[GetSparseIndex(a_object->GetId())];
+	if (objectIndex != s_invalidIndex && m_objects[objectIndex] == a_object)
+	{
+		const ePartition fromPartition = GetPartitionForIndex(objectIndex);
+		const ePartition toPartition = GetPartitionForState(a_object->GetState());
+		if (fromPartition != toPartition)
+		{
+			MoveObjectPartition(objectIndex, fromPartition, toPartition);
+		}
+	}
+}
+
+void Scene::ApplyStateChanges()
+{
+	for (unsigned int i = 0; i < m_stateChanges.m_numCommands; ++i)
+	{
+		ApplyObjectState(m_stateChanges.m_commands[i].m_object);
+	}
+	m_stateChanges.m_numCommands = 0;
+}
+
+unsigned int Scene::MoveObjectPartition(unsigned int a_index, unsigned int a_fromPartition, unsigned int a_toPartition)
+{
+	// Moving towards the front the object swaps with the first object of each partition it passes, which then starts one later
+	unsigned int objectIndex = a_index;
+	for (unsigned int partition = a_fromPartition; partition > a_toPartition; --partition)
+	{
+		const unsigned int firstIndex = m_partitionEnds[partition - 1];
+		SwapObjects(objectIndex, firstIndex);
+		objectIndex = firstIndex;
+		++m_partitionEnds[partition - 1];
+	}
+
+	// Moving towards the back the object swaps with the last object of each partition it passes, which then ends one earlier
+	for (unsigned int partition = a_fromPartition; partition < a_toPartition; ++partition)
+	{
+		const unsigned int lastIndex = m_partitionEnds[partition] - 1;
+		SwapObjects(objectIndex, lastIndex);
+		objectIndex = lastIndex;
+		--m_partitionEnds[partition];
+	}
+
+	return objectIndex;
+}
+
+void Scene::SwapObjects(unsigned int a_index1, unsigned int a_index2)
+{
+	if (a_index1 == a_index2)
+	{
+		return;
+	}
+
+	GameObject * object1 = m_objects[a_index1];
+	GameObject * object2 = m_objects[a_index2];
+	const ObjectGrid::ItemId gridItem1 = m_gridItems[a_index1];
+	const ObjectTree::LeafId treeLeaf1 = m_treeLeaves[a_index1];
+	const ObjectBroadphase::ProxyId proxy1 = m_broadphaseProxies[a_index1];
+	m_objects[a_index1] = object2;
+	m_objects[a_index2] = object1;
+	m_gridItems[a_index1] = m_gridItems[a_index2];
+	m_gridItems[a_index2] = gridItem1;
+	m_treeLeaves[a_index1] = m_treeLeaves[a_index2];
+	m_treeLeaves[a_index2] = treeLeaf1;
+	m_broadphaseProxies[a_index1] = m_broadphaseProxies[a_index2];
+	m_broadphaseProxies[a_index2] = proxy1;
+	m_objectIndices[GetSparseIndex(object1->GetId())] = (unsigned short)a_index2;
+	m_objectIndices[GetSparseIndex(object2->GetId())] = (unsigned short)a_index1;
+}
+
+bool Scene::AddWakeTimer(GameObject * a_object, float a_delay)
+{
+	return AddWakeTrigger(a_object, eWakeTriggerTimer, a_delay, 0);
+}
+
+bool Scene::AddWakeProximity(GameObject * a_object, float a_radius)
+{
+	return AddWakeTrigger(a_object, eWakeTriggerProximity, a_radius, 0);
+}
+
+bool Scene::AddWakeEvent(GameObject * a_object, unsigned int a_eventHash)
+{
+	return AddWakeTrigger(a_object, eWakeTriggerEvent, 0.0f, a_eventHash);
+}
+
+bool Scene::AddWakeTrigger(GameObject * a_object, eWakeTrigger a_type, float a_value, unsigned int a_eventHash)
+{
+	if (GetSceneObject(a_object->GetId()) != a_object)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot add a wake trigger for object %s, it is not in scene %s.", a_object->GetName(), m_name);
+		return false;
+	}
+
+	// The list grows by doubling
+	if (m_numWakeTriggers >= m_maxWakeTriggers)
+	{
+		MemoryManager & memMan = MemoryManager::Get();
+		const unsigned int newMaxTriggers = m_maxWakeTriggers > 0 ? m_maxWakeTriggers * 2 : s_minWakeTriggers;
+		WakeTrigger * newTriggers = (WakeTrigger *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(WakeTrigger) * newMaxTriggers);
+		if (newTriggers == NULL)
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory for a wake trigger for object %s in scene %s.", a_object->GetName(), m_name);
+			return false;
+		}
+		if (m_numWakeTriggers > 0)
+		{
+			memcpy(newTriggers, m_wakeTriggers, sizeof(WakeTrigger) * m_numWakeTriggers);
+		}
+		memMan.Free(MemoryManager::eArenaWorld, m_wakeTriggers);
+		m_wakeTriggers = newTriggers;
+		m_maxWakeTriggers = newMaxTriggers;
+	}
+
+	WakeTrigger & newTrigger = m_wakeTriggers[m_numWakeTriggers++];
+	newTrigger.m_objectId = a_object->GetId();
+	newTrigger.m_type = a_type;
+	newTrigger.m_value = a_value;
+	newTrigger.m_eventHash = a_eventHash;
+	return true;
+}
+
+void Scene::RemoveWakeTriggers(GameObject * a_object)
+{
+	for (unsigned int i = 0; i < m_numWakeTriggers; )
+	{
+		if (m_wakeTriggers[i].m_objectId == a_object->GetId())
+		{
+			m_wakeTriggers[i] = m_wakeTriggers[--m_numWakeTriggers];
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+unsigned int Scene::SendWakeEvent(unsigned int a_eventHash)
+{
+	unsigned int numWoken = 0;
+	for (unsigned int i = 0; i < m_numWakeTriggers; )
+	{
+		WakeTrigger & curTrigger = m_wakeTriggers[i];
+		if (curTrigger.m_type == eWakeTriggerEvent && curTrigger.m_eventHash == a_eventHash)
+		{
+			if (GameObject * object = GetSceneObject(curTrigger.m_objectId))
+			{
+				numWoken += object->IsSleeping() ? 1 : 0;
+				object->SetActive();
+			}
+			m_wakeTriggers[i] = m_wakeTriggers[--m_numWakeTriggers];
+		}
+		else
+		{
+			++i;
+		}
+	}
+	return numWoken;
+}
+
+void Scene::UpdateWakeTriggers(float a_dt)
+{
+	// Only the sleepers with triggers are visited, the rest of the sleeping partition is never touched
+	for (unsigned int i = 0; i < m_numWakeTriggers; )
+	{
+		WakeTrigger & curTrigger = m_wakeTriggers[i];
+		GameObject * object = GetSceneObject(curTrigger.m_objectId);
+		bool fired = false;
+		if (object != NULL)
+		{
+			switch (curTrigger.m_type)
+			{
+				case eWakeTriggerTimer:
+				{
+					curTrigger.m_value -= a_dt;
+					fired = curTrigger.m_value <= 0.0f;
+					break;
+				}
+				case eWakeTriggerProximity:
+				{
+					if (object->IsSleeping())
+					{
+						const Vector centre = object->GetPos();
+						GameObject * nearbyObject = NULL;
+						fired = m_objectGrid.Query(centre - curTrigger.m_value, centre + curTrigger.m_value, WakeFilter(object, curTrigger.m_value), &nearbyObject, 1) > 0;
+					}
+					break;
+				}
+				default: break;
+			}
+		}
+
+		// Triggers for objects that have left the scene are dropped
+		if (object == NULL || fired)
+		{
+			if (fired)
+			{
+				object->SetActive();
+			}
+			m_wakeTriggers[i] = m_wakeTriggers[--m_numWakeTriggers];
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+GameObject * Scene::GetSceneObject(unsigned int a_objectId)
+{
+	if (m_objectIndices == NULL)
+	{
+		return NULL;
+	}
+
+	// The full id is checked as the slot may have been reused by an object from another generation
+	const unsigned int objectIndex = m_objectIndices[GetSparseIndex(a_objectId)];
+	if (objectIndex != s_invalidIndex && m_objects[objectIndex]->GetId() == a_objectId)
+	{
+		return m_objects[objectIndex];
+	}
+
+	return NULL;
+}
+
+GameObject * Scene::GetSceneObject(Vector a_worldPos)
+{
+	GameObject * firstObject = NULL;
+	GetSceneObjects(a_worldPos, &firstObject, 1);
+	return firstObject;
+}
+
+unsigned int Scene::GetSceneObjects(const Vector & a_worldPos, GameObject ** a_results_OUT, unsigned int a_maxResults)
+{
+	// Only objects in the cell containing the point are tested against their clip volume
+	return m_objectGrid.Query(a_worldPos, a_worldPos, PointFilter(a_worldPos), a_results_OUT, a_maxResults);
+}
+
+unsigned int Scene::GetSceneObjectsInRadius(const Vector & a_centre, float a_radius, GameObject ** a_results_OUT, unsigned int a_maxResults)
+{
+	return m_objectGrid.Query(a_centre - a_radius, a_centre + a_radius, RadiusFilter(a_centre, a_radius), a_results_OUT, a_maxResults);
+}
+
+unsigned int Scene::GetSceneObjectsInBox(const Vector & a_min, const Vector & a_max, GameObject ** a_results_OUT, unsigned int a_maxResults)
+{
+	return m_objectGrid.Query(a_min, a_max, a_results_OUT, a_maxResults);
+}
+
+void Scene::UpdateObjectBounds(GameObject * a_object)
+{
+	if (m_updatingInParallel)
+	{
+		RecordCommand(eCommandTypeUpdateBounds, a_object, Matrix::Identity());
+	}
+	else
+	{
+		ApplyObjectBounds(a_object);
+	}
+}
+
+void Scene::ApplyObjectBounds(GameObject * a_object)
+{
+	// Objects in a hierarchy move once their world transform is recalculated along with their children
+	if (a_object->IsInHierarchy())
+	{
+		QueueTransformUpdate(a_object);
+	}
+	else
+	{
+		MoveObjectBounds(a_object);
+	}
+}
+
+void Scene::MoveObjectBounds(GameObject * a_object)
+{
+	const unsigned int objectIndex = m_objectIndices[GetSparseIndex(a_object->GetId())];
+	if (objectIndex != s_invalidIndex && m_objects[objectIndex] == a_object)
+	{
+		Vector boundsMin, boundsMax;
+		a_object->GetClipBounds(boundsMin, boundsMax);
+		m_objectGrid.Move(m_gridItems[objectIndex], boundsMin, boundsMax);
+		m_objectTree.Move(m_treeLeaves[objectIndex], boundsMin, boundsMax);
+		m_broadphase.Move(m_broadphaseProxies[objectIndex], boundsMin, boundsMax);
+	}
+}
+
+void Scene::UpdateObjectOverlaps(GameObject * a_object)
+{
+	const unsigned int objectIndex = m_objectIndices[GetSparseIndex(a_object->GetId())];
+	if (objectIndex != s_invalidIndex && m_objects[objectIndex] == a_object)
+	{
+		m_broadphase.SetListening(m_broadphaseProxies[objectIndex], a_object->IsReportingOverlaps());
+	}
+}
+
+bool Scene::OverlapFilter::operator()(unsigned int a_objectId1, unsigned int a_objectId2) const
+{
+	GameObject * object1 = m_scene->GetSceneObject(a_objectId1);
+	GameObject * object2 = m_scene->GetSceneObject(a_objectId2);
+	return object1 != NULL && object2 != NULL && object1->CollidesWith(object2);
+}
+
+void Scene::OverlapReporter::operator()(unsigned int a_objectId1, unsigned int a_objectId2, ObjectBroadphase::eOverlap a_overlap) const
+{
+	// Either object may have left the scene since the pair was found, only the end of the overlap is reported to the one that is left
+	GameObject * object1 = m_scene->GetSceneObject(a_objectId1);
+	GameObject * object2 = m_scene->GetSceneObject(a_objectId2);
+	if (a_overlap != ObjectBroadphase::eOverlapEnd && (object1 == NULL || object2 == NULL))
+	{
+		return;
+	}
+
+	const GameObject::eOverlap overlap = (GameObject::eOverlap)a_overlap;
+	if (object1 != NULL && object1->IsReportingOverlaps())
+	{
+		object1->OnOverlap(object2, overlap);
+	}
+	if (object2 != NULL && object2->IsReportingOverlaps())
+	{
+		object2->OnOverlap(object1, overlap);
+	}
+}
+
+void Scene::QueueTransformUpdate(GameObject * a_object)
+{
+	if (a_object->m_transformDirty || GetSceneObject(a_object->GetId()) != a_object)
+	{
+		return;
+	}
+
+	// Objects that leave and rejoin the scene can be listed twice so make room if the list fills
+	if (m_numDirtyTransforms >= s_maxObjects)
+	{
+		UpdateTransforms();
+	}
+	a_object->m_transformDirty = true;
+	m_dirtyTransforms[m_numDirtyTransforms++] = a_object->GetId();
+}
+
+void Scene::UpdateTransforms()
+{
+	for (unsigned int i = 0; i < m_numDirtyTransforms; ++i)
+	{
+		// Objects that left the scene or were recalculated as part of a dirty ancestor's hierarchy are skipped
+		GameObject * dirtyObject = GetSceneObject(m_dirtyTransforms[i]);
+		if (dirtyObject == NULL || !dirtyObject->m_transformDirty)
+		{
+			continue;
+		}
+
+		// A dirty ancestor later in the list will recalculate this object along with the rest of it's hierarchy
+		bool ancestorDirty = false;
+		for (GameObject * ancestor = dirtyObject->m_parent; ancestor != NULL && !ancestorDirty; ancestor = ancestor->m_parent)
+		{
+			ancestorDirty = ancestor->m_transformDirty;
+		}
+		if (!ancestorDirty)
+		{
+			UpdateHierarchyTransforms(dirtyObject);
+		}
+	}
+	m_numDirtyTransforms = 0;
+}
+
+void Scene::UpdateHierarchyTransforms(GameObject * a_root)
+{
+	// No ancestor is waiting so the root's parent is already up to date
+	a_root->m_worldMat = a_root->m_parent != NULL ? a_root->m_localMat.Multiply(a_root->m_parent->m_worldMat) : a_root->m_localMat;
+
+	// Each level is finished before the level below reads it, the children of each object are multiplied by it's world transform in batches
+	Matrix batchMats[s_transformBatchSize];
+	GameObject * batchObjects[s_transformBatchSize];
+	unsigned int queueHead = 0;
+	unsigned int queueTail = 0;
+	m_transformQueue[queueTail++] = a_root;
+	while (queueHead < queueTail)
+	{
+		GameObject * parent = m_transformQueue[queueHead++];
+		parent->m_transformDirty = false;
+		if (parent->m_scene != NULL)
+		{
+			parent->m_scene->MoveObjectBounds(parent);
+		}
+
+		GameObject * child = parent->m_child;
+		while (child != NULL)
+		{
+			unsigned int batchSize = 0;
+			for (; child != NULL && batchSize < s_transformBatchSize; child = child->m_next)
+			{
+				batchObjects[batchSize] = child;
+				batchMats[batchSize++] = child->m_localMat;
+			}
+			Matrix::MultiplyBatch(&batchMats[0], parent->m_worldMat, &batchMats[0], batchSize);
+			for (unsigned int i = 0; i < batchSize; ++i)
+			{
+				batchObjects[i]->m_worldMat = batchMats[i];
+				if (queueTail < s_maxObjects)
+				{
+					m_transformQueue[queueTail++] = batchObjects[i];
+				}
+				else
+				{
+					Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Hierarchy under object %s in scene %s is too large to update, the transform of %s is out of date.", a_root->GetName(), m_name, batchObjects[i]->GetName());
+				}
+			}
+		}
+	}
+}
+
+bool Scene::RadiusFilter::operator()(GameObject * a_object, const Vector & a_min, const Vector & a_max) const
+{
+	// Distance from the centre to the closest point on the bounds
+	const float closestX = m_centre.GetX() < a_min.GetX() ? a_min.GetX() : (m_centre.GetX() > a_max.GetX() ? a_max.GetX() : m_centre.GetX());
+	const float closestY = m_centre.GetY() < a_min.GetY() ? a_min.GetY() : (m_centre.GetY() > a_max.GetY() ? a_max.GetY() : m_centre.GetY());
+	const float closestZ = m_centre.GetZ() < a_min.GetZ() ? a_min.GetZ() : (m_centre.GetZ() > a_max.GetZ() ? a_max.GetZ() : m_centre.GetZ());
+	return (Vector(closestX, closestY, closestZ) - m_centre).LengthSquared() <= m_radiusSquared;
+}
+
+void Scene::LineFilter::operator()(GameObject * const * a_objects, unsigned int a_numObjects, const Vector & a_lineStart, const Vector & a_lineEnd, bool * a_hits_OUT, float * a_hitFractions_OUT) const
+{
+	// Sort the batch by shape so each shape can be tested with the wide kernels
+	static const unsigned int s_batchSize = ObjectTree::s_maxLeafBatch;
+	Vector spherePositions[s_batchSize];
+	float sphereRadii[s_batchSize];
+	unsigned int sphereIndices[s_batchSize];
+	unsigned int numSpheres = 0;
+	Vector boxPositions[s_batchSize];
+	Vector boxDimensions[s_batchSize];
+	unsigned int boxIndices[s_batchSize];
+	unsigned int numBoxes = 0;
+	for (unsigned int i = 0; i < a_numObjects; ++i)
+	{
+		GameObject * object = a_objects[i];
+		switch (object->GetClipType())
+		{
+			case GameObject::eClipTypeSphere:
+			{
+				spherePositions[numSpheres] = object->GetClipPos();
+				sphereRadii[numSpheres] = object->GetClipSize().GetX();
+				sphereIndices[numSpheres++] = i;
+				break;
+			}
+			case GameObject::eClipTypeAxisBox:
+			{
+				boxPositions[numBoxes] = object->GetClipPos();
+				boxDimensions[numBoxes] = object->GetClipSize();
+				boxIndices[numBoxes++] = i;
+				break;
+			}
+			default:
+			{
+				// Rotated boxes and anything else are tested one at a time
+				a_hits_OUT[i] = object->CollidesWith(a_lineStart, a_lineEnd, a_hitFractions_OUT[i]);
+				break;
+			}
+		}
+	}
+
+	bool shapeHits[s_batchSize];
+	float shapeFractions[s_batchSize];
+	if (numSpheres > 0)
+	{
+		CollisionUtils::IntersectLineSpheres(a_lineStart, a_lineEnd, spherePositions, sphereRadii, numSpheres, shapeHits, shapeFractions);
+		for (unsigned int i = 0; i < numSpheres; ++i)
+		{
+			a_hits_OUT[sphereIndices[i]] = shapeHits[i];
+			a_hitFractions_OUT[sphereIndices[i]] = shapeFractions[i];
+		}
+	}
+	if (numBoxes > 0)
+	{
+		CollisionUtils::IntersectLineAxisBoxes(a_lineStart, a_lineEnd, boxPositions, boxDimensions, numBoxes, shapeHits, shapeFractions);
+		for (unsigned int i = 0; i < numBoxes; ++i)
+		{
+			a_hits_OUT[boxIndices[i]] = shapeHits[i];
+			a_hitFractions_OUT[boxIndices[i]] = shapeFractions[i];
+		}
+	}
+}
+
+GameObject * Scene::GetSceneObject(Vector a_lineStart, Vector a_lineEnd)
+{
+	LineHit closestHit;
+	return GetSceneObject(a_lineStart, a_lineEnd, closestHit) ? closestHit.m_object : NULL;
+}
+
+bool Scene::GetSceneObject(const Vector & a_lineStart, const Vector & a_lineEnd, LineHit & a_hit_OUT)
+{
+	ObjectTree::Hit treeHit;
+	if (m_numObjects > 0 && m_objectTree.TraceNearest(a_lineStart, a_lineEnd, LineFilter(), treeHit))
+	{
+		SetLineHit(a_lineStart, a_lineEnd, treeHit, a_hit_OUT);
+		return true;
+	}
+	return false;
+}
+
+unsigned int Scene::GetSceneObjects(const Vector & a_lineStart, const Vector & a_lineEnd, LineHit * a_hits_OUT, unsigned int a_maxHits)
+{
+	if (m_numObjects == 0 || a_maxHits == 0)
+	{
+		return 0;
+	}
+
+	// Trace into a local buffer then sort nearest first while copying out, there are rarely more than a handful of hits
+	ObjectTree::Hit treeHits[s_maxTraceHits];
+	const unsigned int numHits = m_objectTree.TraceAll(a_lineStart, a_lineEnd, LineFilter(), treeHits, a_maxHits < s_maxTraceHits ? a_maxHits : s_maxTraceHits);
+	if (numHits == s_maxTraceHits && a_maxHits > s_maxTraceHits)
+	{
+		Log::Get().WriteOnce(Log::LL_WARNING, Log::LC_ENGINE, "Line trace in scene %s hit more than %u objects, only the first %u found are returned.", m_name, s_maxTraceHits, s_maxTraceHits);
+	}
+	for (unsigned int i = 0; i < numHits; ++i)
+	{
+		unsigned int insertIndex = i;
+		while (insertIndex > 0 && a_hits_OUT[insertIndex - 1].m_fraction > treeHits[i].m_fraction)
+		{
+			a_hits_OUT[insertIndex] = a_hits_OUT[insertIndex - 1];
+			--insertIndex;
+		}
+		SetLineHit(a_lineStart, a_lineEnd, treeHits[i], a_hits_OUT[insertIndex]);
+	}
+	return numHits;
+}
+
+unsigned int Scene::GetSceneObjects(const Vector * a_lineStarts, const Vector * a_lineEnds, unsigned int a_numLines, LineHit * a_hits_OUT)
+{
+	// Lines are traced through the tree in packets that share the walk down to the leaves
+	unsigned int numHits = 0;
+	for (unsigned int firstLine = 0; firstLine < a_numLines; firstLine += ObjectTree::s_maxPacketLines)
+	{
+		const unsigned int numPacketLines = a_numLines - firstLine < ObjectTree::s_maxPacketLines ? a_numLines - firstLine : ObjectTree::s_maxPacketLines;
+		const Vector * packetStarts = a_lineStarts + firstLine;
+		const Vector * packetEnds = a_lineEnds + firstLine;
+		ObjectTree::Hit treeHits[ObjectTree::s_maxPacketLines];
+		const unsigned int hitLines = m_numObjects > 0 ? m_objectTree.TraceNearestPacket(packetStarts, packetEnds, numPacketLines, LineFilter(), treeHits) : 0;
+		for (unsigned int i = 0; i < numPacketLines; ++i)
+		{
+			if ((hitLines & (1u << i)) != 0)
+			{
+				SetLineHit(packetStarts[i], packetEnds[i], treeHits[i], a_hits_OUT[firstLine + i]);
+				++numHits;
+			}
+			else
+			{
+				a_hits_OUT[firstLine + i].m_object = NULL;
+			}
+		}
+	}
+	return numHits;
+}
+
+void Scene::SetLineHit(const Vector & a_lineStart, const Vector & a_lineEnd, const ObjectTree::Hit & a_treeHit, LineHit & a_hit_OUT)
+{
+	a_hit_OUT.m_object = a_treeHit.m_data;
+	a_hit_OUT.m_fraction = a_treeHit.m_fraction;
+	a_hit_OUT.m_distance = (a_lineEnd - a_lineStart).Length() * a_treeHit.m_fraction;
+	a_hit_OUT.m_point = a_lineStart + ((a_lineEnd - a_lineStart) * a_treeHit.m_fraction);
+}
+
+void Scene::SetObjectWorldMat(GameObject * a_object, const Matrix & a_mat)
+{
+	if (m_updatingInParallel)
+	{
+		RecordCommand(eCommandTypeSetWorldMat, a_object, a_mat);
+	}
+	else
+	{
+		a_object->SetWorldMat(a_mat);
+	}
+}
+
+void Scene::SetObjectPos(GameObject * a_object, const Vector & a_pos)
+{
+	if (m_updatingInParallel)
+	{
+		Matrix posMat = Matrix::Identity();
+		posMat.SetPos(a_pos);
+		RecordCommand(eCommandTypeSetPos, a_object, posMat);
+	}
+	else
+	{
+		a_object->SetPos(a_pos);
+	}
+}
+
+void Scene::StorePrevWorldMats()
+{
+	// Sleeping objects are included as they may be woken and moved in the step
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		m_objects[i]->StorePrevWorldMat();
+	}
+}
+
+bool Scene::Update(float a_dt)
+{
+	// Wake up any sleepers first so they update this frame
+	UpdateWakeTriggers(a_dt);
+
+	// Parallel update needs the job system, without it the objects update one by one
+	bool updateSuccess = true;
+	if (m_parallelUpdate && JobManager::Get().IsRunning())
+	{
+		updateSuccess = m_verifyParallelUpdate ? UpdateAndVerify(a_dt) : UpdateParallel(a_dt);
+	}
+	else
+	{
+		updateSuccess = UpdateSerial(a_dt);
+	}
+
+	// Attached objects follow whatever moved in the update
+	UpdateTransforms();
+
+	// Objects are told about overlaps once everything is where it will be drawn
+	m_numOverlaps = m_broadphase.Update(OverlapFilter(this), OverlapReporter(this));
+
+	return updateSuccess;
+}
+
+bool Scene::UpdateSerial(float a_dt)
+{
+	// Components of the active objects update together by type before their objects
+	bool updateSuccess = ComponentManager::Get().Update(a_dt, this);
+
+	// Iterate through all active objects in the scene and update state, objects changing state move partition afterwards
+	const unsigned int numActiveObjects = m_partitionEnds[ePartitionActive];
+	m_deferStateChanges = true;
+	for (unsigned int i = 0; i < numActiveObjects; ++i)
+	{
+		if (!m_objects[i]->IsUpdatedOnMainThread())
+		{
+			updateSuccess &= m_objects[i]->Update(a_dt);
+		}
+	}
+
+	// Objects that opt out of a parallel update go last here too so both ways see the scene in the same order
+	for (unsigned int i = 0; i < numActiveObjects; ++i)
+	{
+		if (m_objects[i]->IsUpdatedOnMainThread())
+		{
+			updateSuccess &= m_objects[i]->Update(a_dt);
+		}
+	}
+	m_deferStateChanges = false;
+	ApplyStateChanges();
+
+	return updateSuccess;
+}
+
+bool Scene::UpdateParallel(float a_dt)
+{
+	const unsigned int numActiveObjects = m_partitionEnds[ePartitionActive];
+	const unsigned int numChunks = (numActiveObjects + s_updateChunkSize - 1) / s_updateChunkSize;
+	if (!AllocateCommandBuffers(numChunks))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate command buffers for a parallel update of scene %s, updating serially.", m_name);
+		return UpdateSerial(a_dt);
+	}
+
+	// Components move objects directly so they update on this thread before the objects are split across the others
+	bool updateSuccess = ComponentManager::Get().Update(a_dt, this);
+
+	// Each job updates whole chunks and waiting on the counter is the barrier before anything is applied
+	JobManager & jobMan = JobManager::Get();
+	JobSystem::Counter chunksDone;
+	m_updateDt = a_dt;
+	m_deferStateChanges = true;
+	m_updatingInParallel = true;
+	jobMan.ParallelFor(UpdateChunks, this, numChunks, 1, &chunksDone);
+	jobMan.Wait(chunksDone);
+	m_updatingInParallel = false;
+
+	// Apply what each chunk recorded in the order the objects are stored, the same order a serial update would
+	for (unsigned int i = 0; i < numChunks; ++i)
+	{
+		CommandBuffer & buffer = m_commandBuffers[i];
+		for (unsigned int j = 0; j < buffer.m_numCommands; ++j)
+		{
+			ApplyCommand(buffer.m_commands[j]);
+		}
+		buffer.m_numCommands = 0;
+		updateSuccess &= buffer.m_updateOk;
+	}
+
+	// Objects that opted out update last with full access to the scene
+	for (unsigned int i = 0; i < numActiveObjects; ++i)
+	{
+		if (m_objects[i]->IsUpdatedOnMainThread())
+		{
+			updateSuccess &= m_objects[i]->Update(a_dt);
+		}
+	}
+
+	// Objects that changed state move partition once everything has updated
+	m_deferStateChanges = false;
+	ApplyStateChanges();
+
+	return updateSuccess;
+}
+
+bool Scene::UpdateAndVerify(float a_dt)
+{
+	// Save the state of every object so the update can be run twice from the same start
+	unsigned int stateSize = 0;
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		stateSize += m_objects[i]->GetStateSize();
+	}
+	const unsigned int numObjects = m_numObjects;
+	MemoryManager & memMan = MemoryManager::Get();
+	unsigned char * savedState = (unsigned char *)memMan.Allocate(MemoryManager::eArenaWorld, stateSize);
+	GameObject ** serialObjects = (GameObject **)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(GameObject *) * numObjects);
+	Matrix * serialMats = (Matrix *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(Matrix) * numObjects);
+	float * serialLifeTimes = (float *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(float) * numObjects);
+	if (savedState == NULL || serialObjects == NULL || serialMats == NULL || serialLifeTimes == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to verify the parallel update of scene %s.", m_name);
+		memMan.Free(MemoryManager::eArenaWorld, savedState);
+		memMan.Free(MemoryManager::eArenaWorld, serialObjects);
+		memMan.Free(MemoryManager::eArenaWorld, serialMats);
+		memMan.Free(MemoryManager::eArenaWorld, serialLifeTimes);
+		return UpdateParallel(a_dt);
+	}
+
+	// Objects change places in the dense array as they change state so they are tracked through a copy of the order at the start
+	unsigned char * state = savedState;
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		serialObjects[i] = m_objects[i];
+		serialObjects[i]->SaveState(state);
+		state += serialObjects[i]->GetStateSize();
+	}
+
+	// Run the serial update and keep the results, objects it would create or destroy are left to the parallel update
+	m_verifyingSerialUpdate = true;
+	UpdateSerial(a_dt);
+	m_verifyingSerialUpdate = false;
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		serialMats[i] = serialObjects[i]->GetWorldMat();
+		serialLifeTimes[i] = serialObjects[i]->GetLifeTime();
+	}
+
+	// Go back to the start and keep the parallel result
+	state = savedState;
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		serialObjects[i]->RestoreState(state);
+		state += serialObjects[i]->GetStateSize();
+	}
+	const bool updateSuccess = UpdateParallel(a_dt);
+
+	// The results should match exactly, any difference means an object's update depends on what other threads are doing
+	unsigned int numMismatches = 0;
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		GameObject * curObject = serialObjects[i];
+		const Matrix parallelMat = curObject->GetWorldMat();
+		const float parallelLifeTime = curObject->GetLifeTime();
+		if (memcmp(&parallelMat, &serialMats[i], sizeof(Matrix)) != 0 ||
+			memcmp(&parallelLifeTime, &serialLifeTimes[i], sizeof(float)) != 0)
+		{
+			Log::Get().Write(Log::LL_WARNING, Log::LC_ENGINE, "Parallel update of object %s in scene %s does not match the serial update.", curObject->GetName(), m_name);
+			++numMismatches;
+		}
+	}
+	if (numMismatches > 0)
+	{
+		Log::Get().Write(Log::LL_WARNING, Log::LC_ENGINE, "Parallel update of scene %s differs from the serial update for %u objects.", m_name, numMismatches);
+	}
+
+	memMan.Free(MemoryManager::eArenaWorld, savedState);
+	memMan.Free(MemoryManager::eArenaWorld, serialObjects);
+	memMan.Free(MemoryManager::eArenaWorld, serialMats);
+	memMan.Free(MemoryManager::eArenaWorld, serialLifeTimes);
+	return updateSuccess;
+}
+
+void Scene::UpdateChunks(void * a_scene, unsigned int a_startChunk, unsigned int a_endChunk)
+{
+	Scene * scene = (Scene *)a_scene;
+	const unsigned int threadIndex = JobManager::Get().GetThreadIndex();
+	for (unsigned int chunk = a_startChunk; chunk < a_endChunk; ++chunk)
+	{
+		// Commands recorded by these objects go into this chunk's buffer
+		scene->m_threadChunks[threadIndex] = chunk;
+		const unsigned int firstObject = chunk * s_updateChunkSize;
+		const unsigned int numActiveObjects = scene->m_partitionEnds[ePartitionActive];
+		const unsigned int lastObject = firstObject + s_updateChunkSize < numActiveObjects ? firstObject + s_updateChunkSize : numActiveObjects;
+		bool updateOk = true;
+		for (unsigned int i = firstObject; i < lastObject; ++i)
+		{
+			GameObject * curObject = scene->m_objects[i];
+			if (!curObject->IsUpdatedOnMainThread())
+			{
+				updateOk &= curObject->Update(scene->m_updateDt);
+			}
+		}
+		scene->m_commandBuffers[chunk].m_updateOk = updateOk;
+	}
+}
+
+void Scene::RecordCommand(eCommandType a_type, GameObject * a_object, const Matrix & a_mat)
+{
+	const unsigned int threadIndex = JobManager::Get().GetThreadIndex();
+	if (threadIndex == JobSystem::s_invalidThread)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Object %s was changed from a thread outside the job system during a parallel update of scene %s.", a_object->GetName(), m_name);
+		return;
+	}
+
+	// Only the thread updating the chunk touches it's buffer
+	CommandBuffer & buffer = m_commandBuffers[m_threadChunks[threadIndex]];
+	if (!AddCommand(buffer, a_type, a_object, a_mat))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to grow the command buffer for a parallel update of scene %s, a change to object %s is lost.", m_name, a_object->GetName());
+		buffer.m_updateOk = false;
+	}
+}
+
+bool Scene::AddCommand(CommandBuffer & a_buffer, eCommandType a_type, GameObject * a_object, const Matrix & a_mat)
+{
+	// Buffers grow by doubling
+	if (a_buffer.m_numCommands >= a_buffer.m_maxCommands)
+	{
+		MemoryManager & memMan = MemoryManager::Get();
+		const unsigned int newMaxCommands = a_buffer.m_maxCommands > 0 ? a_buffer.m_maxCommands * 2 : s_minCommands;
+		Command * newCommands = (Command *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(Command) * newMaxCommands);
+		if (newCommands == NULL)
+		{
+			return false;
+		}
+		if (a_buffer.m_numCommands > 0)
+		{
+			memcpy(newCommands, a_buffer.m_commands, sizeof(Command) * a_buffer.m_numCommands);
+		}
+		memMan.Free(MemoryManager::eArenaWorld, a_buffer.m_commands);
+		a_buffer.m_commands = newCommands;
+		a_buffer.m_maxCommands = newMaxCommands;
+	}
+
+	Command & newCommand = a_buffer.m_commands[a_buffer.m_numCommands++];
+	newCommand.m_type = a_type;
+	newCommand.m_object = a_object;
+	newCommand.m_mat = a_mat;
+	return true;
+}
+
+void Scene::ApplyCommand(const Command & a_command)
+{
+	switch (a_command.m_type)
+	{
+		case eCommandTypeUpdateBounds:
+		{
+			ApplyObjectBounds(a_command.m_object);
+			break;
+		}
+		case eCommandTypeSetWorldMat:
+		{
+			a_command.m_object->SetWorldMat(a_command.m_mat);
+			break;
+		}
+		case eCommandTypeSetPos:
+		{
+			a_command.m_object->SetPos(a_command.m_mat.GetPos());
+			break;
+		}
+		case eCommandTypeUpdateState:
+		{
+			// Still held back until the objects on the main thread have updated
+			UpdateObjectState(a_command.m_object);
+			break;
+		}
+		default: break;
+	}
+}
+
+bool Scene::AllocateAddBounds(unsigned int a_numObjects)
+{
+	if (a_numObjects <= m_maxAddBounds)
+	{
+		return true;
+	}
+
+	// Nothing in the scratch space is kept between batches so the old space is let go before the new is taken
+	MemoryManager & memMan = MemoryManager::Get();
+	memMan.Free(MemoryManager::eArenaWorld, m_addBounds);
+	const unsigned int newMaxAddBounds = a_numObjects > m_maxAddBounds * 2 ? a_numObjects : m_maxAddBounds * 2;
+	m_addBounds = (Vector *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(Vector) * newMaxAddBounds * 2);
+	m_maxAddBounds = m_addBounds != NULL ? newMaxAddBounds : 0;
+	return m_addBounds != NULL;
+}
+
+bool Scene::AllocateCommandBuffers(unsigned int a_numChunks)
+{
+	if (a_numChunks <= m_numCommandBuffers)
+	{
+		return true;
+	}
+
+	// Existing buffers keep their storage, new ones start empty from the zeroed memory and grow when first used
+	MemoryManager & memMan = MemoryManager::Get();
+	CommandBuffer * newBuffers = (CommandBuffer *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(CommandBuffer) * a_numChunks);
+	if (newBuffers == NULL)
+	{
+		return false;
+	}
+	if (m_numCommandBuffers > 0)
+	{
+		memcpy(newBuffers, m_commandBuffers, sizeof(CommandBuffer) * m_numCommandBuffers);
+	}
+	memMan.Free(MemoryManager::eArenaWorld, m_commandBuffers);
+	m_commandBuffers = newBuffers;
+	m_numCommandBuffers = a_numChunks;
+	return true;
+}
+
+void Scene::Serialise()
+{
+	// Construct the path from the scene directory and name of the scene
+	char scenePath[StringUtils::s_maxCharsPerLine];
+	sprintf(scenePath, "%s/%s.scn", WorldManager::Get().GetScenePath(), m_name);
+
+	// Create an output stream
+	GameFile * sceneFile = new GameFile();
+
+	GameFile::Object * sceneObject = sceneFile->AddObject("scene");
+	sceneFile->AddProperty(sceneObject, "name", m_name);
+	sceneFile->AddProperty(sceneObject, "beginLoaded", StringUtils::BoolToString(m_beginLoaded));
+	sceneFile->AddProperty(sceneObject, "parallelUpdate", StringUtils::BoolToString(m_parallelUpdate));
+	
+	// Add each object in the scene
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		// Alias the game object in the scene
+		GameObject * childGameObject = m_objects[i];
+		
+		// Objects with a parent are saved inside it
+		if (childGameObject->GetParent() != NULL)
+		{
+			continue;
+		}
+
+		// Only if the object has a template for loading can it be saved
+		if (childGameObject->HasTemplate())
+		{
+			// Add the object to the game file
+			childGameObject->Serialise(sceneFile, sceneObject);
+		}
+		else
+		{
+			Log::Get().Write(Log::LL_WARNING, Log::LC_ENGINE, "Game object called %s will not be saved in the scene as it does not have a source template.", childGameObject->GetName());
+		}
+	}
+
+	// Write all the data to a file
+	sceneFile->Write(scenePath);
+	delete sceneFile;
+}
+
+bool Scene::SaveSnapshot(SceneSnapshot & a_snapshot_OUT)
+{
+	// Every object's record goes in first so the state only has to be sized once
+	if (!a_snapshot_OUT.Begin(m_numObjects))
+	{
+		return false;
+	}
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		a_snapshot_OUT.AddObject(m_objects[i]->GetId(), m_objects[i]->GetStateSize());
+	}
+	if (!a_snapshot_OUT.AllocateState())
+	{
+		return false;
+	}
+
+	for (unsigned int i = 0; i < m_numObjects; ++i)
+	{
+		m_objects[i]->SaveState(a_snapshot_OUT.GetObjectState(i));
+	}
+	return true;
+}
+
+bool Scene::RestoreSnapshot(const SceneSnapshot & a_snapshot)
+{
+	if (!a_snapshot.IsValid() || a_snapshot.IsDelta())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot restore scene %s from a snapshot that is not a full snapshot.", m_name);
+		return false;
+	}
+
+	// Objects are found by id, one whose components have changed since can't take the old state
+	unsigned int numMissing = 0;
+	const unsigned int numObjects = a_snapshot.GetNumObjects();
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		GameObject * curObject = GetSceneObject(a_snapshot.GetObjectId(i));
+		if (curObject == NULL || curObject->GetStateSize() != a_snapshot.GetObjectStateSize(i))
+		{
+			++numMissing;
+			continue;
+		}
+
+		curObject->RestoreState(a_snapshot.GetObjectState(i));
+		curObject->ResetInterpolation();
+	}
+
+	if (numMissing > 0)
+	{
+		Log::Get().Write(Log::LL_WARNING, Log::LC_ENGINE, "Restoring scene %s from a snapshot skipped %u of %u objects that have left the scene or changed components.", m_name, numMissing, numObjects);
+	}
+	return numMissing == 0;
+}
+
+bool Scene::Draw(float a_interpolation)
+{
+	// Objects are tested against what the camera can see in batches and only the visible ones draw
+	Frustum viewFrustum;
+	RenderManager::Get().GetViewFrustum(CameraManager::Get().GetCameraMatrix(), viewFrustum);
+
+	// Only the active partition is drawn, sleeping and dying objects are not visited
+	bool drawSuccess = true;
+	Frustum::Volume cullVolumes[s_cullBatchSize];
+	bool visible[s_cullBatchSize];
+	const unsigned int numActiveObjects = m_partitionEnds[ePartitionActive];
+	m_numCulledObjects = 0;
+	for (unsigned int batchStart = 0; batchStart < numActiveObjects; batchStart += s_cullBatchSize)
+	{
+		const unsigned int batchSize = numActiveObjects - batchStart < s_cullBatchSize ? numActiveObjects - batchStart : s_cullBatchSize;
+		for (unsigned int i = 0; i < batchSize; ++i)
+		{
+			m_objects[batchStart + i]->GetCullVolume(cullVolumes[i]);
+		}
+
+		m_numCulledObjects += batchSize - viewFrustum.TestBatch(cullVolumes, batchSize, visible);
+		for (unsigned int i = 0; i < batchSize; ++i)
+		{
+			if (visible[i])
+			{
+				m_objects[batchStart + i]->Interpolate(a_interpolation);
+				drawSuccess &= m_objects[batchStart + i]->Draw();
+			}
+		}
+	}
+
+	return drawSuccess;
+}
+
+void WorldManager::LoadSceneObject(GameFile::Object * a_fileObject, Scene * a_scene, GameObject * a_parent, TemplateMap * a_templates)
+{
+	if (GameFile::Property * prop = a_fileObject->FindProperty(STRING_HASH("template")))
+	{
+		// Use the template if it has already been read, creation adds the object to the scene
+		GameFile * templateFile = NULL;
+		if (a_templates != NULL)
+		{
+			a_templates->Get(StringHash::GenerateCRC(prop->GetString(), false), templateFile);
+		}
+		GameObject * newObject = templateFile != NULL ? CreateObject<GameObject>(*templateFile, a_scene) : CreateObject<GameObject>(prop->GetString(), a_scene);
+		if (newObject != NULL)
+		{
+			newObject->SetTemplate(prop->GetString());
+			newObject->SetName(a_fileObject->FindProperty(STRING_HASH("name"))->GetString());
+
+			// Children are saved with their position relative to the parent
+			if (a_parent != NULL)
+			{
+				a_parent->AddChild(newObject, false);
+			}
+			newObject->SetLocalPos(a_fileObject->FindProperty(STRING_HASH("pos"))->GetVector());
+
+			// Then the objects attached to this one
+			GameFile::Object * childObject = a_fileObject->m_firstChild;
+			while (childObject != NULL)
+			{
+				LoadSceneObject(childObject, a_scene, newObject, a_templates);
+				childObject = childObject->m_next;
+			}
+		}
+	}
+}
+
+WorldManager::TemplatePrototype * WorldManager::GetPrototype(const char * a_templatePath)
+{
+	// Prototypes are found by the name they were asked for with so there is no path building for the ones already read
+	const unsigned int templateHash = StringHash::GenerateCRC(a_templatePath, false);
+	TemplatePrototype * prototype = NULL;
+	if (m_prototypes.Get(templateHash, prototype))
+	{
+		return prototype;
+	}
+
+	char fileNameBuf[StringUtils::s_maxCharsPerLine];
+	GetTemplateFilePath(a_templatePath, fileNameBuf);
+	GameFile templateFile(fileNameBuf);
+	if (!templateFile.IsLoaded())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to load template file %s", a_templatePath);
+		return NULL;
+	}
+
+	BinaryScene::Template objectTemplate;
+	if (!BinaryScene::ReadTemplate(templateFile, objectTemplate))
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to find a root gameObject node for template file %s", a_templatePath);
+		return NULL;
+	}
+
+	// Failure of model load will report errors
+	Model * model = NULL;
+	if (objectTemplate.m_model != NULL && (model = ModelManager::Get().GetModel(objectTemplate.m_model)) == NULL)
+	{
+		return NULL;
+	}
+
+	// Copy the strings out of the template file as it's about to be closed
+	prototype = MemoryManager::Get().New<TemplatePrototype>(MemoryManager::eArenaWorld);
+	if (prototype == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory for the prototype of template file %s", a_templatePath);
+		return NULL;
+	}
+	prototype->m_template = objectTemplate;
+	prototype->m_model = model;
+	FileManager::Get().GetFileTimeStamp(fileNameBuf, prototype->m_timeStamp);
+	sprintf(prototype->m_path, "%s", fileNameBuf);
+	prototype->m_template.m_path = prototype->m_path;
+	if (objectTemplate.m_name != NULL)
+	{
+		sprintf(prototype->m_name, "%s", objectTemplate.m_name);
+		prototype->m_template.m_name = prototype->m_name;
+	}
+	if (objectTemplate.m_model != NULL)
+	{
+		sprintf(prototype->m_modelPath, "%s", objectTemplate.m_model);
+		prototype->m_template.m_model = prototype->m_modelPath;
+	}
+	m_prototypes.Insert(templateHash, prototype);
+	return prototype;
+}
+
+void WorldManager::UpdatePrototypes(float a_dt)
+{
+	m_prototypeUpdateTimer += a_dt;
+	if (m_prototypeUpdateTimer < s_prototypeUpdateFreq)
+	{
+		return;
+	}
+	m_prototypeUpdateTimer = 0.0f;
+
+	// Changed templates are dropped rather than read again now, removing while iterating invalidates the iterator so collect them first
+	unsigned int staleHashes[s_maxStalePrototypes];
+	unsigned int numStale = 0;
+	for (PrototypeMap::Iterator it = m_prototypes.Begin(); it != m_prototypes.End() && numStale < s_maxStalePrototypes; ++it)
+	{
+		TemplatePrototype * prototype = it.GetValue();
+		FileManager::Timestamp curTimeStamp;
+		if (FileManager::Get().GetFileTimeStamp(prototype->m_path, curTimeStamp) && !IsSameTimeStamp(curTimeStamp, prototype->m_timeStamp))
+		{
+			Log::Get().Write(Log::LL_INFO, Log::LC_ENGINE, "Change detected in template %s, reloading.", prototype->m_path);
+			staleHashes[numStale++] = it.GetKey();
+		}
+	}
+	for (unsigned int i = 0; i < numStale; ++i)
+	{
+		TemplatePrototype * prototype = NULL;
+		m_prototypes.Get(staleHashes[i], prototype);
+		m_prototypes.Remove(staleHashes[i]);
+		MemoryManager::Get().Delete(MemoryManager::eArenaWorld, prototype);
+	}
+}
+
+void WorldManager::ClearPrototypes()
+{
+	MemoryManager & memMan = MemoryManager::Get();
+	for (PrototypeMap::Iterator it = m_prototypes.Begin(); it != m_prototypes.End(); ++it)
+	{
+		memMan.Delete(MemoryManager::eArenaWorld, it.GetValue());
+	}
+	m_prototypes.Clear();
+}
+
+void WorldManager::GetTemplateFilePath(const char * a_templatePath, char * a_fileName_OUT)
+{
+	if (!strstr(a_templatePath, ":\\"))
+	{
+		sprintf(a_fileName_OUT, "%s%s", m_templatePath, a_templatePath);
+
+		// Add on file extension if not present
+		if (!strstr(a_fileName_OUT, ".tmp"))
+		{
+			strcat(a_fileName_OUT, ".tmp");
+		}
+	} 
+	else // Already fully qualified
+	{
+		sprintf(a_fileName_OUT, "%s", a_templatePath);
+	}
+}
+
+bool WorldManager::RequestUnload(Scene * a_scene)
+{
+	if (a_scene == NULL)
+	{
+		return false;
+	}
+
+	// A scene still streaming is thrown away when the worker is done with it
+	SceneLoadNode * curLoad = m_sceneLoads.GetHead();
+	while (curLoad != NULL)
+	{
+		if (curLoad->GetData()->m_scene == a_scene)
+		{
+			curLoad->GetData()->m_unloadRequested = true;
+			return true;
+		}
+		curLoad = curLoad->GetNext();
+	}
+
+	// Otherwise remove it from the world straight away
+	SceneNode * curScene = m_scenes.GetHead();
+	while (curScene != NULL)
+	{
+		if (curScene->GetData() == a_scene)
+		{
+			m_scenes.Remove(curScene);
+			MemoryManager & memMan = MemoryManager::Get();
+			memMan.Delete(MemoryManager::eArenaWorld, curScene);
+			memMan.Delete(MemoryManager::eArenaWorld, a_scene);
+
+			// Show the next scene along if the current one went
+			if (m_currentScene == a_scene)
+			{
+				m_currentScene = m_scenes.GetHead() != NULL ? m_scenes.GetHead()->GetData() : NULL;
+			}
+			return true;
+		}
+		curScene = curScene->GetNext();
+	}
+
+	return false;
+}
+
+Scene * WorldManager::RequestLoad(const char * a_scenePath, bool a_onlyIfBeginLoaded)
+{
+	if (a_scenePath == NULL)
+	{
+		return NULL;
+	}
+
+	MemoryManager & memMan = MemoryManager::Get();
+	SceneLoad * newLoad = memMan.New<SceneLoad>(MemoryManager::eArenaWorld);
+	SceneLoadNode * newLoadNode = memMan.New<SceneLoadNode>(MemoryManager::eArenaWorld);
+	Scene * newScene = memMan.New<Scene>(MemoryManager::eArenaWorld);
+	if (newLoad == NULL || newLoadNode == NULL || newScene == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to load scene %s.", a_scenePath);
+		memMan.Delete(MemoryManager::eArenaWorld, newLoad);
+		memMan.Delete(MemoryManager::eArenaWorld, newLoadNode);
+		memMan.Delete(MemoryManager::eArenaWorld, newScene);
+		return NULL;
+	}
+
+	newLoad->m_scene = newScene;
+	newLoad->m_scene->SetState(Scene::eSceneState_Loading);
+	newLoad->m_onlyIfBeginLoaded = a_onlyIfBeginLoaded;
+	GetSceneFilePath(a_scenePath, newLoad->m_path);
+	newLoadNode->SetData(newLoad);
+	m_sceneLoads.Insert(newLoadNode);
+
+	// Files are read on a worker, without workers the job runs here and now
+	JobManager::Get().AddJob(&WorldManager::StreamSceneJob, newLoad, &newLoad->m_counter);
+	return newLoad->m_scene;
+}
+
+void WorldManager::StreamSceneJob(void * a_sceneLoad)
+{
+	// Nothing else touches the load or it's scene until the counter is done
+	SceneLoad * sceneLoad = (SceneLoad *)a_sceneLoad;
+	Scene * scene = sceneLoad->m_scene;
+	WorldManager & worldMan = WorldManager::Get();
+	MemoryManager & memMan = MemoryManager::Get();
+
+	// A compiled scene that is up to date skips parsing the scene and every template
+	char binaryPath[StringUtils::s_maxCharsPerLine];
+	GetBinarySceneFilePath(sceneLoad->m_path, binaryPath);
+	BinaryScene * binaryScene = memMan.New<BinaryScene>(MemoryManager::eArenaWorld);
+	if (binaryScene != NULL && binaryScene->Load(binaryPath) && worldMan.IsBinarySceneCurrent(*binaryScene, sceneLoad->m_path))
+	{
+		sceneLoad->m_binaryScene = binaryScene;
+		scene->SetName(binaryScene->GetName());
+		scene->SetBeginLoaded(binaryScene->IsBeginLoaded());
+		scene->SetParallelUpdate(binaryScene->IsParallelUpdate());
+		if (sceneLoad->m_onlyIfBeginLoaded && !scene->IsBeginLoaded())
+		{
+			return;
+		}
+
+		// Textures are known up front so they are read before the models that use them
+		for (unsigned int i = 0; i < binaryScene->GetNumTemplates(); ++i)
+		{
+			const BinaryScene::Template & curTemplate = binaryScene->GetTemplate(i);
+			if (curTemplate.m_texture != NULL)
+			{
+				TextureManager::Get().GetTexture(curTemplate.m_texture, TextureManager::eCategoryModel);
+			}
+			if (curTemplate.m_model != NULL)
+			{
+				ModelManager::Get().GetModel(curTemplate.m_model);
+			}
+		}
+
+		sceneLoad->m_binaryObjects = (GameObject **)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(GameObject *) * (binaryScene->GetNumObjects() + 1));
+		sceneLoad->m_loadOk = sceneLoad->m_binaryObjects != NULL;
+		return;
+	}
+	memMan.Delete(MemoryManager::eArenaWorld, binaryScene);
+
+	// Otherwise read the text scene
+	GameFile * sceneFile = memMan.New<GameFile>(MemoryManager::eArenaWorld);
+	if (sceneFile == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to read scene file %s.", sceneLoad->m_path);
+		return;
+	}
+	sceneLoad->m_sceneFile = sceneFile;
+	sceneFile->Load(sceneLoad->m_path);
+	GameFile::Object * sceneObject = sceneFile->FindObject(STRING_HASH("scene"));
+	if (sceneObject == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Error loading scene file %s, no valid scene parent element.", sceneLoad->m_path);
+		return;
+	}
+
+	// Set various properties of a scene
+	if (sceneFile->FindProperty(sceneObject, STRING_HASH("name")) &&
+		sceneFile->FindProperty(sceneObject, STRING_HASH("beginLoaded")))
+	{
+		scene->SetName(sceneFile->GetString("scene", "name"));
+		scene->SetBeginLoaded(sceneFile->GetBool("scene", "beginLoaded"));
+	}
+	else
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Error loading scene file %s, scene does not have required properties.", sceneLoad->m_path);
+		return;
+	}
+
+	// Optional properties
+	if (sceneFile->FindProperty(sceneObject, STRING_HASH("parallelUpdate")))
+	{
+		scene->SetParallelUpdate(sceneFile->GetBool("scene", "parallelUpdate"));
+	}
+
+	// Scenes left out of startup don't need their resources read
+	if (sceneLoad->m_onlyIfBeginLoaded && !scene->IsBeginLoaded())
+	{
+		return;
+	}
 
-#include "WorldManager.h"
+	// Read every template once along with the models and textures they use, so object creation on the main thread doesn't touch the disk
+	GameFile::Object * childGameObject = sceneObject->m_firstChild;
+	while (childGameObject != NULL)
+	{
+		ReadSceneObjectTemplates(childGameObject, sceneLoad->m_templates);
+		childGameObject = childGameObject->m_next;
+	}
 
-using namespace std;	//< For fstream operations
+	// Compile the scene so the next load is quicker
+	worldMan.WriteBinaryScene(sceneLoad->m_path, *sceneFile, sceneLoad->m_templates);
 
-template<> WorldManager * Singleton<WorldManager>::s_instance = NULL;
+	sceneLoad->m_nextObject = sceneObject->m_firstChild;
+	sceneLoad->m_loadOk = true;
+}
 
-Scene::~Scene()
+bool WorldManager::CompileScene(const char * a_scenePath)
 {
-	// Clean up memory allocated for scene list
-	SceneObject * next = m_objects.GetHead();
-	while(next != NULL)
+	char scenePath[StringUtils::s_maxCharsPerLine];
+	GetSceneFilePath(a_scenePath, scenePath);
+	GameFile sceneFile(scenePath);
+	GameFile::Object * sceneObject = sceneFile.FindObject(STRING_HASH("scene"));
+	if (sceneObject == NULL)
 	{
-		// Cache off next pointer
-		SceneObject * cur = next;
-		next = cur->GetNext();
-
-		m_objects.Remove(cur);
-		delete cur->GetData();
-		delete cur;
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot compile scene file %s, no valid scene parent element.", scenePath);
+		return false;
 	}
-}
 
-void Scene::AddObject(GameObject * a_newObject)
-{
-	// TODO Scene objects should also have a heap, implement memory management
-	if (SceneObject * newSceneObject = new SceneObject())
+	// Templates are read and their models loaded to find the textures they use
+	TemplateMap templates;
+	GameFile::Object * childGameObject = sceneObject->m_firstChild;
+	while (childGameObject != NULL)
 	{
-		newSceneObject->SetData(a_newObject);
-		a_newObject->Startup();
-		a_newObject->SetState(GameObject::eGameObjectState_Active);
-		m_objects.Insert(newSceneObject);
+		ReadSceneObjectTemplates(childGameObject, templates);
+		childGameObject = childGameObject->m_next;
+	}
 
-		++m_numObjects;
+	const bool compiled = WriteBinaryScene(scenePath, sceneFile, templates);
+	MemoryManager & memMan = MemoryManager::Get();
+	for (TemplateMap::Iterator it = templates.Begin(); it != templates.End(); ++it)
+	{
+		memMan.Delete(MemoryManager::eArenaWorld, it.GetValue());
 	}
+	return compiled;
 }
 
-GameObject * Scene::GetSceneObject(unsigned int a_objectId)
+bool WorldManager::WriteBinaryScene(const char * a_scenePath, GameFile & a_sceneFile, TemplateMap & a_templates)
 {
-	// Iterate through all objects in the scene
-	SceneObject * curObject = m_objects.GetHead();
-	while (curObject != NULL)
+	GameFile::Object * sceneObject = a_sceneFile.FindObject(STRING_HASH("scene"));
+	if (sceneObject == NULL ||
+		a_sceneFile.FindProperty(sceneObject, STRING_HASH("name")) == NULL ||
+		a_sceneFile.FindProperty(sceneObject, STRING_HASH("beginLoaded")) == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot compile scene file %s, scene does not have required properties.", a_scenePath);
+		return false;
+	}
+	const bool parallelUpdate = a_sceneFile.FindProperty(sceneObject, STRING_HASH("parallelUpdate")) != NULL && a_sceneFile.GetBool("scene", "parallelUpdate");
+
+	// One record for each template with the model's texture resolved
+	MemoryManager & memMan = MemoryManager::Get();
+	const unsigned int numTemplates = a_templates.GetCount();
+	BinaryScene::Template * templates = (BinaryScene::Template *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(BinaryScene::Template) * (numTemplates > 0 ? numTemplates : 1));
+	if (templates == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot compile scene file %s, unable to allocate memory for %u templates.", a_scenePath, numTemplates);
+		return false;
+	}
+	HashMap<unsigned int, unsigned int> templateIndices;
+	const char * texturePath = TextureManager::Get().GetTexturePath();
+	const size_t texturePathLength = strlen(texturePath);
+	unsigned int templateIndex = 0;
+	for (TemplateMap::Iterator it = a_templates.Begin(); it != a_templates.End(); ++it)
 	{
-		// To find a target with a specific id
-		GameObject * gameObject = curObject->GetData();
-		if (gameObject->GetId() == a_objectId)
+		BinaryScene::Template & curTemplate = templates[templateIndex];
+		curTemplate = BinaryScene::Template();
+		GameFile * templateFile = it.GetValue();
+		if (!BinaryScene::ReadTemplate(*templateFile, curTemplate))
 		{
-			return gameObject;
+			continue;
 		}
-	
-		curObject = curObject->GetNext();
+
+		// The name objects use for the template is filled in when the objects are flattened
+		FileManager::Get().GetFileTimeStamp(templateFile->GetFilePath(), curTemplate.m_timeStamp);
+		templateIndices.Insert(it.GetKey(), templateIndex);
+
+		// Texture paths are kept relative to the texture dir so the compiled scene works on any machine
+		if (curTemplate.m_model != NULL)
+		{
+			Model * model = ModelManager::Get().GetModel(curTemplate.m_model);
+			Texture * texture = model != NULL ? model->GetDiffuseTexture() : NULL;
+			if (texture != NULL)
+			{
+				const char * texturePathFull = texture->GetFilePath();
+				curTemplate.m_texture = strncmp(texturePathFull, texturePath, texturePathLength) == 0 ? texturePathFull + texturePathLength : texturePathFull;
+			}
+		}
+		++templateIndex;
 	}
 
-	return NULL;
+	// Count the objects first so the records can be gathered in one allocation
+	unsigned int numObjects = 0;
+	for (GameFile::Object * fileObject = sceneObject->m_firstChild; fileObject != NULL; fileObject = fileObject->m_next)
+	{
+		FlattenSceneObject(fileObject, -1, templateIndices, NULL, NULL, numObjects);
+	}
+	BinaryScene::Object * objects = (BinaryScene::Object *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(BinaryScene::Object) * (numObjects > 0 ? numObjects : 1));
+	if (objects == NULL)
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot compile scene file %s, unable to allocate memory for %u objects.", a_scenePath, numObjects);
+		memMan.Free(MemoryManager::eArenaWorld, templates);
+		return false;
+	}
+	unsigned int objectIndex = 0;
+	for (GameFile::Object * fileObject = sceneObject->m_firstChild; fileObject != NULL; fileObject = fileObject->m_next)
+	{
+		FlattenSceneObject(fileObject, -1, templateIndices, templates, objects, objectIndex);
+	}
+
+	FileManager::Timestamp sourceTimeStamp;
+	FileManager::Get().GetFileTimeStamp(a_scenePath, sourceTimeStamp);
+	char binaryPath[StringUtils::s_maxCharsPerLine];
+	GetBinarySceneFilePath(a_scenePath, binaryPath);
+	const bool written = BinaryScene::Write(binaryPath, a_sceneFile.GetString("scene", "name"), a_sceneFile.GetBool("scene", "beginLoaded"), parallelUpdate, sourceTimeStamp,
+											templates, templateIndex, objects, numObjects);
+	memMan.Free(MemoryManager::eArenaWorld, templates);
+	memMan.Free(MemoryManager::eArenaWorld, objects);
+	return written;
 }
 
-GameObject * Scene::GetSceneObject(Vector a_worldPos)
+void WorldManager::FlattenSceneObject(GameFile::Object * a_fileObject, int a_parent, HashMap<unsigned int, unsigned int> & a_templateIndices, 
+									  BinaryScene::Template * a_templates_OUT, BinaryScene::Object * a_objects_OUT, unsigned int & a_numObjects_OUT)
 {
-	// Iterate through all objects in the scene
-	SceneObject * curObject = m_objects.GetHead();
-	while (curObject != NULL)
+	// Objects with a template that couldn't be read are left out along with their children, as they would be loading the text scene
+	GameFile::Property * prop = a_fileObject->FindProperty(STRING_HASH("template"));
+	unsigned int templateIndex = 0;
+	if (prop == NULL || !a_templateIndices.Get(StringHash::GenerateCRC(prop->GetString(), false), templateIndex))
 	{
-		// To the first object that intersects with a point
-		GameObject * gameObject = curObject->GetData();
-		if (gameObject->CollidesWith(a_worldPos))
-		{
-			return gameObject;
-		}
-	
-		curObject = curObject->GetNext();
+		return;
 	}
 
-	return NULL;
+	const unsigned int objectIndex = a_numObjects_OUT++;
+	if (a_objects_OUT != NULL)
+	{
+		GameFile::Property * name = a_fileObject->FindProperty(STRING_HASH("name"));
+		GameFile::Property * pos = a_fileObject->FindProperty(STRING_HASH("pos"));
+		BinaryScene::Object & curObject = a_objects_OUT[objectIndex];
+		curObject.m_name = name != NULL ? name->GetString() : NULL;
+		curObject.m_template = templateIndex;
+		curObject.m_parent = a_parent;
+		curObject.m_localPos = pos != NULL ? pos->GetVector() : Vector::Zero();
+		a_templates_OUT[templateIndex].m_path = prop->GetString();
+	}
+
+	// Children follow their parent so the parent is always created first
+	for (GameFile::Object * childObject = a_fileObject->m_firstChild; childObject != NULL; childObject = childObject->m_next)
+	{
+		FlattenSceneObject(childObject, (int)objectIndex, a_templateIndices, a_templates_OUT, a_objects_OUT, a_numObjects_OUT);
+	}
 }
 
-GameObject *Scene::GetSceneObject(Vector a_lineStart, Vector a_lineEnd)
+bool WorldManager::IsBinarySceneCurrent(const BinaryScene & a_binaryScene, const char * a_scenePath)
 {
-	// Iterate through all objects in the scene
-	SceneObject * curObject = m_objects.GetHead();
-	while (curObject != NULL)
+	// A compiled scene shipped without the text is always used
+	FileManager & fileMan = FileManager::Get();
+	FileManager::Timestamp curTimeStamp;
+	if (fileMan.GetFileTimeStamp(a_scenePath, curTimeStamp) && !IsSameTimeStamp(curTimeStamp, a_binaryScene.GetSourceTimeStamp()))
+	{
+		return false;
+	}
+
+	// Templates only used by objects that were left out have no name
+	for (unsigned int i = 0; i < a_binaryScene.GetNumTemplates(); ++i)
 	{
-		// To the first object that intersects with a point
-		GameObject * gameObject = curObject->GetData();
-		if (gameObject->CollidesWith(a_lineStart, a_lineEnd))
+		const BinaryScene::Template & curTemplate = a_binaryScene.GetTemplate(i);
+		if (curTemplate.m_path == NULL)
 		{
-			return gameObject;
+			continue;
+		}
+		char templatePath[StringUtils::s_maxCharsPerLine];
+		GetTemplateFilePath(curTemplate.m_path, templatePath);
+		if (fileMan.GetFileTimeStamp(templatePath, curTimeStamp) && !IsSameTimeStamp(curTimeStamp, curTemplate.m_timeStamp))
+		{
+			return false;
 		}
-	
-		curObject = curObject->GetNext();
 	}
-
-	return NULL;
+	return true;
 }
 
-bool Scene::Update(float a_dt)
+void WorldManager::GetSceneFilePath(const char * a_scenePath, char * a_fileName_OUT)
 {
-	// Iterate through all objects in the scene and update state
-	bool updateSuccess = true;
-	SceneObject * curObject = m_objects.GetHead();
-	while (curObject != NULL)
+	// Scene paths are either fully qualified or relative to the config scene dir
+	if (!strstr(a_scenePath, ":\\"))
 	{
-		GameObject * gameObject = curObject->GetData();
-		updateSuccess &= gameObject->Update(a_dt);
-
-		curObject = curObject->GetNext();
+		sprintf(a_fileName_OUT, "%s%s", m_scenePath, a_scenePath);
+	}
+	else
+	{
+		sprintf(a_fileName_OUT, "%s", a_scenePath);
+	}
+	if (!strstr(a_fileName_OUT, ".scn"))
+	{
+		strcat(a_fileName_OUT, ".scn");
 	}
-
-	// Now state and position have been updated, submit resources to be rendered
-	bool drawSuccess = Draw();
-
-	return updateSuccess && drawSuccess;
 }
 
-void Scene::Serialise()
+void WorldManager::LoadBinarySceneObject(SceneLoad * a_sceneLoad)
 {
-	// Construct the path from the scene directory and name of the scene
-	char scenePath[StringUtils::s_maxCharsPerLine];
-	sprintf(scenePath, "%s/%s.scn", WorldManager::Get().GetScenePath(), m_name);
-
-	// Create an output stream
-	GameFile * sceneFile = new GameFile();
+	const BinaryScene & binaryScene = *a_sceneLoad->m_binaryScene;
+	const unsigned int objectIndex = a_sceneLoad->m_nextBinaryObject++;
+	const BinaryScene::Object & fileObject = binaryScene.GetObject(objectIndex);
+	const BinaryScene::Template & objectTemplate = binaryScene.GetTemplate(fileObject.m_template);
 
-	GameFile::Object * sceneObject = sceneFile->AddObject("scene");
-	sceneFile->AddProperty(sceneObject, "name", m_name);
-	sceneFile->AddProperty(sceneObject, "beginLoaded", StringUtils::BoolToString(m_beginLoaded));
-	
-	// Add each object in the scene
-	SceneObject * curObject = m_objects.GetHead();
-	while (curObject != NULL)
+	// Children of objects that failed to create are skipped as they would be loading the text scene
+	GameObject * parent = fileObject.m_parent >= 0 ? a_sceneLoad->m_binaryObjects[fileObject.m_parent] : NULL;
+	GameObject * newObject = NULL;
+	if (fileObject.m_parent < 0 || parent != NULL)
 	{
-		// Alias the game object in the scene
-		GameObject * childGameObject = curObject->GetData();
-		
-		// Only if the object has a template for loading can it be saved
-		if (childGameObject->HasTemplate())
+		newObject = CreateObject<GameObject>(objectTemplate, a_sceneLoad->m_scene);
+	}
+	a_sceneLoad->m_binaryObjects[objectIndex] = newObject;
+	if (newObject != NULL)
+	{
+		newObject->SetTemplate(objectTemplate.m_path);
+		if (fileObject.m_name != NULL)
 		{
-			// Add the object to the game file
-			childGameObject->Serialise(sceneFile, sceneObject);
+			newObject->SetName(fileObject.m_name);
 		}
-		else
+
+		// Children are saved with their position relative to the parent
+		if (parent != NULL)
 		{
-			Log::Get().Write(Log::LL_WARNING, Log::LC_ENGINE, "Game object called %s will not be saved in the scene as it does not have a source template.", childGameObject->GetName());
+			parent->AddChild(newObject, false);
 		}
-			
-		curObject = curObject->GetNext();
+		newObject->SetLocalPos(fileObject.m_localPos);
 	}
-
-	// Write all the data to a file
-	sceneFile->Write(scenePath);
-	delete sceneFile;
 }
 
-bool Scene::Draw()
+void WorldManager::ReadSceneObjectTemplates(GameFile::Object * a_fileObject, TemplateMap & a_templates_OUT)
 {
-	// Iterate through all objects in the scene and update state
-	bool drawSuccess = true;
-	SceneObject * curObject = m_objects.GetHead();
-	while (curObject != NULL)
+	GameFile::Property * prop = a_fileObject->FindProperty(STRING_HASH("template"));
+	const unsigned int templateHash = prop != NULL ? StringHash::GenerateCRC(prop->GetString(), false) : 0;
+	if (prop != NULL && !a_templates_OUT.Contains(templateHash))
 	{
-		GameObject * gameObject = curObject->GetData();
-		drawSuccess &= gameObject->Draw();
+		char fileNameBuf[StringUtils::s_maxCharsPerLine];
+		WorldManager::Get().GetTemplateFilePath(prop->GetString(), fileNameBuf);
+		MemoryManager & memMan = MemoryManager::Get();
+		GameFile * templateFile = memMan.New<GameFile>(MemoryManager::eArenaWorld);
+		if (templateFile != NULL && templateFile->Load(fileNameBuf) && templateFile->IsLoaded())
+		{
+			a_templates_OUT.Insert(templateHash, templateFile);
 
-		curObject = curObject->GetNext();
+			// The model manager keeps the model so creating the object finds it already loaded
+			GameFile::Object * object = templateFile->FindObject(STRING_HASH("gameObject"));
+			GameFile::Property * model = object != NULL ? object->FindProperty(STRING_HASH("model")) : NULL;
+			if (model != NULL)
+			{
+				ModelManager::Get().GetModel(model->GetString());
+			}
+		}
+		else // Creation will try the file again and report the error
+		{
+			memMan.Delete(MemoryManager::eArenaWorld, templateFile);
+		}
 	}
 
-	return drawSuccess;
+	// Then the objects attached to this one
+	GameFile::Object * childObject = a_fileObject->m_firstChild;
+	while (childObject != NULL)
+	{
+		ReadSceneObjectTemplates(childObject, a_templates_OUT);
+		childObject = childObject->m_next;
+	}
 }
 
-bool WorldManager::LoadScene(const char * a_scenePath, Scene * a_sceneToLoad_OUT)
+void WorldManager::UpdateStreaming(unsigned int a_budgetMs)
 {
-	// Quick safety check
-	if (a_sceneToLoad_OUT != NULL)
+	// Textures decoded by the workers go to GL first so objects don't show untextured
+	const unsigned int startTime = Time::GetSystemTime();
+	TextureManager & texMan = TextureManager::Get();
+	texMan.UploadPendingTextures(a_budgetMs);
+	MemoryManager & memMan = MemoryManager::Get();
+
+	SceneLoadNode * next = m_sceneLoads.GetHead();
+	while (next != NULL)
 	{
-		GameFile * sceneFile = new GameFile();
-		sceneFile->Load(a_scenePath);
+		SceneLoadNode * cur = next;
+		next = cur->GetNext();
+		SceneLoad * sceneLoad = cur->GetData();
+		if (!sceneLoad->m_counter.IsDone())
+		{
+			continue;
+		}
+
+		// Scenes that failed, weren't wanted or were unloaded while streaming go now, the worker will have reported any error
+		if (!sceneLoad->m_loadOk || sceneLoad->m_unloadRequested)
+		{
+			m_sceneLoads.Remove(cur);
+			memMan.Delete(MemoryManager::eArenaWorld, cur);
+			FreeSceneLoad(sceneLoad);
+			continue;
+		}
 
-		// Create a new widget and copy properties from file
-		if (GameFile::Object * sceneObject = sceneFile->FindObject("scene"))
+		// Create objects until out of time, from the compiled scene one at a time or from the text whole objects with their children
+		Scene * scene = sceneLoad->m_scene;
+		BinaryScene * binaryScene = sceneLoad->m_binaryScene;
+		if (binaryScene != NULL)
 		{
-			// Set various properties of a scene
-			bool propsOk = true;
-			if (sceneFile->FindProperty(sceneObject, "name") &&
-				sceneFile->FindProperty(sceneObject, "beginLoaded"))
+			while (sceneLoad->m_nextBinaryObject < binaryScene->GetNumObjects() && Time::GetSystemTime() - startTime < a_budgetMs)
 			{
-				a_sceneToLoad_OUT->SetName(sceneFile->GetString("scene", "name"));
-				a_sceneToLoad_OUT->SetBeginLoaded(sceneFile->GetBool("scene", "beginLoaded"));
+				LoadBinarySceneObject(sceneLoad);
 			}
-			else
+		}
+		else
+		{
+			while (sceneLoad->m_nextObject != NULL && Time::GetSystemTime() - startTime < a_budgetMs)
 			{
-				propsOk = false;
+				LoadSceneObject(sceneLoad->m_nextObject, scene, NULL, &sceneLoad->m_templates);
+				sceneLoad->m_nextObject = sceneLoad->m_nextObject->m_next;
 			}
+		}
+		const bool objectsCreated = binaryScene != NULL ? sceneLoad->m_nextBinaryObject >= binaryScene->GetNumObjects() : sceneLoad->m_nextObject == NULL;
+
+		// Objects can hold textures from their models that are still waiting to upload
+		if (objectsCreated && texMan.GetNumPendingUploads() == 0)
+		{
+			// Attached objects were positioned relative to their parents
+			scene->UpdateTransforms();
+
+			// Objects were added one at a time so build the line trace tree again for the final layout
+			scene->RebuildObjectTree();
 
-			// Load child game objects of the scene
-			GameFile::Object * childGameObject = sceneObject->m_firstChild;
-			while (childGameObject != NULL)
+			// Hand the scene to the world, it waits for the next update if there isn't memory to list it
+			SceneNode * newSceneNode = memMan.New<SceneNode>(MemoryManager::eArenaWorld);
+			if (newSceneNode == NULL)
 			{
-				if (GameFile::Property * prop = childGameObject->FindProperty("template"))
-				{
-					if (GameObject * newObject = CreateObject<GameObject>(prop->GetString(), a_sceneToLoad_OUT))
-					{
-						newObject->SetTemplate(prop->GetString());
-						newObject->SetName(childGameObject->FindProperty("name")->GetString());
-						newObject->SetPos(childGameObject->FindProperty("pos")->GetVector());
-						a_sceneToLoad_OUT->AddObject(newObject);
-					}
-				}
-				
-				childGameObject = childGameObject->m_next;
+				Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to add scene %s to the world.", sceneLoad->m_path);
+				continue;
 			}
-
-			// No properties present
-			if (!propsOk) 
+			scene->SetState(Scene::eSceneState_Active);
+			newSceneNode->SetData(scene);
+			m_scenes.Insert(newSceneNode);
+			if (m_currentScene == NULL)
 			{
-				Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Error loading scene file %s, scene does not have required properties.", a_scenePath);
-				return false;
+				m_currentScene = scene;
 			}
-		}
-		else // Unexpected file format, no root element
-		{
-			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Error loading scene file %s, no valid scene parent element.", a_scenePath);
-			return false;
+
+			sceneLoad->m_scene = NULL;
+			m_sceneLoads.Remove(cur);
+			memMan.Delete(MemoryManager::eArenaWorld, cur);
+			FreeSceneLoad(sceneLoad);
 		}
 	}
-	else // No valid scene to write into
+}
+
+void WorldManager::FreeSceneLoad(SceneLoad * a_sceneLoad)
+{
+	MemoryManager & memMan = MemoryManager::Get();
+	for (TemplateMap::Iterator it = a_sceneLoad->m_templates.Begin(); it != a_sceneLoad->m_templates.End(); ++it)
 	{
-		Log::Get().WriteEngineErrorNoParams("Scene load failed because there is no place in memory to write to.");
-		return false;
+		memMan.Delete(MemoryManager::eArenaWorld, it.GetValue());
 	}
-
-	return true;
+	memMan.Delete(MemoryManager::eArenaWorld, a_sceneLoad->m_sceneFile);
+	memMan.Delete(MemoryManager::eArenaWorld, a_sceneLoad->m_binaryScene);
+	memMan.Free(MemoryManager::eArenaWorld, a_sceneLoad->m_binaryObjects);
+	memMan.Delete(MemoryManager::eArenaWorld, a_sceneLoad->m_scene);
+	memMan.Delete(MemoryManager::eArenaWorld, a_sceneLoad);
 }
 
 bool WorldManager::Startup(const char * a_templatePath, const char * a_scenePath)
 {
+	// All game objects live in one contiguous pool, each can only be queued for destruction once so the queue is the same size
+	// Objects being created in batches are in the pool as well so their stack is the same size too
+	MemoryManager & memMan = MemoryManager::Get();
+	m_destroyQueue = (unsigned int *)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(unsigned int) * s_maxGameObjects);
+	m_newObjects = (GameObject **)memMan.Allocate(MemoryManager::eArenaWorld, sizeof(GameObject *) * s_maxGameObjects);
+	if (m_destroyQueue == NULL || m_newObjects == NULL || !m_objectPool.Init(s_maxGameObjects))
+	{
+		Log::Get().WriteEngineErrorNoParams("WorldManager failed to allocate the game object pool!");
+		memMan.Free(MemoryManager::eArenaWorld, m_destroyQueue);
+		memMan.Free(MemoryManager::eArenaWorld, m_newObjects);
+		m_destroyQueue = NULL;
+		m_newObjects = NULL;
+		return false;
+	}
+	m_numDestroyQueued = 0;
+	m_numNewObjects = 0;
+
 	// Cache off the template path for non qualified loading of game object
 	memset(&m_templatePath, 0 , StringUtils::s_maxCharsPerLine);
 	strncpy(m_templatePath, a_templatePath, strlen(a_templatePath));
@@ -244,39 +1989,16 @@ bool WorldManager::Startup(const char * a_templatePath, const char * a_scenePath
 	FileManager::FileList sceneFiles;
 	FileManager::Get().FillFileList(m_scenePath, sceneFiles, ".scn");
 
-	// Load each scene in the directory
-	unsigned int numSceneFiles = 0;
+	// Stream in each scene in the directory that is set to begin loaded, the first to finish becomes the current scene
 	FileManager::FileListNode * curNode = sceneFiles.GetHead();
 	while(curNode != NULL)
 	{
-		char fullPath[StringUtils::s_maxCharsPerLine];
-		sprintf(fullPath, "%s%s", a_scenePath, curNode->GetData()->m_name);
-		
-		// Add to the loaded scenes if begin loaded
-		// TODO Implement memory management
-		Scene * newScene = new Scene();
-		if (LoadScene(fullPath, newScene))
-		{
-			if (newScene->IsBeginLoaded())
-			{
-				// Insert into list
-				SceneNode * newSceneNode = new SceneNode();
-				newSceneNode->SetData(newScene);
-				m_scenes.Insert(newSceneNode);
-
-				// Set current scene to the first loaded scene
-				if (m_currentScene == NULL)
-				{
-					m_currentScene = newScene;
-				}
-			}
-
-			++numSceneFiles;
-		}
-		else
+		// Compiled scenes are found through their text scene
+		if (!strstr(curNode->GetData()->m_name, ".scnb"))
 		{
-			// Clean up the scene, the load will report the error
-			delete newScene;
+			char fullPath[StringUtils::s_maxCharsPerLine];
+			sprintf(fullPath, "%s%s", a_scenePath, curNode->GetData()->m_name);
+			RequestLoad(fullPath, true);
 		}
 		curNode = curNode->GetNext();
 	}
@@ -284,14 +2006,32 @@ bool WorldManager::Startup(const char * a_templatePath, const char * a_scenePath
 	// Clean up the list of fonts
 	FileManager::Get().EmptyFileList(sceneFiles);
 
+	// Startup waits for the first scenes with no time limit, the main thread helps with the reading while it waits
+	for (SceneLoadNode * curLoad = m_sceneLoads.GetHead(); curLoad != NULL; curLoad = curLoad->GetNext())
+	{
+		JobManager::Get().Wait(curLoad->GetData()->m_counter);
+	}
+	while (IsStreaming())
+	{
+		UpdateStreaming(UINT_MAX);
+	}
+
 	// If no scenes, setup the default scene
-	if (numSceneFiles == 0)
+	if (m_scenes.IsEmpty())
 	{
 		Log::Get().WriteEngineErrorNoParams("No scene files or no scenes set to start on load, creating a default scene.");
-		Scene * newScene = new Scene();
+		Scene * newScene = memMan.New<Scene>(MemoryManager::eArenaWorld);
+		SceneNode * newSceneNode = memMan.New<SceneNode>(MemoryManager::eArenaWorld);
+		if (newScene == NULL || newSceneNode == NULL)
+		{
+			Log::Get().WriteEngineErrorNoParams("Unable to allocate memory for the default scene.");
+			memMan.Delete(MemoryManager::eArenaWorld, newScene);
+			memMan.Delete(MemoryManager::eArenaWorld, newSceneNode);
+			return false;
+		}
 		newScene->SetBeginLoaded(true);
 		newScene->SetName("defaultScene");
-		SceneNode * newSceneNode = new SceneNode();
+		newScene->SetState(Scene::eSceneState_Active);
 		newSceneNode ->SetData(newScene);
 		m_scenes.Insert(newSceneNode);
 		m_currentScene = newScene;
@@ -303,6 +2043,30 @@ bool WorldManager::Startup(const char * a_templatePath, const char * a_scenePath
 
 bool WorldManager::Shutdown()
 {
+	// Objects already on their way out go first
+	FlushDestroyedObjects();
+	MemoryManager & memMan = MemoryManager::Get();
+	memMan.Free(MemoryManager::eArenaWorld, m_destroyQueue);
+	memMan.Free(MemoryManager::eArenaWorld, m_newObjects);
+	m_destroyQueue = NULL;
+	m_newObjects = NULL;
+
+	// Scenes still streaming are dropped once their workers are done with them, jobs don't run once the job system has stopped
+	SceneLoadNode * nextLoad = m_sceneLoads.GetHead();
+	while (nextLoad != NULL)
+	{
+		SceneLoadNode * curLoad = nextLoad;
+		nextLoad = curLoad->GetNext();
+		if (JobManager::Get().IsRunning())
+		{
+			JobManager::Get().Wait(curLoad->GetData()->m_counter);
+		}
+
+		m_sceneLoads.Remove(curLoad);
+		FreeSceneLoad(curLoad->GetData());
+		memMan.Delete(MemoryManager::eArenaWorld, curLoad);
+	}
+
 	// Cleanup memory allocated for scene objects
 	SceneNode * next = m_scenes.GetHead();
 	while(next != NULL)
@@ -312,50 +2076,203 @@ bool WorldManager::Shutdown()
 		next = cur->GetNext();
 
 		m_scenes.Remove(cur);
-		delete cur->GetData();
-		delete cur;
+		memMan.Delete(MemoryManager::eArenaWorld, cur->GetData());
+		memMan.Delete(MemoryManager::eArenaWorld, cur);
 	}
 
 	// Clear the current scene as it's data has been cleared
 	m_currentScene = NULL;
+	ClearPrototypes();
+
+	// All objects have been returned by the scenes so the pool can go
+	m_objectPool.Done();
 
 	return true;
 }
 
 bool WorldManager::Update(float a_dt)
 {
-	// Iterate through all loaded scenes and update them
-	bool updateOk = true;
+	// Drawing blends from where the objects are before the step to where they end up, anything in the step can move them
 	SceneNode * next = m_scenes.GetHead();
 	while(next != NULL)
 	{
-		updateOk &= next->GetData()->Update(a_dt);
+		if (next->GetData()->IsActive())
+		{
+			next->GetData()->StorePrevWorldMats();
+		}
+		next = next->GetNext();
+	}
+
+	// Iterate through all loaded scenes and update the active ones
+	bool updateOk = true;
+	next = m_scenes.GetHead();
+	while(next != NULL)
+	{
+		if (next->GetData()->IsActive())
+		{
+			updateOk &= next->GetData()->Update(a_dt);
+		}
 		next = next->GetNext();
 	}
 
 	return updateOk;
 }
 
-GameObject * WorldManager::GetGameObject(unsigned int a_objectId)
+void WorldManager::UpdateFrame(float a_dt)
+{
+	// Templates edited on disk are picked up by the next object created from them
+	UpdatePrototypes(a_dt);
+
+	// Scenes streaming in get a slice of the frame
+	if (IsStreaming() || TextureManager::Get().GetNumPendingUploads() > 0)
+	{
+		UpdateStreaming(m_streamingBudgetMs);
+	}
+}
+
+bool WorldManager::Draw(float a_interpolation)
+{
+	bool drawOk = true;
+	SceneNode * next = m_scenes.GetHead();
+	while(next != NULL)
+	{
+		if (next->GetData()->IsActive())
+		{
+			drawOk &= next->GetData()->Draw(a_interpolation);
+		}
+		next = next->GetNext();
+	}
+	return drawOk;
+}
+
+bool WorldManager::DestroyObject(unsigned int a_objectId)
+{
+	// Stale or invalid handles fail here
+	GameObject * object = m_objectPool.Get(a_objectId);
+	if (object == NULL)
+	{
+		return false;
+	}
+
+	// The serial pass of a verified update has it's states restored and is run again, the parallel pass claims the object
+	if (GetVerifyingScene() != NULL)
+	{
+		object->SetState(GameObject::eGameObjectState_Death);
+		return true;
+	}
+
+	// Objects on their way out are only queued once, only the first caller from any thread claims the object
+	if (InterlockedCompareExchange(&object->m_destroyQueued, 1, 0) != 0)
+	{
+		return true;
+	}
+
+	// Reserve a slot before checking the bound so two threads can't both take the last one, an overflow gives the slot and the claim back
+	const LONG queueIndex = InterlockedIncrement(&m_numDestroyQueued) - 1;
+	if (m_destroyQueue == NULL || (unsigned int)queueIndex >= s_maxGameObjects)
+	{
+		InterlockedDecrement(&m_numDestroyQueued);
+		InterlockedExchange(&object->m_destroyQueued, 0);
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot destroy object %s, the destroy queue is full.", object->GetName());
+		return false;
+	}
+	m_destroyQueue[queueIndex] = a_objectId;
+
+	// The scene moves the object to it's dying partition so it is no longer updated or drawn
+	object->SetState(GameObject::eGameObjectState_Death);
+	return true;
+}
+
+void WorldManager::FlushDestroyedObjects()
 {
-	// First try to find the object in the current scene
-	if (GameObject * foundObject = m_currentScene->GetSceneObject(a_objectId))
+	const unsigned int numQueued = (unsigned int)m_numDestroyQueued;
+	if (numQueued == 0)
 	{
-		return foundObject;
+		return;
 	}
-	else // Look through each scene for the target object
+
+	// Shutdown every object first so they can still find each other while cleaning up, handles gone stale since queuing are skipped
+	for (unsigned int i = 0; i < numQueued; ++i)
 	{
-		SceneNode * next = m_scenes.GetHead();
-		while(next != NULL)
+		if (GameObject * object = m_objectPool.Get(m_destroyQueue[i]))
 		{
-			if (GameObject * foundObject = next->GetData()->GetSceneObject(a_objectId))
+			object->Shutdown();
+			object->RemoveAllComponents();
+
+			// Attached objects are left where they are in the world
+			if (GameObject * parent = object->GetParent())
 			{
-				return foundObject;
+				parent->RemoveChild(object);
 			}
-			next = next->GetNext();
+			object->RemoveAllChildren();
+		}
+	}
+
+	// Then unlink them from their scenes, dying objects are at the back of the dense array so each removal is a swap or two
+	for (unsigned int i = 0; i < numQueued; ++i)
+	{
+		GameObject * object = m_objectPool.Get(m_destroyQueue[i]);
+		if (object != NULL && object->GetScene() != NULL)
+		{
+			object->GetScene()->RemoveObject(object);
+		}
+	}
+
+	// Finally return the memory, bumping the generation of each handle
+	for (unsigned int i = 0; i < numQueued; ++i)
+	{
+		m_objectPool.Free(m_destroyQueue[i]);
+	}
+	m_numDestroyQueued = 0;
+}
+
+Scene * WorldManager::GetParallelUpdateScene()
+{
+	for (SceneNode * curNode = m_scenes.GetHead(); curNode != NULL; curNode = curNode->GetNext())
+	{
+		if (curNode->GetData()->IsUpdatingInParallel())
+		{
+			return curNode->GetData();
 		}
 	}
+	return NULL;
+}
 
-	// Failure case
+Scene * WorldManager::GetVerifyingScene()
+{
+	for (SceneNode * curNode = m_scenes.GetHead(); curNode != NULL; curNode = curNode->GetNext())
+	{
+		if (curNode->GetData()->IsVerifyingSerialUpdate())
+		{
+			return curNode->GetData();
+		}
+	}
 	return NULL;
 }
+
+bool WorldManager::CanCreateObjects(const char * a_templatePath)
+{
+	// The serial pass of a verified update is run again in parallel, objects are created then
+	if (GetVerifyingScene() != NULL)
+	{
+		return false;
+	}
+
+	// Objects that create others have to update on the main thread, after the chunks are done
+	if (Scene * updatingScene = GetParallelUpdateScene())
+	{
+		Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Cannot create an object from template %s during a parallel update of scene %s, objects that create others should update on the main thread.",
+						 a_templatePath != NULL ? a_templatePath : "default", updatingScene->GetName());
+		return false;
+	}
+	return true;
+}
+
+void WorldManager::FreeObject(GameObject * a_object)
+{
+	if (a_object != NULL)
+	{
+		a_object->Shutdown();
+		m_objectPool.Free(a_object);
+	}
+}
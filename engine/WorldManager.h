@@ -4,10 +4,18 @@
 #include <iostream>
 #include <fstream>
 
+#include "../core/BoundingVolumeHierarchy.h"
+#include "../core/HashMap.h"
+#include "../core/JobSystem.h"
 #include "../core/LinkedList.h"
+#include "../core/ObjectPool.h"
+#include "../core/SpatialHashGrid.h"
+#include "../core/SweepAndPrune.h"
 
+#include "BinaryScene.h"
 #include "GameObject.h"
 #include "Log.h"
+#include "SceneSnapshot.h"
 #include "Singleton.h"
 #include "StringUtils.h"
 
@@ -27,18 +35,74 @@ public:
 		eSceneState_Count,
 	};
 
+	//\brief Ways a sleeping object can be woken without anything calling SetActive on it
+	enum eWakeTrigger
+	{
+		eWakeTriggerTimer = 0,		///< Wake once a time has passed
+		eWakeTriggerProximity,		///< Wake when an active object comes within a radius
+		eWakeTriggerEvent,			///< Wake when an event is sent to the scene
+
+		eWakeTriggerCount,
+	};
+
+	//\brief Where a line traced through the scene touched an object
+	struct LineHit
+	{
+		GameObject * m_object;	///< The object hit, NULL for lines in a batch that hit nothing
+		float m_fraction;		///< How far along the line the hit is, 0 at the start and 1 at the end
+		float m_distance;		///< Distance from the start of the line to the hit in world units
+		Vector m_point;			///< Where the line first touches the object's clip volume
+	};
+
 	//\brief Set scene count to 0 on construction
 	Scene() 
-		: m_numObjects(0)
+		: m_objects(NULL)
+		, m_objectIndices(NULL)
+		, m_gridItems(NULL)
+		, m_treeLeaves(NULL)
+		, m_broadphaseProxies(NULL)
+		, m_wakeTriggers(NULL)
+		, m_dirtyTransforms(NULL)
+		, m_transformQueue(NULL)
+		, m_addBounds(NULL)
+		, m_numObjects(0)
+		, m_numCulledObjects(0)
+		, m_numOverlaps(0)
+		, m_numWakeTriggers(0)
+		, m_maxWakeTriggers(0)
+		, m_numDirtyTransforms(0)
+		, m_maxAddBounds(0)
+		, m_commandBuffers(NULL)
+		, m_numCommandBuffers(0)
 		, m_state(eSceneState_Unloaded) 
 		, m_beginLoaded(false) 
-		{ sprintf(m_name, "scene01"); }
+		, m_parallelUpdate(false)
+		, m_verifyParallelUpdate(false)
+		, m_updatingInParallel(false)
+		, m_verifyingSerialUpdate(false)
+		, m_deferStateChanges(false)
+		{ 
+			sprintf(m_name, "scene01"); 
+			memset(&m_partitionEnds[0], 0, sizeof(unsigned int) * ePartitionCount);
+			memset(&m_stateChanges, 0, sizeof(CommandBuffer));
+		}
 
 	// Cleanup the of objects in the scene on destruction
 	~Scene();
 
-	//\brief Adding and removing objects from the scene
-	void AddObject(GameObject * a_newObject);
+	//\brief Adding and removing objects from the scene, removal moves the last object into the gap
+	//\return true if the object was added, objects that can't be added are left for the caller to free
+	bool AddObject(GameObject * a_newObject);
+	bool RemoveObject(GameObject * a_object);
+
+	//\brief Add many objects to the scene at once, they are inserted into the grid and tree in one go and then started
+	//\param a_newObjects array of a_numObjects objects that are not in a scene
+	//\return true if all the objects were added, none are added on failure
+	bool AddObjects(GameObject ** a_newObjects, unsigned int a_numObjects);
+
+	//\brief Get an object in the scene by id without searching
+	//\param a_objectId the unique game id of the object
+	//\return a pointer to the game object or NULL if the object is not in this scene
 	GameObject * GetSceneObject(unsigned int a_objectId);
 	
 	//\brief Get the first object in the scene that intersects with a point in worldspace
@@ -46,45 +110,387 @@ public:
 	//\return a pointer to a game object or NULL if no hits
 	GameObject * GetSceneObject(Vector a_worldPos);
 
-	//\brief Get the first object in the scene that intersects with a line segment
+	//\brief Get the closest object to the start of a line segment that the line touches
 	//\param a_lineStart the start of the line segment to check against
 	//\return a pointer to a game object or NULL if no hits
 	GameObject * GetSceneObject(Vector a_lineStart, Vector a_lineEnd);
 
-	//\brief TODO Stubbed out for implementation
-	GameObject * GetSceneObjects(Vector a_worldPos);
-	GameObject * GetSceneObjects(Vector a_lineStart, Vector a_lineEnd);
-
-	//\brief Update all the objects in the scene
+	//\brief Get the closest object along a line segment along with where it was hit
+	//\param a_hit_OUT is set to the object, distance and point of the closest hit
+	//\return true if the line touched any object
+	bool GetSceneObject(const Vector & a_lineStart, const Vector & a_lineEnd, LineHit & a_hit_OUT);
+
+	//\brief Get all the objects in the scene whose clip volume contains a point
+	//\param a_worldPos the point to check against
+	//\param a_results_OUT pointer to caller supplied storage for the objects found
+	//\param a_maxResults how many objects will fit in the storage, the search stops when it is full
+	//\return the number of objects written to the results
+	unsigned int GetSceneObjects(const Vector & a_worldPos, GameObject ** a_results_OUT, unsigned int a_maxResults);
+
+	//\brief Get all the objects in the scene whose bounds touch a sphere
+	//\param a_centre and a_radius describe the sphere to search
+	//\return the number of objects written to the results
+	unsigned int GetSceneObjectsInRadius(const Vector & a_centre, float a_radius, GameObject ** a_results_OUT, unsigned int a_maxResults);
+
+	//\brief Get all the objects in the scene whose bounds touch an axis aligned box
+	//\param a_min and a_max are the corners of the box to search
+	//\return the number of objects written to the results
+	unsigned int GetSceneObjectsInBox(const Vector & a_min, const Vector & a_max, GameObject ** a_results_OUT, unsigned int a_maxResults);
+
+	//\brief Get all the objects a line segment touches, nearest to the start of the line first
+	//\param a_hits_OUT pointer to caller supplied storage for the hits
+	//\param a_maxHits how many hits will fit in the storage, the trace stops when it is full. No more than
+	//		 256 hits are ever returned, a warning is logged if a trace is cut short by that limit
+	//\return the number of hits written
+	unsigned int GetSceneObjects(const Vector & a_lineStart, const Vector & a_lineEnd, LineHit * a_hits_OUT, unsigned int a_maxHits);
+
+	//\brief Get the closest object along each of a set of line segments, for line of sight checks from many places at once.
+	//		 The lines are traced through the tree together in packets so lines that start close to each other share the work.
+	//\param a_lineStarts, a_lineEnds arrays of a_numLines points describing each line
+	//\param a_hits_OUT array of a_numLines hits, the object is NULL for lines that touch nothing
+	//\return how many of the lines touched an object
+	unsigned int GetSceneObjects(const Vector * a_lineStarts, const Vector * a_lineEnds, unsigned int a_numLines, LineHit * a_hits_OUT);
+
+	//\brief Rebuild the tree used for line traces from scratch, for after many objects are added or moved a long way
+	inline void RebuildObjectTree() { m_objectTree.Rebuild(); }
+
+	//\brief Called by objects in the scene when their position or clip volume changes
+	//\param a_object the object whose bounds have changed
+	void UpdateObjectBounds(GameObject * a_object);
+
+	//\brief Called by objects in the scene when their state changes so only active objects are updated and drawn
+	//\param a_object the object whose state has changed
+	void UpdateObjectState(GameObject * a_object);
+
+	//\brief Wake a sleeping object when a condition is met, each trigger fires once and is then removed
+	//\param a_object the object to wake, triggers are dropped if it leaves the scene
+	//\param a_delay how many seconds until the object wakes
+	//\param a_radius how close an active object has to come to the object's position to wake it
+	//\param a_eventHash the hash of the event name that will wake the object when sent with SendWakeEvent
+	//\return true if the trigger was added
+	bool AddWakeTimer(GameObject * a_object, float a_delay);
+	bool AddWakeProximity(GameObject * a_object, float a_radius);
+	bool AddWakeEvent(GameObject * a_object, unsigned int a_eventHash);
+
+	//\brief Remove all the wake triggers for an object
+	void RemoveWakeTriggers(GameObject * a_object);
+
+	//\brief Wake every object waiting for an event, not safe to call from a parallel update
+	//\param a_eventHash the hash of the event name
+	//\return how many objects were woken
+	unsigned int SendWakeEvent(unsigned int a_eventHash);
+
+	//\brief Recalculate the world transforms of objects in hierarchies that have moved since the last time, along with
+	//		 everything attached below them. Called each update after objects have updated and before they are drawn.
+	void UpdateTransforms();
+
+	//\brief Called by objects in the scene when they start or stop asking to be told about overlaps
+	void UpdateObjectOverlaps(GameObject * a_object);
+
+	//\brief Get how many pairs of objects were overlapping after the last update, only pairs with an object reporting overlaps are counted
+	inline unsigned int GetNumOverlaps() { return m_numOverlaps; }
+
+	//\brief Move an object from another object's update, safe to call while the scene is updating in parallel
+	//\param a_object the object to move
+	//\param a_mat, a_pos where the object should be, applied after all objects have updated in a parallel update
+	void SetObjectWorldMat(GameObject * a_object, const Matrix & a_mat);
+	void SetObjectPos(GameObject * a_object, const Vector & a_pos);
+
+	//\brief Record where every object is before a simulation step so drawing can blend from there, the world
+	//		 does this for every active scene before anything in the step can move an object
+	void StorePrevWorldMats();
+
+	//\brief Update all the objects in the scene by one simulation step
 	bool Update(float a_dt);
 
+	//\brief Draw will cause active objects in the scene to submit resources to the render manager
+	//\param a_interpolation how far between the last two simulation steps the frame is, 0 to 1, objects are drawn blended between them
+	//\return true if resources were submitted without issue
+	bool Draw(float a_interpolation);
+
+	//\brief Parallel update splits the objects into chunks that update across the job system's threads.
+	//		 Objects may only change themselves in their update, moving other objects goes through 
+	//		 SetObjectWorldMat and objects that need more than that should update on the main thread.
+	//		 Creating objects is refused until the chunks are done, destroying them is safe from any thread.
+	//		 Spatial queries during a parallel update see where objects were before the update.
+	//		 Objects with a parent should move with SetLocalMat as SetWorldMat reads the parent's transform.
+	inline void SetParallelUpdate(bool a_parallel) { m_parallelUpdate = a_parallel; }
+	inline bool IsParallelUpdate() { return m_parallelUpdate; }
+
+	//\brief If chunks of objects in the scene are updating across threads right now
+	inline bool IsUpdatingInParallel() { return m_updatingInParallel; }
+
+	//\brief Run each update serially and then in parallel from the same start and report any objects that differ.
+	//		 The serial pass is thrown away so objects are only created and destroyed for real by the parallel pass.
+	inline void SetVerifyParallelUpdate(bool a_verify) { m_verifyParallelUpdate = a_verify; }
+	inline bool IsVerifyParallelUpdate() { return m_verifyParallelUpdate; }
+
+	//\brief If the scene is running the serial pass of a verified update, which is undone before the parallel pass
+	inline bool IsVerifyingSerialUpdate() { return m_verifyingSerialUpdate; }
+
 	//\brief Get the number of objects in the scene
 	//\return uint of the number of objects
 	inline unsigned int GetNumObjects() { return m_numObjects; }
+
+	//\brief Get how many more objects can be added before the scene is full
+	inline unsigned int GetNumFreeObjects() { return s_maxObjects - m_numObjects; }
+
+	//\brief Get how many objects are in each partition of the scene
+	inline unsigned int GetNumActiveObjects() { return m_partitionEnds[ePartitionActive]; }
+	inline unsigned int GetNumSleepingObjects() { return m_partitionEnds[ePartitionSleeping] - m_partitionEnds[ePartitionActive]; }
+	inline unsigned int GetNumDyingObjects() { return m_partitionEnds[ePartitionDying] - m_partitionEnds[ePartitionSleeping]; }
+
+	//\brief Get how many objects were outside the camera's view and not drawn last frame
+	inline unsigned int GetNumCulledObjects() { return m_numCulledObjects; }
 	
 	//\brief Resource mutators and accessors
 	inline void SetName(const char * a_name) { sprintf(m_name, "%s", a_name); }
+	inline const char * GetName() { return m_name; }
 	inline void SetBeginLoaded(bool a_begin) { m_beginLoaded = a_begin; }
 	inline bool IsBeginLoaded() { return m_beginLoaded; }
+	inline void SetState(SceneState a_state) { m_state = a_state; }
+	inline SceneState GetState() { return m_state; }
+	inline bool IsActive() { return m_state == eSceneState_Active; }
 
 	//\brief Write all objects in the scene out to a scene file
 	void Serialise();
 
+	//\brief Copy everything an update can change for every object in the scene into a snapshot, cheap enough to do
+	//		 every step for rewinding or replay. Not safe to call while the scene is updating.
+	//\param a_snapshot_OUT is overwritten with a full snapshot, it's buffer is reused so capturing often doesn't allocate
+	//\return true if there was memory for every object
+	bool SaveSnapshot(SceneSnapshot & a_snapshot_OUT);
+
+	//\brief Put every object in a snapshot back how it was, objects are drawn where they are put without blending.
+	//		 Objects that have left the scene since are skipped and objects added since are left as they are.
+	//\param a_snapshot a full snapshot saved from this scene
+	//\return true if every object in the snapshot was restored
+	bool RestoreSnapshot(const SceneSnapshot & a_snapshot);
+
 private:
 
-	//\brief Alias to refer to a group of objects
-	typedef LinkedListNode<GameObject> SceneObject;
-	typedef LinkedList<GameObject> SceneObjects;
+	//\brief Ways to update the objects in the scene, serial is one after the other on the calling thread
+	bool UpdateSerial(float a_dt);
+	bool UpdateParallel(float a_dt);
+	bool UpdateAndVerify(float a_dt);
 
-	//\brief Draw will cause active objects in the scene to submit resources to the render manager
-	//\return true if resources were submitted without issue
-	bool Draw();
+	//\brief Job system entry point to update a range of chunks of the dense object array
+	static void UpdateChunks(void * a_scene, unsigned int a_startChunk, unsigned int a_endChunk);
+
+	//\brief A change to the scene made during a parallel update that is applied once all objects have updated
+	enum eCommandType
+	{
+		eCommandTypeUpdateBounds = 0,	///< Move the object in the spatial structures to match it's clip volume
+		eCommandTypeSetWorldMat,		///< Set the object's world matrix
+		eCommandTypeSetPos,				///< Set the position part of the object's world matrix
+		eCommandTypeUpdateState,		///< Move the object to the partition for it's state
+
+		eCommandTypeCount,
+	};
+	struct Command
+	{
+		eCommandType m_type;	///< What to do
+		GameObject * m_object;	///< The object to do it to
+		Matrix m_mat;			///< World matrix or position in the position row
+	};
+
+	//\brief Commands recorded by one chunk of objects, chunks are applied in order so the result doesn't depend on threads
+	struct CommandBuffer
+	{
+		Command * m_commands;			///< Storage for commands, grows as needed
+		unsigned int m_numCommands;		///< How many commands have been recorded
+		unsigned int m_maxCommands;		///< How many commands will fit before the storage has to grow
+		bool m_updateOk;				///< If every object in the chunk updated without issue
+	};
+
+	//\brief Add a command to the buffer of the chunk being updated by the calling thread
+	void RecordCommand(eCommandType a_type, GameObject * a_object, const Matrix & a_mat);
+
+	//\brief Add a command to the end of a buffer, growing it if needed
+	//\return true if there was memory for the command
+	static bool AddCommand(CommandBuffer & a_buffer, eCommandType a_type, GameObject * a_object, const Matrix & a_mat);
+
+	//\brief Apply the state changes held back while objects were updating
+	void ApplyStateChanges();
+
+	//\brief Carry out a recorded command
+	void ApplyCommand(const Command & a_command);
+
+	//\brief Move an object in the spatial grid and line trace tree, objects in a hierarchy wait for their world transform to be recalculated
+	void ApplyObjectBounds(GameObject * a_object);
+
+	//\brief Move an object in the spatial grid and line trace tree to match it's current world transform
+	void MoveObjectBounds(GameObject * a_object);
+
+	//\brief Add an object to the list waiting for world transforms to be recalculated, once only until the next UpdateTransforms
+	void QueueTransformUpdate(GameObject * a_object);
+
+	//\brief Recalculate the world transform of an object and everything below it in one breadth first pass
+	void UpdateHierarchyTransforms(GameObject * a_root);
+
+	//\brief The dense object array is split into runs of objects by state so updating and drawing only visit active objects
+	enum ePartition
+	{
+		ePartitionActive = 0,		///< Updated and drawn
+		ePartitionSleeping,			///< New, loading and sleeping objects, not updated or drawn
+		ePartitionDying,			///< On their way out of the scene
+
+		ePartitionCount,
+	};
+
+	//\brief Which partition objects in a state belong in
+	static inline ePartition GetPartitionForState(GameObject::eGameObjectState a_state)
+	{
+		return a_state == GameObject::eGameObjectState_Active ? ePartitionActive : (a_state == GameObject::eGameObjectState_Death ? ePartitionDying : ePartitionSleeping);
+	}
+
+	//\brief Which partition an index into the dense array is in
+	inline ePartition GetPartitionForIndex(unsigned int a_index)
+	{
+		return a_index < m_partitionEnds[ePartitionActive] ? ePartitionActive : (a_index < m_partitionEnds[ePartitionSleeping] ? ePartitionSleeping : ePartitionDying);
+	}
+
+	//\brief Move an object to the partition for it's state by swapping it over the partition boundaries in between
+	void ApplyObjectState(GameObject * a_object);
 
-	SceneObjects m_objects;							///< All the objects in the current scene
+	//\brief Move an object from one partition to another, every partition after the last is outside the array
+	//\return the object's new index in the dense array
+	unsigned int MoveObjectPartition(unsigned int a_index, unsigned int a_fromPartition, unsigned int a_toPartition);
+
+	//\brief Exchange two objects in the dense array and all the arrays parallel to it
+	void SwapObjects(unsigned int a_index1, unsigned int a_index2);
+
+	//\brief A condition that wakes a sleeping object
+	struct WakeTrigger
+	{
+		unsigned int m_objectId;	///< Id of the object to wake so triggers for objects that leave the scene can be detected
+		eWakeTrigger m_type;		///< What wakes the object
+		float m_value;				///< Time left for timers or the radius for proximity
+		unsigned int m_eventHash;	///< Name of the event that wakes the object
+	};
+
+	//\brief Add a trigger to the end of the list
+	bool AddWakeTrigger(GameObject * a_object, eWakeTrigger a_type, float a_value, unsigned int a_eventHash);
+
+	//\brief Tick timers and look for active objects near sleepers, waking objects whose triggers fire
+	void UpdateWakeTriggers(float a_dt);
+
+	//\brief Make sure there is room for the bounds of a batch of objects being added, the room is kept for the next batch
+	//\return true if there is enough scratch space
+	bool AllocateAddBounds(unsigned int a_numObjects);
+
+	//\brief Make sure there is a command buffer for each chunk of the dense array
+	//\return true if there are enough buffers
+	bool AllocateCommandBuffers(unsigned int a_numChunks);
+
+	//\brief Allocate the dense and sparse object arrays the first time an object is added
+	//\return true if the arrays are ready for use
+	bool AllocateObjectArrays();
+
+	//\brief Where an object's entry in the sparse table is, taken from the pool index part of it's id
+	static inline unsigned int GetSparseIndex(unsigned int a_objectId) { return a_objectId & ObjectPool<GameObject>::s_handleIndexMask; }
+
+	//\brief Spatial query filters that test the candidates from the grid more accurately
+	struct PointFilter
+	{
+		PointFilter(const Vector & a_point) : m_point(a_point) { }
+		inline bool operator()(GameObject * a_object, const Vector & a_min, const Vector & a_max) const { return a_object->CollidesWith(m_point); }
+		Vector m_point;
+	};
+	struct RadiusFilter
+	{
+		RadiusFilter(const Vector & a_centre, float a_radius) : m_centre(a_centre), m_radiusSquared(a_radius * a_radius) { }
+		bool operator()(GameObject * a_object, const Vector & a_min, const Vector & a_max) const;
+		Vector m_centre;
+		float m_radiusSquared;
+	};
+
+	//\brief Line trace test against the clip volumes of a batch of objects reached in the tree, spheres and axis
+	//		 aligned boxes are gathered up and tested four at a time
+	struct LineFilter
+	{
+		void operator()(GameObject * const * a_objects, unsigned int a_numObjects, const Vector & a_lineStart, const Vector & a_lineEnd, bool * a_hits_OUT, float * a_hitFractions_OUT) const;
+	};
+
+	//\brief Only active objects other than the sleeper near enough to it can wake it
+	struct WakeFilter
+	{
+		WakeFilter(GameObject * a_sleeper, float a_radius) : m_radiusFilter(a_sleeper->GetPos(), a_radius), m_sleeper(a_sleeper) { }
+		inline bool operator()(GameObject * a_object, const Vector & a_min, const Vector & a_max) const { return a_object != m_sleeper && a_object->IsActive() && m_radiusFilter(a_object, a_min, a_max); }
+		RadiusFilter m_radiusFilter;
+		GameObject * m_sleeper;
+	};
+
+	typedef SpatialHashGrid<GameObject *> ObjectGrid;
+	typedef BoundingVolumeHierarchy<GameObject *> ObjectTree;
+
+	//\brief The broadphase stores ids rather than pointers as the end of an overlap is reported after an object has left the scene
+	typedef SweepAndPrune<unsigned int> ObjectBroadphase;
+
+	//\brief Narrowphase for the broadphase, pairs only overlap if their clip volumes do and not just their bounds
+	struct OverlapFilter
+	{
+		OverlapFilter(Scene * a_scene) : m_scene(a_scene) { }
+		bool operator()(unsigned int a_objectId1, unsigned int a_objectId2) const;
+		Scene * m_scene;
+	};
+
+	//\brief Passes the overlaps found by the broadphase on to the objects that asked for them
+	struct OverlapReporter
+	{
+		OverlapReporter(Scene * a_scene) : m_scene(a_scene) { }
+		void operator()(unsigned int a_objectId1, unsigned int a_objectId2, ObjectBroadphase::eOverlap a_overlap) const;
+		Scene * m_scene;
+	};
+
+	//\brief Fill out a line hit from the result of a tree trace
+	static void SetLineHit(const Vector & a_lineStart, const Vector & a_lineEnd, const ObjectTree::Hit & a_treeHit, LineHit & a_hit_OUT);
+
+	static const unsigned int s_maxObjects = 16384;	///< How many objects can be in a single scene at once
+	static const unsigned int s_maxTraceHits = 256;	///< Most hits a single line trace can return
+	static const unsigned short s_invalidIndex = 0xffff;	///< Sparse table entry for an object that is not in the scene
+	static const float s_gridCellSize;				///< Size of each cell of the spatial grid in world units
+	static const unsigned int s_gridNumBuckets;		///< How many buckets the spatial grid hashes cells into
+	static const float s_treeMargin;				///< How far an object can move before it's box in the line trace tree is refit
+	static const unsigned int s_cullBatchSize = 256;	///< How many objects have their clip volumes tested against the view at once
+	static const unsigned int s_updateChunkSize = 64;	///< How many objects in a row are updated by one job in a parallel update
+	static const unsigned int s_minCommands = 16;		///< Starting size of each chunk's command buffer
+	static const unsigned int s_minWakeTriggers = 32;	///< Starting size of the wake trigger list
+	static const unsigned int s_transformBatchSize = 64;	///< How many siblings have their world transforms multiplied by their parent's at once
+
+	GameObject ** m_objects;						///< All the objects in the current scene packed together for iteration, the start of the block every fixed size array of the scene is carved from
+	unsigned short * m_objectIndices;				///< Sparse table from each possible object id to the object's position in the dense array
+	ObjectGrid::ItemId * m_gridItems;				///< Each object's id in the spatial grid, parallel to the dense array
+	ObjectGrid m_objectGrid;						///< Spatial hash of object bounds for point, radius and box queries
+	ObjectTree::LeafId * m_treeLeaves;				///< Each object's leaf in the line trace tree, parallel to the dense array
+	ObjectTree m_objectTree;						///< Bounding volume hierarchy of object bounds for line traces
+	ObjectBroadphase::ProxyId * m_broadphaseProxies;	///< Each object's proxy in the overlap broadphase, parallel to the dense array
+	ObjectBroadphase m_broadphase;					///< Sweep and prune of object bounds for finding overlapping pairs
+	WakeTrigger * m_wakeTriggers;					///< Conditions waiting to wake sleeping objects
+	unsigned int * m_dirtyTransforms;				///< Ids of objects in hierarchies that have moved since transforms were last updated
+	GameObject ** m_transformQueue;					///< Scratch queue for walking a hierarchy breadth first
+	Vector * m_addBounds;							///< Scratch bounds for adding objects in a batch, the minimums then the maximums
 	char m_name[StringUtils::s_maxCharsPerName];	///< Scene name for serialization
 	unsigned int m_numObjects;						///< How many objects are in the default scene
+	unsigned int m_numCulledObjects;				///< How many objects were outside the view on the last draw
+	unsigned int m_numOverlaps;						///< How many pairs of objects were overlapping after the last update
+	unsigned int m_partitionEnds[ePartitionCount];	///< Index one past the last object of each partition of the dense array
+	unsigned int m_numWakeTriggers;					///< How many wake triggers are waiting
+	unsigned int m_maxWakeTriggers;					///< How many wake triggers fit before the list has to grow
+	unsigned int m_numDirtyTransforms;				///< How many objects are waiting for world transforms to be recalculated
+	unsigned int m_maxAddBounds;					///< How many objects there are scratch bounds for
+	CommandBuffer m_stateChanges;					///< State changes held back until all objects have updated
+	CommandBuffer * m_commandBuffers;				///< Commands recorded by each chunk during a parallel update
+	unsigned int m_numCommandBuffers;				///< How many chunks there are buffers for
+	unsigned int m_threadChunks[JobSystem::s_maxWorkers + 1];	///< Which chunk each job system thread is updating, indexed by thread
+	float m_updateDt;								///< Time step of the parallel update in progress
 	SceneState m_state;								///< What state the scene is in
 	bool m_beginLoaded;								///< If the scene should be loaded and rendering on startup
+	bool m_parallelUpdate;							///< If objects are updated across the job system's threads
+	bool m_verifyParallelUpdate;					///< If each parallel update is checked against a serial update
+	bool m_updatingInParallel;						///< Set while chunks are updating so changes to the scene are recorded instead of applied
+	bool m_verifyingSerialUpdate;					///< Set during the serial pass of a verified update so objects aren't created or destroyed twice
+	bool m_deferStateChanges;						///< Set while objects are updating so partitions don't change under the update loop
 };
 
 //\brief WorldManager handles object and scene management.
@@ -96,8 +502,13 @@ public:
 
 	//\brief Ctor calls through to startup
 	WorldManager() 
-		: m_totalSceneNumObjects(0)
-		, m_currentScene(NULL) { }
+		: m_currentScene(NULL)
+		, m_destroyQueue(NULL)
+		, m_numDestroyQueued(0)
+		, m_newObjects(NULL)
+		, m_numNewObjects(0)
+		, m_streamingBudgetMs(s_defaultStreamingBudgetMs)
+		, m_prototypeUpdateTimer(0.0f) { }
 	~WorldManager() { Shutdown(); }
 
 	//\brief Initialise memory pools on startup, cleanup worlds objects on shutdown
@@ -108,9 +519,41 @@ public:
 	bool Shutdown();
 
 	//\brief Update will propogate through all objects in the active scene
+	//\param a_dt the length of a simulation step, fixed so the simulation runs the same at any frame rate
 	//\return true if a world was update without issue
 	bool Update(float a_dt);
 
+	//\brief Work done once a frame however many simulation steps there are, streaming scenes in and picking up edited templates
+	//\param a_dt the length of the frame in seconds
+	void UpdateFrame(float a_dt);
+
+	//\brief Submit the objects in the active scenes for rendering, once a frame after any simulation steps
+	//\param a_interpolation how far the frame is between the last two simulation steps, 0 to 1
+	//\return true if every scene was drawn without issue
+	bool Draw(float a_interpolation);
+
+	//\brief Start loading a scene in the background. The scene file, templates, models and textures are read on a
+	//		 worker thread, then textures are uploaded and objects created on the main thread a few at a time each
+	//		 update within the streaming budget. The scene is updated and drawn once it flips to the active state.
+	//\param a_scenePath the name of a scene file in the scene path or a fully qualified path
+	//\return A pointer to the scene in the loading state or NULL if the request could not be made
+	Scene * RequestLoad(const char * a_scenePath) { return RequestLoad(a_scenePath, false); }
+
+	//\brief Remove a scene and all of it's objects, a scene still loading is removed once it's worker job is done
+	//\param a_scene a scene returned from RequestLoad or already in the world
+	//\return true if the scene was found
+	bool RequestUnload(Scene * a_scene);
+
+	//\brief How long the main thread can spend on streaming each update
+	inline void SetStreamingBudget(unsigned int a_budgetMs) { m_streamingBudgetMs = a_budgetMs; }
+	inline bool IsStreaming() { return m_sceneLoads.GetHead() != NULL; }
+
+	//\brief Build step to compile a text scene and the templates it uses to a binary .scnb file next to it.
+	//		 Streaming does the same whenever the binary is missing or older than the text scene or it's templates.
+	//\param a_scenePath the name of a scene file in the scene path or a fully qualified path
+	//\return true if the compiled scene was written
+	bool CompileScene(const char * a_scenePath);
+
 	//\brief Create and object from an optional game file template
 	//\param a_templatePath Pointer to a cstring with an optional game file to create from
 	//\param a_scene a pointer to the scene to add the object to, will try the current if NULL
@@ -118,150 +561,204 @@ public:
 	template <typename T>
 	T * CreateObject(const char * a_templatePath = NULL, Scene * a_scene = NULL)
 	{
-		// Check there is a valid scene to add the object to
-		Scene * sceneToAddObjectTo = NULL;
-		if (a_scene == NULL)
+		if (!CanCreateObjects(a_templatePath))
 		{
-			sceneToAddObjectTo = m_currentScene;
+			return NULL;
 		}
-		else
+
+		// Templates are only read the first time, after that objects are stamped out of the cached prototype
+		if (a_templatePath)
 		{
-			sceneToAddObjectTo = a_scene;
+			TemplatePrototype * prototype = GetPrototype(a_templatePath);
+			return prototype != NULL ? CreateObject<T>(prototype->m_template, prototype->m_model, a_scene) : NULL;
 		}
 
-		// Early out if no scene
+		// Check there is a valid scene to add the object to
+		Scene * sceneToAddObjectTo = a_scene != NULL ? a_scene : m_currentScene;
 		if (sceneToAddObjectTo == NULL)
 		{
 			Log::Get().WriteEngineErrorNoParams("Cannot create an object, there is no scene to add it to!");
 			return NULL;
 		}
-
-		// TODO Please allocate a heap for game objects
-
-		// Template paths are either fully qualified or relative to the config template dir
-		ModelManager & modelMan = ModelManager::Get();
-		if (a_templatePath)
+		else // Create default object
 		{
-			char fileNameBuf[StringUtils::s_maxCharsPerLine];
-			if (!strstr(a_templatePath, ":\\"))
+			GameObjectHandle newHandle = GameObjectPool::s_invalidHandle;
+			if (T * newGameObject = m_objectPool.Allocate<T>(newHandle))
 			{
-				sprintf(fileNameBuf, "%s%s", m_templatePath, a_templatePath);
-
-				// Add on file extension if not present
-				if (!strstr(fileNameBuf, ".tmp"))
+				newGameObject->SetId(newHandle);
+				newGameObject->SetState(GameObject::eGameObjectState_Loading);
+				newGameObject->SetName("NEW_GAME_OBJECT");
+				newGameObject->SetPos(Vector(0.0f, 0.0f, -20.0f));
+				
+				// Add to currently active scene, an object with no scene would never be freed so it goes straight back
+				if (!sceneToAddObjectTo->AddObject(newGameObject))
 				{
-					sprintf(fileNameBuf, "%s%s", fileNameBuf, ".tmp");
+					m_objectPool.Free(newGameObject);
+					return NULL;
 				}
-			} 
-			else // Already fully qualified
+				return newGameObject;
+			}
+			else
+			{
+				Log::Get().WriteEngineErrorNoParams("Unable to allocate memory to create a default game object, the pool is full.");
+			}
+		}
+
+		return NULL;
+	}
+
+	//\brief Create many objects from the same template in one go, for populating a level or spawning swarms
+	//		 of small objects. Pool space is checked once, the objects are set up in a tight loop and then
+	//		 added to the scene's grid and tree in a single batch.
+	//\param a_templatePath the name of a template in the template path or a fully qualified path
+	//\param a_count how many objects to create
+	//\param a_positions array of a_count world positions for the objects, NULL to leave them at the origin
+	//\param a_handles_OUT optional array of a_count that is written with the id of each new object
+	//\param a_scene a pointer to the scene to add the objects to, will try the current if NULL
+	//\return true if all the objects were created, none are created on failure
+	template <typename T>
+	bool CreateObjects(const char * a_templatePath, unsigned int a_count, const Vector * a_positions, unsigned int * a_handles_OUT = NULL, Scene * a_scene = NULL)
+	{
+		if (!CanCreateObjects(a_templatePath))
+		{
+			return false;
+		}
+		Scene * sceneToAddObjectsTo = a_scene != NULL ? a_scene : m_currentScene;
+		if (sceneToAddObjectsTo == NULL)
+		{
+			Log::Get().WriteEngineErrorNoParams("Cannot create objects, there is no scene to add them to!");
+			return false;
+		}
+		TemplatePrototype * prototype = GetPrototype(a_templatePath);
+		if (prototype == NULL)
+		{
+			return false;
+		}
+		if (a_count > m_objectPool.GetNumFree() || a_count > sceneToAddObjectsTo->GetNumFreeObjects())
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to create %u objects from template %s, the pool or scene is full", a_count, a_templatePath);
+			return false;
+		}
+
+		// Every object on the stack is already in the pool so the stack can't hold more than the pool's free space leaves
+		GameObject ** newObjects = m_newObjects + m_numNewObjects;
+		m_numNewObjects += a_count;
+
+		// Everything the objects share is read from the prototype once
+		const BinaryScene::Template & objectTemplate = prototype->m_template;
+		const GameObject::eClipType clipType = (GameObject::eClipType)objectTemplate.m_clipType;
+		unsigned int numCreated = 0;
+		for (; numCreated < a_count; ++numCreated)
+		{
+			GameObjectHandle newHandle = GameObjectPool::s_invalidHandle;
+			T * newGameObject = m_objectPool.Allocate<T>(newHandle);
+			if (newGameObject == NULL)
+			{
+				Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to create game object from template %s, the type is too large", a_templatePath);
+				break;
+			}
+			newGameObject->SetId(newHandle);
+			newGameObject->SetState(GameObject::eGameObjectState_Loading);
+			if (objectTemplate.m_name != NULL)
 			{
-				sprintf(fileNameBuf, "%s", a_templatePath);
+				newGameObject->SetName(objectTemplate.m_name);
 			}
+			newGameObject->SetModel(prototype->m_model);
+			newGameObject->SetClipType(clipType);
+			newGameObject->SetClipSize(objectTemplate.m_clipSize);
+			newGameObject->SetUpdateOnMainThread(objectTemplate.m_updateOnMainThread);
 
-			// Open the template file
-			GameFile templateFile(fileNameBuf);
-			if (templateFile.IsLoaded())
+			// Placed before joining the scene so each goes straight into the right cells
+			if (a_positions != NULL)
 			{
-				// Create from template properties
-				// TODO memory management kill std::new
-				if (T * newGameObject = new T())
-				{
-					bool validObject = true;
-					newGameObject->SetId(m_totalSceneNumObjects++);
-					newGameObject->SetState(GameObject::eGameObjectState_Loading);
-					if (GameFile::Object * object = templateFile.FindObject("gameObject"))
-					{
-						// Name
-						if (GameFile::Property * name = object->FindProperty("name"))
-						{
-							newGameObject->SetName(name->GetString());
-						}
-						// Model file
-						if (GameFile::Property * model = object->FindProperty("model"))
-						{
-							if (Model * newModel = modelMan.GetModel(model->GetString()))
-							{
-								newGameObject->SetModel(newModel);
-							}
-							else // Failure of model load will report errors
-							{
-								validObject = false;
-							}
-						}
-						// Clipping type
-						if (GameFile::Property * clipType = object->FindProperty("clipType"))
-						{
-							if (strstr(clipType->GetString(), "sphere") != NULL)
-							{
-								newGameObject->SetClipType(GameObject::eClipTypeSphere);
-							}
-							else if (strstr(clipType->GetString(), "axisbox") != NULL)
-							{
-								newGameObject->SetClipType(GameObject::eClipTypeAxisBox);
-							}
-						}
-						// Clipping size
-						if (GameFile::Property * clipSize = object->FindProperty("clipSize"))
-						{
-							newGameObject->SetClipSize(clipSize->GetVector());
-						}
-						// TODO Pos, rot, shader, etc
-
-						// Add to currently active scene
-						if (validObject)
-						{
-							sceneToAddObjectTo->AddObject(newGameObject);
-							return newGameObject;
-						}
-						else
-						{
-							return NULL;
-						}
-					}
-					else // Can't find the first object
-					{
-						Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to find a root gameObject node for template file %s", a_templatePath);
-						return NULL;
-					}
-				}
-				else // Can't create the game object
-				{
-					Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to create game object from template file %s", a_templatePath);
-					return NULL;
-				}
+				newGameObject->SetPos(a_positions[numCreated]);
 			}
-			else // Load failed
+			newObjects[numCreated] = newGameObject;
+			if (a_handles_OUT != NULL)
 			{
-				Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to load template file %s", a_templatePath);
-				return NULL;
+				a_handles_OUT[numCreated] = newHandle;
 			}
 		}
-		else // Create default object
+
+		// Hand back everything on failure so the caller never sees a partial batch
+		const bool created = numCreated == a_count && sceneToAddObjectsTo->AddObjects(newObjects, a_count);
+		if (!created)
 		{
-			if (T * newGameObject = new T())
+			for (unsigned int i = 0; i < numCreated; ++i)
 			{
-				newGameObject->SetId(m_totalSceneNumObjects++);
-				newGameObject->SetState(GameObject::eGameObjectState_Loading);
-				newGameObject->SetName("NEW_GAME_OBJECT");
-				newGameObject->SetPos(Vector(0.0f, 0.0f, -20.0f));
-				
-				// Add to currently active scene
-				sceneToAddObjectTo->AddObject(newGameObject);
-
-				return newGameObject;
+				m_objectPool.Free(newObjects[i]);
 			}
 		}
+		m_numNewObjects -= a_count;
+		return created;
+	}
 
-		return NULL;
+	//\brief Create an object from a template file that has already been read
+	//\param a_templateFile the loaded template to take the object's properties from
+	//\param a_scene a pointer to the scene to add the object to, will try the current if NULL
+	//\return A pointer to the newly created game object of NULL for failure
+	template <typename T>
+	T * CreateObject(GameFile & a_templateFile, Scene * a_scene = NULL)
+	{
+		BinaryScene::Template objectTemplate;
+		objectTemplate.m_path = a_templateFile.GetFilePath();
+		if (!BinaryScene::ReadTemplate(a_templateFile, objectTemplate))
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to find a root gameObject node for template file %s", a_templateFile.GetFilePath());
+			return NULL;
+		}
+		return CreateObject<T>(objectTemplate, a_scene);
+	}
+
+	//\brief Create an object from template properties that have already been read from a template or compiled scene
+	//\param a_template the properties to give the object
+	//\param a_scene a pointer to the scene to add the object to, will try the current if NULL
+	//\return A pointer to the newly created game object of NULL for failure
+	template <typename T>
+	T * CreateObject(const BinaryScene::Template & a_template, Scene * a_scene = NULL)
+	{
+		if (!CanCreateObjects(a_template.m_path))
+		{
+			return NULL;
+		}
+
+		// Failure of model load will report errors
+		Model * newModel = NULL;
+		if (a_template.m_model != NULL && (newModel = ModelManager::Get().GetModel(a_template.m_model)) == NULL)
+		{
+			return NULL;
+		}
+		return CreateObject<T>(a_template, newModel, a_scene);
 	}
 	
-	//\brief Remove a created object from the world, will not be destroyed right away
-	bool DestroyObject(unsigned int a_objectId) { return false; }
+	//\brief Mark an object for destruction, it moves to the death state and stops updating and drawing straight away
+	//		 then is shutdown and returned to the pool with the rest of the frame's dead objects in FlushDestroyedObjects.
+	//		 Safe for an object to call on itself from it's update, including a parallel update.
+	//\param a_objectId the handle of the object to destroy
+	//\return true if the handle referred to a live object, which may already have been marked
+	bool DestroyObject(unsigned int a_objectId);
+
+	//\brief Shutdown and free every object marked for destruction in one batch, once a frame when nothing holds object pointers.
+	//		 Freeing bumps the generation of each object's handle so any ids still held fail to resolve from then on.
+	void FlushDestroyedObjects();
+
+	//\brief How many objects are marked for destruction and waiting for the flush
+	inline unsigned int GetNumObjectsPendingDestruction() const { return (unsigned int)m_numDestroyQueued; }
+
+	//\brief Get the scene whose objects are updating across the job system's threads, nothing can be added to the
+	//		 object pool or any scene until the update is done
+	//\return the scene or NULL if no parallel update is running
+	Scene * GetParallelUpdateScene();
+
+	//\brief Get the scene running the serial pass of a verified update. The pass is run again in parallel so objects
+	//		 created in it are not, and objects destroyed in it only change state until the parallel pass destroys them.
+	//\return the scene or NULL if no verified update is running it's serial pass
+	Scene * GetVerifyingScene();
 
 	//\brief Get a pointer to an existing object in the world.
-	//\param a_objectId the unique game id for this object
-	//\return Pointer to a game object in the world
-	GameObject * GetGameObject(unsigned int a_objectId);
+	//\param a_objectId the unique game id for this object, which is a handle into the object pool
+	//\return Pointer to a game object in the world or NULL if the object no longer exists, objects marked for destruction resolve until the flush
+	inline GameObject * GetGameObject(unsigned int a_objectId) { return m_objectPool.Get(a_objectId); }
 
 	//\brief Get the scene that the world is currently showing
 	//\return A pointer to a scene
@@ -271,19 +768,211 @@ public:
 	inline const char * GetTemplatePath() { return m_templatePath; }
 	inline const char * GetScenePath() { return m_scenePath; }
 
+	//\brief Accessor for object pool usage
+	inline unsigned int GetNumObjects() const { return m_objectPool.GetNumAllocated(); }
+
 private:
 
-	//\brief Read scene details from a file into a scene object
-	//\param a_scenePath is a string containing the filename of a scene file
-	//\param a_sceneToLoad_OUT is a pointer to a scene object to modify with data from the scene path
-	bool LoadScene(const char * a_scenePath, Scene * a_sceneToLoad_OUT);
+	//\brief Scenes return objects to the pool when they are removed or the scene is unloaded
+	friend class Scene;
+
+	//\brief Objects can't be created while a scene is updating in parallel, nothing guards the pool or the scenes from other threads
+	//\param a_templatePath the template the object would be created from for the error, NULL for a default object
+	//\return true if objects can be created now, an error is logged if not unless it's the serial pass of a verified update
+	bool CanCreateObjects(const char * a_templatePath);
+
+	//\brief Shutdown an object and return its memory to the pool
+	//\param a_object pointer to an object allocated from the world pool
+	void FreeObject(GameObject * a_object);
+
+	//\brief Create an object from template properties with the model already resolved, the last step of every template creation
+	//\param a_template the properties to give the object
+	//\param a_model the model to draw the object with, NULL for none
+	//\param a_scene a pointer to the scene to add the object to, will try the current if NULL
+	//\return A pointer to the newly created game object of NULL for failure
+	template <typename T>
+	T * CreateObject(const BinaryScene::Template & a_template, Model * a_model, Scene * a_scene)
+	{
+		// Check there is a valid scene to add the object to
+		Scene * sceneToAddObjectTo = a_scene != NULL ? a_scene : m_currentScene;
+		if (sceneToAddObjectTo == NULL)
+		{
+			Log::Get().WriteEngineErrorNoParams("Cannot create an object, there is no scene to add it to!");
+			return NULL;
+		}
+
+		// Create from template properties in the object pool
+		GameObjectHandle newHandle = GameObjectPool::s_invalidHandle;
+		if (T * newGameObject = m_objectPool.Allocate<T>(newHandle))
+		{
+			newGameObject->SetId(newHandle);
+			newGameObject->SetState(GameObject::eGameObjectState_Loading);
+			if (a_template.m_name != NULL)
+			{
+				newGameObject->SetName(a_template.m_name);
+			}
+			newGameObject->SetModel(a_model);
+			newGameObject->SetClipType((GameObject::eClipType)a_template.m_clipType);
+			newGameObject->SetClipSize(a_template.m_clipSize);
+			newGameObject->SetUpdateOnMainThread(a_template.m_updateOnMainThread);
+
+			// Add to currently active scene, an object with no scene would never be freed so it goes straight back
+			if (!sceneToAddObjectTo->AddObject(newGameObject))
+			{
+				m_objectPool.Free(newGameObject);
+				return NULL;
+			}
+			return newGameObject;
+		}
+		else // Can't create the game object
+		{
+			Log::Get().Write(Log::LL_ERROR, Log::LC_ENGINE, "Unable to allocate memory to create game object from template %s, the pool is full or the type is too large", a_template.m_path);
+		}
+
+		return NULL;
+	}
+
+	//\brief A template read once and kept so objects can be created from it without touching the disk or looking anything up by name
+	struct TemplatePrototype
+	{
+		BinaryScene::Template m_template;					///< Object properties, the strings point at the storage below
+		Model * m_model;									///< The model already loaded, NULL for none
+		FileManager::Timestamp m_timeStamp;					///< Modification time of the template file when read
+		char m_path[StringUtils::s_maxCharsPerLine];		///< Fully qualified path of the template file
+		char m_name[StringUtils::s_maxCharsPerName];		///< Storage for the default object name
+		char m_modelPath[StringUtils::s_maxCharsPerLine];	///< Storage for the model path
+	};
+
+	typedef HashMap<unsigned int, TemplatePrototype *> PrototypeMap;
+
+	//\brief Get the prototype for a template, reading the template and loading it's model the first time
+	//\param a_templatePath the name of a template in the template path or a fully qualified path
+	//\return the prototype or NULL if the template or it's model could not be loaded, errors are reported
+	TemplatePrototype * GetPrototype(const char * a_templatePath);
+
+	//\brief Drop prototypes whose template file has changed so the next object created reads the new version
+	void UpdatePrototypes(float a_dt);
+	void ClearPrototypes();
+
+	//\brief Template files read ahead of object creation, keyed by the hash of the template name as written in the scene
+	typedef HashMap<unsigned int, GameFile *> TemplateMap;
+
+	//\brief Everything about a scene being streamed in. The worker job owns it until the counter is done, then the main thread.
+	struct SceneLoad
+	{
+		SceneLoad() 
+			: m_scene(NULL)
+			, m_sceneFile(NULL)
+			, m_nextObject(NULL)
+			, m_binaryScene(NULL)
+			, m_binaryObjects(NULL)
+			, m_nextBinaryObject(0)
+			, m_onlyIfBeginLoaded(false)
+			, m_loadOk(false)
+			, m_unloadRequested(false) { m_path[0] = '\0'; }
+
+		Scene * m_scene;									///< The scene objects are created in, not in the world's list until active
+		GameFile * m_sceneFile;								///< The parsed scene file
+		TemplateMap m_templates;							///< Every template the scene uses, parsed once
+		GameFile::Object * m_nextObject;					///< The next top level object in the scene file to create
+		BinaryScene * m_binaryScene;						///< The compiled scene if it was up to date, used instead of the scene file
+		GameObject ** m_binaryObjects;						///< Objects created from the compiled scene so far, to attach children to
+		unsigned int m_nextBinaryObject;					///< Index of the next object in the compiled scene to create
+		JobSystem::Counter m_counter;						///< Done when the worker has finished reading files
+		bool m_onlyIfBeginLoaded;							///< Drop the scene without error if it's not set to begin loaded
+		bool m_loadOk;										///< Set by the worker if the scene file was read correctly
+		bool m_unloadRequested;								///< Throw the scene away as soon as the worker is done
+		char m_path[StringUtils::s_maxCharsPerLine];		///< Fully qualified path to the scene file
+	};
+
+	//\brief Create an object from a scene file along with the objects saved inside it as it's children
+	//\param a_fileObject the game file object with the template, name and position properties
+	//\param a_scene the scene to create the objects in
+	//\param a_parent the object to attach the new object to, NULL for objects at the top of the scene
+	//\param a_templates optional templates that have already been read, others are read from disk
+	void LoadSceneObject(GameFile::Object * a_fileObject, Scene * a_scene, GameObject * a_parent, TemplateMap * a_templates = NULL);
+
+	//\brief Create the next object in a compiled scene and attach it to it's parent
+	void LoadBinarySceneObject(SceneLoad * a_sceneLoad);
+
+	//\brief Resolve a scene name to the fully qualified path of it's text file
+	//\param a_scenePath the name of a scene file in the scene path or a fully qualified path
+	//\param a_fileName_OUT storage for the path, s_maxCharsPerLine long
+	void GetSceneFilePath(const char * a_scenePath, char * a_fileName_OUT);
+
+	//\brief Compare file modification times, the timestamp only has greater and less than operators
+	static inline bool IsSameTimeStamp(const FileManager::Timestamp & a_time1, const FileManager::Timestamp & a_time2)
+	{
+		return a_time1.m_totalDays == a_time2.m_totalDays && a_time1.m_totalSeconds == a_time2.m_totalSeconds;
+	}
+
+	//\brief Get the path of the compiled version of a text scene, s_maxCharsPerLine long
+	static inline void GetBinarySceneFilePath(const char * a_scenePath, char * a_fileName_OUT) { sprintf(a_fileName_OUT, "%sb", a_scenePath); }
+
+	//\brief Check a compiled scene against the modification times of the text scene and templates it was compiled from
+	//\return true if none of the files have changed or the text files are not there
+	bool IsBinarySceneCurrent(const BinaryScene & a_binaryScene, const char * a_scenePath);
+
+	//\brief Flatten a scene file and the templates it uses into a compiled scene, the models in the templates must be loaded
+	//\param a_scenePath the path of the text scene, the compiled scene is written next to it
+	//\param a_sceneFile the parsed scene
+	//\param a_templates every template the scene uses, any missing will leave out the objects that use them
+	//\return true if the compiled scene was written
+	bool WriteBinaryScene(const char * a_scenePath, GameFile & a_sceneFile, TemplateMap & a_templates);
+
+	//\brief Count the objects in a scene file that would go in the compiled scene and gather their records
+	//\param a_fileObject the scene file object to flatten along with it's children
+	//\param a_parent the index of the record for the parent object, -1 for none
+	//\param a_templateIndices map from template name hash to template record index
+	//\param a_templates_OUT template records to fill in the name objects use for them, NULL when counting
+	//\param a_objects_OUT storage for the records, NULL to just count them
+	//\param a_numObjects_OUT incremented for each object
+	static void FlattenSceneObject(GameFile::Object * a_fileObject, int a_parent, HashMap<unsigned int, unsigned int> & a_templateIndices, 
+								   BinaryScene::Template * a_templates_OUT, BinaryScene::Object * a_objects_OUT, unsigned int & a_numObjects_OUT);
+
+	//\brief Resolve a template name to the fully qualified path of it's file
+	//\param a_templatePath the name of a template in the template path or a fully qualified path
+	//\param a_fileName_OUT storage for the path, s_maxCharsPerLine long
+	void GetTemplateFilePath(const char * a_templatePath, char * a_fileName_OUT);
+
+	//\brief Start streaming a scene in, used at startup to skip scenes that aren't set to begin loaded
+	Scene * RequestLoad(const char * a_scenePath, bool a_onlyIfBeginLoaded);
+
+	//\brief Worker job that reads the scene file, every template it uses, and the models and textures in those templates
+	//\param a_sceneLoad pointer to the SceneLoad to fill
+	static void StreamSceneJob(void * a_sceneLoad);
+
+	//\brief Gather the templates used by a scene object and it's children and read any not already read
+	static void ReadSceneObjectTemplates(GameFile::Object * a_fileObject, TemplateMap & a_templates_OUT);
+
+	//\brief Upload textures and create objects for streaming scenes until the budget runs out, scenes that are done become active
+	void UpdateStreaming(unsigned int a_budgetMs);
+
+	//\brief Release a scene load along with any files it read, the scene is deleted unless it has been handed to the world
+	void FreeSceneLoad(SceneLoad * a_sceneLoad);
 
 	//\brief Alias to refer to a group of objects
 	typedef LinkedListNode<Scene> SceneNode;
+	typedef LinkedListNode<SceneLoad> SceneLoadNode;
+	typedef ObjectPool<GameObject> GameObjectPool;
+	typedef GameObjectPool::Handle GameObjectHandle;
+
+	static const unsigned int s_maxGameObjects;				///< How many objects can be alive across all scenes at once
+	static const unsigned int s_defaultStreamingBudgetMs;	///< How long the main thread spends streaming each update unless set
+	static const float s_prototypeUpdateFreq;				///< How often template files are checked for changes
+	static const unsigned int s_maxStalePrototypes = 64;	///< Most changed templates dropped in one check, any more are found in the next
 	
+	GameObjectPool m_objectPool;							///< Contiguous storage for all game objects, handles drive ID creation
+	unsigned int * m_destroyQueue;							///< Handles of objects marked for destruction this frame
+	volatile LONG m_numDestroyQueued;						///< How many handles are in the destroy queue, added to from any thread
+	GameObject ** m_newObjects;								///< Stack of objects being created in a batch, calls nested in Startup go on top
+	unsigned int m_numNewObjects;							///< How many objects are on the stack
 	LinkedList<Scene> m_scenes;								///< All the currently loaded scenes are added to this list
+	LinkedList<SceneLoad> m_sceneLoads;						///< Scenes that are streaming in
+	unsigned int m_streamingBudgetMs;						///< How long the main thread can spend on streaming each update
+	PrototypeMap m_prototypes;								///< Templates that have been read, keyed by the hash of the name they were created with
+	float m_prototypeUpdateTimer;							///< Time since template files were last checked for changes
 	Scene * m_currentScene;									///< The currently active scene
-	unsigned int m_totalSceneNumObjects;					///< Total object count across all scenes, drives ID creation
 	char m_templatePath[StringUtils::s_maxCharsPerLine];	///< Path for templates
 	char m_scenePath[StringUtils::s_maxCharsPerLine];		///< Path for scene files
 };
@@ -21,11 +21,11 @@ static const GLubyte cTGAcompare[12] = {0,0,10,0,0,0,0,0,0,0,0,0};
 
 bool Texture::Load(const char *a_tgaFilePath, bool a_useLinearFilter)
 {
-    int x, y, bpp;
-    GLubyte *textureData;
-    GLuint textureID;
-    GLenum texFormat, intTexFormat;
+	return LoadData(a_tgaFilePath, a_useLinearFilter) && Upload();
+}
 
+bool Texture::LoadData(const char *a_tgaFilePath, bool a_useLinearFilter)
+{
 	// Early out for no file case
 	if (a_tgaFilePath == NULL)
 	{
@@ -35,14 +35,24 @@ bool Texture::Load(const char *a_tgaFilePath, bool a_useLinearFilter)
 	// Store off the file name
 	memcpy(m_filePath, a_tgaFilePath, sizeof(char) * strlen(a_tgaFilePath));
 
-	// Load texture data into memory and check if successful
-    textureData = loadTGA(a_tgaFilePath, x, y, bpp);
-    if (textureData == NULL) 
-	{ 
-        return false;
-    }
+	// Load texture data into memory and check if successful, a reload replaces any pixels not uploaded yet
+	free(m_pendingData);
+	m_pendingData = loadTGA(a_tgaFilePath, m_pendingWidth, m_pendingHeight, m_pendingBpp);
+	m_useLinearFilter = a_useLinearFilter;
+	return m_pendingData != NULL;
+}
+
+bool Texture::Upload()
+{
+    GLuint textureID;
+    GLenum texFormat, intTexFormat;
+
+	if (m_pendingData == NULL)
+	{
+		return false;
+	}
 
-    switch (bpp) 
+    switch (m_pendingBpp) 
 	{
         case 24:
 		{
@@ -70,7 +80,7 @@ bool Texture::Load(const char *a_tgaFilePath, bool a_useLinearFilter)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-	if (a_useLinearFilter)
+	if (m_useLinearFilter)
 	{
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -81,11 +91,12 @@ bool Texture::Load(const char *a_tgaFilePath, bool a_useLinearFilter)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	}
     
-    glTexImage2D(GL_TEXTURE_2D, 0, intTexFormat, x, y, 0, texFormat, GL_UNSIGNED_BYTE, textureData);
+    glTexImage2D(GL_TEXTURE_2D, 0, intTexFormat, m_pendingWidth, m_pendingHeight, 0, texFormat, GL_UNSIGNED_BYTE, m_pendingData);
 
 	m_textureId = textureID;
 
-    free(textureData);
+    free(m_pendingData);
+	m_pendingData = NULL;
 
     return true;
 }
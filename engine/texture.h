@@ -22,7 +22,13 @@ public:
 	};
 	
 	// Assigned texture IDs start from 0
-	Texture() : m_textureId(-1) {}
+	Texture() 
+		: m_textureId(-1)
+		, m_pendingData(NULL)
+		, m_pendingWidth(0)
+		, m_pendingHeight(0)
+		, m_pendingBpp(0)
+		, m_useLinearFilter(true) {}
 
 	//\brief Load a TGA file into memory and store out the texture ID
 	//\param a_tgaFilePath is a const pointer to a c string with the fully qualified path
@@ -30,8 +36,15 @@ public:
 	//\return bool true if the texture was loaded succesfullly
 	bool Load(const char *a_tgaFilePath, bool a_useLinearFilter = true);
 
+	//\brief Loading in two halves, reading and decoding the file touches no GL state so it can be done on any
+	//		 thread, then the upload creates the GL texture and has to be on the thread that owns the context
+	//\return bool true if the pixels were read or the texture was created
+	bool LoadData(const char *a_tgaFilePath, bool a_useLinearFilter = true);
+	bool Upload();
+
 	//\brief Utility methods for texture member data for convenience
 	inline bool IsLoaded() { return m_textureId >= 0; }
+	inline bool IsUploadPending() { return m_pendingData != NULL; }
 	inline unsigned int GetId() { return m_textureId; }
 	inline const char * GetFilePath() { return m_filePath; }
 	inline const char * GetFileName() { return StringUtils::ExtractFileNameFromPath(m_filePath); }
@@ -62,6 +75,11 @@ private:
 	GLubyte *loadTGA(const char *a_tgaFilePath, int &a_x, int &a_y, int &a_bpp);
 
 	int m_textureId;			///< Texture ID as stored off by the load operation
+	GLubyte * m_pendingData;	///< Decoded pixels waiting to be uploaded
+	int m_pendingWidth;			///< Size of the decoded pixels
+	int m_pendingHeight;
+	int m_pendingBpp;			///< Bits per pixel of the decoded pixels
+	bool m_useLinearFilter;		///< Filter mode to set when the pixels are uploaded
 	char m_filePath[StringUtils::s_maxCharsPerLine];	///< File path stored off during load, fully qualified
 
 };
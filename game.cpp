@@ -8,16 +8,20 @@
 #include "core/MathUtils.h"
 
 #include "engine/CameraManager.h"
+#include "engine/ComponentManager.h"
 #include "engine/DebugMenu.h"
 #include "engine/FontManager.h"
 #include "engine/GameFile.h"
 #include "engine/Gui.h"
 #include "engine/InputManager.h"
+#include "engine/JobManager.h"
 #include "engine/Log.h"
+#include "engine/MemoryManager.h"
 #include "engine/ModelManager.h"
 #include "engine/RenderManager.h"
 #include "engine/StringUtils.h"
 #include "engine/TextureManager.h"
+#include "engine/Time.h"
 #include "engine/WorldManager.h"
 
 int main(int argc, char *argv[])
@@ -140,6 +144,7 @@ int main(int argc, char *argv[])
 
 	// Subsystem startup
 	MathUtils::InitialiseRandomNumberGenerator();
+	JobManager::Get().Startup(configFile.GetInt("jobs", "workerThreads"));
     RenderManager::Get().Startup(sc_colourBlack);
     RenderManager::Get().Resize(width, height, bpp);
 	TextureManager::Get().Startup(texturePath, configFile.GetBool("render", "textureFilter"));
@@ -147,11 +152,21 @@ int main(int argc, char *argv[])
 	Gui::Get().Startup(guiPath);
 	InputManager::Get().Startup(fullScreen);
 	ModelManager::Get().Startup(modelPath);
+	ComponentManager::Get().Startup();
 	WorldManager::Get().Startup(templatePath, scenePath);
 	CameraManager::Get().Startup();
 
+	// The world is simulated in fixed steps, drawing blends between the last two
+	FixedTimestep simTimestep;
+	simTimestep.SetTickRate((float)configFile.GetInt("simulation", "tickRate"));
+	const int maxSimSteps = configFile.GetInt("simulation", "maxStepsPerFrame");
+	if (maxSimSteps > 0)
+	{
+		simTimestep.SetMaxStepsPerFrame(maxSimSteps);
+	}
+
     // Game main loop
-	unsigned int lastFrameTime = 0;
+	double lastFrameTime = 0.0;
 	float lastFrameTimeSec = 0.0f;
 	unsigned int frameCount = 0;
 	unsigned int lastFps = 0;
@@ -161,7 +176,7 @@ int main(int argc, char *argv[])
     while (active)
     {
 		// Start counting time
-		unsigned int startFrame = Time::GetSystemTime();
+		const double startFrame = Time::GetPreciseTimeSec();
 
         // Message processing loop
         SDL_Event event;
@@ -173,8 +188,18 @@ int main(int argc, char *argv[])
 		// Update the camera first
 		CameraManager::Get().Update(lastFrameTimeSec);
 
+		// Stream scenes in once a frame, the simulation steps below may run any number of times
+		WorldManager::Get().UpdateFrame(lastFrameTimeSec);
+
 		// Update the world first, other systems rely on object positions/states etc
-		WorldManager::Get().Update(lastFrameTimeSec);
+		const unsigned int numSimSteps = simTimestep.Advance(lastFrameTime);
+		for (unsigned int i = 0; i < numSimSteps; ++i)
+		{
+			WorldManager::Get().Update(simTimestep.GetStepTime());
+		}
+
+		// Submit objects where they are between the last two steps
+		WorldManager::Get().Draw(simTimestep.GetInterpolation());
 		
 		// Draw the Gui
 		Gui::Get().Update(lastFrameTimeSec);
@@ -194,6 +219,13 @@ int main(int argc, char *argv[])
 			char buf[32];
 			sprintf(buf, "FPS: %u", lastFps);
 			FontManager::Get().DrawDebugString2D(buf, Vector2(0.85f, 1.0f));
+
+			// Along with how many objects the camera could not see
+			if (Scene * curScene = WorldManager::Get().GetCurrentScene())
+			{
+				sprintf(buf, "Culled: %u/%u", curScene->GetNumCulledObjects(), curScene->GetNumActiveObjects());
+				FontManager::Get().DrawDebugString2D(buf, Vector2(0.85f, 0.95f));
+			}
 		}
 
 		// Drawing the scene will flush the batches
@@ -202,12 +234,21 @@ int main(int argc, char *argv[])
         // Cycle SDL surface
         SDL_GL_SwapBuffers();
 
+		// Objects destroyed during the frame are freed together now nothing is drawing them
+		WorldManager::Get().FlushDestroyedObjects();
+
+		// Defragment a few pages of each memory arena now nothing is holding on to movable memory
+		MemoryManager::Get().Update(lastFrameTimeSec);
+
 		// Finished a frame, count time and calc FPS
-		lastFrameTime = Time::GetSystemTime() - startFrame;
-		lastFrameTimeSec = lastFrameTime / 1000.0f;
+		lastFrameTime = Time::GetPreciseTimeSec() - startFrame;
+		lastFrameTimeSec = (float)lastFrameTime;
 		if (fps > 1.0f) { lastFps = frameCount; frameCount = 0; fps = 0.0f; } else { ++frameCount;	fps+=lastFrameTimeSec; }
     }
 
+	// Worker threads are stopped first as jobs may use any other system
+	JobManager::Get().Shutdown();
+
 	// Singletons are shutdown by their destructors
     Log::Get().Write(Log::LL_INFO, Log::LC_ENGINE, "Exited cleanly");
 